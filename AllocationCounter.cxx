@@ -0,0 +1,179 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file AllocationCounter.cxx This file contains the replacement of the glibc allocation functions that count allocations.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sys.h"
+#include "debug.h"
+#include "AllocationCounter.h"
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <unistd.h>
+
+#if defined(__GLIBC__) && !(defined(CWDEBUG) && CWDEBUG_ALLOC) && !defined(__SANITIZE_ADDRESS__)
+#define UTIL_ALLOCATION_COUNTING 1
+#else
+#define UTIL_ALLOCATION_COUNTING 0
+#endif
+
+namespace util {
+namespace allocation {
+
+namespace {
+
+// Constant initialized, so that they can be used before main and while a thread is being created.
+thread_local Counts tl_counts;
+std::atomic<uint64_t> S_allocations;
+std::atomic<uint64_t> S_bytes;
+std::atomic<uint64_t> S_deallocations;
+
+#if UTIL_ALLOCATION_COUNTING
+
+inline void count_allocation(size_t size)
+{
+  ++tl_counts.allocations;
+  tl_counts.bytes += size;
+  S_allocations.fetch_add(1, std::memory_order_relaxed);
+  S_bytes.fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void count_deallocation(void* ptr)
+{
+  if (ptr)
+  {
+    ++tl_counts.deallocations;
+    S_deallocations.fetch_add(1, std::memory_order_relaxed);
+  }
+}
+
+#endif // UTIL_ALLOCATION_COUNTING
+
+} // namespace
+
+bool counting()
+{
+  return UTIL_ALLOCATION_COUNTING;
+}
+
+Counts this_thread_counts()
+{
+  return tl_counts;
+}
+
+Counts all_threads_counts()
+{
+  Counts counts;
+  counts.allocations = S_allocations.load(std::memory_order_relaxed);
+  counts.bytes = S_bytes.load(std::memory_order_relaxed);
+  counts.deallocations = S_deallocations.load(std::memory_order_relaxed);
+  return counts;
+}
+
+} // namespace allocation
+} // namespace util
+
+#if UTIL_ALLOCATION_COUNTING
+
+// The implementation of glibc, which is what the replacements below call after counting.
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t nmemb, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void* __libc_valloc(size_t size);
+void* __libc_pvalloc(size_t size);
+void __libc_free(void* ptr);
+}
+
+using util::allocation::count_allocation;
+using util::allocation::count_deallocation;
+
+extern "C" {
+
+void* malloc(size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_malloc(size);
+}
+
+void* calloc(size_t nmemb, size_t size) noexcept
+{
+  count_allocation(nmemb * size);
+  return __libc_calloc(nmemb, size);
+}
+
+void* realloc(void* ptr, size_t size) noexcept
+{
+  // Counted as a new allocation, and the deallocation of ptr if any.
+  count_deallocation(ptr);
+  if (size || !ptr)
+    count_allocation(size);
+  return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) noexcept
+{
+  count_deallocation(ptr);
+  __libc_free(ptr);
+}
+
+void* memalign(size_t alignment, size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+void* aligned_alloc(size_t alignment, size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_memalign(alignment, size);
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) noexcept
+{
+  if (alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0)
+    return EINVAL;
+  count_allocation(size);
+  void* ptr = __libc_memalign(alignment, size);
+  if (!ptr)
+    return ENOMEM;
+  *memptr = ptr;
+  return 0;
+}
+
+void* valloc(size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_valloc(size);
+}
+
+void* pvalloc(size_t size) noexcept
+{
+  count_allocation(size);
+  return __libc_pvalloc(size);
+}
+
+} // extern "C"
+
+#endif // UTIL_ALLOCATION_COUNTING
@@ -0,0 +1,109 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file AllocationCounter.h Counters of the heap allocations of the current thread and of the whole program.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+/*
+ * Counts the heap allocations of a program, in order to check that hot paths
+ * don't allocate, and to report the allocations done by a benchmark.
+ *
+ * The counting is done by AllocationCounter.cxx, which replaces malloc, calloc,
+ * realloc, free and the aligned allocation functions of glibc by functions that
+ * count and then call the glibc implementation. Since operator new calls malloc,
+ * every allocation with new is counted too, as well as those of glib. Only link
+ * AllocationCounter.cxx into test programs and benchmarks, never into a library.
+ *
+ * Nothing is replaced when compiled with libcwd's memory allocation debugging or
+ * with AddressSanitizer, which have their own malloc, or without glibc; the
+ * counters then stay zero and counting() returns false.
+ *
+ * Usage:
+ *
+ *   util::allocation::Scope scope;			// Or Scope scope(util::allocation::all_threads);
+ *   chess_position.execute(move);
+ *   if (scope.counts().allocations != 0) ...
+ */
+
+#include <cstdint>
+
+namespace util {
+namespace allocation {
+
+//! The number of allocations and deallocations, and the number of bytes that were requested.
+struct Counts {
+  uint64_t allocations = 0;		//!< The number of calls to malloc, calloc, realloc and the aligned allocation functions.
+  uint64_t bytes = 0;			//!< The total number of bytes requested by those calls.
+  uint64_t deallocations = 0;		//!< The number of calls to free (with a non-NULL pointer).
+
+  Counts& operator-=(Counts const& counts)
+  {
+    allocations -= counts.allocations;
+    bytes -= counts.bytes;
+    deallocations -= counts.deallocations;
+    return *this;
+  }
+
+  friend Counts operator-(Counts lhs, Counts const& rhs) { return lhs -= rhs; }
+};
+
+//! Return TRUE when the allocations of this program are being counted.
+bool counting();
+
+//! Return the counts of the calling thread since it started.
+Counts this_thread_counts();
+
+//! Return the counts of all threads together since the program started.
+Counts all_threads_counts();
+
+//! Which allocations a Scope counts.
+enum scope_type {
+  this_thread,			//!< Only those of the thread that created the Scope.
+  all_threads			//!< Those of every thread; use this when the work is done by other threads.
+};
+
+/** @brief Counts the allocations from construction until counts() is called.
+ *
+ * A Scope of type this_thread must be used by the thread that created it.
+ */
+class Scope {
+  private:
+    scope_type M_type;
+    Counts M_start;
+
+  public:
+    //! Start counting the allocations of \a type.
+    Scope(scope_type type = this_thread) : M_type(type), M_start(current()) { }
+
+    //! Return the counts since construction or the last restart().
+    Counts counts() const { return current() - M_start; }
+
+    //! Start counting from zero again.
+    void restart() { M_start = current(); }
+
+  private:
+    Counts current() const { return M_type == this_thread ? this_thread_counts() : all_threads_counts(); }
+};
+
+} // namespace allocation
+} // namespace util
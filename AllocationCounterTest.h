@@ -0,0 +1,199 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file AllocationCounterTest.h Testsuite for util::allocation and the hot paths that may not allocate.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "AllocationCounter.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class AllocationCounterTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(AllocationCounterTest);
+
+  CPPUNIT_TEST(testCounting);
+  CPPUNIT_TEST(testThreads);
+  CPPUNIT_TEST(testMoveGeneration);
+  CPPUNIT_TEST(testExecute);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    AllocationCounterTest() { }
+
+    void testCounting();
+    void testThreads();
+    void testMoveGeneration();
+    void testExecute();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "ChessPosition.h"
+#include "PieceIterator.h"
+#include "MoveIterator.h"
+#include "Benchmark.h"
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(AllocationCounterTest);
+
+namespace {
+
+char const* const allocation_test_FENs[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3"
+};
+
+std::vector<cwchess::ChessPosition> allocation_test_positions()
+{
+  std::vector<cwchess::ChessPosition> positions;
+  for (char const* FEN : allocation_test_FENs)
+  {
+    positions.emplace_back();
+    CPPUNIT_ASSERT(positions.back().load_FEN(FEN));
+  }
+  return positions;
+}
+
+} // namespace
+
+void AllocationCounterTest::testCounting()
+{
+  using namespace util::allocation;
+  if (!counting())
+    return;
+
+  Scope scope;
+  std::unique_ptr<char[]> buffer(new char[1000]);
+  util::benchmark::do_not_optimize(buffer.get());
+  Counts counts = scope.counts();
+  CPPUNIT_ASSERT(counts.allocations == 1 && counts.bytes == 1000 && counts.deallocations == 0);
+  buffer.reset();
+  CPPUNIT_ASSERT(scope.counts().deallocations == 1);
+
+  scope.restart();
+  void* ptr = std::malloc(10);
+  util::benchmark::do_not_optimize(ptr);
+  ptr = std::realloc(ptr, 100);
+  util::benchmark::do_not_optimize(ptr);
+  std::free(ptr);
+  counts = scope.counts();
+  CPPUNIT_ASSERT(counts.allocations == 2 && counts.bytes == 110 && counts.deallocations == 2);
+
+  scope.restart();
+  CPPUNIT_ASSERT(scope.counts().allocations == 0);
+}
+
+void AllocationCounterTest::testThreads()
+{
+  using namespace util::allocation;
+  if (!counting())
+    return;
+
+  Scope this_thread_scope;
+  Scope all_threads_scope(all_threads);
+  uint64_t other_thread_allocations = 0;
+  std::thread thread([&other_thread_allocations](){
+    Scope scope;
+    std::vector<int> v(1000);
+    util::benchmark::do_not_optimize(v.data());
+    other_thread_allocations = scope.counts().allocations;
+  });
+  thread.join();
+  // Only the vector; not what this thread allocated to start it.
+  CPPUNIT_ASSERT(other_thread_allocations == 1);
+  CPPUNIT_ASSERT(all_threads_scope.counts().allocations >= this_thread_scope.counts().allocations + other_thread_allocations);
+}
+
+void AllocationCounterTest::testMoveGeneration()
+{
+  using namespace cwchess;
+  std::vector<ChessPosition> positions(allocation_test_positions());
+  MoveIterator const move_end;
+  size_t moves = 0;
+  util::allocation::Scope scope;
+  for (ChessPosition const& chess_position : positions)
+  {
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+      {
+        util::benchmark::do_not_optimize(*move_iter);
+	++moves;
+      }
+    util::benchmark::do_not_optimize(chess_position.check());
+  }
+  CPPUNIT_ASSERT(scope.counts().allocations == 0);
+  CPPUNIT_ASSERT(moves > 100);
+}
+
+void AllocationCounterTest::testExecute()
+{
+  using namespace cwchess;
+  std::vector<ChessPosition> positions(allocation_test_positions());
+  std::vector<Move> moves;
+  std::vector<size_t> first_move;
+  MoveIterator const move_end;
+  for (ChessPosition const& chess_position : positions)
+  {
+    first_move.push_back(moves.size());
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+	moves.push_back(*move_iter);
+  }
+  first_move.push_back(moves.size());
+
+  // Includes captures, promotions, castling and en passant.
+  util::allocation::Scope scope;
+  for (size_t i = 0; i < positions.size(); ++i)
+    for (size_t m = first_move[i]; m < first_move[i + 1]; ++m)
+    {
+      ChessPosition chess_position(positions[i]);
+      util::benchmark::do_not_optimize(chess_position.execute(moves[m]));
+      util::benchmark::do_not_optimize(chess_position);
+    }
+  // The SAN of the moves that are played from the initial position in a PGN database.
+  ChessPosition chess_position(positions[0]);
+  for (char const* SAN : { "e4", "c5", "Nf3", "d6", "d4", "cxd4", "Nxd4", "Nf6", "Nc3", "a6" })
+  {
+    Move move;
+    CPPUNIT_ASSERT(chess_position.parse_SAN(SAN, move));
+    chess_position.execute(move);
+  }
+  CPPUNIT_ASSERT(scope.counts().allocations == 0);
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,131 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file Benchmark.h This file contains the measuring part of the benchmark programs.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "AllocationCounter.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace util {
+namespace benchmark {
+
+//! Make the compiler believe that \a value is used.
+template<typename T>
+inline void do_not_optimize(T const& value)
+{
+  asm volatile("" : : "r,m" (value) : "memory");
+}
+
+//! A benchmark function does its work once and returns the number of operations it did.
+typedef std::function<size_t ()> function_type;
+
+//! The runtime settings of measure.
+struct Options {
+  int samples = 15;			//!< The number of timed samples.
+  double min_sample_time = 0.02;	//!< The minimum duration of a sample in seconds, if iterations is zero.
+  size_t iterations = 0;		//!< The number of calls per sample, or zero to calibrate with min_sample_time.
+};
+
+//! The result of measure. All times are in nanoseconds per operation.
+struct Result {
+  size_t operations;			//!< The number of operations per call of the benchmark function.
+  size_t iterations;			//!< The number of calls per sample.
+  std::vector<double> samples;		//!< The time per operation of each sample.
+  double min, median, mean, stddev;
+  double allocations;			//!< The number of heap allocations per operation, by all threads.
+  double bytes_allocated;		//!< The number of bytes allocated per operation.
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+//! Return the number of seconds that \a iterations calls of \a function take.
+inline double run(function_type const& function, size_t iterations)
+{
+  clock_type::time_point start = clock_type::now();
+  for (size_t i = 0; i < iterations; ++i)
+    do_not_optimize(function());
+  return std::chrono::duration<double>(clock_type::now() - start).count();
+}
+
+/** @brief Measure the time per operation of \a function.
+ *
+ * Unless Options::iterations is set, the number of calls per sample is first
+ * doubled until a sample takes long enough. One untimed warm-up sample is
+ * followed by Options::samples timed samples, of which the minimum, median,
+ * mean and (sample) standard deviation are returned.
+ *
+ * Finally one more, untimed, call counts the heap allocations that the function
+ * does once it is warmed up. The program must be linked with AllocationCounter.cxx;
+ * see AllocationCounter.h.
+ */
+inline Result measure(function_type const& function, Options const& options)
+{
+  Result result;
+  result.operations = function();
+
+  size_t iterations = options.iterations;
+  if (iterations == 0)
+  {
+    iterations = 1;
+    double seconds;
+    while ((seconds = run(function, iterations)) < options.min_sample_time / 4)
+      iterations *= 2;
+    iterations = std::max(size_t(1), size_t(std::ceil(iterations * options.min_sample_time / seconds)));
+  }
+  result.iterations = iterations;
+
+  run(function, iterations);		// Warm-up.
+  double const operations = double(iterations) * std::max(size_t(1), result.operations);
+  for (int sample = 0; sample < options.samples; ++sample)
+    result.samples.push_back(run(function, iterations) * 1e9 / operations);
+
+  std::vector<double> sorted(result.samples);
+  std::sort(sorted.begin(), sorted.end());
+  size_t n = sorted.size();
+  result.min = sorted[0];
+  result.median = (n % 2) ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2;
+  double sum = 0;
+  for (double ns : sorted)
+    sum += ns;
+  result.mean = sum / n;
+  double sum_of_squares = 0;
+  for (double ns : sorted)
+    sum_of_squares += (ns - result.mean) * (ns - result.mean);
+  result.stddev = n > 1 ? std::sqrt(sum_of_squares / (n - 1)) : 0.0;
+
+  allocation::Scope scope(allocation::all_threads);
+  size_t const counted_operations = std::max(size_t(1), function());
+  allocation::Counts const counts = scope.counts();
+  result.allocations = double(counts.allocations) / counted_operations;
+  result.bytes_allocated = double(counts.bytes) / counted_operations;
+  return result;
+}
+
+} // namespace benchmark
+} // namespace util
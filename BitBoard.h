@@ -43,7 +43,7 @@ namespace cwchess {
  */
 typedef uint64_t mask_t;
 
-#define CW_MASK_T_CONST(k) k
+#define CW_MASK_T_CONST(k) UINT64_C(k)
 
 /** @brief Convert Index to a mask_t. */
 inline mask_t index2mask(Index index)
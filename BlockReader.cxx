@@ -0,0 +1,345 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file BlockReader.cxx This file contains the implementation of class BlockReader.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "BlockReader.h"
+#include "debug.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib.h>
+#ifdef HAVE_LINUX_IO_URING_H
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace util {
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+// A minimal io_uring, using the system calls directly.
+struct BlockReader::Ring {
+  int fd;				// The file descriptor of the ring.
+  unsigned int* sq_tail;
+  unsigned int* sq_mask;
+  unsigned int* sq_array;
+  unsigned int* cq_head;
+  unsigned int* cq_tail;
+  unsigned int* cq_mask;
+  io_uring_cqe* cqes;
+  io_uring_sqe* sqes;
+  void* sq_map;
+  size_t sq_map_size;
+  void* cq_map;				// Equal to sq_map with IORING_FEAT_SINGLE_MMAP.
+  size_t cq_map_size;
+  size_t sqes_size;
+  unsigned int unsubmitted;		// The number of prepared submission queue entries.
+
+  static Ring* create(unsigned int entries);
+  ~Ring();
+
+  void prepare_read(int file_fd, char* buf, unsigned int len, uint64_t offset, uint64_t user_data);
+  bool enter(unsigned int min_complete);
+  bool pop(uint64_t& user_data, int& res);
+};
+
+BlockReader::Ring* BlockReader::Ring::create(unsigned int entries)
+{
+  io_uring_params params;
+  std::memset(&params, 0, sizeof(params));
+  int fd = syscall(__NR_io_uring_setup, entries, &params);
+  if (fd == -1)
+  {
+    Dout(dc::notice, "io_uring_setup failed: " << std::strerror(errno));
+    return NULL;
+  }
+  Ring* ring = new Ring;
+  ring->fd = fd;
+  ring->unsubmitted = 0;
+  ring->sq_map_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+  ring->cq_map_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP)
+    ring->sq_map_size = ring->cq_map_size = std::max(ring->sq_map_size, ring->cq_map_size);
+  ring->sq_map = mmap(NULL, ring->sq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+  ring->cq_map = ring->sq_map;
+  if (ring->sq_map != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP))
+    ring->cq_map = mmap(NULL, ring->cq_map_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+  ring->sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+  void* sqes = MAP_FAILED;
+  if (ring->cq_map != MAP_FAILED)
+    sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+  if (sqes == MAP_FAILED)
+  {
+    if (ring->cq_map != MAP_FAILED && ring->cq_map != ring->sq_map)
+      munmap(ring->cq_map, ring->cq_map_size);
+    if (ring->sq_map != MAP_FAILED)
+      munmap(ring->sq_map, ring->sq_map_size);
+    ::close(fd);
+    delete ring;
+    return NULL;
+  }
+  char* sq = static_cast<char*>(ring->sq_map);
+  char* cq = static_cast<char*>(ring->cq_map);
+  ring->sq_tail = reinterpret_cast<unsigned int*>(sq + params.sq_off.tail);
+  ring->sq_mask = reinterpret_cast<unsigned int*>(sq + params.sq_off.ring_mask);
+  ring->sq_array = reinterpret_cast<unsigned int*>(sq + params.sq_off.array);
+  ring->cq_head = reinterpret_cast<unsigned int*>(cq + params.cq_off.head);
+  ring->cq_tail = reinterpret_cast<unsigned int*>(cq + params.cq_off.tail);
+  ring->cq_mask = reinterpret_cast<unsigned int*>(cq + params.cq_off.ring_mask);
+  ring->cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+  ring->sqes = static_cast<io_uring_sqe*>(sqes);
+  return ring;
+}
+
+BlockReader::Ring::~Ring()
+{
+  munmap(sqes, sqes_size);
+  if (cq_map != sq_map)
+    munmap(cq_map, cq_map_size);
+  munmap(sq_map, sq_map_size);
+  ::close(fd);
+}
+
+void BlockReader::Ring::prepare_read(int file_fd, char* buf, unsigned int len, uint64_t offset, uint64_t user_data)
+{
+  // Only this thread writes the tail.
+  unsigned int tail = *sq_tail;
+  unsigned int index = tail & *sq_mask;
+  io_uring_sqe* sqe = &sqes[index];
+  std::memset(sqe, 0, sizeof(*sqe));
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = file_fd;
+  sqe->addr = reinterpret_cast<uintptr_t>(buf);
+  sqe->len = len;
+  sqe->off = offset;
+  sqe->user_data = user_data;
+  sq_array[index] = index;
+  __atomic_store_n(sq_tail, tail + 1, __ATOMIC_RELEASE);
+  ++unsubmitted;
+}
+
+// Submit the prepared entries and wait until at least min_complete entries completed.
+bool BlockReader::Ring::enter(unsigned int min_complete)
+{
+  for (;;)
+  {
+    int submitted = syscall(__NR_io_uring_enter, fd, unsubmitted, min_complete, min_complete ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+    if (submitted >= 0)
+    {
+      unsubmitted -= submitted;
+      return true;
+    }
+    if (errno != EINTR)
+      return false;
+  }
+}
+
+// Remove the next completion queue entry, if any.
+bool BlockReader::Ring::pop(uint64_t& user_data, int& res)
+{
+  unsigned int head = *cq_head;
+  if (head == __atomic_load_n(cq_tail, __ATOMIC_ACQUIRE))
+    return false;
+  io_uring_cqe const& cqe(cqes[head & *cq_mask]);
+  user_data = cqe.user_data;
+  res = cqe.res;
+  __atomic_store_n(cq_head, head + 1, __ATOMIC_RELEASE);
+  return true;
+}
+
+#else // HAVE_LINUX_IO_URING_H
+
+struct BlockReader::Ring {
+  static Ring* create(unsigned int) { return NULL; }
+  void prepare_read(int, char*, unsigned int, uint64_t, uint64_t) { }
+  bool enter(unsigned int) { return false; }
+  bool pop(uint64_t&, int&) { return false; }
+};
+
+#endif // HAVE_LINUX_IO_URING_H
+
+bool BlockReader::open(std::string const& filename, Options const& options)
+{
+  DoutEntering(dc::notice, "BlockReader::open(\"" << filename << "\", {" << options.block_size << ", " << options.queue_depth << ", " << options.direct << "})");
+  close();
+  M_direct = false;
+  if (options.direct)
+  {
+    M_fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC | O_DIRECT);
+    M_direct = M_fd != -1;
+  }
+  if (M_fd == -1)
+    M_fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat sb;
+  if (M_fd == -1 || fstat(M_fd, &sb) == -1 || !S_ISREG(sb.st_mode))
+  {
+    close();
+    return false;
+  }
+  M_file_size = sb.st_size;
+  M_block_size = std::max(options.block_size, size_t(1));
+  if (M_direct)
+  {
+    size_t const page_size = sysconf(_SC_PAGESIZE);
+    M_block_size = (M_block_size + page_size - 1) / page_size * page_size;
+  }
+  else
+    posix_fadvise(M_fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  M_number_of_blocks = (M_file_size + M_block_size - 1) / M_block_size;
+  unsigned int queue_depth = std::max(options.queue_depth, 1U);
+  M_slots.resize(queue_depth);
+  M_results.resize(queue_depth, -EINPROGRESS);
+  M_ring = Ring::create(queue_depth);
+  Dout(dc::notice, "Reading " << M_number_of_blocks << " blocks of " << M_block_size << " bytes " <<
+      (M_ring ? "with io_uring" : "with pread") << (M_direct ? " and O_DIRECT." : "."));
+  submit();
+  return true;
+}
+
+void BlockReader::close()
+{
+  if (M_ring)
+  {
+    // The kernel may still be writing into the blocks in flight.
+    while (M_in_flight > 0 && wait_for_completion())
+      ;
+    delete M_ring;
+    M_ring = NULL;
+  }
+  M_slots.clear();
+  M_results.clear();
+  if (M_fd != -1)
+    ::close(M_fd);
+  M_fd = -1;
+  M_file_size = 0;
+  M_error = false;
+  M_next_block = 0;
+  M_submitted_blocks = 0;
+  M_number_of_blocks = 0;
+  M_in_flight = 0;
+}
+
+// Keep the queue filled with reads.
+void BlockReader::submit()
+{
+  if (!M_ring)
+    return;
+  size_t const queue_depth = M_slots.size();
+  while (M_submitted_blocks < M_number_of_blocks && M_submitted_blocks - M_next_block < queue_depth)
+  {
+    size_t slot = M_submitted_blocks % queue_depth;
+    M_slots[slot] = M_direct ? MemoryBlockNode::create_page_aligned(M_block_size) : MemoryBlockNode::create(M_block_size);
+    M_results[slot] = -EINPROGRESS;
+    ++M_in_flight;
+    M_ring->prepare_read(M_fd, M_slots[slot]->block_begin(), M_block_size, M_submitted_blocks * M_block_size, slot);
+    ++M_submitted_blocks;
+  }
+  if (G_UNLIKELY(!M_ring->enter(0)))
+    M_error = true;
+}
+
+// Wait for at least one read to complete and store the results.
+bool BlockReader::wait_for_completion()
+{
+  if (G_UNLIKELY(!M_ring->enter(1)))
+  {
+    M_error = true;
+    return false;
+  }
+  uint64_t slot;
+  int res;
+  while (M_ring->pop(slot, res))
+  {
+    M_results[slot] = res;
+    --M_in_flight;
+  }
+  return true;
+}
+
+// Complete a short read of the block in slot, of which len bytes were read.
+ssize_t BlockReader::read_rest(size_t slot, size_t len)
+{
+  size_t const size = std::min(uint64_t(M_block_size), M_file_size - M_next_block * M_block_size);
+  while (len < size)
+  {
+    // O_DIRECT requires the length to be a multiple of the logical block size; ask for the whole block then.
+    size_t const count = (M_direct ? M_block_size : size) - len;
+    ssize_t n = pread(M_fd, M_slots[slot]->block_begin() + len, count, M_next_block * M_block_size + len);
+    if (n == -1 && errno == EINTR)
+      continue;
+    if (n == -1)
+      return -1;
+    if (n == 0)		// The file was truncated.
+      break;
+    len += n;
+  }
+  return len;
+}
+
+ssize_t BlockReader::read(Glib::RefPtr<MemoryBlockNode>& block)
+{
+  if (G_UNLIKELY(M_error))
+    return -1;
+  if (M_next_block == M_number_of_blocks)
+    return 0;
+  size_t slot = M_next_block % M_slots.size();
+  ssize_t len;
+  if (M_ring)
+  {
+    while (M_results[slot] == -EINPROGRESS)
+      if (!wait_for_completion())
+	return -1;
+    len = M_results[slot];
+    if (G_UNLIKELY(len == -EINTR || len == -EAGAIN))
+      len = 0;
+    else if (G_UNLIKELY(len < 0))
+    {
+      Dout(dc::warning, "io_uring read failed: " << std::strerror(-len));
+      M_error = true;
+      return -1;
+    }
+  }
+  else
+  {
+    M_slots[slot] = M_direct ? MemoryBlockNode::create_page_aligned(M_block_size) : MemoryBlockNode::create(M_block_size);
+    len = 0;
+  }
+  len = read_rest(slot, len);
+  if (G_UNLIKELY(len <= 0))
+  {
+    M_error = len == -1;
+    M_number_of_blocks = M_next_block;
+    return len;
+  }
+  block.swap(M_slots[slot]);
+  M_slots[slot].reset();
+  ++M_next_block;
+  submit();
+  return len;
+}
+
+} // namespace util
@@ -0,0 +1,128 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file BlockReader.h This file contains the declaration of class BlockReader.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "MemoryBlockList.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace util {
+
+/** @brief Sequential reader of a file into MemoryBlockNode objects.
+ *
+ * The file is read in blocks of Options::block_size bytes, with up to
+ * Options::queue_depth reads in flight at the same time, which is what
+ * fast SSDs need to reach their bandwidth. The reads are submitted with
+ * io_uring when the kernel supports it (and this was compiled with
+ * HAVE_LINUX_IO_URING_H); otherwise one block at a time is read with pread(2).
+ *
+ * With Options::direct the file is opened with O_DIRECT, bypassing the
+ * page cache. The block size is then rounded up to a multiple of the page size
+ * and the data of each block is page aligned. If the file system doesn't support
+ * O_DIRECT, the file is read normally.
+ *
+ * Usage example:
+ * \code
+ * util::BlockReader reader;
+ * if (reader.open("games.pgn", util::BlockReader::Options(1024 * 1024, 8)))
+ *   while ((len = reader.read(block)) > 0)
+ *     process(block->block_begin(), len);
+ * \endcode
+ */
+class BlockReader {
+  public:
+    //! The runtime settings of a BlockReader.
+    struct Options {
+      size_t block_size;		//!< The number of bytes per read.
+      unsigned int queue_depth;		//!< The maximum number of reads in flight.
+      bool direct;			//!< Set to bypass the page cache with O_DIRECT.
+
+      //! Construct options for reading blocks of \a block_size_ bytes.
+      Options(size_t block_size_, unsigned int queue_depth_ = 4, bool direct_ = false) :
+          block_size(block_size_), queue_depth(queue_depth_), direct(direct_) { }
+    };
+
+  private:
+    struct Ring;
+
+    int M_fd;					//!< The file descriptor of the file, or -1.
+    uint64_t M_file_size;			//!< The size of the file.
+    size_t M_block_size;			//!< The (possibly rounded up) block size.
+    bool M_direct;				//!< Set when the file was opened with O_DIRECT.
+    bool M_error;				//!< Set when reading failed.
+    Ring* M_ring;				//!< The io_uring, or NULL when pread is used.
+    std::vector<Glib::RefPtr<MemoryBlockNode>> M_slots;	//!< Blocks in flight, indexed by block number modulo the queue depth.
+    std::vector<ssize_t> M_results;		//!< The result of each slot; -EINPROGRESS while the read is in flight.
+    uint64_t M_next_block;			//!< The block number of the next block that read returns.
+    uint64_t M_submitted_blocks;		//!< The number of blocks that were submitted.
+    uint64_t M_number_of_blocks;		//!< The number of blocks in the file.
+    unsigned int M_in_flight;			//!< The number of submitted reads that didn't complete yet.
+
+  public:
+    //! Construct a closed reader.
+    BlockReader() : M_fd(-1), M_file_size(0), M_block_size(0), M_direct(false), M_error(false), M_ring(NULL),
+        M_next_block(0), M_submitted_blocks(0), M_number_of_blocks(0), M_in_flight(0) { }
+    ~BlockReader() { close(); }
+
+    BlockReader(BlockReader const&) = delete;
+    BlockReader& operator=(BlockReader const&) = delete;
+
+    /** @brief Open \a filename for reading with \a options and start reading the first blocks.
+     *
+     * @returns FALSE if the file could not be opened or isn't a regular file.
+     */
+    bool open(std::string const& filename, Options const& options);
+
+    //! Wait for reads in flight and close the file.
+    void close();
+
+    /** @brief Return the next block of the file in \a block.
+     *
+     * @returns The number of valid bytes in \a block, 0 at the end of the file or -1 on error.
+     */
+    ssize_t read(Glib::RefPtr<MemoryBlockNode>& block);
+
+    //! Return TRUE if io_uring is used.
+    bool uses_io_uring() const { return M_ring; }
+
+    //! Return TRUE if the page cache is bypassed.
+    bool uses_direct_io() const { return M_direct; }
+
+    //! Return the block size in use.
+    size_t block_size() const { return M_block_size; }
+
+    //! Return the size of the file.
+    uint64_t file_size() const { return M_file_size; }
+
+    //! Return TRUE if reading failed.
+    bool error() const { return M_error; }
+
+  private:
+    void submit();
+    bool wait_for_completion();
+    ssize_t read_rest(size_t slot, size_t len);
+};
+
+} // namespace util
@@ -0,0 +1,150 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file BlockReaderTest.h Testsuite for util::BlockReader.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "BlockReader.h"
+#include "TempFile.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include <memory>
+
+namespace testsuite {
+
+class BlockReaderTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(BlockReaderTest);
+
+  CPPUNIT_TEST(testRead);
+  CPPUNIT_TEST(testDirect);
+  CPPUNIT_TEST(testEmptyAndMissing);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    std::string M_text;
+    std::unique_ptr<TempFile> M_file;
+
+    std::string const& filename() const { return M_file->filename(); }
+
+  public:
+    BlockReaderTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testRead();
+    void testDirect();
+    void testEmptyAndMissing();
+
+  private:
+    std::string read_all(util::BlockReader::Options const& options, bool& direct);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <random>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(BlockReaderTest);
+
+void BlockReaderTest::setUp()
+{
+  // A file that isn't a multiple of any of the block sizes used.
+  std::mt19937 random_number_generator(2718281828);
+  M_text.resize(3 * 1024 * 1024 + 12345);
+  for (char& c : M_text)
+    c = 'a' + random_number_generator() % 26;
+  M_file.reset(new TempFile("BlockReaderTest", M_text));
+  M_file->close();
+}
+
+void BlockReaderTest::tearDown()
+{
+  M_file.reset();
+  M_text.clear();
+}
+
+std::string BlockReaderTest::read_all(util::BlockReader::Options const& options, bool& direct)
+{
+  util::BlockReader reader;
+  CPPUNIT_ASSERT(reader.open(filename(), options));
+  CPPUNIT_ASSERT(reader.file_size() == M_text.size());
+  direct = reader.uses_direct_io();
+  std::string result;
+  Glib::RefPtr<util::MemoryBlockNode> block;
+  ssize_t len;
+  while ((len = reader.read(block)) > 0)
+  {
+    CPPUNIT_ASSERT(size_t(len) <= reader.block_size());
+    result.append(block->block_begin(), len);
+    if (direct)
+      CPPUNIT_ASSERT(reinterpret_cast<uintptr_t>(block->block_begin()) % sysconf(_SC_PAGESIZE) == 0);
+  }
+  CPPUNIT_ASSERT(len == 0 && !reader.error());
+  CPPUNIT_ASSERT(reader.read(block) == 0);
+  return result;
+}
+
+void BlockReaderTest::testRead()
+{
+  bool direct;
+  for (size_t block_size : { size_t(1000), size_t(6 * 4096 - 64), size_t(1024 * 1024) })
+    for (unsigned int queue_depth : { 1, 3, 16 })
+      CPPUNIT_ASSERT(read_all(util::BlockReader::Options(block_size, queue_depth), direct) == M_text && !direct);
+
+  // Stop reading half way; the reads in flight are waited for.
+  util::BlockReader reader;
+  CPPUNIT_ASSERT(reader.open(filename(), util::BlockReader::Options(4096, 32)));
+  Glib::RefPtr<util::MemoryBlockNode> block;
+  CPPUNIT_ASSERT(reader.read(block) == 4096 && M_text.compare(0, 4096, block->block_begin(), 4096) == 0);
+  reader.close();
+}
+
+void BlockReaderTest::testDirect()
+{
+  // Falls back to cached reads on file systems that don't support O_DIRECT.
+  bool direct;
+  CPPUNIT_ASSERT(read_all(util::BlockReader::Options(100000, 4, true), direct) == M_text);
+  CPPUNIT_ASSERT(read_all(util::BlockReader::Options(1024 * 1024, 2, true), direct) == M_text);
+}
+
+void BlockReaderTest::testEmptyAndMissing()
+{
+  util::BlockReader reader;
+  CPPUNIT_ASSERT(!reader.open("/nonexistent/file.pgn", util::BlockReader::Options(4096)));
+  CPPUNIT_ASSERT(!reader.open("/tmp", util::BlockReader::Options(4096)));
+  int fd = open(filename().c_str(), O_WRONLY | O_TRUNC);
+  close(fd);
+  CPPUNIT_ASSERT(reader.open(filename(), util::BlockReader::Options(4096)));
+  Glib::RefPtr<util::MemoryBlockNode> block;
+  CPPUNIT_ASSERT(reader.read(block) == 0 && !block && !reader.error());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -25,6 +25,7 @@
 #include "ChessPosition.h"
 #include "Direction.h"
 #include "ChessNotation.h"
+#include "ProfileCounters.h"
 #include "debug.h"
 #include <sstream>
 #include <cassert>
@@ -46,9 +47,11 @@ std::string EnPassant::FEN4() const
 void ChessPosition::clear_en_passant()
 {
   Index index = M_en_passant.pawn_index();
-  if (index > ih1 && piece_at(index - 1) == pawn)
+  // Only pawns of the other color could take en passant (see set_en_passant).
+  Code code((M_en_passant.index().row() == 2) ? black_pawn : white_pawn);
+  if (index > ih1 && M_pieces[index - 1] == code)
     M_pieces[index - 1].reset_can_take_king_side();
-  if (index < ia8 && piece_at(index + 1) == pawn)
+  if (index < ia8 && M_pieces[index + 1] == code)
     M_pieces[index + 1].reset_can_take_queen_side();
   M_en_passant.clear();
 }
@@ -73,8 +76,6 @@ void ChessPosition::clear()
   M_pinning[white].reset();
   M_defended[black].reset();
   M_defended[white].reset();
-  M_king_battery_attack_count[black] = 0;
-  M_king_battery_attack_count[white] = 0;
   M_double_check = false;
 }
 
@@ -166,6 +167,8 @@ void ChessPosition::swap_colors()
 // pawns on the board.
 void ChessPosition::update_removed(uint8_t col, uint8_t row, Color const& color)
 {
+  CWCHESS_PROFILE(update_removed);
+
   // A piece was removed from (col, row).
   // We have to update possible pawns on (col - 1, row +/- 1) and (col + 1, row +/- 1).
   bool ok;
@@ -204,6 +207,8 @@ void ChessPosition::update_removed(uint8_t col, uint8_t row, Color const& color)
 // pawns on the board.
 void ChessPosition::update_placed(uint8_t col, uint8_t row, Color const& color)
 {
+  CWCHESS_PROFILE(update_placed);
+
   // A piece was placed at (col, row).
   // We have to update possible pawns on (col - 1, row +/- 1) and (col + 1, row +/- 1).
   bool ok;
@@ -247,6 +252,7 @@ void ChessPosition::update_placed(uint8_t col, uint8_t row, Color const& color)
 //
 void ChessPosition::update_pinning(Code const& code, Index const& index, mask_t mask, Direction const& direction, BitBoard const& relevant_pieces)
 {
+  CWCHESS_PROFILE(update_pinning);
   bool king_side_is_msb = (relevant_pieces() < mask);	// This means that the most significant bit is on the side of the king.
   // Run over all pieces, starting at the side of the king.
   PieceIterator piece_iter = king_side_is_msb ? PieceIterator(this, relevant_pieces, 0) : PieceIterator(this, relevant_pieces);
@@ -311,10 +317,29 @@ void ChessPosition::update_pinning(Code const& code, Index const& index, mask_t
   }
 }
 
+// This function recalculates the part of M_attackers for the color of the king at \a king_index
+// that lies in the direction \a direction from the king.
+void ChessPosition::update_attackers(Color const& color, Index const& king_index, Direction const& direction)
+{
+  TypeData mover;
+  mover.M_bits = direction.flags & type_mask;
+  Code queen_code(color.opposite(), queen);
+  Code mover_code(color.opposite(), mover);
+  BitBoard mover_attackers(M_bitboards[mover_code] | M_bitboards[queen_code]);
+  BitBoard line(direction.from(king_index));
+  mover_attackers &= line;
+  BitBoard attackers(CW_MASK_T_CONST(0));
+  for (PieceIterator piece_iter(this, mover_attackers); piece_iter != piece_end(); ++piece_iter)
+    attackers |= squares_from_to(piece_iter.index(), king_index);
+  M_attackers[color].reset(line);
+  M_attackers[color].set(attackers);
+}
+
 // This function updates M_pieces and M_bitboards.
 bool ChessPosition::place(Code const& code, Index const& index)
 {
   DoutEntering(dc::place, "ChessPosition::place(" << code << ", " << index << ")");
+  CWCHESS_PROFILE(place);
 
   // Refuse to place pawns on row 1 or 8.
   if (code.is_a(pawn))
@@ -388,14 +413,11 @@ bool ChessPosition::place(Code const& code, Index const& index)
       M_attackers[old_code].reset();
       M_pinning[old_code].reset();
       M_en_passant.pinned_reset();
-      M_king_battery_attack_count[old_code.color().opposite()] = 0;
     }
 
     // Update the M_defended CountBoard.
-    bool battery = false;
+    bool battery;
     M_defended[old_code.color()].sub(defendables(old_code, index, battery));
-    if (battery)
-      --M_king_battery_attack_count[old_code.color()];
     update_blocked_defendables(old_code, index, true);
   }
 
@@ -464,10 +486,8 @@ bool ChessPosition::place(Code const& code, Index const& index)
     }
 
     // Update the M_defended CountBoard.
-    bool battery = false;
+    bool battery;
     M_defended[code.color()].add(defendables(code, index, battery));
-    if (battery)
-      ++M_king_battery_attack_count[code.color()];
     update_blocked_defendables(code, index, false);
   }
 
@@ -708,18 +728,7 @@ bool ChessPosition::place(Code const& code, Index const& index)
 	if (direction.matches(old_code.type()))
 	{
 	  // An attacker was removed. Check if M_attackers needs to be changed.
-	  TypeData mover;
-	  mover.M_bits = direction.flags & type_mask;
-	  Code queen_code(color.opposite(), queen);
-	  Code mover_code(color.opposite(), mover);
-	  BitBoard mover_attackers(M_bitboards[mover_code] | M_bitboards[queen_code]);
-	  BitBoard line(direction.from(king_index));
-	  mover_attackers &= line;
-	  BitBoard attackers(CW_MASK_T_CONST(0));
-	  for (PieceIterator piece_iter(this, mover_attackers); piece_iter != piece_end(); ++piece_iter)
-	    attackers |= squares_from_to(piece_iter.index(), king_index);
-	  M_attackers[color].reset(line);
-	  M_attackers[color].set(attackers);
+	  update_attackers(color, king_index, direction);
 
 	  // We only need an update if the corresponding bit in M_pinning is set as well
 	  // (then this was the pinning attacker), or otherwise if M_pinning has no
@@ -734,18 +743,24 @@ bool ChessPosition::place(Code const& code, Index const& index)
 	  need_update = !(M_pinning[color]() & mask);
 	}
       }
-      else if ((M_pinning[color]() & mask))	// Is the corresponding bit in M_pinning set too?
-      {
-	// Case 1ba.
-	need_reset = true;
-	need_update = !old_code.is_nothing();
-      }
       else
       {
-	// Case 1bb.
-	BitBoard line(direction.from(king_index));
-	need_reset = need_update =
-	    (code.color() == color || (M_en_passant.exists() && direction.is_horizontal())) && !M_pinning[color].test(line);
+	// An attacker that is replaced by a non-attacker (it is taken) is removed as well.
+	if (!old_code.is_nothing() && old_code.color() != color && direction.matches(old_code.type()))
+	  update_attackers(color, king_index, direction);
+	if ((M_pinning[color]() & mask))	// Is the corresponding bit in M_pinning set too?
+	{
+	  // Case 1ba.
+	  need_reset = true;
+	  need_update = !old_code.is_nothing();
+	}
+	else
+	{
+	  // Case 1bb.
+	  BitBoard line(direction.from(king_index));
+	  need_reset = need_update =
+	      (code.color() == color || (M_en_passant.exists() && direction.is_horizontal())) && !M_pinning[color].test(line);
+	}
       }
     }
     if (need_reset)
@@ -1119,8 +1134,8 @@ bool ChessPosition::set_en_passant(Index const& index)
       {
 	BitBoard line(direction.from(king_index));
 	M_pinning[M_to_move].reset(line);
+	// This sets the pinned flag of M_en_passant if taking en passant would expose the king.
 	update_pinning(king_code, king_index, mask, direction, (M_bitboards[black] | M_bitboards[white]) & line);
-	M_en_passant.pinned_set();
       }
     }
   }
@@ -1316,7 +1331,7 @@ BitBoard ChessPosition::defendables(Code const& code, Index const& index, bool&
 
       result |= reachables;
 
-      // Do we need to update M_king_battery_attack_count?
+      // Do we form a battery with another piece that attacks the king?
       BitBoard opposite_king_pos(M_bitboards[Code(color.opposite(), king)]);	// The position of the opposite king.
       if (__builtin_expect(
 	  result.test(opposite_king_pos) &&		// Do we give check?
@@ -1385,7 +1400,7 @@ BitBoard ChessPosition::defendables(Code const& code, Index const& index, bool&
 
       result |= reachables;
 
-      // Do we need to update M_king_battery_attack_count?
+      // Do we form a battery with another piece that attacks the king?
       BitBoard opposite_king_pos(M_bitboards[Code(color.opposite(), king)]);	// The position of the opposite king.
       if (__builtin_expect(result.test(opposite_king_pos), false))	// Do we give check?
       {
@@ -1508,19 +1523,19 @@ BitBoard ChessPosition::defendables(Code const& code, Index const& index, bool&
 
       result |= reachables;
 
-      // Do we need to update M_king_battery_attack_count?
+      // Do we form a battery with another piece that attacks the king?
       BitBoard opposite_king_pos(M_bitboards[Code(color.opposite(), king)]);	// The position of the opposite king.
       if (__builtin_expect(result.test(opposite_king_pos), false))	// Do we give check?
       {
-	Code queen_code(color, queen);
 	Code bishop_code(color, bishop);
-	BitBoard other_attackers(other_rook_movers | M_bitboards[queen_code] | M_bitboards[bishop_code]);
+	Index king_index(mask2index(opposite_king_pos()));
+	Direction direction(direction_from_to(king_index, index));
+	// Only the pieces that move along the line to the king can form a battery with the queen.
+	BitBoard other_attackers(direction.matches(rook) ? other_rook_movers : M_bitboards[queen_code] | M_bitboards[bishop_code]);
 	if (result.test(other_attackers))				// and block or look through another attacker?
 	{
 	  // This other attacker could be on a different line than the one to the king.
 	  // So, check if it is really on the line with the king or not.
-	  Index king_index(mask2index(opposite_king_pos()));
-	  Direction direction(direction_from_to(king_index, index));
 	  BitBoard line(direction.from(king_index));	// All squares from checked king in the direction of the new attacker.
 	  line &= result;					// ... but only until the blocker on the other side.
 	  line &= other_attackers;			// ... only possible other attackers.
@@ -1536,9 +1551,9 @@ BitBoard ChessPosition::defendables(Code const& code, Index const& index, bool&
 
 // This function updates M_defended by adding or subtracting BitBoard's
 // that represent blocked squares by placing 'code' on square 'index'.
-// It also updates M_king_battery_attack_count.
 void ChessPosition::update_blocked_defendables(Code const& code, Index const& index, bool add)
 {
+  CWCHESS_PROFILE(update_blocked_defendables);
   // A bitboard with bits set on every square where there is any piece.
   BitBoard const all_pieces(M_bitboards[white] | M_bitboards[black]);
   // Calculate a bitboard with bits set for every rook and queen.
@@ -1675,19 +1690,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
       // The update of M_defended is delayed. Instead, collect all results (seperated by color).
       result[blocked_piece_color] |= blocked_squares;
 
-      // If the current_blocker is a king of opposite color of blocked_piece,
-      // then we are dealing with an attack on the king and M_king_battery_attack_count
-      // might need to be updated too.
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(rookmovers_of_same_color), false))
-      {
-        if (add)
-	  ++M_king_battery_attack_count[blocked_piece_color];
-	else
-	  --M_king_battery_attack_count[blocked_piece_color];
-      }
-
       // Call call_back_battery for each additional piece that is blocked:
       // that is north of 'blocked_piece' but 'looks through' the piece on index.
       //
@@ -1707,13 +1709,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
 	  M_defended[blocked_piece_color].add(blocked_squares);
 	else
 	  M_defended[blocked_piece_color].sub(blocked_squares);
-	if (king_attack)
-	{
-	  if (add)
-	    ++M_king_battery_attack_count[blocked_piece_color];
-	  else
-	    --M_king_battery_attack_count[blocked_piece_color];
-        }
       }
     }
   }
@@ -1745,15 +1740,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     if (blocked_squares)
     {
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(rookmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       if (blocked_piece != index_begin)
       {
 	for (blocked_piece.prev_bit_in(line()); blocked_piece != index_pre_begin && rookmovers_of_same_color.test(blocked_piece); blocked_piece.prev_bit_in(line()))
@@ -1762,13 +1748,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
 	    M_defended[blocked_piece_color].add(blocked_squares);
 	  else
 	    M_defended[blocked_piece_color].sub(blocked_squares);
-	  if (king_attack)
-	  {
-	    if (add)
-	      ++M_king_battery_attack_count[blocked_piece_color];
-	    else
-	      --M_king_battery_attack_count[blocked_piece_color];
-	  }
 	  if (blocked_piece == index_begin)
 	    break;
 	}
@@ -1802,28 +1781,12 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     if (blocked_squares)
     {
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(rookmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       for (blocked_piece.next_bit_in(line()); blocked_piece != index_end && rookmovers_of_same_color.test(blocked_piece); blocked_piece.next_bit_in(line()))
       {
 	if (add)
 	  M_defended[blocked_piece_color].add(blocked_squares);
 	else
 	  M_defended[blocked_piece_color].sub(blocked_squares);
-	if (king_attack)
-	{
-	  if (add)
-	    ++M_king_battery_attack_count[blocked_piece_color];
-	  else
-	    --M_king_battery_attack_count[blocked_piece_color];
-	}
       }
     }
   }
@@ -1854,15 +1817,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     if (blocked_squares)
     {
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(rookmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       if (blocked_piece != index_begin)
       {
 	for (blocked_piece.prev_bit_in(line()); blocked_piece != index_pre_begin && rookmovers_of_same_color.test(blocked_piece); blocked_piece.prev_bit_in(line()))
@@ -1871,13 +1825,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
 	    M_defended[blocked_piece_color].add(blocked_squares);
 	  else
 	    M_defended[blocked_piece_color].sub(blocked_squares);
-	  if (king_attack)
-	  {
-	    if (add)
-	      ++M_king_battery_attack_count[blocked_piece_color];
-	    else
-	      --M_king_battery_attack_count[blocked_piece_color];
-	  }
 	  if (blocked_piece == index_begin)
 	    break;
 	}
@@ -1906,35 +1853,25 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     current_blocker.prev_bit_in(all_blockers());
     BitBoard blocked_squares(opposite_line);
     if (current_blocker != index_pre_begin)
-      blocked_squares.reset(south_east.from(current_blocker));
+    {
+      // A pawn of the same color that takes in this direction doesn't block the square behind it.
+      Index last_blocked(current_blocker);
+      if (blocked_piece_color == black && M_pieces[current_blocker] == Code(black, pawn) && south_east.from(current_blocker).test())
+	last_blocked += south_east.offset;
+      blocked_squares.reset(south_east.from(last_blocked));
+    }
     // Call it multiple times if there is a battery.
     if (blocked_squares)
     {
       if (__builtin_expect(code == black_pawn, false) && blocked_piece_color == black)
 	blocked_squares.reset(index + south_east.offset);
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(bishopmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       for (blocked_piece.next_bit_in(line()); blocked_piece != index_end && bishopmovers_of_same_color.test(blocked_piece); blocked_piece.next_bit_in(line()))
       {
 	if (add)
 	  M_defended[blocked_piece_color].add(blocked_squares);
 	else
 	  M_defended[blocked_piece_color].sub(blocked_squares);
-	if (king_attack)
-	{
-	  if (add)
-	    ++M_king_battery_attack_count[blocked_piece_color];
-	  else
-	    --M_king_battery_attack_count[blocked_piece_color];
-	}
       }
     }
   }
@@ -1960,22 +1897,19 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     current_blocker.next_bit_in(all_blockers());
     BitBoard blocked_squares(opposite_line);
     if (current_blocker != index_end)
-      blocked_squares.reset(north_west.from(current_blocker));
+    {
+      // A pawn of the same color that takes in this direction doesn't block the square behind it.
+      Index last_blocked(current_blocker);
+      if (blocked_piece_color == white && M_pieces[current_blocker] == Code(white, pawn) && north_west.from(current_blocker).test())
+	last_blocked += north_west.offset;
+      blocked_squares.reset(north_west.from(last_blocked));
+    }
     // Call it multiple times if there is a battery.
     if (blocked_squares)
     {
       if (__builtin_expect(code == white_pawn, false) && blocked_piece_color == white)
 	blocked_squares.reset(index + north_west.offset);
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(bishopmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       if (blocked_piece != index_begin)
       {
 	for (blocked_piece.prev_bit_in(line()); blocked_piece != index_pre_begin && bishopmovers_of_same_color.test(blocked_piece); blocked_piece.prev_bit_in(line()))
@@ -1984,13 +1918,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
 	    M_defended[blocked_piece_color].add(blocked_squares);
 	  else
 	    M_defended[blocked_piece_color].sub(blocked_squares);
-	  if (king_attack)
-	  {
-	    if (add)
-	      ++M_king_battery_attack_count[blocked_piece_color];
-	    else
-	      --M_king_battery_attack_count[blocked_piece_color];
-	  }
 	  if (blocked_piece == index_begin)
 	    break;
 	}
@@ -2019,35 +1946,25 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     current_blocker.prev_bit_in(all_blockers());
     BitBoard blocked_squares(opposite_line);
     if (current_blocker != index_pre_begin)
-      blocked_squares.reset(south_west.from(current_blocker));
+    {
+      // A pawn of the same color that takes in this direction doesn't block the square behind it.
+      Index last_blocked(current_blocker);
+      if (blocked_piece_color == black && M_pieces[current_blocker] == Code(black, pawn) && south_west.from(current_blocker).test())
+	last_blocked += south_west.offset;
+      blocked_squares.reset(south_west.from(last_blocked));
+    }
     // Call it multiple times if there is a battery.
     if (blocked_squares)
     {
       if (__builtin_expect(code == black_pawn, false) && blocked_piece_color == black)
 	blocked_squares.reset(index + south_west.offset);
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(bishopmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       for (blocked_piece.next_bit_in(line()); blocked_piece != index_end && bishopmovers_of_same_color.test(blocked_piece); blocked_piece.next_bit_in(line()))
       {
 	if (add)
 	  M_defended[blocked_piece_color].add(blocked_squares);
 	else
 	  M_defended[blocked_piece_color].sub(blocked_squares);
-	if (king_attack)
-	{
-	  if (add)
-	    ++M_king_battery_attack_count[blocked_piece_color];
-	  else
-	    --M_king_battery_attack_count[blocked_piece_color];
-	}
       }
     }
   }
@@ -2073,22 +1990,19 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
     current_blocker.next_bit_in(all_blockers());
     BitBoard blocked_squares(opposite_line);
     if (current_blocker != index_end)
-      blocked_squares.reset(north_east.from(current_blocker));
+    {
+      // A pawn of the same color that takes in this direction doesn't block the square behind it.
+      Index last_blocked(current_blocker);
+      if (blocked_piece_color == white && M_pieces[current_blocker] == Code(white, pawn) && north_east.from(current_blocker).test())
+	last_blocked += north_east.offset;
+      blocked_squares.reset(north_east.from(last_blocked));
+    }
     // Call it multiple times if there is a battery.
     if (blocked_squares)
     {
       if (__builtin_expect(code == white_pawn, false) && blocked_piece_color == white)
 	blocked_squares.reset(index + north_east.offset);
       result[blocked_piece_color] |= blocked_squares;
-      Code king_code(blocked_piece_color.opposite(), king);
-      bool king_attack = M_bitboards[king_code].test(blocked_squares);
-      if (__builtin_expect(king_attack && blocked_squares.test(bishopmovers_of_same_color), false))
-      {
-        if (add)
-          ++M_king_battery_attack_count[blocked_piece_color];
-        else
-          --M_king_battery_attack_count[blocked_piece_color];
-      }
       if (blocked_piece != index_begin)
       {
 	for (blocked_piece.prev_bit_in(line()); blocked_piece != index_pre_begin && bishopmovers_of_same_color.test(blocked_piece); blocked_piece.prev_bit_in(line()))
@@ -2097,13 +2011,6 @@ void ChessPosition::update_blocked_defendables(Code const& code, Index const& in
 	    M_defended[blocked_piece_color].add(blocked_squares);
 	  else
 	    M_defended[blocked_piece_color].sub(blocked_squares);
-	  if (king_attack)
-	  {
-	    if (add)
-	      ++M_king_battery_attack_count[blocked_piece_color];
-	    else
-	      --M_king_battery_attack_count[blocked_piece_color];
-	  }
 	  if (blocked_piece == index_begin)
 	    break;
 	}
@@ -2401,6 +2308,32 @@ BitBoard ChessPosition::reachables(Index const& index, bool attacked_squares) co
   return BitBoard();	// Never reached.
 }
 
+bool ChessPosition::double_check(Color const& color) const
+{
+  Code king_code(color, king);
+  BitBoard king_pos(M_bitboards[king_code]);
+  if (!king_pos)
+    return false;
+  Index king_index(mask2index(king_pos()));
+  Color opposite_color(color.opposite());
+  // Count the pieces that attack the king directly; pieces behind another attacker don't count.
+  BitBoard checkers(candidates_table[candidates_table_offset(knight) + king_index()] & M_bitboards[Code(opposite_color, knight)]);
+  BitBoard queenside_pawn((color == white) ? king_pos() << 7 : king_pos() >> 9);
+  BitBoard kingside_pawn((color == white) ? king_pos() << 9 : king_pos() >> 7);
+  queenside_pawn.reset(file_h);
+  kingside_pawn.reset(file_a);
+  checkers |= (queenside_pawn | kingside_pawn) & M_bitboards[Code(opposite_color, pawn)];
+  BitBoard const all_pieces(M_bitboards[white] | M_bitboards[black]);
+  BitBoard queens(M_bitboards[Code(opposite_color, queen)]);
+  BitBoard sliders(candidates_table[candidates_table_offset(rook) + king_index()] & (M_bitboards[Code(opposite_color, rook)] | queens));
+  sliders |= candidates_table[candidates_table_offset(bishop) + king_index()] & (M_bitboards[Code(opposite_color, bishop)] | queens);
+  for (PieceIterator piece_iter(this, sliders); piece_iter != piece_end(); ++piece_iter)
+    if ((squares_from_to(piece_iter.index(), king_index) & all_pieces) == BitBoard(piece_iter.index()))
+      checkers.set(piece_iter.index());
+  // More than one bit set?
+  return (checkers() & (checkers() - 1)) != 0;
+}
+
 BitBoard ChessPosition::moves(Index const& index) const
 {
   Code code(M_pieces[index].code());
@@ -2459,7 +2392,7 @@ BitBoard ChessPosition::moves(Index const& index) const
         BitBoard line(squares_from_to(piece_iter.index(), king_index));
 	if ((line & all_pieces) == BitBoard(piece_iter.index()))
 	{
-	  // We found the rookmover that gives check.
+	  // We found a rookmover that gives check (in double check, the king continues to look for a second one).
 	  if (is_king)
 	  {
 	    // If this wraps around from a-file to h-file or visa versa then that is not a problem: it will be far away from the king.
@@ -2469,8 +2402,10 @@ BitBoard ChessPosition::moves(Index const& index) const
 	      reachables.reset(one_step_away_from_attacker);
 	  }
 	  else
+	  {
 	    attacker_squares |= line;
-	  break;
+	    break;
+	  }
 	}
       }
       if (M_double_check || !attacker_squares)
@@ -2483,7 +2418,7 @@ BitBoard ChessPosition::moves(Index const& index) const
 	  BitBoard line(squares_from_to(piece_iter.index(), king_index));
 	  if ((line & all_pieces) == piece_iter.index())
 	  {
-	    // We found the bishopmover that gives check.
+	    // We found a bishopmover that gives check.
 	    if (is_king)
 	    {
 	      Index one_step_away_from_attacker(king_index - direction);
@@ -2491,14 +2426,19 @@ BitBoard ChessPosition::moves(Index const& index) const
 		reachables.reset(one_step_away_from_attacker);
 	    }
 	    else
+	    {
 	      attacker_squares |= line;
-	    break;
+	      break;
+	    }
 	  }
 	}
       }
     }
     if (!is_king)
     {
+      // A pawn that gives check can also be taken en passant.
+      if (__builtin_expect(code.is_a(pawn) && M_en_passant.exists() && attacker_squares.test(M_en_passant.pawn_index()), false))
+	attacker_squares.set(M_en_passant.index());
       // The only possible move is taking the attacker, or placing something in front of it.
       reachables &= attacker_squares;
     }
@@ -2507,15 +2447,11 @@ BitBoard ChessPosition::moves(Index const& index) const
   if (__builtin_expect(pinning.test(index), false))
   {
     // Remove squares that would result in a check.
-    if (code.is_a(pawn))
-      reachables &= pinning;
-    else
-    {
-      Index king_index(index_of_king(color));
-      Direction direction(direction_from_to(king_index, index));
-      BitBoard line(direction.from(king_index));
-      reachables &= line;
-    }
+    // Note that M_pinning can contain more than one line, so it can't be used to restrict the moves.
+    Index king_index(index_of_king(color));
+    Direction direction(direction_from_to(king_index, index));
+    BitBoard line(direction.from(king_index));
+    reachables &= line;
   }
   if (__builtin_expect(M_en_passant.exists() && M_en_passant.pinned() && code.is_a(pawn), false))
       reachables.reset(M_en_passant.index());		// Taking en passant is prohibitted.
@@ -2552,6 +2488,107 @@ bool ChessPosition::legal(Move const& move) const
   return moves(from).test(to_pos);
 }
 
+bool ChessPosition::parse_SAN(std::string_view SAN, Move& move) const
+{
+  // Strip check, mate and annotation symbols, and a trailing colon (an old capture symbol).
+  size_t len = SAN.size();
+  while (len > 0 && (SAN[len - 1] == '+' || SAN[len - 1] == '#' || SAN[len - 1] == '!' || SAN[len - 1] == '?' || SAN[len - 1] == ':'))
+    --len;
+  if (len < 2)
+    return false;
+  // Castling.
+  if (SAN[0] == 'O' || SAN[0] == '0')
+  {
+    char o = SAN[0];
+    uint8_t row = (M_to_move == white) ? 0 : 7;
+    bool castle_long;
+    if (len == 3 && SAN[1] == '-' && SAN[2] == o)
+      castle_long = false;
+    else if (len == 5 && SAN[1] == '-' && SAN[2] == o && SAN[3] == '-' && SAN[4] == o)
+      castle_long = true;
+    else
+      return false;
+    move.set_move(Index(4, row), Index(castle_long ? 2 : 6, row), nothing);
+    return M_pieces[move.from()].code() == Code(M_to_move, king) && moves(move.from()).test(move.to());
+  }
+  // The type of the piece that moves.
+  Type type(pawn);
+  size_t pos = 1;
+  switch (SAN[0])
+  {
+    case 'K': type = king; break;
+    case 'Q': type = queen; break;
+    case 'R': type = rook; break;
+    case 'B': type = bishop; break;
+    case 'N': type = knight; break;
+    default: pos = 0;
+  }
+  // The promotion type, if any.
+  Type promotion(nothing);
+  if (type == pawn && len > 2)
+  {
+    char c = SAN[len - 1];
+    bool has_equal_sign = SAN[len - 2] == '=';
+    if (!has_equal_sign && c >= 'a')
+      c = 0;		// Don't mistake a file for a promotion.
+    switch (c)
+    {
+      case 'Q': case 'q': promotion = queen; break;
+      case 'R': case 'r': promotion = rook; break;
+      case 'B': case 'b': promotion = bishop; break;
+      case 'N': case 'n': promotion = knight; break;
+    }
+    if (promotion != nothing)
+      len -= has_equal_sign ? 2 : 1;
+  }
+  // The destination square.
+  if (len < pos + 2)
+    return false;
+  char file = SAN[len - 2];
+  char rank = SAN[len - 1];
+  if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+    return false;
+  Index to(file - 'a', rank - '1');
+  // Disambiguation and the capture symbol.
+  int from_col = -1;
+  int from_row = -1;
+  for (size_t i = pos; i < len - 2; ++i)
+  {
+    char c = SAN[i];
+    if (c >= 'a' && c <= 'h')
+      from_col = c - 'a';
+    else if (c >= '1' && c <= '8')
+      from_row = c - '1';
+    else if (c != 'x' && c != ':' && c != '-')
+      return false;
+  }
+  // A pawn that doesn't capture stays on its file.
+  if (type == pawn && from_col == -1)
+    from_col = to.col();
+  // Find the piece that can make this move.
+  bool found = false;
+  for (PieceIterator piece_iter = piece_begin(Code(M_to_move, type)); piece_iter != piece_end(); ++piece_iter)
+  {
+    Index from(piece_iter.index());
+    if ((from_col != -1 && from.col() != from_col) || (from_row != -1 && from.row() != from_row))
+      continue;
+    // Only call moves() for pieces that could reach the destination on an empty board.
+    if (type != pawn && !candidates(from).test(to))
+      continue;
+    if (!moves(from).test(to))
+      continue;
+    if (found)
+      return false;	// Ambiguous.
+    found = true;
+    move.set_move(from, to, promotion);
+  }
+  if (!found)
+    return false;
+  // A pawn must promote if, and only if, it reaches the last rank.
+  bool last_rank = type == pawn && (to.row() == 0 || to.row() == 7);
+  return last_rank == (promotion != nothing);
+}
+
 bool ChessPosition::execute(Move const& move)
 {
   BitBoard from_pos(move.from());
@@ -2574,25 +2611,18 @@ bool ChessPosition::execute(Move const& move)
       clear_en_passant();
     }
   }
-  // Set en passant flags, if applicable.
+  // Set en passant flags, if applicable (after the pawn has been moved, see below).
+  bool pawn_advanced_two_squares = false;
   if (pawn_move)
   {
     uint8_t offset = move.to()() - move.from()();	// -16, -9, -8, -7, 7, 8, 9 or 16.
-    bool pawn_advanced_two_squares = !(offset & 0xf);	// Only -16 and 16 have the last four bits clear.
-    if (pawn_advanced_two_squares)
-    {
-      // Mark that we can take this pawn en passant.
-      // Toggling the third bit finds the passed square: row 3 becomes row 2, and row 4 becomes row 5.
-      IndexData passed_square = { static_cast<uint8_t>(move.to()() ^ 8) };
-      set_en_passant(passed_square);
-      // set_en_passant toggles the move, toggle it back because we'll toggle it again below.
-      M_to_move.toggle();
-    }
+    pawn_advanced_two_squares = !(offset & 0xf);	// Only -16 and 16 have the last four bits clear.
   }
 
   // FIXME. For now, use place() to execute the move.
   CastleFlags castle_flags(M_castle_flags);
   Piece piece(M_pieces[move.from()]);
+  Code captured(M_pieces[move.to()].code());
   place(Code(), move.from());			// 160 ns.
   if (move.is_promotion())
     place(Code(M_to_move, move.promotion_type()), move.to());
@@ -2618,6 +2648,17 @@ bool ChessPosition::execute(Move const& move)
   M_castle_flags = castle_flags;
   M_castle_flags.set_check(M_to_move, in_check);
   M_castle_flags.piece_moved_from(piece, move.from());
+  // Capturing a rook on its initial square also takes away the right to castle with it.
+  M_castle_flags.update_removed(captured, move.to());
+
+  if (pawn_advanced_two_squares)
+  {
+    // Mark that we can take this pawn en passant. This has to be done after the pawn was placed,
+    // because whether or not taking en passant is allowed depends on the pieces on the same row.
+    // Toggling the third bit finds the passed square: row 3 becomes row 2, and row 4 becomes row 5.
+    IndexData passed_square = { static_cast<uint8_t>(move.to()() ^ 8) };
+    set_en_passant(passed_square);
+  }
 
   // Cache whether or not we gave a double check.
   M_double_check = M_castle_flags.in_check(M_to_move) ? double_check(M_to_move) : false;
@@ -2625,6 +2666,68 @@ bool ChessPosition::execute(Move const& move)
   return increment_counters(pawn_advance_or_capture);
 }
 
+bool ChessPosition::verify_incremental_state(std::string& difference) const
+{
+  std::ostringstream os;
+  ChessPosition reference;
+  if (!reference.load_FEN(FEN()))
+    os << "FEN \"" << FEN() << "\" can't be loaded";
+  else
+  {
+    for (Index index = index_begin; index != index_end && os.tellp() == 0; ++index)
+      if (M_pieces[index].code() != reference.M_pieces[index].code() || M_pieces[index].flags() != reference.M_pieces[index].flags())
+        os << "piece or pawn flags at " << ChessNotation(*this, index) << " differ (" << (int)M_pieces[index].flags()() <<
+	    " instead of " << (int)reference.M_pieces[index].flags()() << ')';
+    for (int i = 0; i < 16 && os.tellp() == 0; ++i)
+    {
+      CodeData data = { static_cast<uint8_t>(i) };
+      if (M_bitboards[data] != reference.M_bitboards[data])
+        os << "bitboard " << i << " differs";
+    }
+    for (Color color : { Color(white), Color(black) })
+    {
+      if (os.tellp() != 0)
+        break;
+      char const* name = color == white ? "white" : "black";
+      // The defended squares summed over the defendables of every piece.
+      CountBoard defended;
+      defended.reset();
+      for (PieceIterator piece_iter(piece_begin(color)); piece_iter != piece_end(); ++piece_iter)
+      {
+        bool battery;
+        defended.add(defendables(piece_iter->code(), piece_iter.index(), battery));
+      }
+      if (M_attackers[color] != reference.M_attackers[color])
+        os << "attackers of " << name << " differ";
+      else if (M_pinning[color] != reference.M_pinning[color])
+        os << "pinning of " << name << " differs";
+      else if (M_defended[color].any() != defended.any() || reference.M_defended[color].any() != defended.any())
+        os << "squares defended by " << name << " differ";
+      for (Index index = index_begin; index != index_end && os.tellp() == 0; ++index)
+        if (M_defended[color].count(index) != defended.count(index) || reference.M_defended[color].count(index) != defended.count(index))
+	  os << ChessNotation(*this, index) << " is defended " << M_defended[color].count(index) << " times by " << name <<
+	      " (" << reference.M_defended[color].count(index) << " when set up from scratch) instead of " << defended.count(index);
+    }
+    if (os.tellp() != 0)
+      ;
+    else if (M_to_move != reference.M_to_move)
+      os << "the color to move differs";
+    else if (M_castle_flags.can_castle_short(white) != reference.M_castle_flags.can_castle_short(white) ||
+        M_castle_flags.can_castle_long(white) != reference.M_castle_flags.can_castle_long(white) ||
+        M_castle_flags.can_castle_short(black) != reference.M_castle_flags.can_castle_short(black) ||
+        M_castle_flags.can_castle_long(black) != reference.M_castle_flags.can_castle_long(black))
+      os << "castling rights differ";
+    else if (M_castle_flags.in_check(M_to_move) != check())
+      os << "the in check flag is " << M_castle_flags.in_check(M_to_move) << " instead of " << check();
+    else if (M_double_check != reference.M_double_check)
+      os << "double check is " << M_double_check << " instead of " << reference.M_double_check;
+    else if (M_en_passant.M_bits != reference.M_en_passant.M_bits)
+      os << "en passant state is " << (int)M_en_passant.M_bits << " instead of " << (int)reference.M_en_passant.M_bits;
+  }
+  difference = os.str();
+  return difference.empty();
+}
+
 BitBoardData ChessPosition::candidates_table[5 * 64] = {
   // Knight
   { CW_MASK_T_CONST(0x0000000000020400)}, { CW_MASK_T_CONST(0x0000000000050800)}, { CW_MASK_T_CONST(0x00000000000a1100)}, { CW_MASK_T_CONST(0x0000000000142200)},
@@ -32,6 +32,7 @@
 #include "CastleFlags.h"
 #include "EnPassant.h"
 #include "CountBoard.h"
+#include <string_view>
 
 namespace cwchess {
 
@@ -51,7 +52,6 @@ class ChessPosition {
     ArrayColor<BitBoard> M_attackers;			//!< Bitboards for squares of enemy pieces on the same line as the king and all squares in between.
     ArrayColor<BitBoard> M_pinning;			//!< Squares between attacker and king for actually pinned pieces (including attacker).
     ArrayColor<CountBoard> M_defended;			//!< The number times a square is defended.
-    ArrayColor<uint8_t> M_king_battery_attack_count;	//!< The number of times that a king is 'attacked' by pieces behind another attacker.
     uint16_t M_full_move_number;			//!< The number of the full move. It starts at 1, and is incremented after Black's move.
     uint8_t M_half_move_clock;				//!< Number of half moves since the last pawn advance or capture.
     CastleFlags M_castle_flags;				//!< Whether black and white may castle long or short.
@@ -227,6 +227,8 @@ class ChessPosition {
 #ifndef DOXYGEN
     // Needs access to M_pieces.
     friend class PieceIterator;
+    // Needs to restore the castle flags and move counters.
+    friend class SlimChessPosition;
 #endif
 
   /** @name Accessors */
@@ -363,10 +365,7 @@ public:
     bool check(Color const& color) const { return M_bitboards[Code(color, king)].test(M_defended[color.opposite()].any()); }
 
     /** @brief Return true if the king of color \a color is in double check. */
-    bool double_check(Color const& color) const
-        { Color opposite_color(color.opposite());
-	  CodeData data = { static_cast<uint8_t>(king_bits | color()) };
-	  return M_defended[opposite_color].count(M_bitboards[data]) - M_king_battery_attack_count[opposite_color] > 1; }
+    bool double_check(Color const& color) const;
 
     /** @brief Return true if the king or rook on \a index has moved or not.
      *
@@ -383,6 +382,19 @@ public:
     /** @brief Return true if the move is a legal move. */
     bool legal(Move const& move) const;
 
+    /** @brief Convert a move in Standard Algebraic Notation into a Move.
+     *
+     * Trailing check, mate and annotation symbols (+, #, !, ?, :) are ignored,
+     * as are a missing 'x' and a missing '=' before the promotion type.
+     * Castling may be written with the letter O as well as with the digit zero.
+     *
+     * @param SAN : The move, for example "Nbd7", "exd8=Q+" or "O-O-O".
+     * @param move : Set to the decoded move upon success.
+     *
+     * @returns TRUE if \a SAN denotes exactly one legal move in this position.
+     */
+    bool parse_SAN(std::string_view SAN, Move& move) const;
+
   //@}
 
   /** @name Iterators */
@@ -422,6 +434,24 @@ public:
 
   //@}
 
+  /** @name Testing */
+  //@{
+
+  /** @brief Compare the incrementally maintained state with a recalculation from scratch.
+   *
+   * The position is set up again from its FEN on an empty board, and the pawn flags,
+   * bitboards, attackers, pinning, defended counts, castling and en passant state of
+   * both are compared. The defended counts are moreover summed directly from the
+   * defendables() of every piece. This is slow; it is meant for tests.
+   *
+   * @param difference : Set to a description of the first difference found.
+   *
+   * @returns TRUE if no difference was found.
+   */
+  bool verify_incremental_state(std::string& difference) const;
+
+  //@}
+
   protected:
     void reset_en_passant() { if (M_en_passant.exists()) clear_en_passant(); }
 
@@ -438,6 +468,9 @@ public:
     // Update the fl_pawn_can_take_* pawn flags for a piece of color \a color that was placed at (col, row).
     void update_placed(uint8_t col, uint8_t row, Color const& color);
 
+    // Recalculate M_attackers of the king of color \a color at \a king_index in direction \a direction.
+    void update_attackers(Color const& color, Index const& king_index, Direction const& direction);
+
     // Update pinning flags.
     void update_pinning(Code const& code, Index const& index, mask_t mask, Direction const& direction, BitBoard const& line);
 
@@ -445,7 +478,6 @@ public:
     BitBoard all_pieces_minus_bishop_movers(Color const& color, Index const& index) const;
 
     // Calculate the squares that would be blocked by a piece with code \a code at \a index and than add or subtract them from M_defended.
-    // Also update M_king_battery_attack_count.
     void update_blocked_defendables(Code const& code, Index const& index, bool add);
 
   private:
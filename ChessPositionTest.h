@@ -40,6 +40,8 @@ class ChessPositionTest : public CppUnit::TestFixture {
   CPPUNIT_TEST(testPlaceCastleFlags);
   CPPUNIT_TEST(testPlaceEnPassant);
   CPPUNIT_TEST(testPlacePinning);
+  CPPUNIT_TEST(testParseSAN);
+  CPPUNIT_TEST(testIncrementalState);
 
   CPPUNIT_TEST_SUITE_END();
 
@@ -59,6 +61,8 @@ class ChessPositionTest : public CppUnit::TestFixture {
     void testPlaceCastleFlags();
     void testPlaceEnPassant();
     void testPlacePinning();
+    void testParseSAN();
+    void testIncrementalState();
 
   private:
     void test_initial_position(ChessPosition const& chess_position);
@@ -69,6 +73,10 @@ class ChessPositionTest : public CppUnit::TestFixture {
 
 #ifdef TESTSUITE_IMPLEMENTATION
 
+#include "RandomGame.h"
+#include <random>
+#include <vector>
+
 namespace testsuite {
 
 CPPUNIT_TEST_SUITE_REGISTRATION(ChessPositionTest);
@@ -528,6 +536,82 @@ void ChessPositionTest::testPlacePinning()
   }
 }
 
+void ChessPositionTest::testParseSAN()
+{
+  ChessPosition chess_position;
+  chess_position.initial_position();
+  Move move;
+  CPPUNIT_ASSERT(chess_position.parse_SAN("e4", move) && move == Move(Index(4, 1), Index(4, 3), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("Nf3", move) && move == Move(Index(6, 0), Index(5, 2), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("Ng1f3!?", move) && move == Move(Index(6, 0), Index(5, 2), nothing));
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("e5", move));
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("Nd2", move));
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("O-O", move));
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("Qx", move));
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("", move));
+
+  // Disambiguation, castling and captures.
+  chess_position.load_FEN("r3k2r/8/8/8/8/8/4K3/R6R w kq - 0 1");
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("Rd1", move));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("Rad1", move) && move == Move(Index(0, 0), Index(3, 0), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("Rhd1", move) && move == Move(Index(7, 0), Index(3, 0), nothing));
+  chess_position.load_FEN("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  CPPUNIT_ASSERT(chess_position.parse_SAN("Rxa8+", move) && move == Move(Index(0, 0), Index(0, 7), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("O-O", move) && move == Move(Index(4, 0), Index(6, 0), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("0-0-0", move) && move == Move(Index(4, 0), Index(2, 0), nothing));
+  chess_position.load_FEN("4k3/8/8/8/8/8/8/R3K2R w - - 0 1");
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("O-O", move));
+  chess_position.load_FEN("4k3/R7/8/8/8/8/8/R3K3 w - - 0 1");
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("Ra4", move));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("R7a4", move) && move == Move(Index(0, 6), Index(0, 3), nothing));
+
+  // Promotion and en passant.
+  chess_position.load_FEN("1n2k3/P7/8/3Pp3/8/8/8/4K3 w - e6 0 1");
+  CPPUNIT_ASSERT(!chess_position.parse_SAN("a8", move));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("a8=Q", move) && move == Move(Index(0, 6), Index(0, 7), queen));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("a8N", move) && move == Move(Index(0, 6), Index(0, 7), knight));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("axb8=R+", move) && move == Move(Index(0, 6), Index(1, 7), rook));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("dxe6", move) && move == Move(Index(3, 4), Index(4, 5), nothing));
+  CPPUNIT_ASSERT(chess_position.parse_SAN("d6", move) && move == Move(Index(3, 4), Index(3, 5), nothing));
+}
+
+void ChessPositionTest::testIncrementalState()
+{
+  ChessPosition chess_position;
+  std::string difference;
+
+  // Positions found by tstfuzz.
+  chess_position.load_FEN("3k4/b7/8/2q5/8/8/5K2/8 w - - 0 7");
+  CPPUNIT_ASSERT(chess_position.check() && !chess_position.double_check(white));
+  chess_position.load_FEN("8/8/8/1q4k1/8/8/1Kr5/8 w - - 0 1");
+  CPPUNIT_ASSERT(chess_position.double_check(white) && !chess_position.legal(Move(Index(1, 1), Index(1, 0), nothing)));
+  chess_position.load_FEN("8/8/2r5/2k4r/6PP/2K5/8/8 b - h3 0 36");
+  chess_position.execute(Move(Index(2, 5), Index(1, 5), nothing));
+  CPPUNIT_ASSERT(chess_position.verify_incremental_state(difference));
+  chess_position.load_FEN("5k2/8/8/8/8/8/6p1/4K2R b K - 0 1");
+  chess_position.execute(Move(Index(6, 1), Index(7, 0), knight));	// gxh1=N
+  CPPUNIT_ASSERT(!chess_position.legal(Move(Index(4, 0), Index(6, 0), nothing)));
+  chess_position.load_FEN("8/8/8/K7/1R2PpPk/8/8/8 b - e3 0 2");
+  CPPUNIT_ASSERT(chess_position.legal(Move(Index(5, 3), Index(4, 2), nothing)));
+  chess_position.load_FEN("8/8/8/K7/1R3p1k/8/6P1/8 w - - 0 1");
+  chess_position.execute(Move(Index(6, 1), Index(6, 3), nothing));	// g4
+  CPPUNIT_ASSERT(chess_position.verify_incremental_state(difference));
+  CPPUNIT_ASSERT(!chess_position.legal(Move(Index(5, 3), Index(6, 2), nothing)));
+  chess_position.load_FEN("8/4b3/6k1/2P5/8/KPq5/8/8 w - - 27 64");
+  CPPUNIT_ASSERT(!chess_position.legal(Move(Index(1, 2), Index(1, 3), nothing)));
+  chess_position.load_FEN("4k3/8/8/4pP2/3K4/8/8/8 w - e6 0 1");
+  CPPUNIT_ASSERT(chess_position.check() && chess_position.legal(Move(Index(5, 4), Index(4, 5), nothing)));
+
+  // A few random games.
+  std::mt19937 random_number_generator(1220638382);
+  for (int game = 0; game < 20; ++game)
+  {
+    chess_position.initial_position();
+    random_game(random_number_generator, chess_position, 200, std::numeric_limits<size_t>::max(),
+	[&](Move const&) { CPPUNIT_ASSERT(chess_position.verify_incremental_state(difference)); });
+  }
+}
+
 } // namespace testsuite
 
 #endif // TESTSUITE_IMPLEMENTATION
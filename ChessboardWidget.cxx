@@ -2175,6 +2175,10 @@ ChessboardWidget::ChessboardWidget() :
   m_floating_piece{},
   m_floating_piece_handle(-1),
   m_redraw_background(true),
+  m_measure_drag_latency(false),
+  m_drag_handler_time(0),
+  m_drag_event_time(0),
+  m_drag_coalesced_events(0),
 #ifdef CWDEBUG
   m_inside_on_draw(false),
   m_show_buffer(false),
@@ -2410,6 +2414,9 @@ bool ChessboardWidget::on_draw(Cairo::RefPtr<Cairo::Context> const& crmm)
 #endif
   Debug(m_inside_on_draw = true);
 
+  // When measuring drag latency and a motion event is waiting to be drawn.
+  gint64 const draw_start = m_drag_handler_time ? g_get_monotonic_time() : 0;
+
   Gtk::Allocation allocation = get_allocation();
   Dout(dc::clip, "allocation = " << allocation);
 
@@ -2455,9 +2462,13 @@ bool ChessboardWidget::on_draw(Cairo::RefPtr<Cairo::Context> const& crmm)
 
   // Last minute update of pixmap.
   guint64 redraw_mask = 1;
+  guint squares_redrawn = 0;
   for (gint i = 0; i < 64; ++i, redraw_mask <<= 1)
     if ((need_redraw & redraw_mask))
+    {
       redraw_square(cr, i);             // This uses the HUD layer.
+      ++squares_redrawn;
+    }
   m_need_redraw_invalidated = 0;
 
   // Redraw border when the border was invalidated.
@@ -2544,6 +2555,9 @@ bool ChessboardWidget::on_draw(Cairo::RefPtr<Cairo::Context> const& crmm)
     cairo_region_destroy(pixmap_region);
   }
 
+  if (draw_start)
+    record_drag_frame(draw_start, squares_redrawn);
+
   Debug(m_inside_on_draw = false);
 
 #if CW_CHESSBOARD_EXPOSE_DEBUG
@@ -2560,6 +2574,8 @@ bool ChessboardWidget::on_motion_notify_event(GdkEventMotion* motion_event)
 
   if (m_floating_piece_handle != -1)
   {
+    if (m_measure_drag_latency)
+      record_drag_event(motion_event->time);
     double hsside = 0.5 * m_sside;
     double fraction = hsside - (gint)hsside;
     move_floating_piece(m_floating_piece_handle, motion_event->x - fraction, motion_event->y - fraction);
@@ -2571,6 +2587,44 @@ bool ChessboardWidget::on_motion_notify_event(GdkEventMotion* motion_event)
   return false;
 }
 
+void ChessboardWidget::set_measure_drag_latency(gboolean measure)
+{
+  DoutEntering(dc::widget, "ChessboardWidget::set_measure_drag_latency(" << measure << ")");
+  m_measure_drag_latency = measure;
+  m_drag_handler_time = 0;
+  m_drag_coalesced_events = 0;
+}
+
+// Called from on_motion_notify_event while dragging a piece and measuring drag latency.
+void ChessboardWidget::record_drag_event(guint32 event_time)
+{
+  // The next frame is measured from the oldest event that it shows.
+  if (m_drag_handler_time)
+  {
+    ++m_drag_coalesced_events;
+    return;
+  }
+  m_drag_handler_time = g_get_monotonic_time();
+  // The event time is in milliseconds and, on X11 and Wayland, uses the same clock as
+  // g_get_monotonic_time() truncated to 32 bits. Ignore it when it is from another clock.
+  guint32 input_delay = static_cast<guint32>(m_drag_handler_time / 1000) - event_time;
+  m_drag_event_time = input_delay < 1000 ? m_drag_handler_time - 1000 * static_cast<gint64>(input_delay) : 0;
+}
+
+// Called at the end of on_draw when a motion event was handled since the previous frame.
+void ChessboardWidget::record_drag_frame(gint64 draw_start, guint squares_redrawn)
+{
+  gint64 const draw_end = g_get_monotonic_time();
+  if (m_drag_event_time)
+    m_drag_latency.add(DragLatency::input, m_drag_handler_time - m_drag_event_time);
+  m_drag_latency.add(DragLatency::wait, draw_start - m_drag_handler_time);
+  m_drag_latency.add(DragLatency::draw, draw_end - draw_start);
+  m_drag_latency.add(DragLatency::total, draw_end - (m_drag_event_time ? m_drag_event_time : m_drag_handler_time));
+  m_drag_latency.add_frame(squares_redrawn, m_drag_coalesced_events);
+  m_drag_handler_time = 0;
+  m_drag_coalesced_events = 0;
+}
+
 void ChessboardWidget::on_realize()
 {
   DoutEntering(dc::widget, "ChessboardWidget::on_realize()");
@@ -24,6 +24,7 @@
 #pragma once
 
 //#include "CwChessboard.h"
+#include "DragLatency.h"
 #include "debug.h"
 
 #pragma GCC diagnostic push
@@ -267,6 +268,12 @@ class ChessboardWidget : public Gtk::DrawingArea
 
   std::vector<Arrow*> m_arrows;		// Array with pointers to Arrow objects.
 
+  bool m_measure_drag_latency;		// Set while drag latencies are being recorded.
+  gint64 m_drag_handler_time;		// When the oldest motion event that wasn't drawn yet was handled, or 0.
+  gint64 m_drag_event_time;		// The time stamp of that event, or 0 if unusable.
+  guint m_drag_coalesced_events;	// The number of motion events handled since then.
+  DragLatency m_drag_latency;		// The recorded drag latencies.
+
 #ifdef CWDEBUG
   bool m_inside_on_draw;                        // True when inside on_draw. Used for debugging.
   bool m_show_buffer;                           // True when m_buffer must be copied to the screen.
@@ -328,6 +335,8 @@ class ChessboardWidget : public Gtk::DrawingArea
   void invalidate_square(gint col, gint row);
   void invalidate_board();
   void invalidate_markers();
+  void record_drag_event(guint32 event_time);
+  void record_drag_frame(gint64 draw_start, guint squares_redrawn);
   void invalidate_cursor();
   guint64 invalidate_arrow(gint col1, gint row1, gint col2, gint row2);
   void redraw_square(Cairo::RefPtr<Cairo::Context> const& cr, gint index);
@@ -1037,6 +1046,39 @@ class ChessboardWidget : public Gtk::DrawingArea
 
   //@}
 
+  /** @name Drag Latency */
+  //@{
+
+    /** @brief Start or stop measuring the latency of dragging a piece.
+     *
+     * While measuring, every frame that is drawn while a piece is being dragged adds
+     * the time from the oldest motion event that it shows until the end of on_draw
+     * to #drag_latency. Measuring costs two calls to g_get_monotonic_time per
+     * motion event and per frame. Default: FALSE.
+     *
+     * @param measure : TRUE to start measuring, FALSE to stop.
+     *
+     * @sa drag_latency, reset_drag_latency
+     */
+    void set_measure_drag_latency(gboolean measure);
+
+    /** @brief Get the boolean that determines whether or not drag latencies are measured.
+     *
+     * @sa set_measure_drag_latency
+     */
+    gboolean get_measure_drag_latency() const { return m_measure_drag_latency; }
+
+    /** @brief The drag latencies that were measured so far.
+     *
+     * @sa set_measure_drag_latency
+     */
+    DragLatency const& drag_latency() const { return m_drag_latency; }
+
+    //! @brief Forget the drag latencies that were measured so far.
+    void reset_drag_latency() { m_drag_latency.reset(); }
+
+  //@}
+
   /** @name Markers */
   //@{
 
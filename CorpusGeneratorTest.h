@@ -0,0 +1,140 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file CorpusGeneratorTest.h Testsuite for pgn::CorpusGenerator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "PgnCorpusGenerator.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class CorpusGeneratorTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(CorpusGeneratorTest);
+
+  CPPUNIT_TEST(testDeterministic);
+  CPPUNIT_TEST(testStyles);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    CorpusGeneratorTest() { }
+
+    void testDeterministic();
+    void testStyles();
+
+  private:
+    std::string generate(pgn::CorpusGenerator::Options const& options, uint32_t& games);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include <cstdio>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(CorpusGeneratorTest);
+
+// Return the corpus generated with options.
+std::string CorpusGeneratorTest::generate(pgn::CorpusGenerator::Options const& options, uint32_t& games)
+{
+  TempFile file("CorpusGeneratorTest");
+  file.remove();
+  int fd = file.fd();
+  {
+    pgn::Writer writer(fd, 4096);
+    games = pgn::CorpusGenerator(options).generate(writer);
+    CPPUNIT_ASSERT(writer.flush());
+  }
+  std::string result;
+  char buf[4096];
+  ssize_t len;
+  lseek(fd, 0, SEEK_SET);
+  while ((len = read(fd, buf, sizeof(buf))) > 0)
+    result.append(buf, len);
+  return result;
+}
+
+void CorpusGeneratorTest::testDeterministic()
+{
+  pgn::CorpusGenerator::Options options;
+  options.games = 50;
+  options.style = pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::variations | pgn::CorpusGenerator::junk;
+  uint32_t games;
+  std::string text = generate(options, games);
+  CPPUNIT_ASSERT(games == 50);
+  CPPUNIT_ASSERT(generate(options, games) == text);
+  options.seed = 42;
+  CPPUNIT_ASSERT(generate(options, games) != text);
+
+  // Without a number of games, games are written until the size is reached.
+  options.games = 0;
+  options.size = 100000;
+  text = generate(options, games);
+  CPPUNIT_ASSERT(text.size() >= 100000 && text.size() < 120000);
+  size_t events = 0;
+  for (size_t pos = 0; (pos = text.find("[Event ", pos)) != std::string::npos; ++pos)
+    ++events;
+  CPPUNIT_ASSERT(events == games);
+}
+
+void CorpusGeneratorTest::testStyles()
+{
+  unsigned int style;
+  CPPUNIT_ASSERT(pgn::CorpusGenerator::parse_style("annotated,crlf", style) && style == (pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::crlf));
+  CPPUNIT_ASSERT(pgn::CorpusGenerator::parse_style("bare", style) && style == pgn::CorpusGenerator::bare);
+  CPPUNIT_ASSERT(!pgn::CorpusGenerator::parse_style("annotated,fancy", style));
+
+  pgn::CorpusGenerator::Options options;
+  options.games = 100;
+  uint32_t games;
+  std::string text = generate(options, games);
+  CPPUNIT_ASSERT(text.find_first_of("{($\r%") == std::string::npos);
+
+  options.style = pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::variations | pgn::CorpusGenerator::crlf | pgn::CorpusGenerator::junk;
+  text = generate(options, games);
+  CPPUNIT_ASSERT(text.find('{') != std::string::npos && text.find("[%clk ") != std::string::npos && text.find('$') != std::string::npos);
+  CPPUNIT_ASSERT(text.find('(') != std::string::npos && text.find("\n%") != std::string::npos);
+  int depth = 0;
+  for (size_t pos = 0; pos < text.size(); ++pos)
+  {
+    if (text[pos] == '\n')
+      CPPUNIT_ASSERT(pos > 0 && text[pos - 1] == '\r');
+    else if (text[pos] == '(')
+      ++depth;
+    else if (text[pos] == ')')
+      CPPUNIT_ASSERT(--depth >= 0);
+  }
+  CPPUNIT_ASSERT(depth == 0);
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -27,6 +27,7 @@
 #include "debug.h"
 #endif
 #include "BitBoard.h"
+#include "ProfileCounters.h"
 #include <cstring>
 
 namespace cwchess {
@@ -41,6 +42,7 @@ class CountBoard {
 
     void add(BitBoard const& bit_board)
     {
+      CWCHESS_PROFILE(countboard_add);
 #ifdef CWDEBUG
       if (debug::channels::dc::countboard.is_on())
       {
@@ -78,6 +80,7 @@ class CountBoard {
 
     void sub(BitBoard const& bit_board)
     {
+      CWCHESS_PROFILE(countboard_sub);
 #ifdef CWDEBUG
       if (debug::channels::dc::countboard.is_on())
       {
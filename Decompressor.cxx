@@ -0,0 +1,498 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file Decompressor.cxx This file contains the implementation of class Decompressor.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "Decompressor.h"
+#include "debug.h"
+#include <algorithm>
+#include <climits>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <bzlib.h>
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+#include <glib.h>
+
+namespace util {
+
+namespace {
+
+uint32_t const skippable_frame_magic = 0x184D2A5E;	// The magic number of the skippable frame that contains the seek table.
+uint32_t const seekable_magic = 0x8F92EAB1;		// The magic number at the very end of a seekable zstd file.
+size_t const seek_table_footer_size = 9;
+
+uint32_t get_le32(unsigned char const* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (uint32_t(p[3]) << 24);
+}
+
+bool pread_all(int fd, unsigned char* buf, size_t size, off_t offset)
+{
+  while (size > 0)
+  {
+    ssize_t len = pread(fd, buf, size, offset);
+    if (len == -1 && errno == EINTR)
+      continue;
+    if (len <= 0)
+      return false;
+    buf += len;
+    size -= len;
+    offset += len;
+  }
+  return true;
+}
+
+} // namespace
+
+bool ZstdSeekTable::load(int fd)
+{
+  clear();
+  struct stat sb;
+  if (fstat(fd, &sb) == -1 || !S_ISREG(sb.st_mode) || size_t(sb.st_size) < 8 + seek_table_footer_size)
+    return false;
+  unsigned char footer[seek_table_footer_size];
+  if (!pread_all(fd, footer, sizeof(footer), sb.st_size - sizeof(footer)) || get_le32(footer + 5) != seekable_magic)
+    return false;
+  uint32_t number_of_frames = get_le32(footer);
+  unsigned char descriptor = footer[4];
+  if ((descriptor & 0x7c))		// Reserved bits must be zero.
+    return false;
+  size_t entry_size = (descriptor & 0x80) ? 12 : 8;	// The entries contain a checksum if the most significant bit is set.
+  uint64_t table_size = uint64_t(number_of_frames) * entry_size + seek_table_footer_size;
+  if (table_size + 8 > uint64_t(sb.st_size))
+    return false;
+  uint64_t table_offset = sb.st_size - table_size - 8;
+  std::vector<unsigned char> table(table_size + 8);
+  if (!pread_all(fd, table.data(), table.size(), table_offset) ||
+      get_le32(table.data()) != skippable_frame_magic || get_le32(table.data() + 4) != table_size)
+    return false;
+  M_compressed_offset.reserve(number_of_frames + 1);
+  M_uncompressed_offset.reserve(number_of_frames + 1);
+  uint64_t compressed_offset = 0;
+  uint64_t uncompressed_offset = 0;
+  unsigned char const* entry = table.data() + 8;
+  for (uint32_t frame = 0; frame < number_of_frames; ++frame, entry += entry_size)
+  {
+    M_compressed_offset.push_back(compressed_offset);
+    M_uncompressed_offset.push_back(uncompressed_offset);
+    compressed_offset += get_le32(entry);
+    uncompressed_offset += get_le32(entry + 4);
+  }
+  M_compressed_offset.push_back(compressed_offset);
+  M_uncompressed_offset.push_back(uncompressed_offset);
+  // The frames must be followed directly by the seek table.
+  if (compressed_offset != table_offset)
+  {
+    clear();
+    return false;
+  }
+  return true;
+}
+
+size_t ZstdSeekTable::frame(uint64_t offset) const
+{
+  if (offset >= uncompressed_size())
+    return number_of_frames();
+  return std::upper_bound(M_uncompressed_offset.begin(), M_uncompressed_offset.end(), offset) - M_uncompressed_offset.begin() - 1;
+}
+
+//static
+Decompressor::format_type Decompressor::detect(unsigned char const* data, size_t size)
+{
+  if (size >= 2 && data[0] == 0x1f && data[1] == 0x8b)
+    return gzip;
+  if (size >= 3 && data[0] == 'B' && data[1] == 'Z' && data[2] == 'h')
+    return bzip2;
+  if (size >= 4 && ((data[0] == 0x28 && data[1] == 0xb5 && data[2] == 0x2f && data[3] == 0xfd) ||
+                    ((data[0] & 0xf0) == 0x50 && data[1] == 0x2a && data[2] == 0x4d && data[3] == 0x18)))	// A skippable frame.
+    return zstd;
+  return uncompressed;
+}
+
+bool Decompressor::open(std::string const& filename)
+{
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+  return open(fd);
+}
+
+bool Decompressor::open(int fd)
+{
+  close();
+  M_fd = fd;
+  M_input = new char[S_input_buffer_size];
+  M_input_begin = M_input_end = M_input;
+  // Read enough to recognize the format.
+  while (M_input_end - M_input_begin < 4 && !M_eof)
+    if (!fill_input())
+      return false;
+  M_format = detect(reinterpret_cast<unsigned char const*>(M_input_begin), M_input_end - M_input_begin);
+  Dout(dc::notice, "Decompressor::open: format is " << M_format);
+  if (M_format == zstd)
+  {
+#ifdef HAVE_ZSTD
+    M_seek_table.load(fd);
+#else
+    Dout(dc::warning, "Decompressor::open: zstd support was not compiled in.");
+    return false;
+#endif
+  }
+  return M_format == uncompressed || init_stream();
+}
+
+void Decompressor::close()
+{
+  end_stream();
+  delete [] M_input;
+  if (M_fd != -1)
+    ::close(M_fd);
+  M_fd = -1;
+  M_format = uncompressed;
+  M_input = M_input_begin = M_input_end = NULL;
+  M_stream_end = true;
+  M_eof = false;
+  M_error = false;
+  M_position = 0;
+  M_file_bytes_read = 0;
+  M_seek_table.clear();
+}
+
+bool Decompressor::init_stream()
+{
+  switch (M_format)
+  {
+    case gzip:
+    {
+      z_stream* stream = new z_stream;
+      std::memset(stream, 0, sizeof(z_stream));
+      M_stream = stream;
+      // 15 is the maximum window size, 16 means: expect a gzip header.
+      if (inflateInit2(stream, 15 + 16) != Z_OK)
+      {
+	delete stream;
+	M_stream = NULL;
+      }
+      break;
+    }
+    case bzip2:
+    {
+      bz_stream* stream = new bz_stream;
+      std::memset(stream, 0, sizeof(bz_stream));
+      M_stream = stream;
+      if (BZ2_bzDecompressInit(stream, 0, 0) != BZ_OK)
+      {
+	delete stream;
+	M_stream = NULL;
+      }
+      break;
+    }
+    case zstd:
+#ifdef HAVE_ZSTD
+    {
+      ZSTD_DStream* stream = ZSTD_createDStream();
+      if (stream && ZSTD_isError(ZSTD_initDStream(stream)))
+      {
+	ZSTD_freeDStream(stream);
+	stream = NULL;
+      }
+      M_stream = stream;
+    }
+#endif
+      break;
+    case uncompressed:
+      break;
+  }
+  if (!M_stream)
+    M_error = true;
+  return M_stream;
+}
+
+void Decompressor::end_stream()
+{
+  if (!M_stream)
+    return;
+  switch (M_format)
+  {
+    case gzip:
+      inflateEnd(static_cast<z_stream*>(M_stream));
+      delete static_cast<z_stream*>(M_stream);
+      break;
+    case bzip2:
+      BZ2_bzDecompressEnd(static_cast<bz_stream*>(M_stream));
+      delete static_cast<bz_stream*>(M_stream);
+      break;
+    case zstd:
+#ifdef HAVE_ZSTD
+      ZSTD_freeDStream(static_cast<ZSTD_DStream*>(M_stream));
+#endif
+      break;
+    case uncompressed:
+      break;
+  }
+  M_stream = NULL;
+}
+
+// Read up to size bytes from M_fd. Returns 0 at the end of the file or when cancelled, and -1 on error.
+ssize_t Decompressor::read_fd(char* buf, size_t size)
+{
+  if (M_cancelled)
+  {
+    // Don't block in read, so that the cancel flag is seen.
+    struct pollfd pfd;
+    pfd.fd = M_fd;
+    pfd.events = POLLIN;
+    int ready;
+    while ((ready = poll(&pfd, 1, S_poll_interval)) == 0 || (ready == -1 && errno == EINTR))
+      if (M_cancelled->load(std::memory_order_relaxed))
+      {
+	Dout(dc::notice, "Decompressor::read_fd: cancelled.");
+	return 0;
+      }
+    // On error or hang up, let read report it.
+  }
+  ssize_t len;
+  do
+    len = ::read(M_fd, buf, size);
+  while (len == -1 && errno == EINTR);
+  if (len == -1)
+  {
+    Dout(dc::warning, "Decompressor::read_fd: read: " << std::strerror(errno));
+    M_error = true;
+    return -1;
+  }
+  M_file_bytes_read += len;
+  return len;
+}
+
+// Move the unprocessed input to the start of the buffer and fill the rest.
+bool Decompressor::fill_input()
+{
+  size_t unprocessed = M_input_end - M_input_begin;
+  if (M_input_begin != M_input)
+  {
+    std::memmove(M_input, M_input_begin, unprocessed);
+    M_input_begin = M_input;
+    M_input_end = M_input + unprocessed;
+  }
+  ssize_t len = read_fd(M_input_end, S_input_buffer_size - unprocessed);
+  if (len == -1)
+    return false;
+  if (len == 0)
+    M_eof = true;
+  M_input_end += len;
+  return true;
+}
+
+// Decompress the available input into buf. Returns the number of bytes written to buf.
+size_t Decompressor::decompress(char* buf, size_t size)
+{
+  if (M_stream_end)
+  {
+    // Another gzip member, bzip2 stream or zstd frame follows. Ignore trailing garbage.
+    if (M_input_end - M_input_begin < 4 && !M_eof && !fill_input())
+      return 0;
+    if (detect(reinterpret_cast<unsigned char const*>(M_input_begin), M_input_end - M_input_begin) != M_format)
+    {
+      Dout(dc::notice, "Decompressor::decompress: ignoring " << (M_input_end - M_input_begin) << " bytes of trailing garbage.");
+      M_input_begin = M_input_end;
+      M_eof = true;
+      return 0;
+    }
+  }
+  size_t avail_in = M_input_end - M_input_begin;
+  size_t len = 0;
+  switch (M_format)
+  {
+    case gzip:
+    {
+      z_stream* stream = static_cast<z_stream*>(M_stream);
+      if (M_stream_end)
+      {
+	inflateReset(stream);
+	M_stream_end = false;
+      }
+      stream->next_in = reinterpret_cast<Bytef*>(M_input_begin);
+      stream->avail_in = std::min(avail_in, size_t(UINT_MAX));
+      stream->next_out = reinterpret_cast<Bytef*>(buf);
+      stream->avail_out = std::min(size, size_t(UINT_MAX));
+      uInt avail_out = stream->avail_out;
+      int ret = inflate(stream, Z_NO_FLUSH);
+      M_input_begin = reinterpret_cast<char*>(stream->next_in);
+      len = avail_out - stream->avail_out;
+      if (ret == Z_STREAM_END)
+	M_stream_end = true;
+      else if (G_UNLIKELY(ret != Z_OK && ret != Z_BUF_ERROR))
+      {
+	Dout(dc::warning, "Decompressor::decompress: inflate: " << (stream->msg ? stream->msg : "error " + std::to_string(ret)));
+	M_error = true;
+      }
+      break;
+    }
+    case bzip2:
+    {
+      bz_stream* stream = static_cast<bz_stream*>(M_stream);
+      if (M_stream_end)
+      {
+	// libbzip2 has no reset.
+	BZ2_bzDecompressEnd(stream);
+	std::memset(stream, 0, sizeof(bz_stream));
+	if (BZ2_bzDecompressInit(stream, 0, 0) != BZ_OK)
+	{
+	  M_error = true;
+	  return 0;
+	}
+	M_stream_end = false;
+      }
+      stream->next_in = M_input_begin;
+      stream->avail_in = std::min(avail_in, size_t(UINT_MAX));
+      stream->next_out = buf;
+      stream->avail_out = std::min(size, size_t(UINT_MAX));
+      unsigned int avail_out = stream->avail_out;
+      int ret = BZ2_bzDecompress(stream);
+      M_input_begin = stream->next_in;
+      len = avail_out - stream->avail_out;
+      if (ret == BZ_STREAM_END)
+	M_stream_end = true;
+      else if (G_UNLIKELY(ret != BZ_OK))
+      {
+	Dout(dc::warning, "Decompressor::decompress: BZ2_bzDecompress returned " << ret);
+	M_error = true;
+      }
+      break;
+    }
+    case zstd:
+    {
+#ifdef HAVE_ZSTD
+      ZSTD_inBuffer input = { M_input_begin, avail_in, 0 };
+      ZSTD_outBuffer output = { buf, size, 0 };
+      size_t ret = ZSTD_decompressStream(static_cast<ZSTD_DStream*>(M_stream), &output, &input);
+      M_input_begin += input.pos;
+      len = output.pos;
+      if (G_UNLIKELY(ZSTD_isError(ret)))
+      {
+	Dout(dc::warning, "Decompressor::decompress: " << ZSTD_getErrorName(ret));
+	M_error = true;
+      }
+      else
+	M_stream_end = ret == 0;	// Zero means that a frame was completely decoded and flushed.
+#endif
+      break;
+    }
+    case uncompressed:
+      break;
+  }
+  return len;
+}
+
+ssize_t Decompressor::read(char* buf, size_t size)
+{
+  if (G_UNLIKELY(M_error))
+    return -1;
+  size_t len = 0;
+  if (M_format == uncompressed)
+  {
+    if (M_input_begin != M_input_end)
+    {
+      // Return what was read while detecting the format first.
+      len = std::min(size, size_t(M_input_end - M_input_begin));
+      std::memcpy(buf, M_input_begin, len);
+      M_input_begin += len;
+    }
+    else if (!M_eof)
+    {
+      ssize_t n = read_fd(buf, size);
+      if (n == -1)
+	return -1;
+      M_eof = n == 0;
+      len = n;
+    }
+  }
+  else
+  {
+    while (len == 0 && size > 0)
+    {
+      if (M_input_begin == M_input_end && !M_eof && !fill_input())
+	return -1;
+      bool no_input = M_input_begin == M_input_end;
+      if (no_input && M_stream_end)
+	break;
+      len = decompress(buf, size);
+      if (G_UNLIKELY(M_error))
+	return -1;
+      if (len == 0 && no_input)
+      {
+	// The decompressor needs more input, but there is none.
+	Dout(dc::warning, "Decompressor::read: the compressed file is truncated.");
+	M_error = true;
+	return -1;
+      }
+    }
+  }
+  M_position += len;
+  return len;
+}
+
+bool Decompressor::seek(uint64_t offset)
+{
+  if (M_fd == -1 || !seekable())
+    return false;
+  uint64_t position;
+  if (M_format == uncompressed)
+  {
+    if (lseek(M_fd, offset, SEEK_SET) == -1)
+      return false;
+    position = offset;
+  }
+  else
+  {
+    if (offset > M_seek_table.uncompressed_size())
+      return false;
+    size_t frame = M_seek_table.frame(offset);
+    if (lseek(M_fd, M_seek_table.compressed_offset(frame), SEEK_SET) == -1)
+      return false;
+    end_stream();
+    if (!init_stream())
+      return false;
+    position = M_seek_table.uncompressed_offset(frame);
+  }
+  M_input_begin = M_input_end = M_input;
+  M_stream_end = true;
+  M_eof = false;
+  M_error = false;
+  M_position = position;
+  // Skip the start of the frame.
+  char buf[4096];
+  while (M_position < offset)
+    if (read(buf, std::min(sizeof(buf), size_t(offset - M_position))) <= 0)
+      return false;
+  return true;
+}
+
+} // namespace util
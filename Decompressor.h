@@ -0,0 +1,199 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file Decompressor.h This file contains the declaration of class Decompressor.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <sys/types.h>
+
+namespace util {
+
+/** @brief The seek table of a file in the zstd seekable format.
+ *
+ * A seekable zstd file consists of independently compressed frames,
+ * followed by a skippable frame that lists the compressed and decompressed
+ * size of each frame. This makes it possible to start decompressing at
+ * the frame that contains a given uncompressed offset.
+ */
+class ZstdSeekTable {
+  private:
+    std::vector<uint64_t> M_compressed_offset;		//!< The file offset of each frame, plus the offset of the seek table.
+    std::vector<uint64_t> M_uncompressed_offset;	//!< The uncompressed offset of each frame, plus the total uncompressed size.
+
+  public:
+    /** @brief Read the seek table at the end of the file \a fd.
+     *
+     * @returns FALSE if the file doesn't end with a seek table.
+     */
+    bool load(int fd);
+
+    //! Forget the seek table.
+    void clear() { M_compressed_offset.clear(); M_uncompressed_offset.clear(); }
+
+    //! Return TRUE if no seek table was loaded.
+    bool empty() const { return M_compressed_offset.empty(); }
+
+    //! Return the number of frames.
+    size_t number_of_frames() const { return empty() ? 0 : M_compressed_offset.size() - 1; }
+
+    //! Return the total uncompressed size.
+    uint64_t uncompressed_size() const { return empty() ? 0 : M_uncompressed_offset.back(); }
+
+    //! Return the frame that contains uncompressed offset \a offset, or number_of_frames() if \a offset is past the end.
+    size_t frame(uint64_t offset) const;
+
+    //! Return the file offset of frame \a frame.
+    uint64_t compressed_offset(size_t frame) const { return M_compressed_offset[frame]; }
+
+    //! Return the uncompressed offset of the first byte of frame \a frame.
+    uint64_t uncompressed_offset(size_t frame) const { return M_uncompressed_offset[frame]; }
+};
+
+/** @brief A reader that transparently decompresses gzip, bzip2 and zstd files.
+ *
+ * The format is detected from the first bytes of the file, so that
+ * uncompressed files are read as they are. Concatenated gzip members,
+ * bzip2 streams and zstd frames are decompressed one after another.
+ * Support for zstd is only available when compiled with HAVE_ZSTD.
+ *
+ * Usage example:
+ * \code
+ * util::Decompressor decompressor;
+ * if (decompressor.open("games.pgn.gz"))
+ *   while ((len = decompressor.read(buf, sizeof(buf))) > 0)
+ *     process(buf, len);
+ * \endcode
+ */
+class Decompressor {
+  public:
+    //! The supported file formats.
+    enum format_type {
+      uncompressed,
+      gzip,
+      bzip2,
+      zstd
+    };
+
+    static size_t const S_input_buffer_size = 256 * 1024;	//!< The number of compressed bytes read at a time.
+    static int const S_poll_interval = 250;			//!< The number of milliseconds between checks of the cancel flag.
+
+  private:
+    int M_fd;					//!< The file descriptor that is read from, or -1.
+    format_type M_format;			//!< The detected format.
+    char* M_input;				//!< The input buffer.
+    char* M_input_begin;			//!< The first byte in M_input that wasn't decompressed yet.
+    char* M_input_end;				//!< One past the last byte read into M_input.
+    void* M_stream;				//!< The decompression state of zlib, libbzip2 or libzstd.
+    bool M_stream_end;				//!< Set when the last gzip member, bzip2 stream or zstd frame was completely decompressed.
+    bool M_eof;					//!< Set when the end of the file was reached.
+    bool M_error;				//!< Set when reading or decompressing failed.
+    uint64_t M_position;			//!< The number of uncompressed bytes before the next byte that is returned by read.
+    uint64_t M_file_bytes_read;			//!< The number of bytes read from the file descriptor.
+    ZstdSeekTable M_seek_table;			//!< The seek table of a seekable zstd file.
+    std::atomic<bool> const* M_cancelled;	//!< If not NULL, reading stops when this becomes true.
+
+  public:
+    //! Construct a closed decompressor.
+    Decompressor() : M_fd(-1), M_format(uncompressed), M_input(NULL), M_input_begin(NULL), M_input_end(NULL), M_stream(NULL),
+        M_stream_end(true), M_eof(false), M_error(false), M_position(0), M_file_bytes_read(0), M_cancelled(NULL) { }
+    ~Decompressor() { close(); }
+
+    Decompressor(Decompressor const&) = delete;
+    Decompressor& operator=(Decompressor const&) = delete;
+
+    /** @brief Open \a filename and detect its format.
+     *
+     * @returns FALSE if the file could not be opened or its format is not supported.
+     */
+    bool open(std::string const& filename);
+
+    /** @brief Start reading from \a fd, which is closed by close().
+     *
+     * \a fd doesn't need to be seekable.
+     *
+     * @returns FALSE if reading failed or the format is not supported.
+     */
+    bool open(int fd);
+
+    /** @brief Stop reading as soon as \a *cancelled becomes true.
+     *
+     * Without this, reading a pipe or socket blocks until data arrives. With it,
+     * the file descriptor is polled and reading ends, as if the end of the file was
+     * reached, within S_poll_interval milliseconds after \a *cancelled became true.
+     * Survives close().
+     */
+    void set_cancel_flag(std::atomic<bool> const* cancelled) { M_cancelled = cancelled; }
+
+    //! Release all resources and close the file descriptor.
+    void close();
+
+    /** @brief Read up to \a size uncompressed bytes into \a buf.
+     *
+     * @returns The number of bytes read, 0 at the end of the file or -1 on error, including a truncated compressed file.
+     */
+    ssize_t read(char* buf, size_t size);
+
+    /** @brief Continue reading at uncompressed offset \a offset.
+     *
+     * This is possible for uncompressed files and for zstd files with a seek table,
+     * provided that the file descriptor is seekable. For the latter only the frame
+     * that contains \a offset is decompressed.
+     *
+     * @returns FALSE if seeking is not possible.
+     */
+    bool seek(uint64_t offset);
+
+    //! Return the detected format.
+    format_type format() const { return M_format; }
+
+    //! Return TRUE if seek can be used.
+    bool seekable() const { return M_format == uncompressed || !M_seek_table.empty(); }
+
+    //! Return the uncompressed offset of the next byte that read returns.
+    uint64_t position() const { return M_position; }
+
+    //! Return the number of (compressed) bytes that were read from the file so far.
+    uint64_t file_bytes_read() const { return M_file_bytes_read; }
+
+    //! Return TRUE if reading or decompressing failed.
+    bool error() const { return M_error; }
+
+    //! Return the seek table, which is empty unless a seekable zstd file is being read.
+    ZstdSeekTable const& seek_table() const { return M_seek_table; }
+
+    //! Return the format of a file starting with the \a size bytes at \a data.
+    static format_type detect(unsigned char const* data, size_t size);
+
+  private:
+    ssize_t read_fd(char* buf, size_t size);
+    bool fill_input();
+    bool init_stream();
+    void end_stream();
+    size_t decompress(char* buf, size_t size);
+};
+
+} // namespace util
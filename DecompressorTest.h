@@ -0,0 +1,257 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file DecompressorTest.h Testsuite for util::Decompressor.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "Decompressor.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class DecompressorTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DecompressorTest);
+
+  CPPUNIT_TEST(testDetect);
+  CPPUNIT_TEST(testDecompress);
+  CPPUNIT_TEST(testSeek);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    std::string M_text;
+
+  public:
+    DecompressorTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testDetect();
+    void testDecompress();
+    void testSeek();
+
+  private:
+    std::string read_all(std::string const& data, size_t chunk_size, bool& error);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include <random>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <bzlib.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DecompressorTest);
+
+namespace {
+
+// Return data compressed as a single gzip member.
+std::string gzip_compress(std::string const& data)
+{
+  z_stream stream;
+  std::memset(&stream, 0, sizeof(stream));
+  deflateInit2(&stream, 6, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+  std::string result(deflateBound(&stream, data.size()), '\0');
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  stream.avail_in = data.size();
+  stream.next_out = reinterpret_cast<Bytef*>(&result[0]);
+  stream.avail_out = result.size();
+  deflate(&stream, Z_FINISH);
+  result.resize(stream.total_out);
+  deflateEnd(&stream);
+  return result;
+}
+
+// Return data compressed as a single bzip2 stream.
+std::string bzip2_compress(std::string const& data)
+{
+  std::string result(data.size() + data.size() / 100 + 600, '\0');
+  unsigned int length = result.size();
+  BZ2_bzBuffToBuffCompress(&result[0], &length, const_cast<char*>(data.data()), data.size(), 9, 0, 0);
+  result.resize(length);
+  return result;
+}
+
+void put_le32(std::string& data, uint32_t value)
+{
+  for (int i = 0; i < 4; ++i)
+    data += static_cast<char>(value >> (8 * i));
+}
+
+} // namespace
+
+void DecompressorTest::setUp()
+{
+  // A megabyte of PGN-like text.
+  std::mt19937 random_number_generator(3141592653);
+  while (M_text.size() < 1000000)
+  {
+    M_text += "[Event \"Test " + std::to_string(random_number_generator() % 1000) + "\"]\n\n";
+    for (int move = 1; move < 40; ++move)
+      M_text += std::to_string(move) + ". e" + std::to_string(random_number_generator() % 8 + 1) + ' ';
+    M_text += "1-0\n\n";
+  }
+}
+
+void DecompressorTest::tearDown()
+{
+  M_text.clear();
+}
+
+// Write data to a file and return what the Decompressor reads from it.
+std::string DecompressorTest::read_all(std::string const& data, size_t chunk_size, bool& error)
+{
+  TempFile file("DecompressorTest", data);
+  util::Decompressor decompressor;
+  CPPUNIT_ASSERT(decompressor.open(file.filename()));
+  std::string result;
+  std::vector<char> buf(chunk_size);
+  ssize_t len;
+  while ((len = decompressor.read(buf.data(), buf.size())) > 0)
+    result.append(buf.data(), len);
+  error = len == -1;
+  CPPUNIT_ASSERT(error == decompressor.error());
+  CPPUNIT_ASSERT(error || decompressor.position() == result.size());
+  return result;
+}
+
+void DecompressorTest::testDetect()
+{
+  unsigned char const gzip_magic[] = { 0x1f, 0x8b, 8, 0 };
+  unsigned char const bzip2_magic[] = { 'B', 'Z', 'h', '9' };
+  unsigned char const zstd_magic[] = { 0x28, 0xb5, 0x2f, 0xfd };
+  unsigned char const skippable_magic[] = { 0x5e, 0x2a, 0x4d, 0x18 };
+  unsigned char const text[] = { '[', 'E', 'v', 'e' };
+  CPPUNIT_ASSERT(util::Decompressor::detect(gzip_magic, 4) == util::Decompressor::gzip);
+  CPPUNIT_ASSERT(util::Decompressor::detect(bzip2_magic, 4) == util::Decompressor::bzip2);
+  CPPUNIT_ASSERT(util::Decompressor::detect(zstd_magic, 4) == util::Decompressor::zstd);
+  CPPUNIT_ASSERT(util::Decompressor::detect(skippable_magic, 4) == util::Decompressor::zstd);
+  CPPUNIT_ASSERT(util::Decompressor::detect(text, 4) == util::Decompressor::uncompressed);
+  CPPUNIT_ASSERT(util::Decompressor::detect(zstd_magic, 3) == util::Decompressor::uncompressed);
+  CPPUNIT_ASSERT(util::Decompressor::detect(text, 0) == util::Decompressor::uncompressed);
+}
+
+void DecompressorTest::testDecompress()
+{
+  bool error;
+  // Uncompressed files are passed through.
+  CPPUNIT_ASSERT(read_all(M_text, 1000, error) == M_text && !error);
+  CPPUNIT_ASSERT(read_all("[E", 1000, error) == "[E" && !error);
+  CPPUNIT_ASSERT(read_all("", 1000, error).empty() && !error);
+
+  std::string gzip = gzip_compress(M_text);
+  std::string bzip2 = bzip2_compress(M_text);
+  for (size_t chunk_size : { 1, 4096, 1000000 })
+  {
+    if (chunk_size == 1)
+    {
+      // Byte by byte is slow; only do it for the start.
+      util::Decompressor decompressor;
+      TempFile file("DecompressorTest", gzip);
+      CPPUNIT_ASSERT(decompressor.open(file.filename()) && decompressor.format() == util::Decompressor::gzip);
+      for (size_t i = 0; i < 10000; ++i)
+      {
+	char c;
+	CPPUNIT_ASSERT(decompressor.read(&c, 1) == 1 && c == M_text[i]);
+      }
+      continue;
+    }
+    CPPUNIT_ASSERT(read_all(gzip, chunk_size, error) == M_text && !error);
+    CPPUNIT_ASSERT(read_all(bzip2, chunk_size, error) == M_text && !error);
+  }
+
+  // Concatenated gzip members and bzip2 streams, as produced by parallel compressors.
+  size_t half = M_text.size() / 2;
+  std::string first(M_text.substr(0, half));
+  std::string second(M_text.substr(half));
+  CPPUNIT_ASSERT(read_all(gzip_compress(first) + gzip_compress(second), 4096, error) == M_text && !error);
+  CPPUNIT_ASSERT(read_all(bzip2_compress(first) + bzip2_compress(second), 4096, error) == M_text && !error);
+
+  // Trailing zeroes are ignored.
+  CPPUNIT_ASSERT(read_all(gzip + std::string(100, '\0'), 4096, error) == M_text && !error);
+
+  // A truncated file is an error, after returning what could be decompressed.
+  std::string text = read_all(gzip.substr(0, gzip.size() / 2), 4096, error);
+  CPPUNIT_ASSERT(error && !text.empty() && M_text.compare(0, text.size(), text) == 0);
+  read_all(bzip2.substr(0, bzip2.size() - 10), 4096, error);
+  CPPUNIT_ASSERT(error);
+}
+
+void DecompressorTest::testSeek()
+{
+  // Uncompressed files can be seeked.
+  util::Decompressor decompressor;
+  TempFile text_file("DecompressorTest", M_text);
+  CPPUNIT_ASSERT(decompressor.open(text_file.filename()) && decompressor.seekable());
+  text_file.remove();
+  char buf[100];
+  for (size_t offset : { size_t(500000), size_t(3), size_t(999900) })
+  {
+    CPPUNIT_ASSERT(decompressor.seek(offset) && decompressor.position() == offset);
+    CPPUNIT_ASSERT(decompressor.read(buf, sizeof(buf)) == sizeof(buf) && M_text.compare(offset, sizeof(buf), buf, sizeof(buf)) == 0);
+  }
+
+  // Gzip files can not.
+  TempFile gzip_file("DecompressorTest", gzip_compress(M_text));
+  CPPUNIT_ASSERT(decompressor.open(gzip_file.filename()) && !decompressor.seekable() && !decompressor.seek(10));
+  gzip_file.remove();
+
+  // A seek table of three frames. The content of the frames doesn't matter for the seek table.
+  std::string data(10 + 20 + 30, 'x');
+  std::string table;
+  put_le32(table, 0x184D2A5E);		// Skippable frame magic.
+  put_le32(table, 3 * 12 + 9);		// Frame size.
+  uint32_t const frame_sizes[3][2] = { { 10, 1000 }, { 20, 2000 }, { 30, 500 } };
+  for (int frame = 0; frame < 3; ++frame)
+  {
+    put_le32(table, frame_sizes[frame][0]);
+    put_le32(table, frame_sizes[frame][1]);
+    put_le32(table, 0);			// Checksum.
+  }
+  put_le32(table, 3);			// Number of frames.
+  table += '\x80';			// Checksums present.
+  put_le32(table, 0x8F92EAB1);		// Seekable magic.
+  TempFile seekable_file("DecompressorTest", data + table);
+  util::ZstdSeekTable seek_table;
+  CPPUNIT_ASSERT(seek_table.load(seekable_file.fd()));
+  CPPUNIT_ASSERT(seek_table.number_of_frames() == 3 && seek_table.uncompressed_size() == 3500);
+  CPPUNIT_ASSERT(seek_table.frame(0) == 0 && seek_table.frame(999) == 0 && seek_table.frame(1000) == 1);
+  CPPUNIT_ASSERT(seek_table.frame(3499) == 2 && seek_table.frame(3500) == 3);
+  CPPUNIT_ASSERT(seek_table.compressed_offset(2) == 30 && seek_table.uncompressed_offset(2) == 3000);
+
+  // The frames must end where the seek table starts.
+  TempFile misaligned_file("DecompressorTest", data + "y" + table);
+  CPPUNIT_ASSERT(!seek_table.load(misaligned_file.fd()) && seek_table.empty());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
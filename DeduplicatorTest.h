@@ -0,0 +1,201 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file DeduplicatorTest.h Testsuite for pgn::Deduplicator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnDeduplicator.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class DeduplicatorTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DeduplicatorTest);
+
+  CPPUNIT_TEST(testFingerprint);
+  CPPUNIT_TEST(testClusters);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    pgn::TagStore M_tag_store[2];
+    pgn::MoveStore M_move_store[2];
+
+  public:
+    DeduplicatorTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testFingerprint();
+    void testClusters();
+
+  private:
+    void deduplicate(pgn::Deduplicator& deduplicator, size_t& clusters);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "RandomGame.h"
+#include <random>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DeduplicatorTest);
+
+void DeduplicatorTest::setUp()
+{
+  // Database 0 has 600 random games of up to 60 plies. Database 1 contains every
+  // fifth of those games, with other tags, after 100 new games.
+  std::mt19937 random_number_generator(3141592653);
+  ChessPosition chess_position;
+  for (int game = 0; game < 700; ++game)
+  {
+    pgn::TagStore& tag_store(M_tag_store[game < 600 ? 0 : 1]);
+    pgn::MoveStore& move_store(M_move_store[game < 600 ? 0 : 1]);
+    tag_store.begin_game(0);
+    tag_store.add_tag("White", "Player" + std::to_string(game));
+    move_store.begin_game();
+    chess_position.initial_position();
+    random_game(random_number_generator, chess_position, move_store, 20 + random_number_generator() % 41);
+  }
+  for (uint32_t game_id = 0; game_id < 600; game_id += 5)
+  {
+    M_tag_store[1].begin_game(0);
+    M_tag_store[1].add_tag("White", "Copy" + std::to_string(game_id));
+    M_move_store[1].begin_game();
+    for (size_t ply = 0; ply < M_move_store[0].number_of_moves(game_id); ++ply)
+      M_move_store[1].add(pgn::MoveStore::decode(M_move_store[0].moves(game_id)[ply]));
+  }
+}
+
+void DeduplicatorTest::tearDown()
+{
+  for (int database = 0; database < 2; ++database)
+  {
+    M_tag_store[database].clear();
+    M_move_store[database].clear();
+  }
+}
+
+void DeduplicatorTest::testFingerprint()
+{
+  pgn::TagStore tag_store;
+  pgn::MoveStore move_store;
+  static char const* const players[4][2] = {
+    { "Carlsen, Magnus", "Anand, Viswanathan" },
+    { "CARLSEN, M.", "Anand,V" },
+    { "Kasparov, Garry", "Anand, Viswanathan" },
+    { "Carlsen, Magnus", "Anand, Viswanathan" }
+  };
+  for (int game = 0; game < 5; ++game)
+  {
+    tag_store.begin_game(0);
+    tag_store.add_tag("White", players[game % 4][0]);
+    tag_store.add_tag("Black", players[game % 4][1]);
+    move_store.begin_game();
+    // Game 3 has other moves; game 4 starts from the initial position, with other move counters.
+    if (game == 4)
+      move_store.set_FEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 5 20");
+    move_store.add(Move(Index(4, 1), Index(4, 3), nothing));				// 1. e4
+    move_store.add(Move(Index(game == 3 ? 4 : 2, 6), Index(game == 3 ? 4 : 2, 4), nothing));	// 1... e5 or 1... c5
+    move_store.add(Move(Index(6, 0), Index(5, 2), nothing));				// 2. Nf3
+  }
+  using pgn::Deduplicator;
+  auto fingerprint = [&](uint32_t game_id, unsigned int key_tags) { return Deduplicator::fingerprint(tag_store, move_store, game_id, key_tags); };
+  CPPUNIT_ASSERT(fingerprint(0, 0) == fingerprint(1, 0));
+  CPPUNIT_ASSERT(fingerprint(0, 0) == fingerprint(2, 0));
+  CPPUNIT_ASSERT(fingerprint(0, 0) != fingerprint(3, 0));
+  CPPUNIT_ASSERT(fingerprint(0, Deduplicator::key_players) == fingerprint(1, Deduplicator::key_players));
+  CPPUNIT_ASSERT(fingerprint(0, Deduplicator::key_players) != fingerprint(2, Deduplicator::key_players));
+  CPPUNIT_ASSERT(fingerprint(0, Deduplicator::key_players) != fingerprint(0, 0));
+  // A FEN of the initial position is not the same as no FEN, but the move counters don't matter.
+  CPPUNIT_ASSERT(fingerprint(0, 0) != fingerprint(4, 0));
+  move_store.set_FEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  Deduplicator::Fingerprint fingerprint4 = fingerprint(4, 0);
+  CPPUNIT_ASSERT(fingerprint4 == fingerprint(4, 0));
+}
+
+void DeduplicatorTest::deduplicate(pgn::Deduplicator& deduplicator, size_t& clusters)
+{
+  clusters = 0;
+  deduplicator.add_database(0, M_tag_store[0], M_move_store[0]);
+  // Add the second database one game at a time.
+  for (uint32_t game_id = 0; game_id < M_move_store[1].size(); ++game_id)
+    deduplicator.add(1, game_id, M_tag_store[1], M_move_store[1], game_id);
+  CPPUNIT_ASSERT(deduplicator.finish([&](pgn::Deduplicator::GameRef const* games, size_t size) {
+    CPPUNIT_ASSERT(size == 2 && games[0].database == 0 && games[1].database == 1 && games[0].game == (games[1].game - 100) * 5);
+    ++clusters;
+  }));
+  CPPUNIT_ASSERT(deduplicator.number_of_games() == 820);
+  for (uint32_t game_id = 0; game_id < 600; ++game_id)
+    CPPUNIT_ASSERT(!deduplicator.is_duplicate(0, game_id));
+  for (uint32_t game_id = 0; game_id < 220; ++game_id)
+    CPPUNIT_ASSERT(deduplicator.is_duplicate(1, game_id) == (game_id >= 100));
+}
+
+void DeduplicatorTest::testClusters()
+{
+  size_t clusters;
+  {
+    // A few of the random games end in mate or stalemate early; don't skip them.
+    pgn::Deduplicator::Options options;
+    options.min_plies = 0;
+    options.number_of_threads = 3;
+    pgn::Deduplicator deduplicator(options);
+    deduplicate(deduplicator, clusters);
+    CPPUNIT_ASSERT(!deduplicator.spilled() && clusters == 120 && deduplicator.number_of_duplicates() == 120);
+  }
+  {
+    // With room for only 100 fingerprints.
+    pgn::Deduplicator::Options options;
+    options.min_plies = 0;
+    options.number_of_threads = 2;
+    options.memory_budget = 100 * (sizeof(pgn::Deduplicator::Fingerprint) + sizeof(pgn::Deduplicator::GameRef));
+    pgn::Deduplicator deduplicator(options);
+    deduplicate(deduplicator, clusters);
+    CPPUNIT_ASSERT(deduplicator.spilled() && clusters == 120 && deduplicator.number_of_clusters() == 120);
+  }
+  {
+    // With the players as key, there are no duplicates.
+    pgn::Deduplicator::Options options;
+    options.key_tags = pgn::Deduplicator::key_players;
+    pgn::Deduplicator deduplicator(options);
+    deduplicator.add_database(0, M_tag_store[0], M_move_store[0]);
+    deduplicator.add_database(1, M_tag_store[1], M_move_store[1]);
+    CPPUNIT_ASSERT(deduplicator.finish() && deduplicator.number_of_duplicates() == 0);
+    // Games shorter than min_plies were skipped.
+    size_t long_games = 0;
+    for (int database = 0; database < 2; ++database)
+      for (uint32_t game_id = 0; game_id < M_move_store[database].size(); ++game_id)
+	long_games += M_move_store[database].number_of_moves(game_id) >= options.min_plies;
+    CPPUNIT_ASSERT(deduplicator.number_of_games() == long_games && long_games < 820);
+  }
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
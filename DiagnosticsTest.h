@@ -0,0 +1,175 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file DiagnosticsTest.h Testsuite for pgn::Diagnostics.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnDiagnostics.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class DiagnosticsTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DiagnosticsTest);
+
+  CPPUNIT_TEST(testBounded);
+  CPPUNIT_TEST(testLowerBound);
+  CPPUNIT_TEST(testParser);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    DiagnosticsTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testBounded();
+    void testLowerBound();
+    void testParser();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "PgnDatabase.h"
+#include "TempFile.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DiagnosticsTest);
+
+void DiagnosticsTest::testBounded()
+{
+  using cwchess::pgn::Diagnostics;
+  Diagnostics diagnostics(3);
+  CPPUNIT_ASSERT(diagnostics.empty() && diagnostics.size() == 0);
+  diagnostics.begin_game(100, 2);
+  diagnostics.add(Diagnostics::illegal_move, 12, 5, "Ke3");
+  diagnostics.begin_game(200, 3);
+  diagnostics.add(Diagnostics::invalid_FEN, 20, 1, std::string(100, 'x'));
+  diagnostics.add(Diagnostics::missing_termination, 25, 1);
+  diagnostics.begin_game(300, 4);
+  diagnostics.add(Diagnostics::illegal_move, 30, 7, "Qh9");
+  diagnostics.add(Diagnostics::truncated_game, 31, 1);
+  CPPUNIT_ASSERT(diagnostics.size() == 3 && diagnostics.total() == 5 && diagnostics.dropped() == 2);
+  CPPUNIT_ASSERT(diagnostics.count(Diagnostics::illegal_move) == 2 && diagnostics.count(Diagnostics::parse_error) == 0);
+  Diagnostics::Entry const& entry(diagnostics[0]);
+  CPPUNIT_ASSERT(entry.offset == 100 && entry.game == 2 && entry.line == 12 && entry.column == 5 && entry.snippet() == "Ke3");
+  CPPUNIT_ASSERT(diagnostics[1].snippet() == std::string(Diagnostics::S_max_snippet_length, 'x'));
+  CPPUNIT_ASSERT(diagnostics[2].kind == Diagnostics::missing_termination && diagnostics[2].snippet().empty());
+  std::ostringstream os;
+  os << entry;
+  CPPUNIT_ASSERT(os.str() == "game 2 at offset 100, line 12:5: illegal move \"Ke3\"");
+  os.str("");
+  diagnostics.print_counts(os);
+  CPPUNIT_ASSERT(os.str() == "1 missing game termination, 1 truncated game, 2 illegal move, 1 invalid FEN");
+  diagnostics.clear();
+  CPPUNIT_ASSERT(diagnostics.empty() && diagnostics.size() == 0);
+}
+
+void DiagnosticsTest::testLowerBound()
+{
+  using cwchess::pgn::Diagnostics;
+  Diagnostics diagnostics;
+  for (uint32_t game = 0; game < 100; ++game)
+  {
+    diagnostics.begin_game(game * 1000, game);
+    if (game % 10 == 3)
+      diagnostics.add(Diagnostics::truncated_game, game * 20, 1);
+  }
+  CPPUNIT_ASSERT(diagnostics.lower_bound(0)->game == 3);
+  CPPUNIT_ASSERT(diagnostics.lower_bound(3000)->game == 3);
+  CPPUNIT_ASSERT(diagnostics.lower_bound(3001)->game == 13);
+  CPPUNIT_ASSERT(diagnostics.lower_bound(40000) - diagnostics.lower_bound(20000) == 2);
+  CPPUNIT_ASSERT(diagnostics.lower_bound(100000) == diagnostics.end());
+}
+
+namespace {
+
+Glib::RefPtr<Glib::MainLoop> diagnostics_test_main_loop;
+
+void diagnostics_test_open_finished(size_t)
+{
+  diagnostics_test_main_loop->quit();
+}
+
+} // namespace
+
+void DiagnosticsTest::testParser()
+{
+  using cwchess::pgn::Diagnostics;
+  TempFile file("DiagnosticsTest",
+      "[Event \"Clean\"]\n"			// Line 1.
+      "\n"
+      "1. e4 e5 2. Nf3 1-0\n"
+      "\n"
+      "[Event \"Malformed\"]\n"		// Line 5.
+      "[White Carlsen]\n"
+      "[Black \"Nakamura\"]\n"
+      "\n"
+      "1. d4 d5 *\n"
+      "\n"
+      "[Event \"Illegal\"]\n"		// Line 11.
+      "\n"
+      "1. e4 e5 2. Ke3 *\n"
+      "\n"
+      "[Event \"Unterminated\"]\n"		// Line 15.
+      "\n"
+      "1. c4\n"
+      "\n"
+      "[Event \"Truncated\"]\n"		// Line 19.
+      "\n"
+      "1. Nf3 Nf6\n");
+
+  // Parse the file in a main loop, like the GUI does; the report that the parser prints is discarded.
+  std::ostringstream report;
+  std::streambuf* cout_buf = std::cout.rdbuf(report.rdbuf());
+  diagnostics_test_main_loop = Glib::MainLoop::create(false);
+  Glib::RefPtr<cwchess::pgn::Database> database =
+      cwchess::pgn::DatabaseSeekable::open(file.filename(), sigc::ptr_fun(&diagnostics_test_open_finished));
+  diagnostics_test_main_loop->run();
+  diagnostics_test_main_loop.reset();
+  std::cout.rdbuf(cout_buf);
+
+  CPPUNIT_ASSERT(database->number_of_games() == 5);
+  Diagnostics const& diagnostics(database->diagnostics());
+  CPPUNIT_ASSERT(diagnostics.size() == 4 && diagnostics.dropped() == 0);
+  // The malformed tag pair is skipped; the tag pairs after it are still stored.
+  CPPUNIT_ASSERT(diagnostics[0].kind == Diagnostics::parse_error && diagnostics[0].game == 1 && diagnostics[0].line == 6 &&
+      diagnostics[0].snippet() == "White");
+  CPPUNIT_ASSERT(database->tag_store().event(1) == "Malformed" && database->tag_store().black(1) == "Nakamura");
+  CPPUNIT_ASSERT(database->tag_store().white(1).empty());
+  CPPUNIT_ASSERT(diagnostics[1].kind == Diagnostics::illegal_move && diagnostics[1].game == 2 && diagnostics[1].line == 13 &&
+      diagnostics[1].snippet() == "Ke3");
+  CPPUNIT_ASSERT(diagnostics[2].kind == Diagnostics::missing_termination && diagnostics[2].game == 3);
+  CPPUNIT_ASSERT(diagnostics[3].kind == Diagnostics::truncated_game && diagnostics[3].game == 4);
+  CPPUNIT_ASSERT(database->progress().sample().parse_errors == 2);
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,179 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file DragLatency.h This file contains the declaration of class cwmm::DragLatency.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace cwmm {
+
+/** @brief Histograms of the latency of dragging a piece, from input event to pixels.
+ *
+ * While measuring is enabled (see ChessboardWidget::set_measure_drag_latency),
+ * ChessboardWidget records, for every frame that is drawn while a piece is
+ * being dragged, how long it took from the oldest motion event that the frame
+ * shows until the end of on_draw. That time is split into stages:
+ *
+ * - input: from the time stamp of the event until on_motion_notify_event handled it.
+ * - wait: from handling the event until on_draw was called.
+ * - draw: the duration of on_draw.
+ * - total: from the time stamp of the event until the end of on_draw.
+ *
+ * The time stamps of events have a resolution of one millisecond; if they don't
+ * use the same clock as g_get_monotonic_time() there is no input stage and the
+ * total starts when the event was handled.
+ *
+ * All times are in microseconds. Only the GUI thread uses this class.
+ */
+class DragLatency {
+  public:
+    //! The stages of the path from input event to pixels.
+    enum stage_type {
+      input,
+      wait,
+      draw,
+      total,
+      number_of_stages
+    };
+
+    //! The width of a bucket of the histograms, in microseconds.
+    static int const bucket_width = 100;
+    //! The number of buckets; the last bucket counts everything that took longer.
+    static int const number_of_buckets = 500;
+
+    //! The latency distribution of one stage.
+    struct Histogram {
+      uint64_t count;				//!< The number of measurements.
+      uint64_t sum;				//!< The sum of all measurements.
+      uint64_t max;				//!< The largest measurement.
+      uint64_t buckets[number_of_buckets];	//!< Bucket b counts the measurements in [b * bucket_width, (b + 1) * bucket_width).
+
+      //! Return the mean, or 0 if there are no measurements.
+      double mean() const { return count ? double(sum) / count : 0.0; }
+
+      //! Return an upper bound of the \a fraction quantile (e.g. 0.99), with the resolution of one bucket.
+      uint64_t percentile(double fraction) const
+      {
+        uint64_t const rank = fraction * count;
+        uint64_t seen = 0;
+        for (int b = 0; b < number_of_buckets - 1; ++b)
+          if ((seen += buckets[b]) > rank)
+            return (b + 1) * bucket_width;
+        return max;
+      }
+    };
+
+  private:
+    Histogram M_histograms[number_of_stages];
+    uint64_t M_frames;			//!< The number of frames that were measured.
+    uint64_t M_coalesced_events;	//!< The number of motion events that were drawn by the same frame as an older one.
+    uint64_t M_squares;			//!< The number of squares that those frames redrew.
+
+  public:
+    //! Construct empty histograms.
+    DragLatency() { reset(); }
+
+    //! Forget all measurements.
+    void reset()
+    {
+      for (Histogram& histogram : M_histograms)
+        histogram = Histogram{};
+      M_frames = M_coalesced_events = M_squares = 0;
+    }
+
+    //! Add a measurement of \a microseconds to \a stage.
+    void add(stage_type stage, int64_t microseconds)
+    {
+      uint64_t const latency = microseconds > 0 ? microseconds : 0;
+      Histogram& histogram(M_histograms[stage]);
+      ++histogram.count;
+      histogram.sum += latency;
+      if (latency > histogram.max)
+        histogram.max = latency;
+      uint64_t const bucket = latency / bucket_width;
+      ++histogram.buckets[bucket < number_of_buckets ? bucket : number_of_buckets - 1];
+    }
+
+    //! Count a measured frame that redrew \a squares squares and showed \a coalesced_events more motion events than the one that was measured.
+    void add_frame(unsigned int squares, unsigned int coalesced_events)
+    {
+      ++M_frames;
+      M_squares += squares;
+      M_coalesced_events += coalesced_events;
+    }
+
+    //! Return the histogram of \a stage.
+    Histogram const& histogram(stage_type stage) const { return M_histograms[stage]; }
+
+    //! Return the number of measured frames.
+    uint64_t frames() const { return M_frames; }
+
+    //! Return the number of motion events that weren't measured because a frame showed an older one.
+    uint64_t coalesced_events() const { return M_coalesced_events; }
+
+    //! Return the average number of squares redrawn per frame.
+    double squares_per_frame() const { return M_frames ? double(M_squares) / M_frames : 0.0; }
+
+    //! Return the name of \a stage.
+    static char const* name(stage_type stage)
+    {
+      switch (stage)
+      {
+        case input:
+          return "input";
+        case wait:
+          return "wait";
+        case draw:
+          return "draw";
+        case total:
+          return "total";
+        case number_of_stages:
+          break;
+      }
+      return "unknown";
+    }
+
+    //! Write a table of the measurements in milliseconds to \a os, one line per stage.
+    void print_on(std::ostream& os) const
+    {
+      std::ios_base::fmtflags const flags = os.flags();
+      os << "drag latency (ms)     n   mean    p50    p90    p99    max\n" << std::fixed << std::setprecision(1);
+      for (int s = 0; s < number_of_stages; ++s)
+      {
+        stage_type const stage = static_cast<stage_type>(s);
+        Histogram const& h(M_histograms[stage]);
+        os << std::left << std::setw(12) << name(stage) << std::right << std::setw(10) << h.count <<
+            std::setw(7) << h.mean() / 1000 << std::setw(7) << h.percentile(0.5) / 1000.0 <<
+            std::setw(7) << h.percentile(0.9) / 1000.0 << std::setw(7) << h.percentile(0.99) / 1000.0 <<
+            std::setw(7) << h.max / 1000.0 << '\n';
+      }
+      os << "frames " << M_frames << ", coalesced events " << M_coalesced_events <<
+          ", squares per frame " << squares_per_frame() << '\n';
+      os.flags(flags);
+    }
+};
+
+} // namespace cwmm
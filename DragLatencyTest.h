@@ -0,0 +1,101 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file DragLatencyTest.h Testsuite for cwmm::DragLatency.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "DragLatency.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class DragLatencyTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(DragLatencyTest);
+
+  CPPUNIT_TEST(testHistogram);
+  CPPUNIT_TEST(testFrames);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    DragLatencyTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testHistogram();
+    void testFrames();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <sstream>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(DragLatencyTest);
+
+void DragLatencyTest::testHistogram()
+{
+  cwmm::DragLatency latency;
+  // 0.1 ms ... 10 ms.
+  for (int i = 1; i <= 100; ++i)
+    latency.add(cwmm::DragLatency::total, 100 * i);
+  latency.add(cwmm::DragLatency::draw, -5);	// Clocks that went backwards count as zero.
+
+  cwmm::DragLatency::Histogram const& total(latency.histogram(cwmm::DragLatency::total));
+  CPPUNIT_ASSERT(total.count == 100 && total.max == 10000);
+  CPPUNIT_ASSERT(total.mean() == 5050.0);
+  CPPUNIT_ASSERT(total.percentile(0.5) == 5200);
+  CPPUNIT_ASSERT(total.percentile(0.1) == 1200);
+  CPPUNIT_ASSERT(latency.histogram(cwmm::DragLatency::draw).count == 1 && latency.histogram(cwmm::DragLatency::draw).max == 0);
+  CPPUNIT_ASSERT(latency.histogram(cwmm::DragLatency::input).count == 0 && latency.histogram(cwmm::DragLatency::input).percentile(0.5) == 0);
+
+  // Beyond the last bucket only the maximum is known.
+  latency.add(cwmm::DragLatency::wait, 1000);
+  latency.add(cwmm::DragLatency::wait, 60000);
+  CPPUNIT_ASSERT(latency.histogram(cwmm::DragLatency::wait).percentile(0.99) == 60000);
+
+  latency.reset();
+  CPPUNIT_ASSERT(latency.histogram(cwmm::DragLatency::total).count == 0 && latency.histogram(cwmm::DragLatency::total).sum == 0);
+}
+
+void DragLatencyTest::testFrames()
+{
+  cwmm::DragLatency latency;
+  CPPUNIT_ASSERT(latency.frames() == 0 && latency.squares_per_frame() == 0.0);
+  latency.add_frame(4, 0);
+  latency.add_frame(2, 3);
+  CPPUNIT_ASSERT(latency.frames() == 2 && latency.coalesced_events() == 3 && latency.squares_per_frame() == 3.0);
+
+  std::ostringstream os;
+  latency.print_on(os);
+  std::string const table(os.str());
+  CPPUNIT_ASSERT(table.find("total") != std::string::npos && table.find("frames 2, coalesced events 3") != std::string::npos);
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,128 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file FileFollower.cxx This file contains the implementation of class FileFollower.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "FileFollower.h"
+#include "debug.h"
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+namespace util {
+
+bool FileFollower::open(std::string const& filename, uint64_t offset)
+{
+  DoutEntering(dc::notice, "FileFollower::open(\"" << filename << "\", " << offset << ")");
+  close();
+  M_fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+  struct stat sb;
+  if (M_fd == -1 || fstat(M_fd, &sb) == -1 || !S_ISREG(sb.st_mode))
+  {
+    close();
+    return false;
+  }
+  M_filename = filename;
+  M_offset = offset;
+#ifdef HAVE_SYS_INOTIFY_H
+  // Watch the file before the first read, so that no append can be missed.
+  M_inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (M_inotify_fd != -1 && inotify_add_watch(M_inotify_fd, filename.c_str(), IN_MODIFY | IN_ATTRIB | IN_DELETE_SELF | IN_MOVE_SELF) == -1)
+  {
+    ::close(M_inotify_fd);
+    M_inotify_fd = -1;
+  }
+  if (M_inotify_fd == -1)
+    Dout(dc::warning, "Can't watch " << filename << " with inotify; polling instead.");
+#endif
+  return true;
+}
+
+void FileFollower::close()
+{
+  if (M_inotify_fd != -1)
+    ::close(M_inotify_fd);
+  M_inotify_fd = -1;
+  if (M_fd != -1)
+    ::close(M_fd);
+  M_fd = -1;
+  M_offset = 0;
+}
+
+ssize_t FileFollower::read(char* buf, size_t len)
+{
+  ssize_t n;
+  do
+    n = pread(M_fd, buf, len, M_offset);
+  while (n == -1 && errno == EINTR);
+  if (n > 0)
+    M_offset += n;
+  return n;
+}
+
+// Return true if the file was deleted, renamed, replaced or truncated.
+bool FileFollower::gone() const
+{
+  struct stat sb, path_sb;
+  return fstat(M_fd, &sb) == -1 || sb.st_nlink == 0 || uint64_t(sb.st_size) < M_offset ||
+      stat(M_filename.c_str(), &path_sb) == -1 || path_sb.st_ino != sb.st_ino || path_sb.st_dev != sb.st_dev;
+}
+
+bool FileFollower::wait(std::atomic<bool> const* cancelled)
+{
+  for (;;)
+  {
+    if (cancelled && cancelled->load(std::memory_order_relaxed))
+      return false;
+    if (gone())
+    {
+      Dout(dc::notice, "FileFollower::wait: " << M_filename << " was removed, renamed or truncated.");
+      return false;
+    }
+    // The file might have grown after the last read returned 0 but before the watch saw it.
+    struct stat sb;
+    if (fstat(M_fd, &sb) == 0 && uint64_t(sb.st_size) > M_offset)
+      return true;
+#ifdef HAVE_SYS_INOTIFY_H
+    if (M_inotify_fd != -1)
+    {
+      struct pollfd pfd = { M_inotify_fd, POLLIN, 0 };
+      if (poll(&pfd, 1, S_poll_interval) > 0)
+      {
+        // Drain the events; whatever happened is checked above.
+        char events[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+        while (::read(M_inotify_fd, events, sizeof(events)) > 0)
+          ;
+      }
+      continue;
+    }
+#endif
+    poll(NULL, 0, S_poll_interval);
+  }
+}
+
+} // namespace util
@@ -0,0 +1,101 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file FileFollower.h This file contains the declaration of class FileFollower.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <sys/types.h>
+
+namespace util {
+
+/** @brief Reader of a file that keeps growing.
+ *
+ * Reads a file sequentially from a given offset. When the end of the file
+ * is reached, wait() blocks until more data was appended; it uses inotify(7)
+ * when available (HAVE_SYS_INOTIFY_H) and otherwise polls the size of the file.
+ * Waiting ends when the file is deleted, renamed or truncated, which
+ * is how a writer rotates its log.
+ *
+ * Usage example:
+ * \code
+ * util::FileFollower follower;
+ * if (follower.open("live.pgn", 0))
+ *   for (;;)
+ *   {
+ *     while ((len = follower.read(buf, sizeof(buf))) > 0)
+ *       process(buf, len);
+ *     if (len == -1 || !follower.wait(&cancelled))
+ *       break;
+ *   }
+ * \endcode
+ */
+class FileFollower {
+  public:
+    static int const S_poll_interval = 250;	//!< The time in milliseconds between checks of the cancel flag (and of the file size, without inotify).
+
+  private:
+    std::string M_filename;			//!< The name of the file, to detect that it was renamed or replaced.
+    int M_fd;					//!< The file descriptor of the file, or -1.
+    int M_inotify_fd;				//!< The inotify instance that watches the file, or -1.
+    uint64_t M_offset;				//!< The offset of the next read.
+
+  public:
+    //! Construct a closed follower.
+    FileFollower() : M_fd(-1), M_inotify_fd(-1), M_offset(0) { }
+    ~FileFollower() { close(); }
+
+    FileFollower(FileFollower const&) = delete;
+    FileFollower& operator=(FileFollower const&) = delete;
+
+    /** @brief Open \a filename and start reading at \a offset.
+     *
+     * @returns FALSE if the file could not be opened or isn't a regular file.
+     */
+    bool open(std::string const& filename, uint64_t offset);
+
+    //! Close the file.
+    void close();
+
+    /** @brief Read up to \a len bytes into \a buf.
+     *
+     * @returns The number of bytes read, 0 at the current end of the file or -1 on error.
+     */
+    ssize_t read(char* buf, size_t len);
+
+    /** @brief Wait until the file grows.
+     *
+     * @returns TRUE when there might be more data to read; FALSE if the file was
+     * deleted, renamed or truncated, or when \a cancelled (if not NULL) became true.
+     */
+    bool wait(std::atomic<bool> const* cancelled);
+
+    //! Return the offset of the next read; the number of bytes read when opened at offset 0.
+    uint64_t offset() const { return M_offset; }
+
+  private:
+    bool gone() const;
+};
+
+} // namespace util
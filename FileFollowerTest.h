@@ -0,0 +1,170 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file FileFollowerTest.h Testsuite for util::FileFollower.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "FileFollower.h"
+#include "TempFile.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include <memory>
+
+namespace testsuite {
+
+class FileFollowerTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(FileFollowerTest);
+
+  CPPUNIT_TEST(testFollow);
+  CPPUNIT_TEST(testGone);
+  CPPUNIT_TEST(testCancel);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    std::unique_ptr<TempFile> M_file;
+
+    std::string const& filename() const { return M_file->filename(); }
+
+  public:
+    FileFollowerTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testFollow();
+    void testGone();
+    void testCancel();
+
+  private:
+    void append(char const* data);
+    std::string read_available(util::FileFollower& follower);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(FileFollowerTest);
+
+void FileFollowerTest::setUp()
+{
+  M_file.reset(new TempFile("FileFollowerTest"));
+  M_file->close();
+  append("[Event \"1\"]\n\n1-0\n");
+}
+
+void FileFollowerTest::tearDown()
+{
+  std::remove((filename() + ".old").c_str());
+  M_file.reset();
+}
+
+void FileFollowerTest::append(char const* data)
+{
+  int fd = open(filename().c_str(), O_WRONLY | O_APPEND);
+  CPPUNIT_ASSERT(fd != -1);
+  CPPUNIT_ASSERT(write(fd, data, std::strlen(data)) == ssize_t(std::strlen(data)));
+  close(fd);
+}
+
+std::string FileFollowerTest::read_available(util::FileFollower& follower)
+{
+  std::string result;
+  char buf[7];
+  ssize_t len;
+  while ((len = follower.read(buf, sizeof(buf))) > 0)
+    result.append(buf, len);
+  CPPUNIT_ASSERT(len == 0);
+  return result;
+}
+
+void FileFollowerTest::testFollow()
+{
+  util::FileFollower follower;
+  CPPUNIT_ASSERT(!follower.open("/nonexistent/file.pgn", 0));
+  // Start past what was already read by someone else.
+  CPPUNIT_ASSERT(follower.open(filename(), 12));
+  CPPUNIT_ASSERT(read_available(follower) == "\n1-0\n");
+
+  // Data that is appended while we wait is seen.
+  std::thread writer([this](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    append("[Event \"2\"]\n");
+  });
+  CPPUNIT_ASSERT(follower.wait(NULL));
+  writer.join();
+  std::string data = read_available(follower);
+  // Data that is appended before we wait is seen too.
+  append("\n0-1\n");
+  CPPUNIT_ASSERT(follower.wait(NULL));
+  data += read_available(follower);
+  CPPUNIT_ASSERT(data == "[Event \"2\"]\n\n0-1\n");
+  CPPUNIT_ASSERT(follower.offset() == 34);
+}
+
+void FileFollowerTest::testGone()
+{
+  util::FileFollower follower;
+  CPPUNIT_ASSERT(follower.open(filename(), 0));
+  read_available(follower);
+  // Log rotation.
+  CPPUNIT_ASSERT(std::rename(filename().c_str(), (filename() + ".old").c_str()) == 0);
+  CPPUNIT_ASSERT(!follower.wait(NULL));
+
+  CPPUNIT_ASSERT(std::rename((filename() + ".old").c_str(), filename().c_str()) == 0);
+  CPPUNIT_ASSERT(follower.open(filename(), 0));
+  read_available(follower);
+  CPPUNIT_ASSERT(truncate(filename().c_str(), 0) == 0);
+  CPPUNIT_ASSERT(!follower.wait(NULL));
+
+  CPPUNIT_ASSERT(follower.open(filename(), 0));
+  std::remove(filename().c_str());
+  CPPUNIT_ASSERT(!follower.wait(NULL));
+}
+
+void FileFollowerTest::testCancel()
+{
+  util::FileFollower follower;
+  CPPUNIT_ASSERT(follower.open(filename(), 0));
+  read_available(follower);
+  std::atomic<bool> cancelled(false);
+  std::thread canceller([&cancelled](){
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    cancelled = true;
+  });
+  CPPUNIT_ASSERT(!follower.wait(&cancelled));
+  canceller.join();
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,179 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file GameArchiveTest.h Testsuite header for class pgn::GameArchive.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnGameArchive.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class GameArchiveTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(GameArchiveTest);
+
+  CPPUNIT_TEST(testMoveOrdinals);
+  CPPUNIT_TEST(testWriteAndDecode);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    pgn::TagStore M_tag_store;
+    pgn::MoveStore M_move_store;
+
+  public:
+    GameArchiveTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testMoveOrdinals();
+    void testWriteAndDecode();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include "RandomGame.h"
+#include <random>
+#include <cstdio>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GameArchiveTest);
+
+void GameArchiveTest::setUp()
+{
+  static char const* const players[] = { "Carlsen, Magnus", "Caruana, Fabiano", "Ding, Liren", "Nepomniachtchi, Ian" };
+  static char const* const results[] = { "1-0", "0-1", "1/2-1/2", "*" };
+  std::mt19937 random_number_generator(1220638382);
+  ChessPosition chess_position;
+  for (int game = 0; game < 200; ++game)
+  {
+    M_tag_store.begin_game(0);
+    M_tag_store.add_tag("White", players[random_number_generator() % 4]);
+    M_tag_store.add_tag("Black", players[random_number_generator() % 4]);
+    M_tag_store.add_tag("Event", "Test " + std::to_string(game % 3));
+    M_tag_store.add_tag("Date", "2026.10." + std::to_string(10 + game % 20));
+    M_tag_store.add_tag("Result", results[game % 4]);
+    M_tag_store.add_tag("WhiteElo", std::to_string(2700 + game));
+    M_move_store.begin_game();
+    // Every tenth game starts from a position where promotions are possible.
+    if (game % 10 == 5)
+    {
+      M_tag_store.add_tag("FEN", "4k3/1P4P1/8/8/8/8/1p4p1/4K3 w - - 0 1");
+      M_move_store.set_FEN("4k3/1P4P1/8/8/8/8/1p4p1/4K3 w - - 0 1");
+      chess_position.load_FEN("4k3/1P4P1/8/8/8/8/1p4p1/4K3 w - - 0 1");
+    }
+    else
+      chess_position.initial_position();
+    random_game(random_number_generator, chess_position, M_move_store, random_number_generator() % 80);
+  }
+  // A game with an invalid FEN has no moves.
+  M_tag_store.begin_game(0);
+  M_move_store.begin_game();
+  M_move_store.set_FEN("invalid");
+}
+
+void GameArchiveTest::tearDown()
+{
+  M_tag_store.clear();
+  M_move_store.clear();
+}
+
+void GameArchiveTest::testMoveOrdinals()
+{
+  ChessPosition chess_position;
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+  {
+    if (!M_move_store.start_position(game_id, chess_position))
+      continue;
+    for (size_t ply = 0; ply < M_move_store.number_of_moves(game_id); ++ply)
+    {
+      // The ordinal of each legal move is its position in the list of legal moves.
+      int ordinal = 0;
+      for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+	for (MoveIterator move_iter = chess_position.move_begin(piece_iter.index()); move_iter != chess_position.move_end(); ++move_iter, ++ordinal)
+	{
+	  CPPUNIT_ASSERT(pgn::GameArchive::encode_move(chess_position, *move_iter) == ordinal);
+	  Move move;
+	  CPPUNIT_ASSERT(pgn::GameArchive::decode_move(chess_position, ordinal, move) && move == *move_iter);
+	}
+      CPPUNIT_ASSERT(ordinal < 256);
+      Move move;
+      CPPUNIT_ASSERT(!pgn::GameArchive::decode_move(chess_position, ordinal, move));
+      chess_position.execute(pgn::MoveStore::decode(M_move_store.moves(game_id)[ply]));
+    }
+  }
+  chess_position.initial_position();
+  CPPUNIT_ASSERT(pgn::GameArchive::encode_move(chess_position, Move(Index(4, 1), Index(4, 4), nothing)) == -1);
+}
+
+void GameArchiveTest::testWriteAndDecode()
+{
+  TempFile file("GameArchiveTest");
+  CPPUNIT_ASSERT(pgn::GameArchive::write(M_tag_store, M_move_store, file.filename(), 7));
+
+  pgn::GameArchive archive;
+  CPPUNIT_ASSERT(!archive.open("/nonexistent/archive"));
+  CPPUNIT_ASSERT(archive.open(file.filename()));
+  file.remove();
+  CPPUNIT_ASSERT(archive.number_of_games() == M_move_store.size());
+  CPPUNIT_ASSERT(archive.number_of_blocks() == (M_move_store.size() + 6) / 7);
+
+  std::vector<pgn::GameArchive::Header> headers;
+  pgn::MoveStore move_store;
+  CPPUNIT_ASSERT(archive.decode(headers, move_store, 3));
+  CPPUNIT_ASSERT(headers.size() == M_tag_store.size() && move_store.size() == M_move_store.size());
+  CPPUNIT_ASSERT(move_store.total_number_of_moves() == M_move_store.total_number_of_moves());
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+  {
+    pgn::GameArchive::Header const& header(headers[game_id]);
+    CPPUNIT_ASSERT(archive.players()[header.white] == M_tag_store.white(game_id));
+    CPPUNIT_ASSERT(archive.players()[header.black] == M_tag_store.black(game_id));
+    CPPUNIT_ASSERT(archive.events()[header.event] == M_tag_store.event(game_id));
+    CPPUNIT_ASSERT(header.date == M_tag_store.date(game_id));
+    CPPUNIT_ASSERT(header.result == M_tag_store.result(game_id));
+    CPPUNIT_ASSERT(header.white_elo == M_tag_store.white_elo(game_id));
+    CPPUNIT_ASSERT(header.black_elo == 0);
+    CPPUNIT_ASSERT((move_store.FEN(game_id) == NULL) == (M_move_store.FEN(game_id) == NULL));
+    CPPUNIT_ASSERT(move_store.number_of_moves(game_id) == M_move_store.number_of_moves(game_id));
+    for (size_t ply = 0; ply < M_move_store.number_of_moves(game_id); ++ply)
+      CPPUNIT_ASSERT(move_store.moves(game_id)[ply] == M_move_store.moves(game_id)[ply]);
+  }
+
+  // A single block can be decoded on its own.
+  headers.clear();
+  move_store.clear();
+  CPPUNIT_ASSERT(archive.first_game(3) == 21);
+  CPPUNIT_ASSERT(archive.decode_block(3, headers, move_store) && move_store.size() == 7);
+  CPPUNIT_ASSERT(move_store.number_of_moves(0) == M_move_store.number_of_moves(21));
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
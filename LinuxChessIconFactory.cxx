@@ -34,6 +34,8 @@ std::string get_label(MenuEntryWithoutIconId menu_entry_id)
       return "Edit position";
     case EditGame:
       return "Edit game";
+    case ShowDragLatency:
+      return "Show drag latency";
   }
   return "Unknown label";
 }
@@ -23,7 +23,8 @@ enum MenuEntryWithoutIconId
   ShowMoves,
   PlacePieces,
   EditPosition,
-  EditGame
+  EditGame,
+  ShowDragLatency
 };
 
 std::string get_label(MenuEntryWithoutIconId menu_entry_id);
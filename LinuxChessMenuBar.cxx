@@ -16,6 +16,8 @@ char const* LinuxChessMenuBar::top_entry_label(TopEntries top_entry)
       return "Game";
     case Mode:
       return "Mode";
+    case View:
+      return "View";
   }
   return "";
 }
@@ -16,6 +16,7 @@ namespace menu_keys {
     File,
     Game,
     Mode,
+    View,
     number_of_top_entries
   };
 
@@ -134,6 +135,16 @@ class LinuxChessMenuBar : public Gtk::MenuBar, public LinuxChessIconFactory
     menu_item_ptr->signal_activate().connect(sigc::mem_fun(*obj, cb));
   }
 
+  template<class T>
+  void append_check_menu_entry(MenuEntryKey menu_entry_key, T* obj, void (T::*cb)())
+  {
+    ASSERT(menu_entry_key.is_menu_entry_without_icon_id());     // None of our check menu items have icons.
+    Gtk::CheckMenuItem* menu_item_ptr = Gtk::manage(new Gtk::CheckMenuItem(get_label(menu_entry_key.get_menu_entry_without_icon_id())));
+    m_menu_items[menu_entry_key] = menu_item_ptr;
+    m_submenus[menu_entry_key.m_top_entry]->append(*menu_item_ptr);
+    menu_item_ptr->signal_toggled().connect(sigc::mem_fun(*obj, cb));
+  }
+
   void activate(MenuEntryKey menu_entry_key)
   {
     auto item = m_menu_items.find(menu_entry_key);
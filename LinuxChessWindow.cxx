@@ -2,6 +2,12 @@
 #include "LinuxChessWindow.h"
 #include "LinuxChessMenuBar.h"
 #include "ChessNotation.h"
+#include "PgnWriter.h"
+#include <sstream>
+#include <algorithm>
+#include <iomanip>
+#include <fcntl.h>
+#include <unistd.h>
 
 LinuxChessWindow::LinuxChessWindow(LinuxChessApplication* application) : m_chessboard_widget(this), m_application(application)
 {
@@ -20,8 +26,23 @@ LinuxChessWindow::LinuxChessWindow(LinuxChessApplication* application) : m_chess
 
   m_grid.attach(m_chessboard_widget, 0, 1);
 
+  // The progress bar and cancel button of loading a database.
+  m_load_progress_bar.set_hexpand(true);
+  m_load_progress_bar.set_valign(Gtk::ALIGN_CENTER);
+  m_load_progress_bar.set_show_text(true);
+  m_load_cancel_button.set_label("_Cancel");
+  m_load_cancel_button.set_use_underline(true);
+  m_load_cancel_button.signal_clicked().connect(sigc::mem_fun(this, &LinuxChessWindow::on_cancel_load));
+  m_load_box.pack_start(m_load_progress_bar, Gtk::PACK_EXPAND_WIDGET);
+  m_load_box.pack_start(m_load_cancel_button, Gtk::PACK_SHRINK);
+  m_grid.attach(m_load_box, 0, 2);
+
   add(m_grid);
 
+  // The load box is only shown while loading; keep show_all() from showing it.
+  m_load_progress_bar.show();
+  m_load_cancel_button.show();
+  m_load_box.set_no_show_all(true);
   show_all_children();
 
   // Record moves.
@@ -42,6 +63,7 @@ LinuxChessWindow::LinuxChessWindow(LinuxChessApplication* application) : m_chess
 LinuxChessWindow::~LinuxChessWindow()
 {
   Dout(dc::notice, "Calling LinuxChessWindow::~LinuxChessWindow()");
+  M_load_progress_timer.disconnect();
 }
 
 void LinuxChessWindow::append_menu_entries(LinuxChessMenuBar* menubar)
@@ -69,11 +91,83 @@ void LinuxChessWindow::append_menu_entries(LinuxChessMenuBar* menubar)
 void LinuxChessWindow::moved(cwchess::Move const& move, cwchess::ChessPosition const& previous_position, cwchess::ChessPosition const& current_position)
 {
   Dout(dc::notice, "LinuxChessWindow::moved(" << cwchess::ChessNotation(current_position, move) << ", ...");
+  if (M_game_moves.empty())
+    M_game_start_position = previous_position;
+  M_game_moves.push_back(move);
 }
 
 void LinuxChessWindow::on_menu_File_OPEN()
 {
   DoutEntering(dc::notice, "LinuxChessWindow::on_menu_File_OPEN()");
+
+  // Only load one database at a time.
+  if (M_load_progress_timer.connected())
+    return;
+
+  Gtk::FileChooserDialog dialog(*this, "Open database", Gtk::FILE_CHOOSER_ACTION_OPEN);
+  dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+  dialog.add_button("_Open", Gtk::RESPONSE_OK);
+  Glib::RefPtr<Gtk::FileFilter> pgn_filter = Gtk::FileFilter::create();
+  pgn_filter->set_name("PGN databases");
+  for (char const* pattern : { "*.pgn", "*.pgn.gz", "*.pgn.bz2", "*.pgn.zst" })
+    pgn_filter->add_pattern(pattern);
+  dialog.add_filter(pgn_filter);
+  Glib::RefPtr<Gtk::FileFilter> all_filter = Gtk::FileFilter::create();
+  all_filter->set_name("All files");
+  all_filter->add_pattern("*");
+  dialog.add_filter(all_filter);
+  if (dialog.run() != Gtk::RESPONSE_OK)
+    return;
+
+  M_database = cwchess::pgn::DatabaseSeekable::open(dialog.get_filename(), sigc::mem_fun(this, &LinuxChessWindow::open_finished));
+  m_load_progress_bar.set_fraction(0.0);
+  m_load_progress_bar.set_text("Loading " + Glib::path_get_basename(dialog.get_filename()));
+  m_load_cancel_button.set_sensitive(true);
+  m_load_box.show();
+  // Sample the progress at frame rate.
+  M_load_progress_timer = Glib::signal_timeout().connect(sigc::mem_fun(this, &LinuxChessWindow::update_load_progress), 16);
+}
+
+bool LinuxChessWindow::update_load_progress()
+{
+  if (!M_database)
+    return false;
+  cwchess::pgn::LoadProgress::Sample sample = M_database->progress().sample();
+  if (sample.file_size)
+    m_load_progress_bar.set_fraction(std::min(sample.fraction(), 1.0));
+  else
+    m_load_progress_bar.pulse();
+  std::ostringstream text;
+  text << sample.games << " games, " << std::fixed << std::setprecision(1) << sample.parse_speed() << " MB/s";
+  if (sample.parse_errors)
+    text << ", " << sample.parse_errors << " errors";
+  if (sample.cancelled)
+    text << " (cancelled)";
+  m_load_progress_bar.set_text(text.str());
+  return true;
+}
+
+void LinuxChessWindow::on_cancel_load()
+{
+  DoutEntering(dc::notice, "LinuxChessWindow::on_cancel_load()");
+  if (!M_database)
+    return;
+  M_database->progress().cancel();
+  m_load_cancel_button.set_sensitive(false);
+}
+
+void LinuxChessWindow::open_finished(size_t bytes_read)
+{
+  DoutEntering(dc::notice, "LinuxChessWindow::open_finished(" << bytes_read << ")");
+  M_load_progress_timer.disconnect();
+  m_load_box.hide();
+  cwchess::pgn::LoadProgress::Sample sample = M_database->progress().sample();
+  std::ostringstream title;
+  title << "LinuxChess - " << Glib::path_get_basename(M_database->get_path()) << " (" << sample.games << " games";
+  if (sample.cancelled)
+    title << ", cancelled";
+  title << ')';
+  set_title(title.str());
 }
 
 void LinuxChessWindow::on_menu_File_SAVE()
@@ -84,16 +178,63 @@ void LinuxChessWindow::on_menu_File_SAVE()
 void LinuxChessWindow::on_menu_Game_NEW()
 {
   DoutEntering(dc::notice, "LinuxChessWindow::on_menu_Game_NEW()");
+  M_game_moves.clear();
 }
 
 void LinuxChessWindow::on_menu_Game_CLEAR()
 {
   DoutEntering(dc::notice, "LinuxChessWindow::on_menu_Game_CLEAR()");
+  M_game_moves.clear();
 }
 
 void LinuxChessWindow::on_menu_Game_Export()
 {
   DoutEntering(dc::notice, "LinuxChessWindow::on_menu_Game_Export()");
+  using namespace cwchess;
+
+  Gtk::FileChooserDialog dialog(*this, "Export game", Gtk::FILE_CHOOSER_ACTION_SAVE);
+  dialog.add_button("_Cancel", Gtk::RESPONSE_CANCEL);
+  dialog.add_button("_Save", Gtk::RESPONSE_OK);
+  dialog.set_do_overwrite_confirmation(true);
+  dialog.set_current_name("game.pgn");
+  if (dialog.run() != Gtk::RESPONSE_OK)
+    return;
+  std::string filename = dialog.get_filename();
+  int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+  {
+    Dout(dc::warning, "Failed to open " << filename);
+    return;
+  }
+  ChessPosition chess_position;
+  if (M_game_moves.empty())
+    chess_position = m_chessboard_widget.get_position();
+  else
+    chess_position = M_game_start_position;
+  {
+    pgn::Writer writer(fd);
+    writer.tag("Event", "?");
+    writer.tag("Site", "?");
+    writer.tag("Date", "????.??.??");
+    writer.tag("Round", "?");
+    writer.tag("White", "?");
+    writer.tag("Black", "?");
+    writer.tag("Result", "*");
+    ChessPosition initial_position;
+    initial_position.initial_position();
+    std::string FEN = chess_position.FEN();
+    if (FEN != initial_position.FEN())
+    {
+      writer.tag("SetUp", "1");
+      writer.tag("FEN", FEN);
+    }
+    for (Move const& move : M_game_moves)
+      writer.move(chess_position, move);
+    writer.result(pgn::TagStore::result_unknown);
+    if (!writer.flush())
+      Dout(dc::warning, "Failed to write " << filename);
+  }
+  ::close(fd);
 }
 
 void LinuxChessWindow::on_menu_Game_UNDO()
@@ -137,6 +278,7 @@ void LinuxChessWindow::on_menu_Mode_EditGame()
 void LinuxChessWindow::position_editted()
 {
   DoutEntering(dc::notice, "LinuxChessWindow::position_editted()");
+  M_game_moves.clear();
   using namespace cwchess;
   using namespace cwmm;
   // We get here while in Edit Position mode and something was changed.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "LinuxChessboardWidget.h"
+#include "PgnDatabase.h"
 #include <gtkmm.h>
 
 class LinuxChessMenuBar;
@@ -40,10 +41,26 @@ class LinuxChessWindow : public Gtk::Window
 
   void position_editted();
 
+  // Loading a database.
+  void open_finished(size_t bytes_read);
+  bool update_load_progress();
+  void on_cancel_load();
+
   // Child widgets.
   Gtk::Grid m_grid;
   LinuxChessMenuBar* m_menubar;
   LinuxChessboardWidget m_chessboard_widget;
+  Gtk::Box m_load_box;                          // Shown while a database is loading.
+  Gtk::ProgressBar m_load_progress_bar;
+  Gtk::Button m_load_cancel_button;
 
   std::stack<cwchess::ChessPosition> M_history;
+
+  // The moves played since the last edit of the position, for Game/Export.
+  cwchess::ChessPosition M_game_start_position;
+  std::vector<cwchess::Move> M_game_moves;
+
+  // The last opened database, and the timer that samples its progress while it loads.
+  Glib::RefPtr<cwchess::pgn::Database> M_database;
+  sigc::connection M_load_progress_timer;
 };
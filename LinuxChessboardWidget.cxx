@@ -5,6 +5,8 @@
 #include "ChessNotation.h"
 #endif
 #include "debug.h"
+#include <sstream>
+#include <cmath>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wdeprecated-declarations"
 #pragma GCC diagnostic ignored "-Wparentheses"
@@ -42,6 +44,80 @@ void LinuxChessboardWidget::append_menu_entries(LinuxChessMenuBar* menubar)
 
   // Start with ShowMoves selected.
   on_menu_Mode_ShowMoves();
+
+  menubar->append_check_menu_entry({View, ShowDragLatency}, this, &LinuxChessboardWidget::on_menu_View_ShowDragLatency);
+}
+
+void LinuxChessboardWidget::on_menu_View_ShowDragLatency()
+{
+  DoutEntering(dc::notice, "LinuxChessboardWidget::on_menu_View_ShowDragLatency()");
+  M_show_drag_latency = !M_show_drag_latency;
+  set_measure_drag_latency(M_show_drag_latency);
+  if (M_show_drag_latency)
+  {
+    reset_drag_latency();
+    // Update the overlay twice per second.
+    M_drag_latency_timer = Glib::signal_timeout().connect(sigc::mem_fun(*this, &LinuxChessboardWidget::on_drag_latency_timeout), 500);
+  }
+  else
+    M_drag_latency_timer.disconnect();
+  on_drag_latency_timeout();
+}
+
+bool LinuxChessboardWidget::on_drag_latency_timeout()
+{
+  // Erase the old overlay, or draw the first one.
+  if (M_drag_latency_area.has_zero_area())
+    queue_draw();
+  else
+    queue_draw_area(M_drag_latency_area.get_x(), M_drag_latency_area.get_y(), M_drag_latency_area.get_width(), M_drag_latency_area.get_height());
+  return true;
+}
+
+bool LinuxChessboardWidget::on_draw(Cairo::RefPtr<Cairo::Context> const& cr)
+{
+  bool result = ChessPositionWidget::on_draw(cr);
+  // Draw the overlay after the chessboard finished, so that it isn't part of the measured latency.
+  if (M_show_drag_latency)
+    draw_drag_latency(cr);
+  return result;
+}
+
+// Draw the drag latency table in the top-left corner, on top of whatever is there.
+void LinuxChessboardWidget::draw_drag_latency(Cairo::RefPtr<Cairo::Context> const& cr)
+{
+  std::ostringstream table;
+  drag_latency().print_on(table);
+  std::vector<std::string> lines;
+  std::istringstream stream(table.str());
+  for (std::string line; std::getline(stream, line);)
+    lines.push_back(line);
+
+  cr->save();
+  cr->select_font_face("Monospace", Cairo::FONT_SLANT_NORMAL, Cairo::FONT_WEIGHT_NORMAL);
+  cr->set_font_size(12);
+  Cairo::FontExtents font_extents;
+  cr->get_font_extents(font_extents);
+  double width = 0;
+  for (std::string const& line : lines)
+  {
+    Cairo::TextExtents extents;
+    cr->get_text_extents(line, extents);
+    width = std::max(width, extents.x_advance);
+  }
+  double const margin = 4;
+  M_drag_latency_area = Gdk::Rectangle(0, 0, static_cast<int>(std::ceil(width + 2 * margin)),
+      static_cast<int>(std::ceil(lines.size() * font_extents.height + 2 * margin)));
+  cr->rectangle(0, 0, M_drag_latency_area.get_width(), M_drag_latency_area.get_height());
+  cr->set_source_rgba(0.0, 0.0, 0.0, 0.7);
+  cr->fill();
+  cr->set_source_rgb(1.0, 1.0, 1.0);
+  for (size_t i = 0; i < lines.size(); ++i)
+  {
+    cr->move_to(margin, margin + i * font_extents.height + font_extents.ascent);
+    cr->show_text(lines[i]);
+  }
+  cr->restore();
 }
 
 void LinuxChessboardWidget::draw_hud_layer(Cairo::RefPtr<Cairo::Context> const& cr, gint sside, guint hud)
@@ -189,7 +265,7 @@ void LinuxChessboardWidget::illegal(cwchess::Move const& move, cwchess::ChessPos
 }
 
 LinuxChessboardWidget::LinuxChessboardWidget(Gtk::Window* window, Glib::RefPtr<cwchess::Promotion> promotion) :
-  cwmm::ChessPositionWidget(window, promotion), M_en_passant_arrow(nullptr), m_showing(false)
+  cwmm::ChessPositionWidget(window, promotion), M_en_passant_arrow(nullptr), m_showing(false), M_show_drag_latency(false)
 {
   DoutEntering(dc::notice, "LinuxChessboardWidget::LinuxChessboardWidget()");
   init_colors();
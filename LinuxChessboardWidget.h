@@ -27,6 +27,9 @@ class LinuxChessboardWidget : public cwmm::ChessPositionWidget
   cwchess::Index M_en_passant_arrow_index;
   mode_type M_mode;
   bool m_showing;
+  bool M_show_drag_latency;
+  Gdk::Rectangle M_drag_latency_area;		// Where the drag latency overlay was drawn last.
+  sigc::connection M_drag_latency_timer;
 
   //Glib::RefPtr<Gio::SimpleActionGroup> m_refActionGroup;
 
@@ -37,6 +40,7 @@ class LinuxChessboardWidget : public cwmm::ChessPositionWidget
   void initialize_menu() override;
   void on_cursor_entered_square(gint prev_col, gint prev_row, gint col, gint row) override;
   void on_cursor_left_chessboard(gint prev_col, gint prev_row) override;
+  bool on_draw(Cairo::RefPtr<Cairo::Context> const& cr) override;
 
  public:
   void picked_up(cwchess::Index const& index, cwchess::ChessPosition const& chess_position);
@@ -59,11 +63,14 @@ class LinuxChessboardWidget : public cwmm::ChessPositionWidget
   void on_menu_Mode_ShowDefendedWhite() { DoutEntering(dc::notice, "LinuxChessboardWidget::on_menu_Mode_ShowDefendedWhite()"); M_mode = mode_show_defended_white; }
   void on_menu_Mode_ShowMoves() { DoutEntering(dc::notice, "LinuxChessboardWidget::on_menu_Mode_ShowMoves()"); M_mode = mode_show_moves; }
   void on_menu_Mode_PlacePieces();
+  void on_menu_View_ShowDragLatency();
 
  private:
   void show_reachables(int col, int row, mode_type mode);
   void update_en_passant_arrow();
   void show_pinning();
+  void draw_drag_latency(Cairo::RefPtr<Cairo::Context> const& cr);
+  bool on_drag_latency_timeout();
 
  private:
   enum colors_t {
@@ -0,0 +1,111 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file LoadProgressTest.h Testsuite for pgn::LoadProgress.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnLoadProgress.h"
+#include "MemoryBlockList.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class LoadProgressTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(LoadProgressTest);
+
+  CPPUNIT_TEST(testCounters);
+  CPPUNIT_TEST(testCancel);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    LoadProgressTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testCounters();
+    void testCancel();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <cstring>
+#include <string>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(LoadProgressTest);
+
+void LoadProgressTest::testCounters()
+{
+  cwchess::pgn::LoadProgress progress;
+  cwchess::pgn::LoadProgress::Sample sample = progress.sample();
+  CPPUNIT_ASSERT(sample.fraction() == 0 && sample.games == 0 && !sample.cancelled && !sample.finished);
+
+  progress.set_file_size(4000);
+  progress.read(1000, 3000);
+  progress.parsed(2500, 7, 500000000);
+  progress.parse_error();
+  progress.parse_error();
+  sample = progress.sample();
+  CPPUNIT_ASSERT(sample.fraction() == 0.25);
+  CPPUNIT_ASSERT(sample.bytes_read == 3000 && sample.bytes_parsed == 2500);
+  CPPUNIT_ASSERT(sample.games == 7 && sample.parse_errors == 2);
+  CPPUNIT_ASSERT(sample.wait_time == 0.5);
+  CPPUNIT_ASSERT(!progress.finished());
+
+  progress.finish(3000, 8, 500000000);
+  sample = progress.sample();
+  CPPUNIT_ASSERT(sample.finished && sample.games == 8 && sample.bytes_parsed == 3000);
+  // The elapsed time stops at finish.
+  CPPUNIT_ASSERT(progress.sample().elapsed_time == sample.elapsed_time);
+}
+
+void LoadProgressTest::testCancel()
+{
+  // The consumer of a MemoryBlockList stops at the first block boundary after a cancel.
+  cwchess::pgn::LoadProgress progress;
+  util::MemoryBlockList buffer(sigc::slot<void>([](){}), &progress.cancel_flag());
+  for (char c = 'a'; c < 'e'; ++c)
+  {
+    Glib::RefPtr<util::MemoryBlockNode> block = util::MemoryBlockNode::create(100);
+    std::memset(block->block_begin(), c, 100);
+    buffer.append(block, 100);
+  }
+  std::string processed;
+  util::MemoryBlockList::iterator iter(buffer.begin());
+  for (; iter != buffer.end(); ++iter)
+  {
+    processed += *iter;
+    if (processed.size() == 150)
+      progress.cancel();
+  }
+  CPPUNIT_ASSERT(processed == std::string(100, 'a') + std::string(100, 'b'));
+  CPPUNIT_ASSERT(!buffer.closed() && buffer.cancelled());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -24,6 +24,7 @@
 #include "sys.h"
 #include "MemoryBlockList.h"
 #include <glib.h>
+#include <ctime>
 
 namespace util {
 
@@ -32,25 +33,70 @@ size_t const MemoryBlockNode::S_data_offset = (sizeof(MemoryBlockNode) + sizeof(
 
 void MemoryBlockList::need_more_data_callback()
 {
-  // Create and read at most one new block per 'buffer full' incident.
-  // If multiple new blocks have been processed in the mean time,
-  // then the call to read_async_ready will trigger subsequent reads.
-  if (!M_buffer_full)
-    return;
-  M_buffer_full = false;
+  // The consumer only emits M_need_more_data after it took M_producer_parked
+  // from true to false, so there is exactly one callback per 'buffer full' incident.
+  // Create and read at most one new block here; the call to append
+  // will trigger subsequent reads.
   M_slot_need_more_data();
 }
 
+void MemoryBlockList::processed(int processed_blocks)
+{
+  // Iterators that were copied for backtracking process blocks again; only the first time counts.
+  if (processed_blocks <= M_processed_blocks.load(std::memory_order_relaxed))
+    return;
+  M_processed_blocks.store(processed_blocks);
+  // Storing M_processed_blocks before loading M_producer_parked, while the producer
+  // stores M_producer_parked before loading M_processed_blocks (all sequentially
+  // consistent), guarantees that at least one of us sees that the producer must continue.
+  if (M_producer_parked.load() &&
+      M_appended_blocks.load(std::memory_order_acquire) - processed_blocks <= S_max_blocks / 2 &&
+      M_producer_parked.exchange(false))
+  {
+    Dout(dc::notice, "Requesting more data!");
+    M_need_more_data.emit();
+  }
+}
+
+void MemoryBlockList::wait_for_more_data(int processed_blocks)
+{
+  Dout(dc::notice, "Waiting for more data...");
+  if (M_follow)
+    M_slot_consumer_waiting(true);
+  timespec start_sleep_time_real, stop_sleep_time_real;
+  clock_gettime(CLOCK_REALTIME, &start_sleep_time_real);
+  for (;;)
+  {
+    // Read the futex word before testing the condition, so that an
+    // append or close after the test causes wait() to return immediately.
+    uint32_t events = M_events.load(std::memory_order_acquire);
+    // When cancelled, the producer closes the buffer instead of reading another block.
+    if (can_process_next_block(processed_blocks))
+      break;
+    M_events.wait(events, std::memory_order_acquire);
+  }
+  clock_gettime(CLOCK_REALTIME, &stop_sleep_time_real);
+  M_wait_time_real += (stop_sleep_time_real.tv_sec - start_sleep_time_real.tv_sec) * 1000000000LL +
+      (stop_sleep_time_real.tv_nsec - start_sleep_time_real.tv_nsec);
+  ++M_number_of_waits;
+  if (M_follow)
+    M_slot_consumer_waiting(false);
+  Dout(dc::notice, "Got data!");
+}
+
 void MemoryBlockListIterator::advance_to_next_block()
 {
   // Count the number of fully processed blocks.
   ++M_processed_blocks;
   Dout(dc::notice, "Finished processing of block " << M_processed_blocks);
-  if (G_UNLIKELY(M_block->is_last_block()))
+  // When following, the block that we just finished might be the last one that was appended.
+  if (G_UNLIKELY(M_buffer->following()) && !M_buffer->can_process_next_block(M_processed_blocks))
+    M_buffer->wait_for_more_data(M_processed_blocks);
+  if (G_UNLIKELY(M_buffer->cancelled() || M_block->is_last_block()))
   {
     // We should never even have been processing the last block,
     // unless the buffer was already closed.
-    ASSERT(M_buffer->closed());
+    ASSERT(M_buffer->cancelled() || M_buffer->closed());
 
     // This might free the memory of this block, if no other iterator is pointing at it.
     Dout(dc::notice, "Setting M_block to NULL.");
@@ -66,37 +112,11 @@ void MemoryBlockListIterator::advance_to_next_block()
     M_ptr = M_block->block_begin();
     M_block_end = M_block->block_end() - 1;
   }
-  if (M_buffer->full() && M_buffer->appended_blocks() - M_processed_blocks <= MemoryBlockList::S_max_blocks / 2)
-  {
-    Dout(dc::notice, "Requesting more data!");
-    M_buffer->need_more_data().emit();
-  }
-  // If M_buffer->full() was just false but around here the main thread
-  // sets it to true, then that means that the number of remaining blocks
-  // in the buffer is much larger than the threshold and the previous
-  // condition would have failed anyway. What would happen then is that
-  // the next condition is definitely false (because there ARE blocks to
-  // be processed), the next block in the buffer will be processed and
-  // we'll recheck the above condition. Hence, there is no race condition.
-  while (!M_buffer->can_process_next_block(*this))
-  {
-    // If can_process_next_block returned false (so we get here)
-    // then the buffer has less than 2 blocks is thus not full (yet).
-    // If now we manage to get into a sleeping state before the
-    // buffer is full then everything works. But, if right here
-    // the buffer is filled -- which causes an attempt to wake
-    // up this thread, but we're not inside wait() yet... and
-    // then we enter wait(), then we have a hang.
-    // Therefore it is needed to lock the mutex then test if
-    // the buffer is full and only if NOT we may really sleep.
-    // In the main thread then we may only mark that the buffer is
-    // full and emit the wake up signal if this mutex is not locked.
-    // The locking and extra buffer full test is done inside wait_for_more_data().
-
-    // This is triggered when a new block is appended, either when there are at least two blocks,
-    // or when the last block was appended (the buffer was closed).
-    M_buffer->wait_for_more_data(*this);
-  }
+  M_buffer->processed(M_processed_blocks);
+  // The block that we just advanced to may only be processed when it isn't the last block
+  // that was appended (the producer might still link a new block to it) or the buffer is closed.
+  if (G_UNLIKELY(!M_buffer->can_process_next_block(M_processed_blocks)))
+    M_buffer->wait_for_more_data(M_processed_blocks);
 }
 
 } // namespace util
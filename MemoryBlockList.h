@@ -24,17 +24,22 @@
 #pragma once
 
 #include "Referenceable.h"
+#include "MemoryBlockPool.h"
 #include "debug.h"
 #include <glibmm/refptr.h>
 #include <glibmm/thread.h>
 #include <glibmm/dispatcher.h>
+#include <atomic>
+#include <new>
+#include <cstdint>
 
 namespace util {
 
 /** @brief A contiguous block in memory.
  *
- * The data block is allocated with malloc(3) and the
+ * The data block is allocated from the MemoryBlockPool and the
  * object is placed at the beginning of that allocated memory block.
+ * Freed blocks are recycled by the pool.
  */
 struct MemoryBlock : public Referenceable {
   private:
@@ -60,13 +65,29 @@ struct MemoryBlock : public Referenceable {
      */
     void* operator new(size_t object_size, size_t block_size)
     {
-      void* ptr = malloc(object_size + block_size);
-      AllocTag(reinterpret_cast<char*>(ptr), "MemoryBlockNode (" << object_size << " bytes) + buffer allocation");
+      void* ptr = MemoryBlockPool::instance().allocate(object_size + block_size);
+      if (__builtin_expect(!ptr, false))
+	throw std::bad_alloc();
       return ptr;
     }
 
-    //! Operator delete.
-    void operator delete(void* ptr) { free(ptr); }
+    /** @brief Operator new for an object whose byte at \a aligned_offset must be page aligned.
+     *
+     * Construct object (derived from MemoryBlock) with:
+     * \code
+     * Object* obj = new (block_size, aligned_offset) Object(params);
+     * \endcode
+     */
+    void* operator new(size_t object_size, size_t block_size, size_t aligned_offset)
+    {
+      void* ptr = MemoryBlockPool::instance().allocate_aligned(object_size + block_size, aligned_offset);
+      if (__builtin_expect(!ptr, false))
+	throw std::bad_alloc();
+      return ptr;
+    }
+
+    //! Operator delete; returns the block to the MemoryBlockPool.
+    void operator delete(void* ptr) { MemoryBlockPool::instance().deallocate(ptr); }
 
   //@}
 };
@@ -96,13 +117,23 @@ struct MemoryBlockNode : public MemoryBlock {
   public:
     /** @brief Allocate a new MemoryBlock with room for \a size bytes of data.
       *
-      * The actual number of bytes allocated are sizeof(MemoryBlockNode) + \a size.
+      * The actual number of bytes allocated are sizeof(MemoryBlockNode) + \a size,
+      * plus MemoryBlockPool::S_header_size, rounded up to a whole number of pages.
       */
     static Glib::RefPtr<MemoryBlockNode> create(size_t size)
     {
       return Glib::RefPtr<MemoryBlockNode>(new (size) MemoryBlockNode);
     }
 
+    /** @brief Allocate a new MemoryBlock with room for \a size bytes of data that starts at a page boundary.
+      *
+      * This is needed to read into the block with O_DIRECT.
+      */
+    static Glib::RefPtr<MemoryBlockNode> create_page_aligned(size_t size)
+    {
+      return Glib::RefPtr<MemoryBlockNode>(new (size, S_data_offset) MemoryBlockNode);
+    }
+
   //@}
 
   private:
@@ -284,13 +315,28 @@ class MemoryBlockListIterator {
  * A newly created list is entirely empty.
  * When the first block is appended, then M_begin is set to point to this first block.
  *
- * A different thread should only start to process this block once the
- * second block is appended: when
+ * A different thread (the consumer) should only start to process this block once the
+ * second block is appended: the producer links new blocks to the last block, so the
+ * consumer never touches the last block until the list is closed. Therefore the
+ * blocks themselves need no locking at all; the list is a bounded single-producer,
+ * single-consumer queue of at most S_max_blocks unprocessed blocks, of which only
+ * the counters M_appended_blocks and M_processed_blocks are shared.
+ *
+ * A list that follows a growing file (see follow()) can't wait for the next block
+ * to appear, because that might take forever. Then the consumer may process the
+ * last block too, but it only reads the link to the next block after
+ * M_appended_blocks says that it was written.
+ *
+ * The consumer parks on the futex word M_events (see wait_for_more_data) when it
+ * runs out of blocks. The producer, which normally runs in the main loop and can't
+ * block, stops requesting data when the queue is full (M_producer_parked) and is
+ * resumed through a Glib::Dispatcher once the consumer processed half of the queue.
  */
 class MemoryBlockList {
   public:
     typedef MemoryBlockListIterator iterator;
     typedef sigc::slot<void> SlotNeedMoreData;
+    typedef sigc::slot<void, bool> SlotConsumerWaiting;
 
     // The the minimum buffer size in blocks is 4.
     // We use 8 because that makes the inner loop use
@@ -298,142 +344,155 @@ class MemoryBlockList {
     static int const S_max_blocks = 8;
 
   private:
-    Glib::RefPtr<MemoryBlockNode> M_last_node;	//!< A pointer to the last node in the list.
-    iterator M_begin;			  	//!< A pointer to the first node in the list. Read/write access by 'DatabaseSeekable::read_thread'.
-    int M_appended_blocks;			//!< The number of blocks appended to this list. Read access by 'DatabaseSeekable::read_thread'.
-    bool M_closed;				//!< False until the last block was appended and the read_thread is the only thread accessing this buffer.
-    bool M_buffer_full;				//!< True while the main thread stops reading new blocks.
+    Glib::RefPtr<MemoryBlockNode> M_last_node;	//!< A pointer to the last node in the list. Only accessed by the producer.
+    iterator M_begin;			  	//!< A pointer to the first node in the list. Written once by the producer before the first block is published.
+    std::atomic<int> M_appended_blocks;		//!< The number of blocks appended to this list. Written by the producer.
+    std::atomic<int> M_processed_blocks;	//!< The number of blocks that the consumer finished. Written by the consumer.
+    std::atomic<bool> M_closed;			//!< False until the last block was appended and the consumer is the only thread accessing this buffer.
+    std::atomic<bool> M_producer_parked;	//!< True while the producer stops reading new blocks because the buffer is full.
+    std::atomic<uint32_t> M_events;		//!< Incremented on every append and on close; the consumer waits on it.
     Glib::Dispatcher M_need_more_data;		//!< Used to signal the main thread that more data can be appended to the buffer.
     SlotNeedMoreData M_slot_need_more_data;	//!< Pass the signal on the calling object.
-    MutexCondPair M_more_data;			//!< Used for signaling that more data in the buffer is ready to be processed.
+    std::atomic<bool> const* M_cancelled;	//!< When set, the consumer stops at the next block boundary. May be NULL.
+    bool M_follow;				//!< Set when the consumer may process the last block. Written before the consumer starts.
+    SlotConsumerWaiting M_slot_consumer_waiting;	//!< Called by the consumer, when following, before (true) and after (false) it waits for data.
+
+  /** @name Statistics */
+  //@{
+    uint64_t M_wait_time_real;			//!< The total real time in nanoseconds that the consumer was parked. Written by the consumer.
+    int M_number_of_waits;			//!< The number of times that the consumer was parked. Written by the consumer.
+    int M_number_of_full_buffers;		//!< The number of times that the producer was parked. Written by the producer.
+  //@}
 
   public:
-    MemoryBlockList(SlotNeedMoreData const& slot) : M_begin(this), M_appended_blocks(0), M_closed(false), M_buffer_full(false), M_slot_need_more_data(slot)
+    /** @brief Construct an empty list.
+     *
+     * \a slot is called whenever the producer may append another block.
+     * If \a cancelled is not NULL, the consumer stops processing at the
+     * next block boundary once \a *cancelled becomes true.
+     */
+    MemoryBlockList(SlotNeedMoreData const& slot, std::atomic<bool> const* cancelled = NULL) : M_begin(this), M_appended_blocks(0),
+        M_processed_blocks(0), M_closed(false), M_producer_parked(false), M_events(0), M_slot_need_more_data(slot), M_cancelled(cancelled),
+	M_follow(false), M_wait_time_real(0), M_number_of_waits(0), M_number_of_full_buffers(0)
 	{ M_need_more_data.connect(sigc::mem_fun(*this, &MemoryBlockList::need_more_data_callback)); }
 
+    //! Append \a new_block with \a valid_bytes bytes of data. May only be called by the producer.
     void append(Glib::RefPtr<MemoryBlockNode>& new_block, size_t valid_bytes)
     {
-      int blocks;
       if (G_UNLIKELY(!M_last_node))
       {
         // If there is no last node, then this is the very first data block
-	// being appended. In that case the 'read thread' is not running:
-	// there wasn't any data yet in this buffer. Therefore, no locks
-	// are necessary.
+	// being appended. The consumer doesn't look at M_begin before
+	// a second block was appended (or the list was closed).
 	new_block->M_valid_bytes = valid_bytes;
         M_last_node.swap(new_block);
         M_begin = M_last_node;
 	Dout(dc::notice, "Appending FIRST block to the list. Number of blocks is now 1");
-	ASSERT(M_appended_blocks == 0);
-	M_appended_blocks = 1;
-	blocks = 1;
       }
       else
       {
-        // The read thread is only running if there is more than one
-	// block available for processing (it won't touch the last
-	// block). Therefore, appending a new block doesn't need locking.
+        // The consumer only processes a block if the block after it
+	// was published. Therefore, appending a new block doesn't need locking.
 	M_last_node->append(new_block, valid_bytes);
 	M_last_node = M_last_node->M_next;
-	// Increment block counter and signal the read thread if we have more than 1 block.
-	++M_appended_blocks;
-	blocks = M_appended_blocks - M_begin.processed_blocks();
-	Dout(dc::notice, "Appending a new block to the list. Number of unread blocks: " << blocks);
-	// There should be always at least two blocks in the buffer now.
-	M_more_data.cond.signal();
       }
+      // Publish the new block.
+      int appended_blocks = M_appended_blocks.load(std::memory_order_relaxed) + 1;
+      M_appended_blocks.store(appended_blocks, std::memory_order_release);
+      wake_consumer();
+      int blocks = appended_blocks - M_processed_blocks.load(std::memory_order_acquire);
+      Dout(dc::notice, "Appended block " << appended_blocks << ". Number of unread blocks: " << blocks);
       // Stop reading if there are eight or more blocks already buffered and waiting.
       if (blocks < S_max_blocks)
         M_slot_need_more_data();
       else
       {
 	Dout(dc::notice, "The buffer is full!");
-	M_more_data.mutex.lock();
-	M_buffer_full = true;
-	// Wake up 'read thread' just in case (special case).
-	M_more_data.cond.signal();
-	M_more_data.mutex.unlock();
+	++M_number_of_full_buffers;
+	M_producer_parked.store(true);
+	// The consumer might have processed blocks before it could see M_producer_parked.
+	// In that case it is up to us to continue.
+	if (appended_blocks - M_processed_blocks.load() <= S_max_blocks / 2 && M_producer_parked.exchange(false))
+	  M_slot_need_more_data();
       }
     }
 
+    //! Mark the end of the data. May only be called by the producer, after the last call to append.
     void close()
     {
-      M_more_data.mutex.lock();
-      M_closed = true;
-      // Wake up 'read thread' just in case (special case).
-      M_more_data.cond.signal();
-      M_more_data.mutex.unlock();
+      M_closed.store(true, std::memory_order_release);
+      wake_consumer();
     }
 
-    bool closed() const { return M_closed; }
-    bool full() const { return M_buffer_full; }
+    /** @brief Let the consumer process all data that was appended, including the last block.
+     *
+     * Used when the data never ends, like a file that is still being written.
+     * \a slot is called by the consumer with true just before it waits for
+     * more data and with false when it continues. Must be called before the consumer starts.
+     */
+    void follow(SlotConsumerWaiting const& slot) { M_follow = true; M_slot_consumer_waiting = slot; }
+
+    bool closed() const { return M_closed.load(std::memory_order_acquire); }
+    bool following() const { return M_follow; }
+    bool cancelled() const { return M_cancelled && M_cancelled->load(std::memory_order_relaxed); }
+    bool full() const { return M_producer_parked.load(std::memory_order_relaxed); }
 
     iterator& begin()
     {
       // Wait until there is another block, so we can start to process the first block.
-      while (!can_process_next_block(M_begin))
-        wait_for_more_data(M_begin);
+      if (!can_process_next_block(0))
+        wait_for_more_data(0);
       return M_begin;
     }
     iterator end() const { return iterator(const_cast<MemoryBlockList*>(this)); }
 
     //! @brief Return the number of blocks that were appended to the linked list.
-    int appended_blocks() const { return M_appended_blocks; }
+    int appended_blocks() const { return M_appended_blocks.load(std::memory_order_acquire); }
 
-    //! Returns ok if the read_thread is allowed to process the block that M_begin is pointing at.
-    // This function is only called from DatabaseSeekable::read_thread.
-    bool can_process_next_block(iterator const& iter)
+    //! Returns ok if the consumer, having finished \a processed_blocks blocks, is allowed to process the next block.
+    bool can_process_next_block(int processed_blocks) const
     {
       // Do not process the last block while we're still writing to the
       // buffer because that would require using a mutex on a per character
       // basis, while not processing the last block allows us to not us
-      // locking at all!
-      return M_closed || M_appended_blocks - iter.processed_blocks() >= 2;
+      // locking at all! Unless we follow a file that might never get another block.
+      return M_appended_blocks.load(std::memory_order_acquire) - processed_blocks >= (M_follow ? 1 : 2) || M_closed.load(std::memory_order_acquire);
     }
 
-    MutexCondPair& more_data() { return M_more_data; }
-
     Glib::Dispatcher& need_more_data() { return M_need_more_data; }
 
     void need_more_data_callback();
 
-    void wait_for_more_data(iterator const& iter)
+    //! Record that the consumer finished \a processed_blocks blocks and resume the producer if it is parked and the buffer is half empty.
+    void processed(int processed_blocks);
+
+    //! Park the consumer, which finished \a processed_blocks blocks, until it can process the next block.
+    void wait_for_more_data(int processed_blocks);
+
+  /** @name Statistics
+   * These may be read by the consumer, or by anyone after loading finished.
+   */
+  //@{
+
+    //! Return the total real time in seconds that the consumer was waiting for data.
+    double wait_time_thread_real() const { return M_wait_time_real * 1e-9; }
+
+    //! Return the total real time in nanoseconds that the consumer was waiting for data.
+    uint64_t wait_time_thread_real_ns() const { return M_wait_time_real; }
+
+    //! Return the number of times that the consumer had to wait for data.
+    int number_of_waits() const { return M_number_of_waits; }
+
+    //! Return the number of times that the producer had to wait because the buffer was full.
+    int number_of_full_buffers() const { return M_number_of_full_buffers; }
+
+  //@}
+
+  private:
+    void wake_consumer()
     {
-      Dout(dc::notice, "Waiting for more data...");
-continue_waiting:
-#if 0
-      timespec start_sleep_time_real, stop_sleep_time_real;
-      timespec start_sleep_time_process, stop_sleep_time_process;
-      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start_sleep_time_process);
-      clock_gettime(CLOCK_REALTIME, &start_sleep_time_real);
-#endif
-      M_more_data.mutex.lock();
-      if (!M_buffer_full && !M_closed)
-	M_more_data.cond.wait(M_more_data.mutex);
-      M_more_data.mutex.unlock();
-#if 0
-      clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &stop_sleep_time_process);
-      clock_gettime(CLOCK_REALTIME, &stop_sleep_time_real);
-      stop_sleep_time_process -= start_sleep_time_process;
-      wait_time_thread_process += stop_sleep_time_process;
-      stop_sleep_time_real -= start_sleep_time_real;
-      wait_time_thread_real += stop_sleep_time_real;
-#endif
-      // There is a small possibility that the main thread delayed
-      // setting M_buffer_full so that this thread already processed
-      // half of the buffer and got here even before M_buffer_full
-      // is set. Therefore, this thread is also woken up again
-      // when M_buffer_full is actually set.
-      if (M_buffer_full)
-      {
-	// Ok that is "weird". Now waste some cpu for this special case.
-	if (!can_process_next_block(iter))
-	{
-	  M_need_more_data.emit();
-	  goto continue_waiting;
-        }
-      }
-      Dout(dc::notice, "Got data!");
+      M_events.fetch_add(1, std::memory_order_release);
+      M_events.notify_one();
     }
 };
 
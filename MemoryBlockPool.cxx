@@ -0,0 +1,177 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file MemoryBlockPool.cxx This file contains the implementation of class MemoryBlockPool.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "MemoryBlockPool.h"
+#include "debug.h"
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <glib.h>
+
+namespace util {
+
+size_t MemoryBlockPool::S_page_size = sysconf(_SC_PAGESIZE);
+
+MemoryBlockPool& MemoryBlockPool::instance()
+{
+  // Never destroyed, so that blocks that are freed during program termination can still be returned.
+  static MemoryBlockPool* pool = new MemoryBlockPool;
+  return *pool;
+}
+
+MemoryBlockPool::MemoryBlockPool() : M_arena_begin(NULL), M_arena_end(NULL), M_use_huge_pages(false)
+{
+  std::memset(&M_statistics, 0, sizeof(M_statistics));
+}
+
+void MemoryBlockPool::use_huge_pages(bool use_huge_pages)
+{
+  std::lock_guard<std::mutex> lock(M_mutex);
+  M_use_huge_pages = use_huge_pages;
+}
+
+MemoryBlockPool::Statistics MemoryBlockPool::statistics()
+{
+  std::lock_guard<std::mutex> lock(M_mutex);
+  return M_statistics;
+}
+
+// Map a new arena of S_arena_size bytes. Called with M_mutex locked.
+char* MemoryBlockPool::new_arena()
+{
+  void* arena = MAP_FAILED;
+  if (M_use_huge_pages)
+  {
+#ifdef MAP_HUGETLB
+    arena = mmap(NULL, S_arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (arena != MAP_FAILED)
+      ++M_statistics.huge_page_arenas;
+    else
+#endif
+    {
+      // No hugetlbfs pages are reserved; ask for transparent huge pages instead, which requires alignment.
+      char* area = static_cast<char*>(mmap(NULL, 2 * S_arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+      if (area != MAP_FAILED)
+      {
+	char* aligned = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(area) + S_arena_size - 1) & ~(S_arena_size - 1));
+	if (aligned != area)
+	  munmap(area, aligned - area);
+	munmap(aligned + S_arena_size, (area + 2 * S_arena_size) - (aligned + S_arena_size));
+#ifdef MADV_HUGEPAGE
+	madvise(aligned, S_arena_size, MADV_HUGEPAGE);
+#endif
+	arena = aligned;
+      }
+    }
+  }
+  else
+    arena = mmap(NULL, S_arena_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (arena == MAP_FAILED)
+    return NULL;
+  Dout(dc::notice, "MemoryBlockPool: mapped arena at " << arena << '.');
+  ++M_statistics.arenas;
+  return static_cast<char*>(arena);
+}
+
+void* MemoryBlockPool::allocate(size_t size)
+{
+  return allocate(size, S_header_size);
+}
+
+void* MemoryBlockPool::allocate_aligned(size_t size, size_t offset)
+{
+  // The smallest lead of at least S_header_size bytes that puts offset at a page boundary.
+  size_t lead = (S_header_size + offset + S_page_size - 1) / S_page_size * S_page_size - offset;
+  return allocate(size, lead);
+}
+
+// Return a block with size bytes following lead bytes, at the start of which the header is stored.
+void* MemoryBlockPool::allocate(size_t size, size_t lead)
+{
+  size_t const pages = (lead + size + S_page_size - 1) / S_page_size;
+  size_t const bytes = pages * S_page_size;
+  char* block = NULL;
+  {
+    std::lock_guard<std::mutex> lock(M_mutex);
+    ++M_statistics.allocations;
+    if (G_LIKELY(pages < M_free_lists.size() && !M_free_lists[pages].empty()))
+    {
+      block = M_free_lists[pages].back();
+      M_free_lists[pages].pop_back();
+      ++M_statistics.recycled;
+    }
+    else if (bytes <= S_arena_size)
+    {
+      // The rest of the current arena is wasted when the block doesn't fit; in practice all blocks have the same size.
+      if (size_t(M_arena_end - M_arena_begin) < bytes)
+      {
+	M_arena_begin = new_arena();
+	M_arena_end = M_arena_begin ? M_arena_begin + S_arena_size : NULL;
+      }
+      if (M_arena_begin)
+      {
+	block = M_arena_begin;
+	M_arena_begin += bytes;
+      }
+    }
+    else
+    {
+      void* map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (map != MAP_FAILED)
+	block = static_cast<char*>(map);
+    }
+    if (G_UNLIKELY(!block))
+    {
+      --M_statistics.allocations;
+      return NULL;
+    }
+    if (++M_statistics.blocks_in_use > M_statistics.peak_blocks_in_use)
+      M_statistics.peak_blocks_in_use = M_statistics.blocks_in_use;
+  }
+  // The header consists of the number of pages at the start of the block and
+  // the distance to the start of the block right in front of the returned pointer.
+  *reinterpret_cast<uint32_t*>(block) = pages;
+  reinterpret_cast<uint32_t*>(block + lead)[-1] = lead;
+  return block + lead;
+}
+
+void MemoryBlockPool::deallocate(void* ptr)
+{
+  char* block = static_cast<char*>(ptr) - static_cast<uint32_t*>(ptr)[-1];
+  size_t const pages = *reinterpret_cast<uint32_t*>(block);
+  if (G_UNLIKELY(pages * S_page_size > S_arena_size))
+  {
+    munmap(block, pages * S_page_size);
+    std::lock_guard<std::mutex> lock(M_mutex);
+    --M_statistics.blocks_in_use;
+    return;
+  }
+  std::lock_guard<std::mutex> lock(M_mutex);
+  if (G_UNLIKELY(pages >= M_free_lists.size()))
+    M_free_lists.resize(pages + 1);
+  M_free_lists[pages].push_back(block);
+  --M_statistics.blocks_in_use;
+}
+
+} // namespace util
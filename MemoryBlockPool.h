@@ -0,0 +1,114 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file MemoryBlockPool.h This file contains the declaration of class MemoryBlockPool.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace util {
+
+/** @brief A pool of page-aligned memory blocks that are recycled instead of freed.
+ *
+ * Reading a large database allocates a new MemoryBlock for every read, which
+ * is freed again as soon as the parser moved past it. The pool keeps those
+ * blocks on a free list per size (in pages), so that after the first few
+ * reads no memory is allocated at all anymore. The number of blocks in use
+ * is bounded by MemoryBlockList::S_max_blocks plus the blocks that are
+ * still referenced by the parser.
+ *
+ * Blocks are carved from arenas of S_arena_size bytes that are obtained with mmap(2)
+ * and never returned to the system. When huge pages are enabled, an arena is first
+ * requested from the hugetlbfs pool and otherwise aligned to S_arena_size and marked
+ * as eligible for transparent huge pages. Blocks that are larger than an arena are
+ * mapped and unmapped individually.
+ *
+ * All member functions are thread-safe: blocks are typically allocated by the
+ * producer and freed by the thread that parses them.
+ */
+class MemoryBlockPool {
+  public:
+    static size_t const S_arena_size = 2 * 1024 * 1024;	//!< The size of an arena; the size of a huge page on x86_64.
+    static size_t const S_header_size = 16;			//!< The number of bytes before the pointer returned by allocate; room for the header.
+
+    //! Allocation statistics.
+    struct Statistics {
+      uint64_t allocations;		//!< The total number of calls to allocate.
+      uint64_t recycled;		//!< The number of those that were served from a free list.
+      size_t blocks_in_use;		//!< The number of blocks currently allocated.
+      size_t peak_blocks_in_use;	//!< The maximum of blocks_in_use so far.
+      size_t arenas;			//!< The number of arenas that were mapped.
+      size_t huge_page_arenas;		//!< The number of those that were mapped from the hugetlbfs pool.
+    };
+
+  private:
+    std::mutex M_mutex;					//!< Protects all other members.
+    std::vector<std::vector<char*>> M_free_lists;	//!< M_free_lists[pages] are the free blocks of that many pages.
+    char* M_arena_begin;				//!< The start of the unused part of the current arena.
+    char* M_arena_end;					//!< The end of the current arena.
+    bool M_use_huge_pages;				//!< Set when new arenas should be backed by huge pages.
+    Statistics M_statistics;				//!< Allocation statistics.
+
+    static size_t S_page_size;				//!< The page size of the system.
+
+  public:
+    //! Return the pool that is used by MemoryBlock.
+    static MemoryBlockPool& instance();
+
+    /** @brief Return a block of at least \a size bytes.
+     *
+     * The returned pointer is S_header_size bytes past a page boundary.
+     * Returns NULL if no memory could be mapped.
+     */
+    void* allocate(size_t size);
+
+    /** @brief Return a block of at least \a size bytes, of which the byte at \a offset is page aligned.
+     *
+     * The header is then stored in front of that page, which usually costs an extra page per block.
+     * Returns NULL if no memory could be mapped.
+     */
+    void* allocate_aligned(size_t size, size_t offset);
+
+    //! Return a block that was returned by allocate to the pool.
+    void deallocate(void* ptr);
+
+    /** @brief Enable or disable huge pages for arenas that are mapped from now on.
+     *
+     * Blocks that were already allocated keep the pages they have.
+     */
+    void use_huge_pages(bool use_huge_pages);
+
+    //! Return a copy of the current statistics.
+    Statistics statistics();
+
+  private:
+    MemoryBlockPool();
+    ~MemoryBlockPool() = delete;
+
+    char* new_arena();
+    void* allocate(size_t size, size_t lead);
+};
+
+} // namespace util
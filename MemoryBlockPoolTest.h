@@ -0,0 +1,146 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file MemoryBlockPoolTest.h Testsuite for util::MemoryBlockPool.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "MemoryBlockPool.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class MemoryBlockPoolTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(MemoryBlockPoolTest);
+
+  CPPUNIT_TEST(testRecycle);
+  CPPUNIT_TEST(testLargeBlocks);
+  CPPUNIT_TEST(testThreads);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    MemoryBlockPoolTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testRecycle();
+    void testLargeBlocks();
+    void testThreads();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <cstring>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MemoryBlockPoolTest);
+
+void MemoryBlockPoolTest::testRecycle()
+{
+  util::MemoryBlockPool& pool(util::MemoryBlockPool::instance());
+  uintptr_t const page_size = sysconf(_SC_PAGESIZE);
+  util::MemoryBlockPool::Statistics before = pool.statistics();
+
+  // Blocks start at a page boundary, just past the header, and can be written entirely.
+  void* blocks[8];
+  for (int i = 0; i < 8; ++i)
+  {
+    blocks[i] = pool.allocate(6 * 4096 - 64);
+    CPPUNIT_ASSERT(blocks[i]);
+    CPPUNIT_ASSERT((reinterpret_cast<uintptr_t>(blocks[i]) - util::MemoryBlockPool::S_header_size) % page_size == 0);
+    std::memset(blocks[i], i, 6 * 4096 - 64);
+  }
+  util::MemoryBlockPool::Statistics during = pool.statistics();
+  CPPUNIT_ASSERT(during.allocations == before.allocations + 8);
+  CPPUNIT_ASSERT(during.blocks_in_use == before.blocks_in_use + 8);
+  CPPUNIT_ASSERT(during.peak_blocks_in_use >= during.blocks_in_use);
+
+  // Freed blocks are handed out again.
+  for (int i = 0; i < 8; ++i)
+    pool.deallocate(blocks[i]);
+  for (int round = 0; round < 100; ++round)
+  {
+    void* block = pool.allocate(6 * 4096 - 64);
+    CPPUNIT_ASSERT(std::find(blocks, blocks + 8, block) != blocks + 8);
+    pool.deallocate(block);
+  }
+  util::MemoryBlockPool::Statistics after = pool.statistics();
+  CPPUNIT_ASSERT(after.recycled == during.recycled + 100);
+  CPPUNIT_ASSERT(after.blocks_in_use == before.blocks_in_use);
+  CPPUNIT_ASSERT(after.peak_blocks_in_use == during.peak_blocks_in_use);
+  CPPUNIT_ASSERT(after.arenas == during.arenas);
+}
+
+void MemoryBlockPoolTest::testLargeBlocks()
+{
+  util::MemoryBlockPool& pool(util::MemoryBlockPool::instance());
+  util::MemoryBlockPool::Statistics before = pool.statistics();
+  size_t const size = 3 * util::MemoryBlockPool::S_arena_size;
+  char* block = static_cast<char*>(pool.allocate(size));
+  CPPUNIT_ASSERT(block);
+  block[0] = 1;
+  block[size - 1] = 2;
+  pool.deallocate(block);
+  util::MemoryBlockPool::Statistics after = pool.statistics();
+  CPPUNIT_ASSERT(after.blocks_in_use == before.blocks_in_use && after.arenas == before.arenas);
+}
+
+void MemoryBlockPoolTest::testThreads()
+{
+  // Blocks allocated by one thread are freed by another, like the producer and consumer of a MemoryBlockList.
+  util::MemoryBlockPool& pool(util::MemoryBlockPool::instance());
+  util::MemoryBlockPool::Statistics before = pool.statistics();
+  std::vector<void*> blocks(10000);
+  std::atomic<size_t> produced(0);
+  std::thread producer([&](){
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      blocks[i] = pool.allocate(4000 + i % 3 * 4096);
+      produced.store(i + 1, std::memory_order_release);
+    }
+  });
+  std::thread consumer([&](){
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+      while (produced.load(std::memory_order_acquire) <= i)
+	std::this_thread::yield();
+      pool.deallocate(blocks[i]);
+    }
+  });
+  producer.join();
+  consumer.join();
+  util::MemoryBlockPool::Statistics after = pool.statistics();
+  CPPUNIT_ASSERT(after.blocks_in_use == before.blocks_in_use);
+  CPPUNIT_ASSERT(after.allocations == before.allocations + blocks.size());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -33,7 +33,10 @@ bool MoveIterator::next_promotion()
   // The piece is a queen when we get here first.
   // Order: queen -> rook -> knight -> bishop -> return true.
   if (promotion_type == bishop)
+  {
+    M_current_move.set_promotion(queen);	// Start with a queen again on the next target square.
     return true;		// We tried all types.
+  }
   else if (promotion_type == rook)
     type = knight;
   else if (promotion_type == knight)
@@ -48,7 +51,10 @@ bool MoveIterator::prev_promotion()
   Type promotion_type = M_current_move.promotion_type();
   // Order: bishop -> knight -> rook --> queen --> return true.
   if (promotion_type == queen)
+  {
+    M_current_move.set_promotion(bishop);	// Start with a bishop again on the previous target square.
     return true;		// We tried all types.
+  }
   else if (promotion_type == bishop)
     type = knight;
   else if (promotion_type == knight)
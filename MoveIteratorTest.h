@@ -0,0 +1,96 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file MoveIteratorTest.h Testsuite header for class MoveIterator.
+//
+// Copyright (C) 2008, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ChessPosition.h"
+#include "MoveIterator.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class MoveIteratorTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(MoveIteratorTest);
+
+  CPPUNIT_TEST(testPromotions);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    MoveIteratorTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testPromotions();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include <vector>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MoveIteratorTest);
+
+void MoveIteratorTest::testPromotions()
+{
+  // The pawn on b7 can promote on a8 (taking the knight) and on b8.
+  ChessPosition chess_position;
+  CPPUNIT_ASSERT(chess_position.load_FEN("n3k3/1P6/8/8/8/8/8/4K3 w - - 0 1"));
+  Index const b7(1, 6);
+  std::vector<Move> moves;
+  MoveIterator last_move;
+  for (MoveIterator move_iter = chess_position.move_begin(b7); move_iter != chess_position.move_end(); ++move_iter)
+  {
+    moves.push_back(*move_iter);
+    last_move = move_iter;
+  }
+
+  // Every target square gets all four promotion pieces.
+  CPPUNIT_ASSERT(moves.size() == 8);
+  for (int col = 0; col < 2; ++col)
+  {
+    Index const to(col, 7);
+    for (Type type : { queen, rook, knight, bishop })
+    {
+      size_t count = 0;
+      for (Move const& move : moves)
+	count += move.from() == b7 && move.to() == to && move.promotion_type() == type;
+      CPPUNIT_ASSERT(count == 1);
+    }
+  }
+
+  // Iterating backwards gives the same moves in reverse order.
+  MoveIterator move_iter = last_move;
+  for (size_t i = moves.size(); i > 0; --i, --move_iter)
+    CPPUNIT_ASSERT(*move_iter == moves[i - 1]);
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,288 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file OpeningTreeTest.h Testsuite for pgn::OpeningTree.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnOpeningTree.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class OpeningTreeTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(OpeningTreeTest);
+
+  CPPUNIT_TEST(testBuildAndFind);
+  CPPUNIT_TEST(testChildren);
+  CPPUNIT_TEST(testTransposition);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    pgn::TagStore M_tag_store;
+    pgn::MoveStore M_move_store;
+
+  public:
+    OpeningTreeTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testBuildAndFind();
+    void testChildren();
+    void testTransposition();
+
+  private:
+    bool build(pgn::OpeningTree& tree, pgn::OpeningTree::BuildOptions const& options);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include "RandomGame.h"
+#include <map>
+#include <random>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(OpeningTreeTest);
+
+void OpeningTreeTest::setUp()
+{
+  // Five hundred random games with a fixed seed. Only a few moves per position are
+  // considered, so that the games share many of their opening positions.
+  std::mt19937 random_number_generator(1760799713);
+  static char const* const results[4] = { "1-0", "0-1", "1/2-1/2", "*" };
+  ChessPosition chess_position;
+  for (int game = 0; game < 500; ++game)
+  {
+    M_tag_store.begin_game(0);
+    M_tag_store.add_tag("Date", "20" + std::to_string(10 + game % 17) + ".0" + std::to_string(1 + game % 9) + ".??");
+    M_tag_store.add_tag("Result", results[random_number_generator() % 4]);
+    if (game % 3)
+      M_tag_store.add_tag("WhiteElo", std::to_string(2000 + random_number_generator() % 800));
+    if (game % 5)
+      M_tag_store.add_tag("BlackElo", std::to_string(2000 + random_number_generator() % 800));
+    M_move_store.begin_game();
+    chess_position.initial_position();
+    random_game(random_number_generator, chess_position, M_move_store, random_number_generator() % 30, 3);
+  }
+}
+
+void OpeningTreeTest::tearDown()
+{
+  M_tag_store.clear();
+  M_move_store.clear();
+}
+
+bool OpeningTreeTest::build(pgn::OpeningTree& tree, pgn::OpeningTree::BuildOptions const& options)
+{
+  TempFile file("OpeningTreeTest");
+  return pgn::OpeningTree::build(M_tag_store, M_move_store, file.filename(), options) && tree.open(file.filename());
+}
+
+void OpeningTreeTest::testBuildAndFind()
+{
+  unsigned int const number_of_plies = 12;
+
+  // Calculate the expected result the slow way.
+  std::map<position_key_t, pgn::OpeningTree::Statistics> expected;
+  ChessPosition chess_position;
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+  {
+    M_move_store.start_position(game_id, chess_position);
+    std::map<position_key_t, bool> seen;
+    size_t number_of_moves = M_move_store.number_of_moves(game_id);
+    for (size_t ply = 0; ply <= std::min(number_of_moves, size_t(number_of_plies)); ++ply)
+    {
+      position_key_t key = position_key(chess_position);
+      if (!seen[key])
+      {
+	seen[key] = true;
+	pgn::OpeningTree::Statistics& statistics(expected[key]);
+	++statistics.games;
+	pgn::TagStore::result_type result = M_tag_store.result(game_id);
+	statistics.white_wins += result == pgn::TagStore::white_wins;
+	statistics.black_wins += result == pgn::TagStore::black_wins;
+	statistics.draws += result == pgn::TagStore::draw;
+	for (uint16_t elo : { M_tag_store.white_elo(game_id), M_tag_store.black_elo(game_id) })
+	{
+	  statistics.ratings += elo != 0;
+	  statistics.elo_sum += elo;
+	}
+	statistics.last_played = std::max(statistics.last_played, M_tag_store.date(game_id));
+      }
+      if (ply < number_of_moves)
+	chess_position.execute(pgn::MoveStore::decode(M_move_store.moves(game_id)[ply]));
+    }
+  }
+
+  pgn::OpeningTree tree;
+  CPPUNIT_ASSERT(!tree.open("/nonexistent/tree"));
+  for (unsigned int number_of_threads = 1; number_of_threads <= 3; number_of_threads += 2)
+  {
+    pgn::OpeningTree::BuildOptions options;
+    options.number_of_plies = number_of_plies;
+    options.number_of_threads = number_of_threads;
+    CPPUNIT_ASSERT(build(tree, options));
+    CPPUNIT_ASSERT(tree.number_of_plies() == number_of_plies);
+    CPPUNIT_ASSERT(tree.number_of_positions() == expected.size());
+    for (auto const& position : expected)
+    {
+      pgn::OpeningTree::Statistics statistics;
+      CPPUNIT_ASSERT(tree.find(position.first, statistics));
+      pgn::OpeningTree::Statistics const& e(position.second);
+      CPPUNIT_ASSERT(statistics.games == e.games && statistics.white_wins == e.white_wins && statistics.draws == e.draws &&
+	  statistics.black_wins == e.black_wins && statistics.ratings == e.ratings && statistics.elo_sum == e.elo_sum &&
+	  statistics.last_played == e.last_played);
+    }
+  }
+
+  // Every game starts from the initial position.
+  pgn::OpeningTree::Statistics statistics;
+  chess_position.initial_position();
+  CPPUNIT_ASSERT(tree.find(chess_position, statistics) && statistics.games == M_move_store.size());
+  CPPUNIT_ASSERT(statistics.white_wins + statistics.draws + statistics.black_wins <= statistics.games);
+  CPPUNIT_ASSERT(statistics.average_elo() >= 2000 && statistics.average_elo() < 2800);
+  chess_position.load_FEN("8/8/8/8/8/8/8/K6k w - - 0 1");
+  CPPUNIT_ASSERT(!tree.find(chess_position, statistics));
+
+  // Rare positions are left out with min_games.
+  pgn::OpeningTree::BuildOptions options;
+  options.number_of_plies = number_of_plies;
+  options.min_games = 10;
+  CPPUNIT_ASSERT(build(tree, options));
+  size_t frequent = 0;
+  for (auto const& position : expected)
+    if (position.second.games >= 10)
+    {
+      ++frequent;
+      CPPUNIT_ASSERT(tree.find(position.first, statistics) && statistics.games == position.second.games);
+    }
+    else
+      CPPUNIT_ASSERT(!tree.find(position.first, statistics));
+  CPPUNIT_ASSERT(tree.number_of_positions() == frequent);
+}
+
+void OpeningTreeTest::testChildren()
+{
+  pgn::OpeningTree tree;
+  pgn::OpeningTree::BuildOptions options;
+  options.number_of_plies = 2;
+  CPPUNIT_ASSERT(build(tree, options));
+
+  // The games of all children of the initial position add up to the games with at least one move.
+  ChessPosition chess_position;
+  chess_position.initial_position();
+  std::vector<pgn::OpeningTree::Child> children;
+  CPPUNIT_ASSERT(tree.children(chess_position, children) == children.size() && !children.empty());
+  uint32_t games = 0;
+  for (pgn::OpeningTree::Child const& child : children)
+  {
+    CPPUNIT_ASSERT(chess_position.legal(child.move));
+    games += child.statistics.games;
+  }
+  uint32_t expected_games = 0;
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+    expected_games += M_move_store.number_of_moves(game_id) > 0;
+  CPPUNIT_ASSERT(games == expected_games);
+
+  // Positions after two plies are leaves of this tree.
+  ChessPosition leaf(chess_position);
+  leaf.execute(children[0].move);
+  children.clear();
+  CPPUNIT_ASSERT(tree.children(leaf, children) > 0);
+  leaf.execute(children[0].move);
+  children.clear();
+  CPPUNIT_ASSERT(tree.children(leaf, children) == 0 && children.empty());
+}
+
+void OpeningTreeTest::testTransposition()
+{
+  // 1.d4 Nf6 2.c4 and 1.c4 Nf6 2.d4 reach the same position.
+  pgn::TagStore tag_store;
+  pgn::MoveStore move_store;
+  Move const d4(Index(3, 1), Index(3, 3), nothing);
+  Move const c4(Index(2, 1), Index(2, 3), nothing);
+  Move const Nf6(Index(6, 7), Index(5, 5), nothing);
+  tag_store.begin_game(0);
+  tag_store.add_tag("Result", "1-0");
+  move_store.begin_game();
+  for (Move const& move : { d4, Nf6, c4 })
+    move_store.add(move);
+  tag_store.begin_game(0);
+  tag_store.add_tag("Result", "0-1");
+  move_store.begin_game();
+  for (Move const& move : { c4, Nf6, d4 })
+    move_store.add(move);
+
+  TempFile file("OpeningTreeTest");
+  pgn::OpeningTree tree;
+  CPPUNIT_ASSERT(pgn::OpeningTree::build(tag_store, move_store, file.filename()) && tree.open(file.filename()));
+  // The initial position, 1.d4, 1.c4, 1.d4 Nf6, 1.c4 Nf6 and the transposed position.
+  CPPUNIT_ASSERT(tree.number_of_positions() == 6);
+
+  ChessPosition chess_position;
+  chess_position.load_FEN("rnbqkb1r/pppppppp/5n2/8/2PP4/8/PP2PPPP/RNBQKBNR b KQkq - 0 2");
+  pgn::OpeningTree::Statistics statistics;
+  CPPUNIT_ASSERT(tree.find(chess_position, statistics));
+  CPPUNIT_ASSERT(statistics.games == 2 && statistics.white_wins == 1 && statistics.black_wins == 1);
+
+  // The child of either move order counts both games.
+  for (Move const& first_move : { d4, c4 })
+  {
+    chess_position.initial_position();
+    chess_position.execute(first_move);
+    chess_position.execute(Nf6);
+    std::vector<pgn::OpeningTree::Child> children;
+    CPPUNIT_ASSERT(tree.children(chess_position, children) == 1);
+    CPPUNIT_ASSERT(children[0].move == (first_move == d4 ? c4 : d4) && children[0].statistics.games == 2);
+  }
+
+  // A number of positions that only matches the file size modulo 2^64 must be rejected.
+  std::string data;
+  {
+    std::ifstream ifs(file.filename(), std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+  uint64_t number_of_positions;
+  std::memcpy(&number_of_positions, &data[16], sizeof(number_of_positions));
+  CPPUNIT_ASSERT(number_of_positions == 6);
+  number_of_positions += uint64_t(1) << 61;	// Times the 40 bytes of an entry is a multiple of 2^64.
+  std::memcpy(&data[16], &number_of_positions, sizeof(number_of_positions));
+  TempFile corrupt_file("OpeningTreeTest", data);
+  pgn::OpeningTree corrupt_tree;
+  CPPUNIT_ASSERT(!corrupt_tree.open(corrupt_file.filename()));
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,223 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnCorpusGenerator.cxx This file contains the implementation of class pgn::CorpusGenerator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sys.h"
+#include "PgnCorpusGenerator.h"
+#include "PieceIterator.h"
+#include "MoveIterator.h"
+#include "debug.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+namespace {
+
+char const* const first_names[] = { "Magnus", "Fabiano", "Liren", "Ian", "Hikaru", "Anish", "Wesley", "Judit", "Hou", "Alireza", "Vladimir", "Maxime" };
+char const* const last_names[] = { "Carlsen", "Caruana", "Ding", "Nepomniachtchi", "Nakamura", "Giri", "So", "Polgar", "Yifan", "Firouzja", "Kramnik", "Vachier-Lagrave" };
+char const* const events[] = { "Casual game", "Rated blitz game", "Club championship", "Open", "Team match", "Simul", "Correspondence" };
+char const* const sites[] = { "?", "Amsterdam NED", "Wijk aan Zee NED", "St. Louis USA", "https://example.org", "London ENG", "Moscow RUS" };
+char const* const comments[] = { "The only move.", "A typical idea in this structure.", "Better was to take on d5 first.",
+    "White has the initiative.", "Black is fine.", "Time trouble.", "A blunder, but the position was already lost.", "Novelty." };
+char const* const junk_lines[] = { "Downloaded from https://example.org/games", "% This line is escaped",
+    "Generated by a program that doesn't write PGN", "=== Round 3 ===", "Page 2 of 17", "" };
+
+char const* const result_strings[4] = { "*", "1-0", "0-1", "1/2-1/2" };
+
+// Store the legal moves of chess_position, except exclude, in moves.
+void legal_moves(ChessPosition const& chess_position, std::vector<Move>& moves, Move const* exclude)
+{
+  moves.clear();
+  for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+    for (MoveIterator move_iter = chess_position.move_begin(piece_iter.index()); move_iter != chess_position.move_end(); ++move_iter)
+      if (!exclude || *move_iter != *exclude)
+	moves.push_back(*move_iter);
+}
+
+} // namespace
+
+uint64_t CorpusGenerator::random()
+{
+  uint64_t z = (M_state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+bool CorpusGenerator::parse_style(std::string_view names, unsigned int& style)
+{
+  style = bare;
+  while (!names.empty())
+  {
+    size_t comma = names.find(',');
+    std::string_view name = names.substr(0, comma);
+    if (name == "annotated")
+      style |= annotated;
+    else if (name == "variations")
+      style |= variations;
+    else if (name == "crlf")
+      style |= crlf;
+    else if (name == "junk")
+      style |= junk;
+    else if (name != "bare")
+      return false;
+    if (comma == std::string_view::npos)
+      break;
+    names.remove_prefix(comma + 1);
+  }
+  return true;
+}
+
+uint32_t CorpusGenerator::generate(Writer& writer)
+{
+  writer.set_crlf(M_options.style & crlf);
+  uint64_t const start = writer.bytes_written();
+  while (M_options.games ? M_games < M_options.games : writer.bytes_written() - start < M_options.size)
+    game(writer);
+  return M_games;
+}
+
+void CorpusGenerator::write_move(Writer& writer, ChessPosition& chess_position, Move const& move, int depth)
+{
+  bool const has_variation = (M_options.style & variations) && depth < 2 && random(depth == 0 ? 10 : 20) == 0;
+  ChessPosition before;
+  if (has_variation)
+    before = chess_position;
+  writer.move(chess_position, move);
+  if ((M_options.style & annotated))
+  {
+    if (random(8) == 0)
+      writer.nag(1 + random(6));
+    uint32_t what = random(16);
+    if (what < 3)
+    {
+      // Evaluation and clock annotations, as written by online servers.
+      char buf[64];
+      int eval = int(random(801)) - 400;
+      unsigned int seconds = random(600);
+      snprintf(buf, sizeof(buf), "[%%eval %s%d.%02d] [%%clk 0:%02u:%02u]", eval < 0 ? "-" : "", std::abs(eval) / 100, std::abs(eval) % 100,
+	  seconds / 60, seconds % 60);
+      writer.comment(buf);
+    }
+    else if (what == 3)
+      writer.comment(comments[random(sizeof(comments) / sizeof(comments[0]))]);
+  }
+  if (has_variation)
+    variation(writer, before, move, 1 + random(8), depth + 1);
+}
+
+void CorpusGenerator::variation(Writer& writer, ChessPosition& chess_position, Move const& exclude, int plies, int depth)
+{
+  std::vector<Move> moves;
+  legal_moves(chess_position, moves, &exclude);
+  if (moves.empty())
+    return;
+  writer.begin_variation();
+  for (int ply = 0;;)
+  {
+    write_move(writer, chess_position, moves[random(moves.size())], depth);
+    if (++ply == plies)
+      break;
+    legal_moves(chess_position, moves, NULL);
+    if (moves.empty())
+      break;
+  }
+  writer.end_variation();
+}
+
+void CorpusGenerator::write_junk(Writer& writer)
+{
+  char const* newline = (M_options.style & crlf) ? "\r\n" : "\n";
+  std::string text;
+  for (uint32_t n = 1 + random(3); n > 0; --n)
+  {
+    text += junk_lines[random(sizeof(junk_lines) / sizeof(junk_lines[0]))];
+    text += newline;
+  }
+  text += newline;
+  writer.raw(text.data(), text.size());
+}
+
+void CorpusGenerator::game(Writer& writer)
+{
+  if ((M_options.style & junk) && random(4) == 0)
+    write_junk(writer);
+
+  // Pick the main line first, because the result depends on how it ends.
+  M_chess_position.initial_position();
+  M_main_line.clear();
+  uint32_t const plies = 10 + random(150);
+  TagStore::result_type result;
+  for (;;)
+  {
+    legal_moves(M_chess_position, M_moves, NULL);
+    if (M_moves.empty())
+    {
+      result = !M_chess_position.check() ? TagStore::draw : M_chess_position.to_move() == white ? TagStore::black_wins : TagStore::white_wins;
+      break;
+    }
+    if (M_main_line.size() == plies)
+    {
+      result = TagStore::result_type(random(4));
+      break;
+    }
+    M_main_line.push_back(M_moves[random(M_moves.size())]);
+    M_chess_position.execute(M_main_line.back());
+  }
+
+  char buf[64];
+  writer.tag("Event", events[random(sizeof(events) / sizeof(events[0]))]);
+  writer.tag("Site", sites[random(sizeof(sites) / sizeof(sites[0]))]);
+  snprintf(buf, sizeof(buf), "%u.%02u.%02u", 1950 + random(76), 1 + random(12), 1 + random(28));
+  writer.tag("Date", buf);
+  snprintf(buf, sizeof(buf), "%u", 1 + random(13));
+  writer.tag("Round", buf);
+  for (char const* color : { "White", "Black" })
+  {
+    snprintf(buf, sizeof(buf), "%s, %s", last_names[random(sizeof(last_names) / sizeof(last_names[0]))],
+	first_names[random(sizeof(first_names) / sizeof(first_names[0]))]);
+    writer.tag(color, buf);
+  }
+  writer.tag("Result", result_strings[result]);
+  snprintf(buf, sizeof(buf), "%u", 1200 + random(1600));
+  writer.tag("WhiteElo", buf);
+  snprintf(buf, sizeof(buf), "%u", 1200 + random(1600));
+  writer.tag("BlackElo", buf);
+  snprintf(buf, sizeof(buf), "%c%02u", 'A' + random(5), random(100));
+  writer.tag("ECO", buf);
+
+  if ((M_options.style & annotated) && random(4) == 0)
+    writer.comment(comments[random(sizeof(comments) / sizeof(comments[0]))]);
+  M_chess_position.initial_position();
+  for (Move const& move : M_main_line)
+    write_move(writer, M_chess_position, move, 0);
+  writer.result(result);
+  ++M_games;
+}
+
+} // namespace pgn
+} // namespace cwchess
@@ -0,0 +1,125 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnCorpusGenerator.h This file contains the declaration of class pgn::CorpusGenerator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "ChessPosition.h"
+#include "PgnWriter.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief Generator of synthetic PGN databases.
+ *
+ * The games consist of random legal moves and random tags. The output only
+ * depends on the Options, so that a benchmark can regenerate the same corpus
+ * on any machine instead of depending on a large file that not everyone has.
+ * The random number generator is splitmix64, and no standard library distributions
+ * are used, because those are not the same on every platform.
+ *
+ * Besides plain games (style bare), the corpus can contain comments,
+ * clock and evaluation annotations and Numeric Annotation Glyphs (annotated),
+ * possibly nested variations (variations), lines ending in CR LF (crlf) and
+ * text between the games that isn't PGN (junk). Styles may be combined.
+ *
+ * Usage example:
+ * \code
+ * pgn::CorpusGenerator::Options options;
+ * options.size = 256 * 1024 * 1024;
+ * options.style = pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::variations;
+ * pgn::Writer writer(fd);
+ * pgn::CorpusGenerator(options).generate(writer);
+ * \endcode
+ */
+class CorpusGenerator {
+  public:
+    //! The style of the generated PGN. The values are bit flags.
+    enum style_type {
+      bare = 0,			//!< Tags and moves only.
+      annotated = 1,		//!< Comments, [%clk] and [%eval] annotations and NAGs.
+      variations = 2,		//!< Variations, nested up to two levels deep.
+      crlf = 4,			//!< Lines end in CR LF.
+      junk = 8			//!< Text between games that isn't PGN.
+    };
+
+    //! The parameters of the corpus.
+    struct Options {
+      uint64_t seed;		//!< The seed of the random number generator.
+      uint64_t size;		//!< The minimum size of the corpus in bytes; ignored if games is not zero.
+      uint32_t games;		//!< The number of games, or zero to generate size bytes.
+      unsigned int style;	//!< A combination of style_type flags.
+
+      //! Construct the default options: 64 MB of bare games.
+      Options() : seed(1220638382), size(64 * 1024 * 1024), games(0), style(bare) { }
+    };
+
+  private:
+    Options M_options;
+    uint64_t M_state;			//!< The state of the random number generator.
+    uint32_t M_games;			//!< The number of games generated so far.
+    ChessPosition M_chess_position;	//!< The position of the main line.
+    std::vector<Move> M_main_line;	//!< The moves of the main line of the current game.
+    std::vector<Move> M_moves;		//!< Scratch space for the legal moves of a position.
+
+  public:
+    //! Construct a generator for \a options.
+    CorpusGenerator(Options const& options) : M_options(options), M_state(options.seed), M_games(0) { }
+
+    //! Write the whole corpus to \a writer. Returns the number of games.
+    uint32_t generate(Writer& writer);
+
+    //! Write the next game to \a writer.
+    void game(Writer& writer);
+
+    //! Return the number of games generated so far.
+    uint32_t number_of_games() const { return M_games; }
+
+    /** @brief Parse a comma separated list of style names, like "annotated,crlf", into \a style.
+     *
+     * @returns FALSE if a name is not known.
+     */
+    static bool parse_style(std::string_view names, unsigned int& style);
+
+  private:
+    // Return the next random number.
+    uint64_t random();
+
+    // Return a random number in the range [0, n).
+    uint32_t random(uint32_t n) { return random() % n; }
+
+    // Write move, which is executed on chess_position, followed by random annotations and variations depending on the style.
+    void write_move(Writer& writer, ChessPosition& chess_position, Move const& move, int depth);
+
+    // Write a variation of up to plies random moves from chess_position that doesn't start with exclude.
+    void variation(Writer& writer, ChessPosition& chess_position, Move const& exclude, int plies, int depth);
+
+    // Write text that isn't PGN.
+    void write_junk(Writer& writer);
+};
+
+} // namespace pgn
+} // namespace cwchess
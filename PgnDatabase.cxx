@@ -35,6 +35,10 @@
 #include <ctime>		// Needed for clock_gettime.
 #include <iomanip>
 #include <glib.h>
+#include <sys/stat.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>		// Needed for __rdtsc.
+#endif
 #ifdef CWDEBUG
 #include <libcwd/buf2str.h>
 #endif
@@ -42,33 +46,284 @@
 namespace cwchess {
 namespace pgn {
 
+namespace {
+
+// The current time in nanoseconds, for the counters of the producer thread.
+uint64_t monotonic_time()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+} // namespace
+
 void Database::process_next_data_block(char const* data, size_t size)
 {
 }
 
-void DatabaseSeekable::load()
+Database::Database(SlotOpenFinished const& slot_open_finished, util::BlockReader::Options const& read_options,
+    SlotGamesAdded const& slot_games_added, SlotGameCompleted const& slot_game_completed, bool keep_games) :
+    M_saw_carriage_return(false), M_line_wrapped(0), M_number_of_lines(0), M_number_of_characters(0), M_state(white_space),
+    M_buffer(NULL), M_complete_games(0), M_bytes_read(0), M_slot_open_finished(slot_open_finished), M_read_thread(NULL),
+    M_read_options(read_options), M_block_reader(NULL), M_decompressor(NULL), M_input_fd(-1), M_producer_thread(NULL),
+    M_producer_read_time(0), M_producer_wait_time(0), M_may_produce(false), M_file_follower(NULL), M_parsing_game(false), M_slot_games_added(slot_games_added),
+    M_slot_game_completed(slot_game_completed), M_keep_games(keep_games), M_reported_games(0), M_cleared_games(0)
 {
   if (!Glib::thread_supported())
-    DoutFatal(dc::fatal, "DatabaseSeekable::load: Threading not initialized. Call Glib::init_thread() at the start of main().");
-  M_file->read_async(sigc::mem_fun(this, &DatabaseSeekable::read_async_open_ready), M_cancellable);
+    DoutFatal(dc::fatal, "Database: Threading not initialized. Call Glib::init_thread() at the start of main().");
+  M_processing_finished.connect(sigc::mem_fun(*this, &Database::processing_finished));
+}
+
+Database::~Database()
+{
+  // Just in case. Normally this should already be freed after loading of the database finished.
+  if (M_buffer)
+    delete M_buffer;
+  delete M_decompressor;
+  delete M_block_reader;
+  delete M_file_follower;
+}
+
+void Database::start_reading()
+{
+  M_buffer = new MemoryBlockList(sigc::mem_fun(*this, &Database::produce_more), &M_progress.cancel_flag());
+  // A stream is parsed as it comes in, like a file that is followed.
+  if (M_file_follower || M_input_fd != -1)
+    M_buffer->follow(sigc::mem_fun(*this, &Database::read_thread_waiting));
+  if (M_file_follower)
+    M_games_added.connect(sigc::mem_fun(*this, &Database::games_added));
+  M_read_thread = Glib::Thread::create(sigc::mem_fun(*this, &Database::read_thread), false);
+  M_may_produce = true;
+  M_producer_thread = Glib::Thread::create(sigc::mem_fun(*this, &Database::producer_thread), true);
+}
+
+// Called by the buffer when another block may be appended;
+// either by the producer thread itself, from append, or by the main thread.
+void Database::produce_more()
+{
+  M_produce_more.mutex.lock();
+  M_may_produce = true;
+  M_produce_more.cond.signal();
+  M_produce_more.mutex.unlock();
+}
+
+// The producer of the buffer, unless gio is used.
+void Database::producer_thread()
+{
+  Debug(debug::init_thread());
+  Dout(dc::notice, "Database::producer_thread started.");
+  if (M_input_fd != -1)
+  {
+    // Opening a stream blocks until the first bytes arrive, so it is done here rather than in the main thread.
+    int fd = M_input_fd;
+    M_input_fd = -1;
+    if (!M_decompressor->open(fd))
+    {
+      Dout(dc::warning, "Failed to read " << get_path() << ". Closing buffer.");
+      M_buffer->close();
+      return;
+    }
+  }
+  for (;;)
+  {
+    uint64_t const wait_start = monotonic_time();
+    M_produce_more.mutex.lock();
+    while (!M_may_produce)
+      M_produce_more.cond.wait(M_produce_more.mutex);
+    M_may_produce = false;
+    M_produce_more.mutex.unlock();
+    uint64_t const read_start = monotonic_time();
+    M_producer_wait_time += read_start - wait_start;
+
+    if (G_UNLIKELY(M_progress.cancelled()))
+    {
+      // Don't read another block; let the read thread finish.
+      Dout(dc::notice, "Loading cancelled after " << M_bytes_read << " bytes. Closing buffer.");
+      M_buffer->close();
+      break;
+    }
+
+    Glib::RefPtr<MemoryBlockNode> new_block;
+    ssize_t n;
+    size_t len = 0;
+    if (M_block_reader)
+    {
+      // The reads of the next blocks are already in flight.
+      n = M_block_reader->read(new_block);
+      if (n > 0)
+	len = n;
+      else if (n == 0 && M_file_follower)
+      {
+	// Everything that the file contained when it was opened was read.
+	// Read what was appended since, and wait for it when there is nothing.
+	size_t const block_size = M_read_options.block_size;
+	new_block = MemoryBlockNode::create(block_size);
+	while ((n = M_file_follower->read(new_block->block_begin(), block_size)) == 0 && M_file_follower->wait(&M_progress.cancel_flag()))
+	  ;
+	if (n > 0)
+	{
+	  len = n;
+	  M_progress.set_file_size(M_file_follower->offset());
+	}
+      }
+    }
+    else
+    {
+      // Fill a whole block; the read thread never processes the last block before the buffer is closed.
+      // Unless the input is a stream: then the read thread may process the last block, and whatever
+      // arrived is appended right away.
+      size_t const block_size = M_read_options.block_size;
+      bool const stream = M_buffer->following();
+      new_block = MemoryBlockNode::create(block_size);
+      n = 1;
+      while (len < block_size && (n = M_decompressor->read(new_block->block_begin() + len, block_size - len)) > 0)
+      {
+	len += n;
+	if (stream)
+	  break;
+      }
+    }
+    M_producer_read_time += monotonic_time() - read_start;
+    if (len > 0)
+    {
+      M_bytes_read += len;
+      M_transcoder.detect(new_block->block_begin(), len);
+      M_progress.read(M_decompressor ? M_decompressor->file_bytes_read() : M_bytes_read, M_bytes_read);
+      M_buffer->append(new_block, len);
+    }
+    if (n <= 0)
+    {
+      if (n == -1)
+	Dout(dc::warning, "Failed to read " << get_path() << " after " << M_bytes_read << " bytes.");
+      Dout(dc::notice, "Read " << M_bytes_read << " bytes. Closing buffer.");
+      M_buffer->close();
+      break;
+    }
+  }
+}
+
+// Called by the read thread, when following a file, before (waiting is true) and after it waits for more data.
+void Database::read_thread_waiting(bool waiting)
+{
+  if (waiting)
+  {
+    // A game is complete once its termination was parsed or, after a parse error, when the next game starts.
+    size_t complete_games = M_tag_store.size() - (M_parsing_game ? 1 : 0);
+    if (complete_games > M_complete_games.load(std::memory_order_relaxed))
+    {
+      M_complete_games.store(complete_games, std::memory_order_release);
+      M_games_added.emit();
+    }
+    M_store_mutex.unlock();
+  }
+  else
+    M_store_mutex.lock();
+}
+
+void Database::games_added()
+{
+  M_slot_games_added(number_of_complete_games());
+}
+
+// Called by the read thread when the first complete_games games in the stores are complete.
+void Database::games_completed(size_t complete_games)
+{
+  if (!M_slot_game_completed.empty())
+    for (; M_reported_games < complete_games; ++M_reported_games)
+      M_slot_game_completed(*this, M_reported_games);
+  else
+    M_reported_games = complete_games;
+  // Only empty the stores between games.
+  if (G_UNLIKELY(!M_keep_games) && complete_games >= S_games_per_batch && complete_games == M_tag_store.size())
+  {
+    M_cleared_games += complete_games;
+    M_tag_store.clear();
+    M_move_store.clear();
+    M_reported_games = 0;
+  }
+}
+
+void DatabaseStream::load()
+{
+  // The decompressor is opened by the producer thread; it reads uncompressed data as it is.
+  M_decompressor = new util::Decompressor;
+  M_decompressor->set_cancel_flag(&M_progress.cancel_flag());
+  M_input_fd = M_fd;
+  start_reading();
+}
+
+void DatabaseSeekable::load()
+{
+  struct stat file_status;
+  if (stat(M_file->get_path().c_str(), &file_status) != 0 || !S_ISREG(file_status.st_mode))
+  {
+    if (M_follow)
+      Dout(dc::warning, "Can't follow " << M_file->get_path() << "; it isn't a regular file.");
+    // Not a regular file; let gio deal with it. Don't sniff the format first,
+    // because the bytes read from a pipe can't be read again.
+    M_file->read_async(sigc::mem_fun(this, &DatabaseSeekable::read_async_open_ready), M_cancellable);
+    return;
+  }
+  M_progress.set_file_size(file_status.st_size);
+  // Compressed databases are decompressed, and uncompressed databases are read with
+  // the BlockReader, by a separate thread that feeds the buffer.
+  M_decompressor = new util::Decompressor;
+  if (!M_decompressor->open(M_file->get_path()) || M_decompressor->format() == util::Decompressor::uncompressed)
+  {
+    delete M_decompressor;
+    M_decompressor = NULL;
+    M_block_reader = new util::BlockReader;
+    if (!M_block_reader->open(M_file->get_path(), M_read_options))
+    {
+      // The file disappeared or can't be read; let gio report it.
+      delete M_block_reader;
+      M_block_reader = NULL;
+      M_file->read_async(sigc::mem_fun(this, &DatabaseSeekable::read_async_open_ready), M_cancellable);
+      return;
+    }
+  }
+  if (M_follow)
+  {
+    if (M_decompressor)
+      Dout(dc::warning, "Can't follow " << M_file->get_path() << "; it is compressed.");
+    else
+    {
+      // Start watching the file now, so that nothing that is appended while reading it is missed.
+      M_file_follower = new util::FileFollower;
+      if (!M_file_follower->open(M_file->get_path(), M_block_reader->file_size()))
+      {
+	delete M_file_follower;
+	M_file_follower = NULL;
+      }
+    }
+  }
+  start_reading();
 }
 
 void DatabaseSeekable::read_async_open_ready(Glib::RefPtr<Gio::AsyncResult>& result)
 {
   M_file_input_stream = M_file->read_finish(result);
-  M_buffer = new MemoryBlockList(sigc::mem_fun(*this, &DatabaseSeekable::need_more_data));
+  M_buffer = new MemoryBlockList(sigc::mem_fun(*this, &DatabaseSeekable::need_more_data), &M_progress.cancel_flag());
   M_read_thread = Glib::Thread::create(sigc::mem_fun(*this, &DatabaseSeekable::read_thread), false);
   M_new_block = MemoryBlockNode::create(S_buffer_size);
   // We're using the glib API for the inner loop in order to avoid unnecessary calls to new/delete.
   GInputStream* stream = M_file_input_stream->InputStream::gobj();
+  M_read_in_flight = true;
   g_input_stream_read_async(stream, M_new_block->block_begin(), S_buffer_size,
       G_PRIORITY_DEFAULT, M_cancellable->gobj(), &DatabaseSeekable::read_async_ready, this);
-  M_processing_finished.connect(sigc::mem_fun(*this, &DatabaseSeekable::processing_finished));
 }
 
 void DatabaseSeekable::need_more_data()
 {
+  if (G_UNLIKELY(M_progress.cancelled()))
+  {
+    Dout(dc::notice, "Loading cancelled after " << M_bytes_read << " bytes. Closing buffer.");
+    M_buffer->close();
+    return;
+  }
   M_new_block = MemoryBlockNode::create(S_buffer_size);
+  M_read_in_flight = true;
   g_input_stream_read_async(M_file_input_stream->InputStream::gobj(), M_new_block->block_begin(), S_buffer_size,
       G_PRIORITY_DEFAULT, M_cancellable->gobj(), &DatabaseSeekable::read_async_ready, this);
 }
@@ -79,11 +334,23 @@ inline void DatabaseSeekable::read_async_ready(GObject* source_object, GAsyncRes
   GInputStream* stream = M_file_input_stream->InputStream::gobj();
   GError* error = NULL;
   gssize len = g_input_stream_read_finish(stream, async_res, &error);
+  M_read_in_flight = false;
+  if (G_UNLIKELY(M_finish_pending))
+  {
+    // Loading was cancelled and the read thread already finished; this read was all we were waiting for.
+    if (error)
+      g_error_free(error);
+    M_buffer->close();
+    processing_finished();
+    return;
+  }
   if (len == -1)
     DoutFatal(dc::core, "read_finish() returned -1");
   if (len > 0)
   {
     M_bytes_read += len;
+    M_transcoder.detect(M_new_block->block_begin(), len);
+    M_progress.read(M_bytes_read, M_bytes_read);
     Dout(dc::notice, "Appending a block with " << len << " bytes to the buffer.");
     // This is the only place where append is called, which is the only
     // function that increments MemoryBlockList::M_blocks.
@@ -106,13 +373,6 @@ void DatabaseSeekable::read_async_ready(GObject* source_object, GAsyncResult* as
   database_seekable->read_async_ready(source_object, async_res);
 }
 
-DatabaseSeekable::~DatabaseSeekable()
-{
-  // Just in case. Normally this should already be freed after loading of the database finished.
-  if (M_buffer)
-    delete M_buffer;
-}
-
 namespace {
 
 timespec& operator-=(timespec& t1, timespec const& t2)
@@ -160,7 +420,7 @@ struct ScannerData {
   ForwardIterator* M_iter;		//!< The current position.
   unsigned int M_line;			//!< The current line number, starts at 1.
   unsigned int M_column;		//!< The current column, starts at 0.
-  unsigned int M_number_of_characters;	//!< The number of characters before the current position.
+  size_t M_number_of_characters;	//!< The number of characters before the current position.
   Color M_to_move;			//!< The color that is too move at this point in the game.
 #if DEBUG_PARSER
   ForwardIterator M_line_start;		//!< Pointer to the start of the current line.
@@ -180,10 +440,104 @@ struct ScannerData {
 class EndOfFileReached : public std::exception {
 };
 
-class ParseError : public std::exception {
+static EndOfFileReached const end_of_file_reached;
+
+//! @brief Storage for the name and value of the tag pair that is being decoded.
+//
+// Names and values that are longer than the buffer are truncated.
+struct TagPairBuffer {
+  static size_t const S_max_name_length = 32;		//!< Names are truncated after this many characters.
+  static size_t const S_max_value_length = 256;		//!< Values are truncated after this many characters.
+
+  char M_name[S_max_name_length];			//!< The tag name.
+  size_t M_name_length;					//!< The number of characters in M_name.
+  char M_value[S_max_value_length];			//!< The tag value, without the quotes.
+  size_t M_value_length;				//!< The number of characters in M_value.
+
+  void clear() { M_name_length = 0; M_value_length = 0; }
+  void append_name(char c) { if (G_LIKELY(M_name_length < S_max_name_length)) M_name[M_name_length++] = c; }
+  void append_value(char c) { if (G_LIKELY(M_value_length < S_max_value_length)) M_value[M_value_length++] = c; }
+  std::string_view name() const { return std::string_view(M_name, M_name_length); }
+  std::string_view value() const { return std::string_view(M_value, M_value_length); }
+  bool value_truncated() const { return M_value_length == S_max_value_length; }
 };
 
-static EndOfFileReached const end_of_file_reached;
+//! @brief Storage for a single movetext token (a move number, SAN move or game termination marker).
+//
+// Tokens that are longer than the buffer are truncated.
+struct MovetextToken {
+  static size_t const S_max_length = 32;		//!< Tokens are truncated after this many characters.
+
+  char M_token[S_max_length];				//!< The token.
+  size_t M_length;					//!< The number of characters in M_token.
+
+  void clear() { M_length = 0; }
+  void append(char c) { if (G_LIKELY(M_length < S_max_length)) M_token[M_length++] = c; }
+  std::string_view str() const { return std::string_view(M_token, M_length); }
+};
+
+//! @brief The per-thread counters of the read thread, that account its run time to the stages of ImportTiming.
+//
+// The time is measured in ticks of the time stamp counter, or in nanoseconds where there is none,
+// and converted to seconds with the real run time of the thread at the end. The time that the
+// thread waited for data is counted by the buffer, in nanoseconds; it is moved from the stage
+// during which it happened to ImportTiming::io_wait.
+class StageCounters {
+  private:
+    MemoryBlockList const* M_buffer;			//!< The buffer that the read thread is parsing.
+    ImportTiming::stage_type M_stage;			//!< The current stage.
+    uint64_t M_start;					//!< The ticks when counting started.
+    uint64_t M_last;					//!< The ticks at the last change of stage.
+    uint64_t M_last_wait_time;				//!< The wait time of the buffer at the last change of stage.
+    uint64_t M_ticks[ImportTiming::number_of_stages];	//!< The ticks spent in each stage.
+    uint64_t M_wait_time[ImportTiming::number_of_stages];	//!< The nanoseconds waited for data in each stage.
+    uint64_t M_moves;					//!< The number of moves that were resolved.
+
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return monotonic_time();
+#endif
+    }
+
+  public:
+    //! Start counting in stage ImportTiming::other.
+    StageCounters(MemoryBlockList const* buffer) : M_buffer(buffer), M_stage(ImportTiming::other), M_start(now()), M_last(M_start),
+        M_last_wait_time(buffer->wait_time_thread_real_ns()), M_ticks{}, M_wait_time{}, M_moves(0) { }
+
+    //! Account the time since the last change of stage to the current stage, and continue with \a stage.
+    void enter(ImportTiming::stage_type stage)
+    {
+      uint64_t const ticks = now();
+      M_ticks[M_stage] += ticks - M_last;
+      M_last = ticks;
+      uint64_t const wait_time = M_buffer->wait_time_thread_real_ns();
+      M_wait_time[M_stage] += wait_time - M_last_wait_time;
+      M_last_wait_time = wait_time;
+      M_stage = stage;
+    }
+
+    //! Count a resolved move.
+    void add_move() { ++M_moves; }
+
+    //! Stop counting and write the stages to \a timing, whose read_thread_real must already be set.
+    void finish(ImportTiming& timing)
+    {
+      enter(M_stage);
+      double const seconds_per_tick = M_last > M_start ? timing.read_thread_real / (M_last - M_start) : 0.0;
+      double io_wait = 0;
+      for (int s = 0; s < ImportTiming::number_of_stages; ++s)
+      {
+	double const wait_time = M_wait_time[s] * 1e-9;
+	timing.stage[s] = std::max(0.0, M_ticks[s] * seconds_per_tick - wait_time);
+	io_wait += wait_time;
+      }
+      timing.stage[ImportTiming::io_wait] = io_wait;
+      timing.moves = M_moves;
+    }
+};
 
 //! @brief A class used to read input from a PGN database.
 template<class ForwardIterator>
@@ -265,7 +619,8 @@ class Scanner {
 #if DEBUG_PARSER
 	print_line();
 #endif
-//	throw end_of_file_reached;
+	// The past-the-end iterator may not be dereferenced.
+	throw end_of_file_reached;
       }
       ++M_current_position.M_column;
       return **M_current_position.M_iter;
@@ -396,13 +751,15 @@ class Scanner {
     // The current position must be a quote character.
     // After this function returns, the current position
     // is the character after the second quote.
-    void decode_string(typename ForwardIterator::value_type& current_character)
+    // The characters in between the quotes are stored in \a tag_pair.
+    void decode_string(typename ForwardIterator::value_type& current_character, TagPairBuffer& tag_pair)
     {
-      do
+      current_character = next_character();
+      while(current_character != '"')
       {
+	tag_pair.append_value(current_character);
 	current_character = next_character();
       }
-      while(current_character != '"');
       // Eat closing quote.
       current_character = next_character();
     }
@@ -413,8 +770,8 @@ class Scanner {
     unsigned int column() const { return M_current_position.M_column + 1; }
     //! @brief Return the total number of characters parsed thus far.
     //
-    // The current character is not counted.
-    unsigned int number_of_characters() const { return M_current_position.M_number_of_characters + M_current_position.M_column; }
+    // The current character is counted.
+    size_t number_of_characters() const { return M_current_position.M_number_of_characters + M_current_position.M_column; }
 
     //! @brief Return who is expected to move at this moment.
     Color to_move() const { return M_current_position.M_to_move; }
@@ -467,23 +824,28 @@ namespace {
 //
 // A tagname must begin with an alpha-numeric character.
 // The rest of the characters are either alpha-numberic or underscores.
+// The name is stored in \a tag_pair.
 //
 // @returns True if a non-empty tagname was found.
-inline bool decode_tagname(char& c, scanner_t& scanner)
+inline bool decode_tagname(char& c, scanner_t& scanner, TagPairBuffer& tag_pair)
 {
   if (G_UNLIKELY(!is_tagname_begin(c)))
     return false;
   while(is_tagname_continuation(c))
+  {
+    tag_pair.append_name(c);
     c = scanner.next_character();
+  }
   return true;
 }
 
 //! @brief Decode a string, if any.
 //
 // This function demands that the string is on one line: EOL characters are not allowed in the string.
+// The value of the string is stored in \a tag_pair.
 //
 // @returns True if a string was found and decoded.
-inline bool correct_string(char& c, scanner_t& scanner)
+inline bool correct_string(char& c, scanner_t& scanner, TagPairBuffer& tag_pair)
 {
   if (c != '"')
     return false;
@@ -491,7 +853,10 @@ inline bool correct_string(char& c, scanner_t& scanner)
   c = scanner.next_character();
   // Find the second quote, but also stop if we run into an EOL.
   while(!is_quote_or_eol(c))
+  {
+    tag_pair.append_value(c);
     c = scanner.next_character();
+  }
   // Note a correct string if we ran into an EOL.
   if (c != '"')
     return false;
@@ -503,19 +868,21 @@ inline bool correct_string(char& c, scanner_t& scanner)
 //! @brief Decode a tag pair.
 //
 // The current position must be on a '['.
+// The name and value are stored in \a tag_pair.
 // @returns True if a correctly formatted tag pair was found and decoded.
-inline bool correct_tag_pair(char& c, scanner_t& scanner)
+inline bool correct_tag_pair(char& c, scanner_t& scanner, TagPairBuffer& tag_pair)
 {
 #if DEBUG_PARSER
   assert(c == '[');
 #endif
+  tag_pair.clear();
   // Skip the '['.
   c = scanner.next_character();
   scanner.eat_white_space(c);
-  if (G_UNLIKELY(!decode_tagname(c, scanner)))
+  if (G_UNLIKELY(!decode_tagname(c, scanner, tag_pair)))
     return false;
   scanner.eat_white_space(c);
-  if (G_UNLIKELY(!correct_string(c, scanner)))
+  if (G_UNLIKELY(!correct_string(c, scanner, tag_pair)))
     return false;
   scanner.eat_white_space(c);
   if (G_UNLIKELY(c != ']'))
@@ -525,15 +892,21 @@ inline bool correct_tag_pair(char& c, scanner_t& scanner)
   return true;
 }
 
-inline bool tag_pair(char& c, scanner_t& scanner)
+//! @brief Decode a tag pair, allowing some common errors.
+//
+// The current position must be on a '['.
+// The name and value are stored in \a tag_pair.
+// @returns True if a tag pair was found and decoded.
+inline bool tag_pair(char& c, scanner_t& scanner, TagPairBuffer& tag_pair)
 {
 #if DEBUG_PARSER
   assert(c == '[');
 #endif
+  tag_pair.clear();
   // Skip the '['.
   c = scanner.next_character();
   scanner.eat_white_space_and_comments(c);
-  if (G_UNLIKELY(!decode_tagname(c, scanner)))
+  if (G_UNLIKELY(!decode_tagname(c, scanner, tag_pair)))
     return false;
   scanner.eat_white_space_and_comments(c);
   if (G_UNLIKELY(is_tag_separator_junk(c)))
@@ -544,7 +917,7 @@ inline bool tag_pair(char& c, scanner_t& scanner)
   }
   if (G_UNLIKELY(c != '"'))
     return false;
-  scanner.decode_string(c);
+  scanner.decode_string(c, tag_pair);
   scanner.eat_white_space_and_comments(c);
   if (G_UNLIKELY(c != ']'))
     return false;
@@ -553,41 +926,140 @@ inline bool tag_pair(char& c, scanner_t& scanner)
   return true;
 }
 
-bool decode_movetext_section_white(char& c, scanner_t& scanner)
+//! @brief Return true if \a c ends a movetext token.
+inline bool is_token_end(char c)
 {
-  throw ParseError();
+  return is_white_space(c) || is_comment_start(c) || c == '(' || c == ')' || c == '$' || c == '[';
 }
 
-bool decode_movetext_section_black(char& c, scanner_t& scanner)
-{
-  throw ParseError();
-}
-
-bool decode_movetext_section(char& c, scanner_t& scanner)
+//! @brief Skip a Recursive Annotation Variation.
+//
+// The current position must be on a '('.
+// Nested variations and comments are skipped too.
+void skip_variation(char& c, scanner_t& scanner)
 {
-  if (scanner.to_move() == white)
-    return decode_movetext_section_white(c, scanner);
-  else
-    return decode_movetext_section_black(c, scanner);
+  int depth = 0;
+  do
+  {
+    if (is_comment_start(c))
+      scanner.eat_comment(c);
+    else if (is_eol(c))
+      scanner.eat_eol(c);
+    else
+    {
+      if (c == '(')
+	++depth;
+      else if (c == ')')
+	--depth;
+      c = scanner.next_character();
+    }
+  }
+  while (depth > 0);
 }
 
-bool decode_game_termination(char& c, scanner_t& scanner)
+//! @brief Decode the movetext section of a game.
+//
+// The SAN moves of the main line are resolved against \a chess_position,
+// executed and stored in \a move_store. Move number indications, NAGs,
+// comments and variations are skipped. After the first move that cannot
+// be resolved the remaining moves are skipped too.
+//
+// Moves that can't be resolved are added to \a diagnostics. The time is accounted to the stages
+// of \a counters; it returns in the movetext_tokenising stage.
+//
+// @returns True if the section was terminated by a game termination marker, which is eaten.
+bool decode_movetext_section(char& c, scanner_t& scanner, MovetextToken& token, ChessPosition& chess_position, MoveStore& move_store,
+    bool moves_valid, Diagnostics& diagnostics, StageCounters& counters)
 {
-  char d = c;
-  c = scanner.next_character();
-  if (d == '0' && c == '-')
-    return scanner.parse_char(c, '1');
-  else if (d == '1' && c == '/')
-    return scanner.parse_str(c, "2-1/2");
-  return d == '*';
+  counters.enter(ImportTiming::movetext_tokenising);
+  token.clear();
+  for (;;)
+  {
+    scanner.eat_white_space_and_comments(c);
+    if (c == '(')
+    {
+      skip_variation(c, scanner);
+      continue;
+    }
+    if (c == '$')
+    {
+      // Numeric Annotation Glyph.
+      do
+	c = scanner.next_character();
+      while (is_digit(c));
+      continue;
+    }
+    if (c == '*')
+    {
+      c = scanner.next_character();
+      return true;
+    }
+    if (G_UNLIKELY(c == ')'))
+    {
+      // Unbalanced parenthesis.
+      c = scanner.next_character();
+      continue;
+    }
+    if (G_UNLIKELY(c == '['))
+      return false;
+    token.clear();
+    while (!is_token_end(c))
+    {
+      token.append(c);
+      c = scanner.next_character();
+    }
+    std::string_view str(token.str());
+    // Strip the move number indication, if any.
+    size_t pos = 0;
+    while (pos < str.size() && is_digit(str[pos]))
+      ++pos;
+    if (pos > 0)
+    {
+      if (pos < str.size() && str[pos] == '.')
+      {
+	while (pos < str.size() && str[pos] == '.')
+	  ++pos;
+	str.remove_prefix(pos);
+	if (str.empty())
+	  continue;
+      }
+      else if (pos == str.size())
+	continue;		// A move number without dots.
+      else if (str == "1-0" || str == "0-1" || str == "1/2-1/2")
+	return true;
+    }
+    // Skip stand-alone annotations like "!?" or "+-".
+    if (G_UNLIKELY(!is_alnum(str[0])))
+      continue;
+    if (!moves_valid)
+      continue;
+    Move move;
+    counters.enter(ImportTiming::san_resolution);
+    if (G_LIKELY(chess_position.parse_SAN(str, move)))
+    {
+      counters.enter(ImportTiming::execute);
+      chess_position.execute(move);
+      counters.enter(ImportTiming::index_writing);
+      move_store.add(move);
+      counters.add_move();
+      counters.enter(ImportTiming::movetext_tokenising);
+    }
+    else
+    {
+      counters.enter(ImportTiming::movetext_tokenising);
+      Dout(dc::parser, "Cannot resolve move \"" << str << "\" at " << scanner.line() << ':' << scanner.column());
+      diagnostics.add(Diagnostics::illegal_move, scanner.line(), scanner.column() - str.size(), str);
+      moves_valid = false;
+    }
+  }
 }
 
 } // namespace
 
-void DatabaseSeekable::read_thread()
+void Database::read_thread()
 {
   Debug(debug::init_thread());
-  Dout(dc::notice, "DatabaseSeekable::read_thread started.");
+  Dout(dc::notice, "Database::read_thread started.");
 
   timespec start_time_real, end_time_real;
   timespec start_time_process, end_time_process;
@@ -597,14 +1069,25 @@ void DatabaseSeekable::read_thread()
   clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &start_time_process);
   clock_gettime(CLOCK_THREAD_CPUTIME_ID, &start_time_thread);
 
+  // When following, the store mutex is only released while waiting for data.
+  bool const following = M_buffer->following();
+  if (following)
+    M_store_mutex.lock();
+
   scanner_t scanner(M_buffer->begin(), M_buffer->end());
+  bool game_ended = true;			// Cleared while inside a game that had no problems yet.
+  StageCounters counters(M_buffer);		// Where the time goes.
 
   try
   {
     int PGN_game_start;
-    int PGN_movetext_section_start;
 
     bool saw_empty_line = true;			// The start of the file has the same status as empty line.
+    TagPairBuffer tag_pair_buffer;		// The name and value of the last decoded tag pair.
+    std::string game_FEN;			// The value of the FEN tag of the current game, if any.
+    std::string utf8_buffer;			// Storage for a tag value that had to be converted to UTF-8.
+    MovetextToken movetext_token;		// The last decoded movetext token.
+    ChessPosition chess_position;		// The position of the current game while decoding its moves.
 
     // Read first character if any.
     char c = scanner.first_character();
@@ -615,90 +1098,136 @@ void DatabaseSeekable::read_thread()
       // We're going to parse a new game. Start with resetting the game state.
       scanner.reset_game_state();
 
-      try
-      {
-
-	//
-	// Start with eating leading junk.
-	//
+      //
+      // Start with eating leading junk.
+      //
 
-	// Eat leading white spaces.
-	scanner.eat_white_space(c);
+      // Eat leading white spaces.
+      scanner.eat_white_space(c);
 
-	do
+      do
+      {
+	if (c == '[')
 	{
-	  if (c == '[')
+	  PGN_game_start = scanner.push_position();
+	  size_t game_offset = scanner.number_of_characters() - 1;
+
+	  // Demand a syntactically correct tag pair if we saw junk and there is no separating empty line before it.
+	  // Otherwise our less restrictive tag pair parser is used.
+	  counters.enter(ImportTiming::tag_parsing);
+	  if ((saw_empty_line && tag_pair(c, scanner, tag_pair_buffer)) ||
+	      (!saw_empty_line && correct_tag_pair(c, scanner, tag_pair_buffer)))
 	  {
-	    PGN_game_start = scanner.push_position();
-
-	    // Demand a syntactically correct tag pair if we saw junk and there is no separating empty line before it.
-	    // Otherwise our less restrictive tag pair parser is used.
-	    if ((saw_empty_line && tag_pair(c, scanner)) ||
-		(!saw_empty_line && correct_tag_pair(c, scanner)))
-	    {
-	      // Found the start of a PGN game.
-	      Dout(dc::parser, "After first tag pair of PGN game: " << scanner.line() << ':' << scanner.column());
-	      break;
-	    }
-	  }
-	  // Eat this whole line.
-	  scanner.eat_line(c);
-	  // Plus the EOL, and possible following empty lines.
-	  saw_empty_line = scanner.eat_eol(c);
-	}
-	while(1);
-
-	//
-	// We found the beginning of the first PGN file and parsed the first tag pair.
-	// Next, parse all remaining tag pairs.
-	//
-
-	scanner.eat_white_space_and_comments(c);
-	while(c == '[')
-	{
-	  if (G_UNLIKELY(!tag_pair(c, scanner)))
+	    // Found the start of a PGN game.
+	    Dout(dc::parser, "After first tag pair of PGN game: " << scanner.line() << ':' << scanner.column());
+	    // The previous game, if any, is complete now; also after a parse error.
+	    counters.enter(ImportTiming::other);
+	    games_completed(M_tag_store.size());
+	    M_diagnostics.begin_game(game_offset, M_cleared_games + M_tag_store.size());
+	    counters.enter(ImportTiming::index_writing);
+	    M_tag_store.begin_game(game_offset);
+	    M_parsing_game = true;
+	    game_ended = false;
+	    M_progress.parsed(game_offset, M_cleared_games + M_tag_store.size(), M_buffer->wait_time_thread_real_ns());
+	    counters.enter(ImportTiming::tag_parsing);
+	    std::string_view value = M_transcoder.to_utf8(tag_pair_buffer.value(), utf8_buffer, tag_pair_buffer.value_truncated());
+	    counters.enter(ImportTiming::index_writing);
+	    M_tag_store.add_tag(tag_pair_buffer.name(), value);
+	    M_move_store.begin_game();
+	    counters.enter(ImportTiming::tag_parsing);
+	    game_FEN.clear();
+	    if (G_UNLIKELY(tag_pair_buffer.name() == "FEN"))
+	      game_FEN = tag_pair_buffer.value();
 	    break;
-	  scanner.eat_white_space_and_comments(c);
+	  }
+	  counters.enter(ImportTiming::other);
 	}
+	// Eat this whole line.
+	scanner.eat_line(c);
+	// Plus the EOL, and possible following empty lines.
+	saw_empty_line = scanner.eat_eol(c);
+      }
+      while(1);
 
-	// Decode optional movetext section.
-	if (c == '1')
-	{
-	  // Because it is optional, we have to remember the position
-	  // in case it fails. This could be a game termination (1-0 or 1/2-1/2).
-          PGN_movetext_section_start = scanner.push_position();
-	}
-	if (!decode_movetext_section(c, scanner))
-	{
-	  // It failed, so pop the position.
-	  scanner.pop_position(PGN_movetext_section_start);
-	  c = '1';
-	}
+      //
+      // We found the beginning of the first PGN file and parsed the first tag pair.
+      // Next, parse all remaining tag pairs.
+      //
 
-	if (decode_game_termination(c, scanner))
+      scanner.eat_white_space_and_comments(c);
+      while(c == '[')
+      {
+	if (G_UNLIKELY(!tag_pair(c, scanner, tag_pair_buffer)))
 	{
-	  // Eat any possible final comments.
+	  // A malformed tag pair: skip the rest of its line and continue with the next tag pair, if any.
+	  counters.enter(ImportTiming::other);
+	  M_diagnostics.add(Diagnostics::parse_error, scanner.line(), scanner.column(), tag_pair_buffer.name());
+	  M_progress.parse_error();
+	  scanner.eat_line(c);
 	  scanner.eat_white_space_and_comments(c);
-
-	  // Since this was a clean exit, start processing of
-	  // next game as if we just saw an empty line (we probably did anyway).
-	  saw_empty_line = true;
+	  counters.enter(ImportTiming::tag_parsing);
 	  continue;
 	}
+	std::string_view value = M_transcoder.to_utf8(tag_pair_buffer.value(), utf8_buffer, tag_pair_buffer.value_truncated());
+	counters.enter(ImportTiming::index_writing);
+	M_tag_store.add_tag(tag_pair_buffer.name(), value);
+	counters.enter(ImportTiming::tag_parsing);
+	if (G_UNLIKELY(tag_pair_buffer.name() == "FEN"))
+	  game_FEN = tag_pair_buffer.value();
+	scanner.eat_white_space_and_comments(c);
+      }
 
-	// Missing game termination, or parse error...
-	Dout(dc::parser, "Parsing stopped at " << scanner.line() << ':' << scanner.column() << " at \"" << scanner << "\".");
+      // Set up the position that the game starts from.
+      counters.enter(ImportTiming::execute);
+      bool moves_valid = true;
+      if (G_LIKELY(game_FEN.empty()))
+	chess_position.initial_position();
+      else
+      {
+	M_move_store.set_FEN(game_FEN);
+	moves_valid = chess_position.load_FEN(game_FEN);
+	if (G_UNLIKELY(!moves_valid))
+	  M_diagnostics.add(Diagnostics::invalid_FEN, scanner.line(), scanner.column(), game_FEN);
       }
-      catch(ParseError&)
+
+      // Decode the (possibly empty) movetext section and the game termination.
+      bool const terminated = decode_movetext_section(c, scanner, movetext_token, chess_position, M_move_store, moves_valid, M_diagnostics, counters);
+      counters.enter(ImportTiming::other);
+      if (terminated)
       {
-	// Eat the rest until the next start of a PGN game.
+	M_parsing_game = false;
+	game_ended = true;
+	games_completed(M_tag_store.size());
+	// Eat any possible final comments.
+	scanner.eat_white_space_and_comments(c);
+
+	// Since this was a clean exit, start processing of
+	// next game as if we just saw an empty line (we probably did anyway).
+	saw_empty_line = true;
 	continue;
       }
-      break;
+
+      // Missing game termination: the next game starts. The snippet is the last token of this game.
+      Dout(dc::parser, "Parsing stopped at " << scanner.line() << ':' << scanner.column() << " at \"" << scanner << "\".");
+      M_diagnostics.add(Diagnostics::missing_termination, scanner.line(), scanner.column(), movetext_token.str());
+      game_ended = true;
+      M_progress.parse_error();
+      // Eat the rest until the next start of a PGN game.
+      saw_empty_line = false;
     }
   }
   catch(EndOfFileReached&)
   {
+    counters.enter(ImportTiming::other);
+    if (!game_ended)
+      M_diagnostics.add(Diagnostics::truncated_game, scanner.line(), scanner.column());
+  }
+  games_completed(M_tag_store.size());
+
+  if (following)
+  {
+    M_complete_games.store(M_tag_store.size(), std::memory_order_release);
+    M_store_mutex.unlock();
   }
 
   clock_gettime(CLOCK_REALTIME, &end_time_real);
@@ -709,6 +1238,12 @@ void DatabaseSeekable::read_thread()
   end_time_process -= start_time_process;
   end_time_thread -= start_time_thread;
 
+  M_import_timing.read_thread_real = end_time_real.tv_sec + end_time_real.tv_nsec * 1e-9;
+  M_import_timing.read_thread_cpu = end_time_thread.tv_sec + end_time_thread.tv_nsec * 1e-9;
+  M_import_timing.bytes = scanner.number_of_characters();
+  M_import_timing.games = M_cleared_games + M_tag_store.size();
+  counters.finish(M_import_timing);
+
 #if 0
   if (!info.hit)
   {
@@ -720,24 +1255,82 @@ void DatabaseSeekable::read_thread()
 
   std::cout << "Number of characters: " << scanner.number_of_characters() << '\n';
   std::cout << "Number of lines: " << scanner.line() << '\n';
+  std::cout << "Number of games: " << M_cleared_games + M_tag_store.size() << '\n';
+  std::cout << "Number of moves: " << M_move_store.total_number_of_moves() << '\n';
 
   std::cout << "Real time                                 : " << end_time_real << " seconds.\n";
   std::cout << "Process time                              : " << end_time_process << " seconds.\n";
   std::cout << "Run time read_thread                      : " << end_time_thread << " seconds.\n";
+  std::cout << "Wait time read_thread (real)              : " << M_buffer->wait_time_thread_real() << " seconds (" << M_buffer->number_of_waits() << " waits).\n";
+  std::cout << "Buffer full (producer waits)              : " << M_buffer->number_of_full_buffers() << " times.\n";
+  std::cout << "Problems                                  : ";
+  M_diagnostics.print_counts(std::cout);
+  std::cout << ".\n";
+  std::cout << "Encoding                                  : " << util::Transcoder::name(M_transcoder.encoding()) << ".\n";
+  util::MemoryBlockPool::Statistics pool_statistics = util::MemoryBlockPool::instance().statistics();
+  if (M_block_reader)
+    std::cout << "Read with                                 : " << (M_block_reader->uses_io_uring() ? "io_uring" : "pread") <<
+        (M_block_reader->uses_direct_io() ? " and O_DIRECT" : "") << ", blocks of " << M_block_reader->block_size() << " bytes, queue depth " <<
+	M_read_options.queue_depth << ".\n";
+  std::cout << "Memory blocks allocated (recycled)        : " << pool_statistics.allocations << " (" << pool_statistics.recycled << "), peak " <<
+      pool_statistics.peak_blocks_in_use << " in use, " << pool_statistics.arenas << " arenas.\n";
+
+  ImportTiming::stage_type slowest = M_import_timing.slowest_stage();
+  std::cout << "Slowest stage                             : " << ImportTiming::name(slowest) << " (" <<
+      M_import_timing.stage[slowest] << " seconds).\n";
 
   double t = end_time_thread.tv_sec + end_time_thread.tv_nsec * 1e-9;
   std::cout << "Speed: " << (scanner.number_of_characters() / t / 1048576) << " MB/s." << std::endl;
 
+  M_progress.finish(scanner.number_of_characters(), M_cleared_games + M_tag_store.size(), M_buffer->wait_time_thread_real_ns());
   M_processing_finished.emit();
 }
 
-void DatabaseSeekable::processing_finished()
+void Database::processing_finished()
 {
+  if (M_producer_thread)
+  {
+    // The producer thread exits right after closing the buffer. After a cancel it might
+    // be waiting for the read thread to make room in the buffer; wake it up so it sees the cancel.
+    if (G_UNLIKELY(M_progress.cancelled()))
+      produce_more();
+    M_producer_thread->join();
+    M_producer_thread = NULL;
+    M_import_timing.producer_read = M_producer_read_time * 1e-9;
+    M_import_timing.producer_wait = M_producer_wait_time * 1e-9;
+    delete M_decompressor;
+    M_decompressor = NULL;
+    delete M_block_reader;
+    M_block_reader = NULL;
+    delete M_file_follower;
+    M_file_follower = NULL;
+  }
+  else if (!finish_reading())
+    return;
   ASSERT(M_buffer->closed());
   delete M_buffer;
   M_buffer = NULL;
   M_slot_open_finished(M_bytes_read);
 }
 
+// Called when the read thread finished while gio was used to read the file.
+bool DatabaseSeekable::finish_reading()
+{
+  if (G_UNLIKELY(!M_buffer->closed()))
+  {
+    // Loading was cancelled while gio was still reading, or while the buffer was full.
+    ASSERT(M_progress.cancelled());
+    if (M_read_in_flight)
+    {
+      // Finish when the read returns.
+      M_finish_pending = true;
+      M_cancellable->cancel();
+      return false;
+    }
+    M_buffer->close();
+  }
+  return true;
+}
+
 } // namespace pgn
 } // namespace cwchess
@@ -25,6 +25,15 @@
 
 #include "Referenceable.h"
 #include "MemoryBlockList.h"
+#include "Decompressor.h"
+#include "BlockReader.h"
+#include "FileFollower.h"
+#include "Transcoder.h"
+#include "PgnTagStore.h"
+#include "PgnMoveStore.h"
+#include "PgnLoadProgress.h"
+#include "PgnDiagnostics.h"
+#include "PgnImportTiming.h"
 #include <glibmm/refptr.h>
 #include <glibmm/dispatcher.h>
 #include <giomm/file.h>
@@ -35,8 +44,21 @@ namespace pgn {
 
 using util::MemoryBlockList;
 using util::MemoryBlockNode;
+using util::MutexCondPair;
 
 class Database : public util::Referenceable {
+  public:
+    typedef sigc::slot<void, size_t> SlotOpenFinished;
+    typedef sigc::slot<void, size_t> SlotGamesAdded;
+    typedef sigc::slot<void, Database const&, uint32_t> SlotGameCompleted;
+    // This is the minimum blocksize needed to reach a speed of 130 MB/s.
+    // The 64 is to take MemoryBlockNode (32 bytes) and the MemoryBlockPool header (16 bytes) into account,
+    // so that every block occupies exactly six pages of the pool.
+    // That means we're not reading an integral number of disk blocks at a time, but that
+    // turns out to make no difference (on my machine).
+    static size_t const S_buffer_size = 6 * 4096 - 64;
+    //! The number of games after which the stores are cleared, when games aren't kept.
+    static size_t const S_games_per_batch = 1024;
 
   enum state_type {
     white_space,
@@ -55,63 +77,230 @@ class Database : public util::Referenceable {
     static unsigned char* S_state_tables[11];
 
   protected:
+    TagStore M_tag_store;				//!< The tag pairs of all games, filled by the read thread.
+    MoveStore M_move_store;				//!< The main line moves of all games, filled by the read thread.
     MemoryBlockList* M_buffer;				//!< Linked list of blocks with valid data.
     Glib::RefPtr<MemoryBlockNode> M_new_block;		//!< Temporary storage for new block that is being read and not linked yet.
+    LoadProgress M_progress;				//!< The progress of loading, updated by the loading threads.
+    Glib::Mutex M_store_mutex;				//!< Held by the read thread while it adds games to a database that is followed.
+    std::atomic<size_t> M_complete_games;		//!< The number of games that were completely parsed, when following.
+    util::Transcoder M_transcoder;			//!< Detects the encoding of the file; the tag values are stored in UTF-8.
+    Diagnostics M_diagnostics;				//!< The problems that the parser ran into, filled by the read thread.
+    ImportTiming M_import_timing;			//!< Where the time of loading went; filled when loading finished.
+
+  /** @name The pipeline that feeds the read thread */
+  //@{
+    gsize M_bytes_read;					//!< The number of (decompressed) bytes that were appended to the buffer.
+    SlotOpenFinished M_slot_open_finished;		//!< Called in the main thread when loading finished.
+    Glib::Thread* M_read_thread;			//!< The thread that parses the buffer.
+    Glib::Dispatcher M_processing_finished;		//!< Used to signal the main thread that the read thread finished.
+    util::BlockReader::Options M_read_options;		//!< The block size, queue depth and whether or not to use O_DIRECT.
+    util::BlockReader* M_block_reader;			//!< The reader of an uncompressed database, or NULL.
+    util::Decompressor* M_decompressor;			//!< The decompressor of a compressed database or a stream, or NULL.
+    int M_input_fd;					//!< The file descriptor that the producer thread opens M_decompressor with, or -1.
+    Glib::Thread* M_producer_thread;			//!< The thread that runs producer_thread, or NULL.
+    uint64_t M_producer_read_time;			//!< The real time in nanoseconds that the producer thread spent reading. Written by the producer thread.
+    uint64_t M_producer_wait_time;			//!< The real time in nanoseconds that the producer thread waited for room. Written by the producer thread.
+    MutexCondPair M_produce_more;			//!< Used to signal the producer thread that it may append another block.
+    bool M_may_produce;					//!< Set when the producer thread may append another block. Protected by M_produce_more.mutex.
+    util::FileFollower* M_file_follower;		//!< Reads what is appended to a followed file, or NULL.
+    bool M_parsing_game;				//!< Set while the read thread is inside a game. Only accessed by the read thread.
+    Glib::Dispatcher M_games_added;			//!< Used to signal the main thread that games were added to a followed database.
+    SlotGamesAdded M_slot_games_added;			//!< Called in the main thread with the number of complete games when games were added.
+    SlotGameCompleted M_slot_game_completed;		//!< Called in the read thread for every game that was completely parsed.
+    bool M_keep_games;					//!< Cleared when the stores may be emptied every S_games_per_batch games.
+    size_t M_reported_games;				//!< The number of games in the stores that were passed to M_slot_game_completed.
+    size_t M_cleared_games;				//!< The number of games that were removed from the stores.
+  //@}
+
     //! Constructor.
-    Database() : M_saw_carriage_return(false), M_line_wrapped(0),
-        M_number_of_lines(0), M_number_of_characters(0), M_state(white_space),
-        M_buffer(NULL) { }
+    Database(SlotOpenFinished const& slot_open_finished, util::BlockReader::Options const& read_options,
+        SlotGamesAdded const& slot_games_added = SlotGamesAdded(), SlotGameCompleted const& slot_game_completed = SlotGameCompleted(),
+	bool keep_games = true);
+    virtual ~Database();
 
     /** @brief Process next data block.
      *
      * This function is called for all subsequent blocks of data during the initialization of the Database object.
      */
     void process_next_data_block(char const* data, size_t size);
+
+    /** @brief Start the read thread and the producer thread.
+     *
+     * M_block_reader or M_decompressor (possibly with M_input_fd), and optionally M_file_follower, must be set up.
+     */
+    void start_reading();
+
+    /** @brief Called in the main thread after the read thread finished and the producer thread was joined.
+     *
+     * Returns FALSE if the buffer can't be deleted yet; processing_finished must then be called again later.
+     */
+    virtual bool finish_reading() { return true; }
+
+    //! Called in the main thread when the read thread finished.
+    void processing_finished();
+
+    //! The thread that parses the buffer.
+    void read_thread();
+
+  private:
+    void producer_thread();
+    void produce_more();
+    void read_thread_waiting(bool waiting);
+    void games_added();
+    void games_completed(size_t complete_games);
+
   public:
     //! @brief Return the path name of the database.
     virtual std::string get_path() const = 0;
 
     int number_of_lines() const { return M_number_of_lines; }
+    size_t number_of_games() const { return M_tag_store.size(); }
+
+    /** @brief Return the tag pairs of all games.
+     *
+     * The tag store is filled by the read thread; it should
+     * not be accessed before the database finished loading.
+     */
+    TagStore const& tag_store() const { return M_tag_store; }
+
+    /** @brief Return the main line moves of all games.
+     *
+     * The move store is filled by the read thread; it should
+     * not be accessed before the database finished loading.
+     */
+    MoveStore const& move_store() const { return M_move_store; }
     size_t number_of_characters() const { return M_number_of_characters; }
+
+    /** @brief Return the progress of loading the database.
+     *
+     * May be sampled from any thread while the database is loading.
+     * Call progress().cancel() to stop loading; the open-finished slot
+     * is then still called, with the games that were parsed so far.
+     */
+    LoadProgress& progress() { return M_progress; }
+    LoadProgress const& progress() const { return M_progress; }
+
+    /** @brief Return the mutex that protects the tag and move store of a database that is followed.
+     *
+     * While following a growing file, the read thread only releases this
+     * mutex while it waits for more data. Lock it while reading the stores,
+     * and only look at the first number_of_complete_games() games.
+     */
+    Glib::Mutex& store_mutex() { return M_store_mutex; }
+
+    /** @brief Return the problems that the parser ran into.
+     *
+     * Like the tag store, this should not be accessed before the database finished loading.
+     */
+    Diagnostics const& diagnostics() const { return M_diagnostics; }
+
+    /** @brief Return where the time of loading the database went.
+     *
+     * Only valid once the database finished loading, when the open-finished slot is called.
+     */
+    ImportTiming const& import_timing() const { return M_import_timing; }
+
+    //! Return the encoding of the file, as detected while loading it. The tag store is always in UTF-8.
+    util::Transcoder::encoding_type encoding() const { return M_transcoder.encoding(); }
+
+    //! Return the number of games that were completely parsed, of a database that is followed.
+    size_t number_of_complete_games() const { return M_complete_games.load(std::memory_order_acquire); }
 };
 
 class DatabaseSeekable : public Database {
-  public:
-    typedef sigc::slot<void, size_t> SlotOpenFinished;
-    // This is the minimum blocksize needed to reach a speed of 130 MB/s.
-    // The 64 is to take MemoryBlockNode (32 bytes) and a possible malloc overhead into account.
-    // That means we're not reading an integral number of disk blocks at a time, but that
-    // turns out to make no difference (on my machine).
-    static size_t const S_buffer_size = 6 * 4096 - 64;
   private:
     Glib::RefPtr<Gio::File> M_file;
     Glib::RefPtr<Gio::Cancellable> M_cancellable;
-    gsize M_bytes_read;
     Glib::RefPtr<Gio::FileInputStream> M_file_input_stream;
-    SlotOpenFinished M_slot_open_finished;
-    Glib::Thread* M_read_thread;
-    Glib::Dispatcher M_processing_finished;
+    bool M_read_in_flight;			//!< Set while gio is reading a block.
+    bool M_finish_pending;			//!< Set when processing finished, after a cancel, while gio was still reading a block.
+    bool M_follow;				//!< Set when the file should be followed after reaching its end.
   public:
-    static Glib::RefPtr<Database> open(std::string const& path, SlotOpenFinished const& slot)
-        { return Glib::RefPtr<Database>(new DatabaseSeekable(path, slot)); }
+    /** @brief Start loading the database \a path and call \a slot when finished.
+     *
+     * Uncompressed databases are read with \a read_options; compressed databases
+     * are decompressed into blocks of read_options.block_size bytes.
+     */
+    static Glib::RefPtr<Database> open(std::string const& path, SlotOpenFinished const& slot,
+        util::BlockReader::Options const& read_options = util::BlockReader::Options(S_buffer_size))
+        { return Glib::RefPtr<Database>(new DatabaseSeekable(path, slot, read_options, false, SlotGamesAdded())); }
+
+    /** @brief Load the database \a path and keep following it as it grows.
+     *
+     * Like open, but when the end of the file is reached the file is watched for
+     * games that are appended to it, which are parsed as they come in. Each time
+     * the read thread runs out of data and new games were completed, \a slot_games_added
+     * is called in the main thread with number_of_complete_games(). Following stops,
+     * and \a slot_open_finished is called, when loading is cancelled through progress()
+     * or when the file is deleted, renamed or truncated.
+     *
+     * Only uncompressed regular files can be followed; other files are just opened.
+     */
+    static Glib::RefPtr<Database> follow(std::string const& path, SlotOpenFinished const& slot_open_finished, SlotGamesAdded const& slot_games_added,
+        util::BlockReader::Options const& read_options = util::BlockReader::Options(S_buffer_size))
+        { return Glib::RefPtr<Database>(new DatabaseSeekable(path, slot_open_finished, read_options, true, slot_games_added)); }
   protected:
-    DatabaseSeekable(std::string const& path, SlotOpenFinished const& slot_open_finished) :
+    DatabaseSeekable(std::string const& path, SlotOpenFinished const& slot_open_finished, util::BlockReader::Options const& read_options,
+        bool follow, SlotGamesAdded const& slot_games_added) :
+        Database(slot_open_finished, read_options, slot_games_added),
         M_file(Gio::File::create_for_path(path)), M_cancellable(Gio::Cancellable::create()),
-	M_bytes_read(0), M_slot_open_finished(slot_open_finished) { load(); }
-    virtual ~DatabaseSeekable();
+	M_read_in_flight(false), M_finish_pending(false), M_follow(follow) { load(); }
   private:
     void load();
     void read_async_open_ready(Glib::RefPtr<Gio::AsyncResult>& result);
     static void read_async_ready(GObject* source_object, GAsyncResult* async_res, gpointer user_data);
     void read_async_ready(GObject* source_object, GAsyncResult* async_res);
     void need_more_data();
-    void processing_finished();
+    virtual bool finish_reading();
 
     //! @brief Return the path name of the database.
     virtual std::string get_path() const { return M_file->get_path(); }
+};
 
+/** @brief A database that is read from a file descriptor that doesn't need to be seekable.
+ *
+ * Use this for standard input, pipes and sockets, for example to run
+ * <code>producer | tool</code>. Compressed input is detected and decompressed
+ * as usual. The data is parsed while it comes in: the read thread doesn't
+ * wait for a block to fill up, so every game is parsed as soon as it completely
+ * arrived, and only a bounded number of blocks are buffered.
+ *
+ * Usage example:
+ * \code
+ * void game_completed(pgn::Database const& database, uint32_t game_id)
+ * {
+ *   std::cout << database.tag_store().white(game_id) << " - " << database.tag_store().black(game_id) << '\n';
+ * }
+ *
+ * database = pgn::DatabaseStream::open(0, sigc::ptr_fun(&open_finished), sigc::ptr_fun(&game_completed), false);
+ * \endcode
+ */
+class DatabaseStream : public Database {
   private:
-    void read_thread();
+    int M_fd;				//!< The file descriptor that is read from; only used for get_path.
+  public:
+    /** @brief Start reading a database from \a fd and call \a slot_open_finished when the end of the input is reached.
+     *
+     * Takes ownership of \a fd. \a slot_game_completed is called in the read thread for
+     * every game that was completely parsed (or skipped after a parse error), with the
+     * id of the game in the stores. Unless \a keep_games is set, the stores are emptied
+     * every S_games_per_batch games, so that memory use doesn't grow with the size of the input;
+     * the game id passed to \a slot_game_completed is then only valid during the call.
+     * The progress() counts all games.
+     */
+    static Glib::RefPtr<Database> open(int fd, SlotOpenFinished const& slot_open_finished,
+        SlotGameCompleted const& slot_game_completed = SlotGameCompleted(), bool keep_games = true, size_t block_size = S_buffer_size)
+        { return Glib::RefPtr<Database>(new DatabaseStream(fd, slot_open_finished, slot_game_completed, keep_games, block_size)); }
+  protected:
+    DatabaseStream(int fd, SlotOpenFinished const& slot_open_finished, SlotGameCompleted const& slot_game_completed, bool keep_games, size_t block_size) :
+        Database(slot_open_finished, util::BlockReader::Options(block_size), SlotGamesAdded(), slot_game_completed, keep_games),
+        M_fd(fd) { load(); }
+  private:
+    void load();
+
+    //! @brief Return the path name of the database.
+    virtual std::string get_path() const { return M_fd == 0 ? "<stdin>" : "fd " + std::to_string(M_fd); }
 };
 
 } // namespace pgn
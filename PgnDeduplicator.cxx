@@ -0,0 +1,424 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnDeduplicator.cxx This file contains the implementation of class pgn::Deduplicator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDeduplicator.h"
+#include "debug.h"
+#include <algorithm>
+#include <thread>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+#include <unistd.h>
+#include <glib.h>
+
+namespace cwchess {
+namespace pgn {
+
+namespace {
+
+// The finalizer of splitmix64.
+inline uint64_t mix(uint64_t x)
+{
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+// Two independent 64-bit hashes of a sequence of 64-bit words.
+class Hasher {
+  private:
+    uint64_t M_high;
+    uint64_t M_low;
+    uint64_t M_words;
+
+  public:
+    Hasher() : M_high(0x6a09e667f3bcc908ULL), M_low(0xbb67ae8584caa73bULL), M_words(0) { }
+
+    void add(uint64_t word)
+    {
+      M_high = mix(M_high ^ word);
+      M_low = mix((M_low << 23 | M_low >> 41) + word * 0x9e3779b97f4a7c15ULL);
+      ++M_words;
+    }
+
+    // Strings are added with their length, so that consecutive strings can't be confused.
+    void add(std::string_view str)
+    {
+      add(str.size());
+      size_t i = 0;
+      for (; i + 8 <= str.size(); i += 8)
+      {
+        uint64_t word;
+        std::memcpy(&word, str.data() + i, 8);
+	add(word);
+      }
+      if (i < str.size())
+      {
+        uint64_t word = 0;
+        std::memcpy(&word, str.data() + i, str.size() - i);
+	add(word);
+      }
+    }
+
+    Deduplicator::Fingerprint fingerprint() const { return { mix(M_high ^ M_words), mix(M_low + M_words) }; }
+};
+
+// Return the letters and digits of value in lower case, up till the first comma if surname is set.
+// Bytes of multi-byte UTF-8 characters are kept as they are.
+std::string_view normalize(std::string_view value, bool surname, std::string& buffer)
+{
+  buffer.clear();
+  for (char c : value)
+  {
+    unsigned char uc = c;
+    if (uc >= 0x80 || (uc >= '0' && uc <= '9') || (uc >= 'a' && uc <= 'z'))
+      buffer += c;
+    else if (uc >= 'A' && uc <= 'Z')
+      buffer += c - 'A' + 'a';
+    else if (c == ',' && surname)
+      break;
+  }
+  return buffer;
+}
+
+// The spill file, or in-memory range, that an entry belongs to.
+inline size_t partition(Deduplicator::Fingerprint const& fingerprint)
+{
+  return fingerprint.high >> (64 - Deduplicator::S_partition_bits);
+}
+
+size_t const number_of_partitions = size_t(1) << Deduplicator::S_partition_bits;
+
+// Move the entries to their partition, in place (one pass of an American flag sort).
+// Upon return, partition p is [begin[p], begin[p + 1]).
+template<class Entry>
+void partition_entries(std::vector<Entry>& entries, std::vector<size_t>& begin)
+{
+  begin.assign(number_of_partitions + 1, 0);
+  for (Entry const& entry : entries)
+    ++begin[partition(entry.fingerprint) + 1];
+  for (size_t p = 0; p < number_of_partitions; ++p)
+    begin[p + 1] += begin[p];
+  std::vector<size_t> next(begin.begin(), begin.end() - 1);
+  for (size_t p = 0; p < number_of_partitions; ++p)
+    while (next[p] < begin[p + 1])
+    {
+      size_t q = partition(entries[next[p]].fingerprint);
+      if (q == p)
+        ++next[p];
+      else
+        std::swap(entries[next[p]], entries[next[q]++]);
+    }
+}
+
+bool write_all(int fd, char const* buf, size_t size, off_t offset)
+{
+  while (size > 0)
+  {
+    ssize_t len = pwrite(fd, buf, size, offset);
+    if (len == -1 && errno == EINTR)
+      continue;
+    if (len <= 0)
+      return false;
+    buf += len;
+    size -= len;
+    offset += len;
+  }
+  return true;
+}
+
+bool read_all(int fd, char* buf, size_t size, off_t offset)
+{
+  while (size > 0)
+  {
+    ssize_t len = pread(fd, buf, size, offset);
+    if (len == -1 && errno == EINTR)
+      continue;
+    if (len <= 0)
+      return false;
+    buf += len;
+    size -= len;
+    offset += len;
+  }
+  return true;
+}
+
+unsigned int number_of_threads(unsigned int number_of_threads)
+{
+  return number_of_threads ? number_of_threads : std::max(std::thread::hardware_concurrency(), 1U);
+}
+
+} // namespace
+
+Deduplicator::Deduplicator(Options const& options) :
+    M_options(options), M_error(false), M_number_of_games(0), M_number_of_duplicates(0), M_number_of_clusters(0)
+{
+}
+
+Deduplicator::~Deduplicator()
+{
+  for (int fd : M_spill_fds)
+    close(fd);
+}
+
+Deduplicator::Fingerprint Deduplicator::fingerprint(TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id, unsigned int key_tags)
+{
+  Hasher hasher;
+  // The moves, four per word.
+  size_t const number_of_moves = move_store.number_of_moves(game_id);
+  MoveStore::encoded_move_type const* moves = move_store.moves(game_id);
+  hasher.add(number_of_moves);
+  size_t i = 0;
+  for (; i + 4 <= number_of_moves; i += 4)
+    hasher.add(uint64_t(moves[i]) | uint64_t(moves[i + 1]) << 16 | uint64_t(moves[i + 2]) << 32 | uint64_t(moves[i + 3]) << 48);
+  if (i < number_of_moves)
+  {
+    uint64_t word = 0;
+    for (int shift = 0; i < number_of_moves; ++i, shift += 16)
+      word |= uint64_t(moves[i]) << shift;
+    hasher.add(word);
+  }
+  // The start position, without the move counters.
+  std::string const* FEN = move_store.FEN(game_id);
+  if (G_UNLIKELY(FEN))
+  {
+    std::string_view position(*FEN);
+    size_t end = 0;
+    for (int field = 0; field < 4 && end != std::string_view::npos; ++field)
+      end = position.find(' ', end + (field ? 1 : 0));
+    hasher.add(position.substr(0, end));
+  }
+  if (key_tags)
+  {
+    std::string buffer;
+    hasher.add(key_tags);
+    if ((key_tags & key_players))
+    {
+      hasher.add(normalize(tag_store.white(game_id), true, buffer));
+      hasher.add(normalize(tag_store.black(game_id), true, buffer));
+    }
+    if ((key_tags & key_result))
+      hasher.add(tag_store.result(game_id));
+    if ((key_tags & key_year))
+      hasher.add(tag_store.date(game_id) >> 9);
+    if ((key_tags & key_event))
+      hasher.add(normalize(tag_store.event(game_id), false, buffer));
+  }
+  return hasher.fingerprint();
+}
+
+void Deduplicator::add(uint32_t database, uint32_t game, Fingerprint const& fingerprint)
+{
+  std::lock_guard<std::mutex> lock(M_mutex);
+  M_entries.push_back({ fingerprint, { database, game } });
+  ++M_number_of_games;
+  if (database >= M_database_size.size())
+    M_database_size.resize(database + 1, 0);
+  M_database_size[database] = std::max(M_database_size[database], game + 1);
+  if (G_UNLIKELY(M_entries.size() * sizeof(Entry) >= M_options.memory_budget))
+    spill();
+}
+
+void Deduplicator::add(uint32_t database, uint32_t game, TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id)
+{
+  if (move_store.number_of_moves(game_id) < M_options.min_plies)
+    return;
+  add(database, game, fingerprint(tag_store, move_store, game_id, M_options.key_tags));
+}
+
+void Deduplicator::add_database(uint32_t database, TagStore const& tag_store, MoveStore const& move_store)
+{
+  DoutEntering(dc::notice, "Deduplicator::add_database(" << database << ", tag_store, move_store)");
+  uint32_t const number_of_games = std::min(tag_store.size(), move_store.size());
+  uint32_t const games_per_batch = 1024;
+  std::atomic<uint32_t> next_game(0);
+  // Each thread fingerprints batches of games and adds them all at once, so that the mutex is rarely contended.
+  auto fingerprint_games = [&]()
+  {
+    std::vector<std::pair<uint32_t, Fingerprint>> batch;
+    for (;;)
+    {
+      uint32_t begin = next_game.fetch_add(games_per_batch);
+      if (begin >= number_of_games)
+        break;
+      uint32_t end = std::min(begin + games_per_batch, number_of_games);
+      batch.clear();
+      for (uint32_t game_id = begin; game_id < end; ++game_id)
+        if (move_store.number_of_moves(game_id) >= M_options.min_plies)
+	  batch.emplace_back(game_id, fingerprint(tag_store, move_store, game_id, M_options.key_tags));
+      std::lock_guard<std::mutex> lock(M_mutex);
+      for (auto const& game : batch)
+      {
+        M_entries.push_back({ game.second, { database, game.first } });
+        if (G_UNLIKELY(M_entries.size() * sizeof(Entry) >= M_options.memory_budget))
+	  spill();
+      }
+      M_number_of_games += batch.size();
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int i = number_of_threads(M_options.number_of_threads); i > 0; --i)
+    threads.emplace_back(fingerprint_games);
+  for (std::thread& thread : threads)
+    thread.join();
+  std::lock_guard<std::mutex> lock(M_mutex);
+  if (database >= M_database_size.size())
+    M_database_size.resize(database + 1, 0);
+  M_database_size[database] = std::max(M_database_size[database], number_of_games);
+}
+
+// Append all entries in memory to the spill file of their partition. Called with M_mutex locked.
+bool Deduplicator::spill()
+{
+  if (G_UNLIKELY(M_error))
+    return false;
+  if (M_spill_fds.empty())
+  {
+    Dout(dc::notice, "Deduplicator::spill: spilling fingerprints to " << M_options.spill_directory << '.');
+    M_spilled.assign(number_of_partitions, 0);
+    for (size_t p = 0; p < number_of_partitions; ++p)
+    {
+      std::string filename = M_options.spill_directory + "/cwchess-dedup-XXXXXX";
+      int fd = mkstemp(&filename[0]);
+      if (fd == -1)
+      {
+        Dout(dc::warning, "Deduplicator::spill: can't create a file in " << M_options.spill_directory << ": " << std::strerror(errno));
+	M_error = true;
+	break;
+      }
+      // Only the file descriptor is needed; the file disappears when it is closed.
+      unlink(filename.c_str());
+      M_spill_fds.push_back(fd);
+    }
+  }
+  std::vector<size_t> begin;
+  partition_entries(M_entries, begin);
+  for (size_t p = 0; p < M_spill_fds.size(); ++p)
+  {
+    size_t n = begin[p + 1] - begin[p];
+    if (!write_all(M_spill_fds[p], reinterpret_cast<char const*>(&M_entries[begin[p]]), n * sizeof(Entry), M_spilled[p] * sizeof(Entry)))
+    {
+      Dout(dc::warning, "Deduplicator::spill: write failed: " << std::strerror(errno));
+      M_error = true;
+    }
+    M_spilled[p] += n;
+  }
+  M_entries.clear();
+  return !M_error;
+}
+
+// Sort the entries of one partition and report the clusters in it.
+void Deduplicator::process_partition(Entry* begin, Entry* end, SlotCluster const& slot_cluster)
+{
+  std::sort(begin, end, [](Entry const& e1, Entry const& e2) {
+      if (e1.fingerprint != e2.fingerprint)
+        return e1.fingerprint < e2.fingerprint;
+      return e1.game.database < e2.game.database || (e1.game.database == e2.game.database && e1.game.game < e2.game.game);
+  });
+  std::vector<GameRef> cluster;
+  std::lock_guard<std::mutex> lock(M_mutex);
+  for (Entry* first = begin; first != end;)
+  {
+    Entry* last = first + 1;
+    while (last != end && last->fingerprint == first->fingerprint)
+      ++last;
+    if (G_UNLIKELY(last - first > 1))
+    {
+      cluster.clear();
+      for (Entry* entry = first; entry != last; ++entry)
+        cluster.push_back(entry->game);
+      // The same game added twice isn't a duplicate of itself.
+      cluster.erase(std::unique(cluster.begin(), cluster.end(),
+          [](GameRef const& g1, GameRef const& g2) { return g1.database == g2.database && g1.game == g2.game; }), cluster.end());
+      if (cluster.size() > 1)
+      {
+	++M_number_of_clusters;
+	M_number_of_duplicates += cluster.size() - 1;
+	for (auto game = cluster.begin() + 1; game != cluster.end(); ++game)
+	  M_duplicate[game->database][game->game / 64] |= uint64_t(1) << (game->game % 64);
+	if (!slot_cluster.empty())
+	  slot_cluster(cluster.data(), cluster.size());
+      }
+    }
+    first = last;
+  }
+}
+
+// The main function of each thread in finish.
+void Deduplicator::process_partitions(std::vector<size_t> const* partition_begin, std::atomic<unsigned int>* next_partition, SlotCluster const* slot_cluster)
+{
+  std::vector<Entry> entries;
+  size_t p;
+  while ((p = next_partition->fetch_add(1)) < number_of_partitions)
+  {
+    if (partition_begin)
+    {
+      // Everything is in memory.
+      process_partition(M_entries.data() + (*partition_begin)[p], M_entries.data() + (*partition_begin)[p + 1], *slot_cluster);
+      continue;
+    }
+    entries.resize(M_spilled[p]);
+    if (!read_all(M_spill_fds[p], reinterpret_cast<char*>(entries.data()), entries.size() * sizeof(Entry), 0))
+    {
+      Dout(dc::warning, "Deduplicator::process_partitions: read failed: " << std::strerror(errno));
+      std::lock_guard<std::mutex> lock(M_mutex);
+      M_error = true;
+      continue;
+    }
+    process_partition(entries.data(), entries.data() + entries.size(), *slot_cluster);
+  }
+}
+
+bool Deduplicator::finish(SlotCluster const& slot_cluster)
+{
+  DoutEntering(dc::notice, "Deduplicator::finish()");
+  M_duplicate.resize(M_database_size.size());
+  for (size_t database = 0; database < M_database_size.size(); ++database)
+    M_duplicate[database].assign((M_database_size[database] + 63) / 64, 0);
+  // Games with the same fingerprint are in the same partition, so the partitions can be processed independently.
+  std::vector<size_t> partition_begin;
+  if (M_spill_fds.empty())
+    partition_entries(M_entries, partition_begin);
+  else
+  {
+    spill();
+    std::vector<Entry>().swap(M_entries);
+  }
+  if (M_error)
+    return false;
+  std::atomic<unsigned int> next_partition(0);
+  std::vector<std::thread> threads;
+  for (unsigned int i = number_of_threads(M_options.number_of_threads); i > 0; --i)
+    threads.emplace_back(&Deduplicator::process_partitions, this, M_spill_fds.empty() ? &partition_begin : NULL, &next_partition, &slot_cluster);
+  for (std::thread& thread : threads)
+    thread.join();
+  Dout(dc::notice, "Found " << M_number_of_duplicates << " duplicates in " << M_number_of_clusters << " clusters of " << M_number_of_games << " games.");
+  return !M_error;
+}
+
+} // namespace pgn
+} // namespace cwchess
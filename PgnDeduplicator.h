@@ -0,0 +1,200 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnDeduplicator.h This file contains the declaration of class pgn::Deduplicator.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnTagStore.h"
+#include "PgnMoveStore.h"
+#include <sigc++/sigc++.h>
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief Finds games that occur more than once, in one or more databases.
+ *
+ * Every game is reduced to a 128-bit fingerprint of its main line moves,
+ * as stored in a MoveStore, and of the position that it starts from.
+ * Because the moves are stored as from, to and promotion type, the
+ * fingerprint doesn't depend on how the moves were written. Optionally
+ * some tags are included too (see key_tag_type), after normalizing them
+ * so that differences in spelling that are common in merged archives
+ * (case, initials, punctuation) don't matter.
+ *
+ * Games are identified by a GameRef: the number of the database, chosen by the caller,
+ * and the number of the game in that database. Fingerprints may be added from several
+ * threads at the same time, for example from the read threads of several databases
+ * that are loaded with DatabaseStream. Once the fingerprints take more than
+ * Options::memory_budget bytes, they are moved to spill files, one per range of
+ * fingerprints, so that the number of games isn't limited by the amount of RAM.
+ *
+ * finish then sorts each range by fingerprint, in parallel, after which games with
+ * the same fingerprint form a cluster. The first game of every cluster (the game with the
+ * lowest database number, and then the lowest game number) is kept; the others are duplicates.
+ *
+ * Usage example:
+ * \code
+ * pgn::Deduplicator deduplicator;
+ * deduplicator.add_database(0, database0->tag_store(), database0->move_store());
+ * deduplicator.add_database(1, database1->tag_store(), database1->move_store());
+ * deduplicator.finish();
+ * for (uint32_t game_id = 0; game_id < database1->number_of_games(); ++game_id)
+ *   if (!deduplicator.is_duplicate(1, game_id))
+ *     writer.game(database1->tag_store(), database1->move_store(), game_id);
+ * \endcode
+ */
+class Deduplicator {
+  public:
+    //! The fingerprint of a game.
+    struct Fingerprint {
+      uint64_t high;
+      uint64_t low;
+
+      friend bool operator==(Fingerprint const& f1, Fingerprint const& f2) { return f1.high == f2.high && f1.low == f2.low; }
+      friend bool operator!=(Fingerprint const& f1, Fingerprint const& f2) { return !(f1 == f2); }
+      friend bool operator<(Fingerprint const& f1, Fingerprint const& f2) { return f1.high < f2.high || (f1.high == f2.high && f1.low < f2.low); }
+    };
+
+    //! A game in one of the databases.
+    struct GameRef {
+      uint32_t database;	//!< The number of the database.
+      uint32_t game;		//!< The number of the game in the database.
+    };
+
+    //! The tags that can be included in the fingerprint.
+    enum key_tag_type {
+      key_players = 1,		//!< The surnames of the players: the White and Black tags up till the first comma, letters and digits only.
+      key_result = 2,		//!< The Result tag.
+      key_year = 4,		//!< The year of the Date tag.
+      key_event = 8		//!< The Event tag, letters and digits only.
+    };
+
+    //! Deduplication parameters.
+    struct Options {
+      unsigned int key_tags;		//!< The tags that must match too; a bitwise OR of key_tag_type values.
+      unsigned int min_plies;		//!< Games with fewer half moves are never duplicates, because unrelated games often share a short line.
+      size_t memory_budget;		//!< The number of bytes of fingerprints that are kept in memory before they are spilled to disk.
+      std::string spill_directory;	//!< The directory in which the spill files are created.
+      unsigned int number_of_threads;	//!< The number of threads used by add_database and finish; 0 means one per core.
+
+      Options() : key_tags(0), min_plies(20), memory_budget(size_t(1) << 30), spill_directory("/tmp"), number_of_threads(0) { }
+    };
+
+    //! Called by finish for every cluster of duplicates. The first game is the one that is kept.
+    typedef sigc::slot<void, GameRef const*, size_t> SlotCluster;
+
+    static unsigned int const S_partition_bits = 8;	//!< The number of most significant fingerprint bits that select the spill file.
+
+  private:
+    struct Entry {
+      Fingerprint fingerprint;
+      GameRef game;
+    };
+
+    Options M_options;
+    std::mutex M_mutex;				//!< Protects all members while adding.
+    std::vector<Entry> M_entries;		//!< The entries that weren't spilled (yet).
+    std::vector<int> M_spill_fds;		//!< The spill file of each partition, or empty if nothing was spilled.
+    std::vector<uint64_t> M_spilled;		//!< The number of entries in each spill file.
+    bool M_error;				//!< Set when a spill file could not be created or written.
+    uint64_t M_number_of_games;			//!< The number of games that were added.
+    std::vector<uint32_t> M_database_size;	//!< One more than the largest game number that was added, per database.
+    std::vector<std::vector<uint64_t>> M_duplicate;	//!< A bit per game of each database, set for duplicates by finish.
+    uint64_t M_number_of_duplicates;		//!< The number of games that are a duplicate of another game.
+    uint64_t M_number_of_clusters;		//!< The number of fingerprints that occur more than once.
+
+  public:
+    //! Construct an empty deduplicator.
+    Deduplicator(Options const& options = Options());
+    ~Deduplicator();
+
+    Deduplicator(Deduplicator const&) = delete;
+    Deduplicator& operator=(Deduplicator const&) = delete;
+
+    //! Return the fingerprint of game \a game_id, including the tags in \a key_tags.
+    static Fingerprint fingerprint(TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id, unsigned int key_tags);
+
+  /** @name Adding games */
+  //@{
+
+    //! Add the game \a game of database \a database with fingerprint \a fingerprint. Thread-safe.
+    void add(uint32_t database, uint32_t game, Fingerprint const& fingerprint);
+
+    /** @brief Add game \a game_id of \a tag_store and \a move_store as game \a game of database \a database. Thread-safe.
+     *
+     * Games with fewer than Options::min_plies half moves are skipped.
+     */
+    void add(uint32_t database, uint32_t game, TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id);
+
+    //! Add all games of \a tag_store and \a move_store as database \a database, using Options::number_of_threads threads. The game numbers are the game ids.
+    void add_database(uint32_t database, TagStore const& tag_store, MoveStore const& move_store);
+
+  //@}
+
+    /** @brief Find the clusters of games with the same fingerprint.
+     *
+     * Call this once, after all games were added. \a slot_cluster is called for every cluster,
+     * from one thread at a time; the games of a cluster are in order of database and game number.
+     *
+     * @returns FALSE if a spill file could not be written or read.
+     */
+    bool finish(SlotCluster const& slot_cluster = SlotCluster());
+
+  /** @name Results */
+  //@{
+
+    //! Return TRUE if game \a game of database \a database is a duplicate of a game that is kept.
+    bool is_duplicate(uint32_t database, uint32_t game) const
+    {
+      if (database >= M_duplicate.size() || game / 64 >= M_duplicate[database].size())
+        return false;
+      return (M_duplicate[database][game / 64] >> (game % 64)) & 1;
+    }
+
+    //! Return the number of games that were added.
+    uint64_t number_of_games() const { return M_number_of_games; }
+
+    //! Return the number of duplicates found by finish.
+    uint64_t number_of_duplicates() const { return M_number_of_duplicates; }
+
+    //! Return the number of clusters found by finish.
+    uint64_t number_of_clusters() const { return M_number_of_clusters; }
+
+    //! Return TRUE if fingerprints were spilled to disk.
+    bool spilled() const { return !M_spill_fds.empty(); }
+
+  //@}
+
+  private:
+    bool spill();
+    void process_partition(Entry* begin, Entry* end, SlotCluster const& slot_cluster);
+    void process_partitions(std::vector<size_t> const* partition_begin, std::atomic<unsigned int>* next_partition, SlotCluster const* slot_cluster);
+};
+
+} // namespace pgn
+} // namespace cwchess
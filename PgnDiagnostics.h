@@ -0,0 +1,214 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnDiagnostics.h This file contains the declaration of class pgn::Diagnostics.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief A bounded log of the problems that the parser ran into while loading a Database.
+ *
+ * Every problem is counted, but only the first capacity() are stored, each with
+ * the game it belongs to, where it was found and a short snippet of the offending text.
+ * Nothing is done for games without problems, apart from remembering where the
+ * current game started; so this is always enabled, also in builds without libcwd.
+ *
+ * The log is written by the read thread of the database. Like the TagStore, it
+ * should not be accessed before the database finished loading, or, when the database
+ * is followed, while not holding Database::store_mutex().
+ *
+ * Usage example:
+ * \code
+ * pgn::Diagnostics const& diagnostics(database->diagnostics());
+ * // Print the problems in the second megabyte of the file.
+ * for (auto entry = diagnostics.lower_bound(1048576); entry != diagnostics.lower_bound(2097152); ++entry)
+ *   std::cout << *entry << '\n';
+ * \endcode
+ */
+class Diagnostics {
+  public:
+    //! The kinds of problems.
+    enum kind_type {
+      missing_termination,	//!< The next game started before the game termination marker.
+      truncated_game,		//!< The input ended inside a game.
+      illegal_move,		//!< A move could not be resolved; the rest of the main line was skipped.
+      invalid_FEN,		//!< The FEN tag could not be loaded; the moves of the game were skipped.
+      parse_error,		//!< A malformed tag pair; the rest of its line was skipped.
+      number_of_kinds
+    };
+
+    static constexpr size_t S_max_snippet_length = 47;	//!< Snippets are truncated after this many characters.
+    static size_t const S_default_capacity = 1024;	//!< The default number of problems that are stored.
+
+    //! A stored problem.
+    struct Entry {
+      uint64_t offset;				//!< The offset of the first character of the game in the (uncompressed) input.
+      uint32_t game;				//!< The number of the game in the input, counting from zero.
+      uint32_t line;				//!< The line of the problem, counting from one.
+      uint32_t column;				//!< The column of the problem, counting from one.
+      kind_type kind;				//!< The kind of problem.
+      uint8_t snippet_length;			//!< The number of characters in snippet_data.
+      char snippet_data[S_max_snippet_length];	//!< The offending text, if any.
+
+      //! Return the offending text, if any.
+      std::string_view snippet() const { return std::string_view(snippet_data, snippet_length); }
+
+      friend std::ostream& operator<<(std::ostream& os, Entry const& entry)
+      {
+	os << "game " << entry.game << " at offset " << entry.offset << ", line " << entry.line << ':' << entry.column << ": " << name(entry.kind);
+	if (entry.snippet_length)
+	  os << " \"" << entry.snippet() << '"';
+	return os;
+      }
+    };
+
+    typedef std::vector<Entry>::const_iterator const_iterator;
+
+  private:
+    std::vector<Entry> M_entries;		//!< The first M_capacity problems.
+    size_t M_capacity;				//!< The maximum number of problems that are stored.
+    uint64_t M_count[number_of_kinds];		//!< The number of problems of each kind.
+    uint64_t M_game_offset;			//!< The offset of the current game.
+    uint32_t M_game;				//!< The number of the current game.
+
+  public:
+    //! Construct an empty log that stores up to \a capacity problems.
+    Diagnostics(size_t capacity = S_default_capacity) : M_capacity(capacity), M_count(), M_game_offset(0), M_game(0) { }
+
+    Diagnostics(Diagnostics const&) = delete;
+    Diagnostics& operator=(Diagnostics const&) = delete;
+
+  /** @name Building */
+  //@{
+
+    //! Called by the parser at the start of game number \a game, at offset \a offset.
+    void begin_game(uint64_t offset, uint32_t game) { M_game_offset = offset; M_game = game; }
+
+    //! Record a problem of kind \a kind in the current game.
+    void add(kind_type kind, uint32_t line, uint32_t column, std::string_view snippet = std::string_view())
+    {
+      ++M_count[kind];
+      if (M_entries.size() >= M_capacity)
+	return;
+      Entry entry;
+      entry.offset = M_game_offset;
+      entry.game = M_game;
+      entry.line = line;
+      entry.column = column;
+      entry.kind = kind;
+      entry.snippet_length = std::min(snippet.size(), S_max_snippet_length);
+      std::memcpy(entry.snippet_data, snippet.data(), entry.snippet_length);
+      M_entries.push_back(entry);
+    }
+
+    //! Set the maximum number of problems that are stored. Doesn't remove problems that are already stored.
+    void set_capacity(size_t capacity) { M_capacity = capacity; }
+
+    //! Remove all problems and reset the counts.
+    void clear() { M_entries.clear(); std::fill(M_count, M_count + number_of_kinds, 0); }
+
+  //@}
+
+  /** @name Queries */
+  //@{
+
+    //! Return the number of stored problems.
+    size_t size() const { return M_entries.size(); }
+
+    //! Return TRUE if no problems were found.
+    bool empty() const { return total() == 0; }
+
+    //! Return the maximum number of problems that are stored.
+    size_t capacity() const { return M_capacity; }
+
+    const_iterator begin() const { return M_entries.begin(); }
+    const_iterator end() const { return M_entries.end(); }
+    Entry const& operator[](size_t i) const { return M_entries[i]; }
+
+    //! Return the number of problems of kind \a kind, including those that were not stored.
+    uint64_t count(kind_type kind) const { return M_count[kind]; }
+
+    //! Return the total number of problems, including those that were not stored.
+    uint64_t total() const
+    {
+      uint64_t sum = 0;
+      for (int kind = 0; kind < number_of_kinds; ++kind)
+	sum += M_count[kind];
+      return sum;
+    }
+
+    //! Return the number of problems that were not stored because the log was full.
+    uint64_t dropped() const { return total() - M_entries.size(); }
+
+    //! Return the first stored problem in a game at or after offset \a offset. The problems are stored in order of offset.
+    const_iterator lower_bound(uint64_t offset) const
+    {
+      return std::lower_bound(M_entries.begin(), M_entries.end(), offset, [](Entry const& entry, uint64_t offset) { return entry.offset < offset; });
+    }
+
+    //! Return the name of \a kind.
+    static char const* name(kind_type kind)
+    {
+      switch (kind)
+      {
+	case missing_termination:
+	  return "missing game termination";
+	case truncated_game:
+	  return "truncated game";
+	case illegal_move:
+	  return "illegal move";
+	case invalid_FEN:
+	  return "invalid FEN";
+	case parse_error:
+	case number_of_kinds:
+	  break;
+      }
+      return "parse error";
+    }
+
+    //! Write the number of problems of each kind to \a os, on one line.
+    void print_counts(std::ostream& os) const
+    {
+      bool first = true;
+      for (int kind = 0; kind < number_of_kinds; ++kind)
+	if (M_count[kind])
+	{
+	  os << (first ? "" : ", ") << M_count[kind] << ' ' << name(static_cast<kind_type>(kind));
+	  first = false;
+	}
+      if (first)
+	os << "none";
+    }
+
+  //@}
+};
+
+} // namespace pgn
+} // namespace cwchess
@@ -0,0 +1,457 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnGameArchive.cxx This file contains the implementation of class pgn::GameArchive.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnGameArchive.h"
+#include "PgnVarint.h"
+#include "debug.h"
+#include <algorithm>
+#include <atomic>
+#include <fstream>
+#include <memory>
+#include <thread>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib.h>
+
+namespace cwchess {
+namespace pgn {
+
+// The file format is:
+//
+// FileHeader
+// three string pools (players, events, sites): varint number of strings, followed by,
+//   for each string except the first (empty) one, varint length + characters.
+// the blocks, each containing the games [block * games_per_block, (block + 1) * games_per_block).
+// padding to a multiple of eight bytes.
+// the block table: one BlockEntry per block, plus one that marks the end of the last block.
+//
+// Each game in a block is stored as:
+//
+// varint result | (has FEN << 2)
+// varint white, black, event, site, date, eco, white_elo, black_elo
+// if has FEN: varint length + characters.
+// varint number of moves, followed by one byte per move (see GameArchive::encode_move).
+//
+// All integers in FileHeader and BlockEntry are stored in native byte order.
+//
+
+namespace {
+
+char const magic[6] = { 'C', 'W', 'G', 'A', 'R', 'C' };
+uint16_t const version = 1;
+
+struct FileHeader {
+  char magic[6];
+  uint16_t version;
+  uint32_t games_per_block;
+  uint32_t reserved;
+  uint64_t number_of_games;
+  uint64_t number_of_blocks;
+  uint64_t block_table_offset;
+};
+
+// An entry of the block table.
+// A block runs till the start of the next block.
+struct BlockEntry {
+  uint64_t offset;		// The offset of the block from the start of the file.
+  uint64_t number_of_moves;	// The total number of moves in the block.
+};
+
+void put_pool(std::string& buf, StringPool const& pool)
+{
+  put_varint(buf, pool.size());
+  for (uint32_t id = 1; id < pool.size(); ++id)
+  {
+    std::string const& str(pool[id]);
+    put_varint(buf, str.size());
+    buf += str;
+  }
+}
+
+bool get_pool(unsigned char const*& p, unsigned char const* end, StringPool& pool)
+{
+  uint64_t size;
+  if (!get_varint(p, end, size) || size == 0)
+    return false;
+  for (uint32_t id = 1; id < size; ++id)
+  {
+    uint64_t length;
+    if (!get_varint(p, end, length) || length > size_t(end - p))
+      return false;
+    if (pool.intern(std::string_view(reinterpret_cast<char const*>(p), length)) != id)
+      return false;
+    p += length;
+  }
+  return true;
+}
+
+// Return TRUE if the pawn on index can only move to the last rank.
+inline bool is_promoting_pawn(ChessPosition const& chess_position, Index const& index)
+{
+  return chess_position.piece_at(index).type() == pawn && index.row() == (chess_position.to_move() == white ? 6 : 1);
+}
+
+// Encode game game_id and append it to buf. Adds the number of moves written to total_number_of_moves.
+bool encode_game(TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id, ChessPosition& chess_position,
+    std::string& buf, uint64_t& total_number_of_moves)
+{
+  std::string const* FEN = move_store.FEN(game_id);
+  put_varint(buf, tag_store.result(game_id) | (FEN ? 4 : 0));
+  put_varint(buf, tag_store.white_id(game_id));
+  put_varint(buf, tag_store.black_id(game_id));
+  put_varint(buf, tag_store.event_id(game_id));
+  put_varint(buf, tag_store.site_id(game_id));
+  put_varint(buf, tag_store.date(game_id));
+  put_varint(buf, tag_store.eco(game_id));
+  put_varint(buf, tag_store.white_elo(game_id));
+  put_varint(buf, tag_store.black_elo(game_id));
+  if (FEN)
+  {
+    put_varint(buf, FEN->size());
+    buf += *FEN;
+  }
+  size_t number_of_moves = move_store.number_of_moves(game_id);
+  // The reader stores no moves for games with an invalid FEN.
+  if (!move_store.start_position(game_id, chess_position))
+    number_of_moves = 0;
+  put_varint(buf, number_of_moves);
+  total_number_of_moves += number_of_moves;
+  MoveStore::encoded_move_type const* moves = move_store.moves(game_id);
+  for (size_t ply = 0; ply < number_of_moves; ++ply)
+  {
+    Move move(MoveStore::decode(moves[ply]));
+    int ordinal = GameArchive::encode_move(chess_position, move);
+    if (ordinal < 0)
+    {
+      Dout(dc::warning, "Game " << game_id << ": move " << ply << " is not legal.");
+      return false;
+    }
+    buf += static_cast<char>(ordinal);
+    chess_position.execute(move);
+  }
+  return true;
+}
+
+} // namespace
+
+int GameArchive::encode_move(ChessPosition const& chess_position, Move const& move)
+{
+  int ordinal = 0;
+  for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+  {
+    Index index(piece_iter.index());
+    if (index == move.from())
+    {
+      for (MoveIterator move_iter = chess_position.move_begin(index); move_iter != chess_position.move_end(); ++move_iter, ++ordinal)
+	if (*move_iter == move)
+	  return ordinal;
+      return -1;
+    }
+    int number_of_moves = __builtin_popcountll(chess_position.moves(index)());
+    if (G_UNLIKELY(is_promoting_pawn(chess_position, index)))
+      number_of_moves *= 4;
+    ordinal += number_of_moves;
+  }
+  return -1;
+}
+
+bool GameArchive::decode_move(ChessPosition const& chess_position, unsigned int ordinal, Move& move)
+{
+  for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+  {
+    Index index(piece_iter.index());
+    // Skip pieces with fewer moves than ordinal by counting their moves, without generating them.
+    unsigned int number_of_moves = __builtin_popcountll(chess_position.moves(index)());
+    if (G_UNLIKELY(is_promoting_pawn(chess_position, index)))
+      number_of_moves *= 4;
+    if (ordinal < number_of_moves)
+    {
+      MoveIterator move_iter = chess_position.move_begin(index);
+      while (ordinal--)
+	++move_iter;
+      move = *move_iter;
+      return true;
+    }
+    ordinal -= number_of_moves;
+  }
+  return false;
+}
+
+bool GameArchive::write(TagStore const& tag_store, MoveStore const& move_store, std::string const& filename, unsigned int games_per_block)
+{
+  DoutEntering(dc::notice, "GameArchive::write(tag_store, move_store, \"" << filename << "\", " << games_per_block << ")");
+
+  if (tag_store.size() != move_store.size() || games_per_block == 0)
+    return false;
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file)
+    return false;
+
+  FileHeader header;
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.games_per_block = games_per_block;
+  header.reserved = 0;
+  header.number_of_games = move_store.size();
+  header.number_of_blocks = (header.number_of_games + games_per_block - 1) / games_per_block;
+  header.block_table_offset = 0;	// Filled in below.
+
+  std::string buf;
+  put_pool(buf, tag_store.players());
+  put_pool(buf, tag_store.events());
+  put_pool(buf, tag_store.sites());
+  file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  file.write(buf.data(), buf.size());
+  uint64_t offset = sizeof(header) + buf.size();
+
+  std::vector<BlockEntry> block_table;
+  block_table.reserve(header.number_of_blocks + 1);
+  ChessPosition chess_position;
+  for (uint32_t first_game = 0; first_game < header.number_of_games; first_game += games_per_block)
+  {
+    uint32_t end_game = std::min<uint64_t>(first_game + games_per_block, header.number_of_games);
+    buf.clear();
+    uint64_t number_of_moves = 0;
+    for (uint32_t game_id = first_game; game_id < end_game; ++game_id)
+    {
+      if (!encode_game(tag_store, move_store, game_id, chess_position, buf, number_of_moves))
+      {
+	file.close();
+	std::remove(filename.c_str());
+	return false;
+      }
+    }
+    block_table.push_back({ offset, number_of_moves });
+    file.write(buf.data(), buf.size());
+    offset += buf.size();
+  }
+  block_table.push_back({ offset, 0 });
+
+  static char const padding[8] = { 0, };
+  file.write(padding, -offset & 7);
+  header.block_table_offset = (offset + 7) & ~uint64_t(7);
+  file.write(reinterpret_cast<char const*>(block_table.data()), block_table.size() * sizeof(BlockEntry));
+  file.seekp(0);
+  file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+  if (!file.flush())
+  {
+    file.close();
+    std::remove(filename.c_str());
+    return false;
+  }
+  return true;
+}
+
+bool GameArchive::open(std::string const& filename)
+{
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+  struct stat sb;
+  if (fstat(fd, &sb) == -1 || size_t(sb.st_size) < sizeof(FileHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+  {
+    ::close(fd);
+    return false;
+  }
+  M_fd = fd;
+  M_map = static_cast<unsigned char const*>(map);
+  M_map_size = sb.st_size;
+
+  FileHeader const* header = static_cast<FileHeader const*>(map);
+  unsigned char const* p = M_map + sizeof(FileHeader);
+  unsigned char const* end = M_map + M_map_size;
+  bool valid =
+      std::memcmp(header->magic, magic, sizeof(magic)) == 0 && header->version == version && header->games_per_block > 0 &&
+      header->number_of_blocks == (header->number_of_games + header->games_per_block - 1) / header->games_per_block &&
+      header->block_table_offset % 8 == 0 && header->block_table_offset <= M_map_size &&
+      (header->number_of_blocks + 1) * sizeof(BlockEntry) == M_map_size - header->block_table_offset;
+  if (valid)
+  {
+    end = M_map + header->block_table_offset;
+    valid = get_pool(p, end, M_players) && get_pool(p, end, M_events) && get_pool(p, end, M_sites);
+  }
+  if (valid)
+  {
+    BlockEntry const* blocks = reinterpret_cast<BlockEntry const*>(end);
+    for (size_t block = 0; valid && block <= header->number_of_blocks; ++block)
+    {
+      valid = blocks[block].offset >= size_t(p - M_map) && blocks[block].offset <= header->block_table_offset;
+      p = M_map + blocks[block].offset;
+    }
+  }
+  if (!valid)
+  {
+    close();
+    return false;
+  }
+  // The blocks are normally decoded from front to back.
+  madvise(map, sb.st_size, MADV_SEQUENTIAL);
+  M_number_of_games = header->number_of_games;
+  M_number_of_blocks = header->number_of_blocks;
+  M_blocks = end;
+  return true;
+}
+
+void GameArchive::close()
+{
+  if (M_map)
+  {
+    munmap(const_cast<unsigned char*>(M_map), M_map_size);
+    ::close(M_fd);
+  }
+  M_fd = -1;
+  M_map = NULL;
+  M_map_size = 0;
+  M_number_of_games = 0;
+  M_number_of_blocks = 0;
+  M_blocks = NULL;
+  M_players.clear();
+  M_events.clear();
+  M_sites.clear();
+}
+
+uint32_t GameArchive::first_game(size_t block) const
+{
+  return block * reinterpret_cast<FileHeader const*>(M_map)->games_per_block;
+}
+
+size_t GameArchive::number_of_moves(size_t block) const
+{
+  return static_cast<BlockEntry const*>(M_blocks)[block].number_of_moves;
+}
+
+bool GameArchive::decode_block(size_t block, std::vector<Header>& headers, MoveStore& move_store) const
+{
+  BlockEntry const* blocks = static_cast<BlockEntry const*>(M_blocks);
+  unsigned char const* p = M_map + blocks[block].offset;
+  unsigned char const* end = M_map + blocks[block + 1].offset;
+  uint32_t number_of_games = std::min<size_t>(first_game(block + 1), M_number_of_games) - first_game(block);
+  std::string FEN;
+  ChessPosition chess_position;
+  for (uint32_t game = 0; game < number_of_games; ++game)
+  {
+    uint64_t values[10];
+    for (int i = 0; i < 10; ++i)
+      if (G_UNLIKELY(!get_varint(p, end, values[i])))
+	return false;
+    if (G_UNLIKELY(values[0] > 7 || values[1] >= M_players.size() || values[2] >= M_players.size() ||
+        values[3] >= M_events.size() || values[4] >= M_sites.size()))
+      return false;
+    headers.push_back({ static_cast<uint32_t>(values[1]), static_cast<uint32_t>(values[2]),
+        static_cast<uint32_t>(values[3]), static_cast<uint32_t>(values[4]), static_cast<uint32_t>(values[5]),
+	static_cast<uint16_t>(values[6]), static_cast<uint16_t>(values[7]), static_cast<uint16_t>(values[8]),
+	static_cast<uint8_t>(values[0] & 3) });
+    move_store.begin_game();
+    bool valid_start_position = true;
+    if (G_UNLIKELY(values[0] & 4))
+    {
+      uint64_t length = values[9];
+      if (length > size_t(end - p))
+	return false;
+      FEN.assign(reinterpret_cast<char const*>(p), length);
+      p += length;
+      move_store.set_FEN(FEN);
+      valid_start_position = chess_position.load_FEN(FEN);
+      if (!get_varint(p, end, values[9]))
+	return false;
+    }
+    else
+      chess_position.initial_position();
+    uint64_t number_of_moves = values[9];
+    if (G_UNLIKELY(number_of_moves > size_t(end - p) || (!valid_start_position && number_of_moves > 0)))
+      return false;
+    for (unsigned char const* move_end = p + number_of_moves; p < move_end; ++p)
+    {
+      Move move;
+      if (G_UNLIKELY(!decode_move(chess_position, *p, move)))
+	return false;
+      move_store.add(move);
+      chess_position.execute(move);
+    }
+  }
+  return p == end;
+}
+
+bool GameArchive::decode(std::vector<Header>& headers, MoveStore& move_store, unsigned int number_of_threads) const
+{
+  DoutEntering(dc::notice, "GameArchive::decode(headers, move_store, " << number_of_threads << ")");
+
+  if (number_of_threads == 0)
+    number_of_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  number_of_threads = std::min<size_t>(number_of_threads, std::max<size_t>(M_number_of_blocks, 1));
+
+  // The decoded games of one block.
+  struct BlockResult {
+    std::vector<Header> headers;
+    MoveStore move_store;
+  };
+  std::vector<std::unique_ptr<BlockResult>> results(M_number_of_blocks);
+  std::atomic<size_t> next_block(0);
+  std::atomic<bool> error(false);
+  auto decode_blocks = [&]() {
+    size_t block;
+    while (!error && (block = next_block++) < M_number_of_blocks)
+    {
+      std::unique_ptr<BlockResult> result(new BlockResult);
+      result->move_store.reserve(first_game(1), number_of_moves(block));
+      if (!decode_block(block, result->headers, result->move_store))
+	error = true;
+      results[block] = std::move(result);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned int i = 1; i < number_of_threads; ++i)
+    threads.emplace_back(decode_blocks);
+  decode_blocks();
+  for (std::thread& thread : threads)
+    thread.join();
+  if (error)
+    return false;
+
+  size_t total_number_of_moves = move_store.total_number_of_moves();
+  for (size_t block = 0; block < M_number_of_blocks; ++block)
+    total_number_of_moves += number_of_moves(block);
+  headers.reserve(headers.size() + M_number_of_games);
+  move_store.reserve(move_store.size() + M_number_of_games, total_number_of_moves);
+  for (std::unique_ptr<BlockResult>& result : results)
+  {
+    headers.insert(headers.end(), result->headers.begin(), result->headers.end());
+    move_store.append(result->move_store);
+    result.reset();
+  }
+  return true;
+}
+
+} // namespace pgn
+} // namespace cwchess
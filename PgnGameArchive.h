@@ -0,0 +1,184 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnGameArchive.h This file contains the declaration of class pgn::GameArchive.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnMoveStore.h"
+#include "PgnTagStore.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief A compact binary file with the games of a database.
+ *
+ * Each move is stored in a single byte: its ordinal number in the list of
+ * legal moves, in the order in which PieceIterator and MoveIterator produce them
+ * (see encode_move). There are never more than 218 legal moves, so this always fits.
+ * The tag pairs of the TagStore are stored as variable length integers;
+ * names are stored once, in string pools at the start of the file, and
+ * referred to by their id.
+ *
+ * The games are stored in blocks of a fixed number of games. A block table at the
+ * end of the file lists where each block starts, so that blocks can be decoded
+ * independently, by different threads (see decode).
+ *
+ * Usage example:
+ * \code
+ * pgn::GameArchive::write(database->tag_store(), database->move_store(), "games.cwa");
+ * pgn::GameArchive archive;
+ * std::vector<pgn::GameArchive::Header> headers;
+ * pgn::MoveStore move_store;
+ * if (archive.open("games.cwa") && archive.decode(headers, move_store))
+ *   std::cout << archive.players()[headers[0].white] << '\n';
+ * \endcode
+ */
+class GameArchive {
+  public:
+    //! The tag pairs of a game. Names are ids in the string pools of the archive.
+    struct Header {
+      uint32_t white;			//!< The id of the White player in players().
+      uint32_t black;			//!< The id of the Black player in players().
+      uint32_t event;			//!< The id of the Event in events().
+      uint32_t site;			//!< The id of the Site in sites().
+      uint32_t date;			//!< The date, packed with TagStore::pack_date.
+      uint16_t eco;			//!< The ECO code number, or 0.
+      uint16_t white_elo;		//!< WhiteElo, or 0.
+      uint16_t black_elo;		//!< BlackElo, or 0.
+      uint8_t result;			//!< A TagStore::result_type.
+    };
+
+    static unsigned int const default_games_per_block = 4096;	//!< The default number of games per block.
+
+  private:
+    int M_fd;					//!< The file descriptor of the open archive, or -1.
+    unsigned char const* M_map;			//!< The mapped archive file.
+    size_t M_map_size;				//!< The size of the mapping.
+    size_t M_number_of_games;			//!< The number of games in the archive.
+    size_t M_number_of_blocks;			//!< The number of blocks.
+    void const* M_blocks;			//!< Pointer to the block table in the mapped file.
+    StringPool M_players;			//!< The player names.
+    StringPool M_events;			//!< The event names.
+    StringPool M_sites;				//!< The site names.
+
+  public:
+    //! Construct a closed archive.
+    GameArchive() : M_fd(-1), M_map(NULL), M_map_size(0), M_number_of_games(0), M_number_of_blocks(0), M_blocks(NULL) { }
+    ~GameArchive() { close(); }
+
+    GameArchive(GameArchive const&) = delete;
+    GameArchive& operator=(GameArchive const&) = delete;
+
+    /** @brief Write an archive with the games of \a tag_store and \a move_store to \a filename.
+     *
+     * The two stores must have the same number of games.
+     *
+     * @returns TRUE on success.
+     */
+    static bool write(TagStore const& tag_store, MoveStore const& move_store, std::string const& filename,
+        unsigned int games_per_block = default_games_per_block);
+
+    /** @brief Memory map the archive \a filename and read its string pools.
+     *
+     * @returns FALSE if the file could not be opened or is not an archive.
+     */
+    bool open(std::string const& filename);
+
+    //! Unmap the archive, if any.
+    void close();
+
+    //! Return TRUE if an archive is open.
+    bool is_open() const { return M_map != NULL; }
+
+  /** @name Accessors */
+  //@{
+
+    //! Return the number of games in the archive.
+    size_t number_of_games() const { return M_number_of_games; }
+
+    //! Return the number of blocks in the archive.
+    size_t number_of_blocks() const { return M_number_of_blocks; }
+
+    //! Return the game id of the first game in block \a block.
+    uint32_t first_game(size_t block) const;
+
+    //! Return the total number of moves of the games in block \a block.
+    size_t number_of_moves(size_t block) const;
+
+    //! Return the pool of player names.
+    StringPool const& players() const { return M_players; }
+    //! Return the pool of event names.
+    StringPool const& events() const { return M_events; }
+    //! Return the pool of site names.
+    StringPool const& sites() const { return M_sites; }
+
+  //@}
+
+  /** @name Decoding */
+  //@{
+
+    /** @brief Decode the games of block \a block.
+     *
+     * For every game in the block one Header is appended to \a headers,
+     * and a game is added to \a move_store.
+     *
+     * @returns FALSE if the block is corrupt.
+     */
+    bool decode_block(size_t block, std::vector<Header>& headers, MoveStore& move_store) const;
+
+    /** @brief Decode all games, using \a number_of_threads threads.
+     *
+     * A value of 0 for \a number_of_threads means one thread per core.
+     * The games are appended to \a headers and \a move_store in order.
+     *
+     * @returns FALSE if the archive is corrupt.
+     */
+    bool decode(std::vector<Header>& headers, MoveStore& move_store, unsigned int number_of_threads = 0) const;
+
+  //@}
+
+  /** @name Move encoding */
+  //@{
+
+    /** @brief Return the ordinal number of the legal move \a move in \a chess_position.
+     *
+     * This is the number of legal moves that MoveIterator visits before \a move,
+     * iterating over the pieces of the side to move with PieceIterator.
+     * Returns -1 if \a move isn't a legal move.
+     */
+    static int encode_move(ChessPosition const& chess_position, Move const& move);
+
+    /** @brief Find the legal move with ordinal number \a ordinal in \a chess_position.
+     *
+     * @returns FALSE if there are fewer legal moves.
+     */
+    static bool decode_move(ChessPosition const& chess_position, unsigned int ordinal, Move& move);
+
+  //@}
+};
+
+} // namespace pgn
+} // namespace cwchess
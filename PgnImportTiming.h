@@ -0,0 +1,139 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnImportTiming.h This file contains the declaration of struct pgn::ImportTiming.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief Where the time of loading a Database went.
+ *
+ * The read thread, which parses the games, accounts every moment of its run time
+ * to one of the stages below; the stages therefore add up to read_thread_real.
+ * The producer thread, which reads (and decompresses) the file, has its own
+ * counters; when both threads keep up with each other the import is bound by
+ * the read thread stage that takes the most time, otherwise by the producer,
+ * which shows as io_wait.
+ *
+ * The stages are measured with the time stamp counter where available, at
+ * every change of stage; this costs in the order of ten nanoseconds per change,
+ * or a few percent of the total for games without comments.
+ *
+ * All times are in seconds.
+ */
+struct ImportTiming {
+  //! The stages of the read thread.
+  enum stage_type {
+    io_wait,			//!< Waiting for the producer thread to append a block.
+    tag_parsing,		//!< Decoding the tag pairs, including the conversion to UTF-8.
+    movetext_tokenising,	//!< Splitting the movetext into tokens; skipping comments, variations and NAGs.
+    san_resolution,		//!< ChessPosition::parse_SAN.
+    execute,			//!< ChessPosition::execute, and setting up the start position of each game.
+    index_writing,		//!< Adding games, tags and moves to the tag and move store.
+    other,			//!< Everything else: searching for the start of games, skipping junk and the per-game callbacks.
+    number_of_stages
+  };
+
+  double stage[number_of_stages];	//!< The real time of the read thread in each stage.
+  double read_thread_real;		//!< The real time that the read thread ran.
+  double read_thread_cpu;		//!< The CPU time of the read thread.
+  double producer_read;			//!< The real time that the producer thread spent reading and decompressing.
+  double producer_wait;			//!< The real time that the producer thread waited for room in the buffer.
+  uint64_t bytes;			//!< The number of (decompressed) bytes that were parsed.
+  uint64_t games;			//!< The number of games.
+  uint64_t moves;			//!< The number of moves that were resolved.
+
+  //! Construct timings of nothing.
+  ImportTiming() : stage{}, read_thread_real(0), read_thread_cpu(0), producer_read(0), producer_wait(0), bytes(0), games(0), moves(0) { }
+
+  //! Return the stage of the read thread that took the most time.
+  stage_type slowest_stage() const
+  {
+    int slowest = 0;
+    for (int s = 1; s < number_of_stages; ++s)
+      if (stage[s] > stage[slowest])
+        slowest = s;
+    return static_cast<stage_type>(slowest);
+  }
+
+  //! Return the name of \a stage_index, as used in the JSON output.
+  static char const* name(stage_type stage_index)
+  {
+    switch (stage_index)
+    {
+      case io_wait:
+        return "io_wait";
+      case tag_parsing:
+        return "tag_parsing";
+      case movetext_tokenising:
+        return "movetext_tokenising";
+      case san_resolution:
+        return "san_resolution";
+      case execute:
+        return "execute";
+      case index_writing:
+        return "index_writing";
+      case other:
+        return "other";
+      case number_of_stages:
+        break;
+    }
+    return "unknown";
+  }
+
+  //! Write a table with the time and share of every stage to \a os.
+  void print_on(std::ostream& os) const
+  {
+    std::ios_base::fmtflags const flags = os.flags();
+    os << std::fixed;
+    for (int s = 0; s < number_of_stages; ++s)
+      os << std::left << std::setw(42) << name(static_cast<stage_type>(s)) << ": " << std::right << std::setprecision(3) << std::setw(8) << stage[s] <<
+          " seconds (" << std::setprecision(1) << std::setw(5) << (read_thread_real > 0 ? 100 * stage[s] / read_thread_real : 0.0) << "%).\n";
+    os << std::left << std::setw(42) << "Slowest stage" << ": " << name(slowest_stage()) << ".\n";
+    os << std::left << std::setw(42) << "Producer reading (waiting)" << ": " << std::setprecision(3) << producer_read <<
+        " (" << producer_wait << ") seconds.\n";
+    os.flags(flags);
+  }
+
+  //! Write the timings as a JSON object to \a os.
+  void write_json(std::ostream& os) const
+  {
+    std::streamsize const precision = os.precision(6);
+    os << "{ \"bytes\": " << bytes << ", \"games\": " << games << ", \"moves\": " << moves <<
+        ", \"read_thread_real\": " << read_thread_real << ", \"read_thread_cpu\": " << read_thread_cpu <<
+        ", \"producer_read\": " << producer_read << ", \"producer_wait\": " << producer_wait <<
+        ", \"slowest_stage\": \"" << name(slowest_stage()) << "\", \"stages\": { ";
+    for (int s = 0; s < number_of_stages; ++s)
+      os << (s ? ", " : "") << '"' << name(static_cast<stage_type>(s)) << "\": " << stage[s];
+    os << " } }";
+    os.precision(precision);
+  }
+};
+
+} // namespace pgn
+} // namespace cwchess
@@ -0,0 +1,156 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnLoadProgress.h This file contains the declaration of class pgn::LoadProgress.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief The progress of loading a Database, and a way to cancel it.
+ *
+ * The counters are written by the threads that load the database and may be
+ * sampled by any thread at any time; typically the GUI calls sample() from a
+ * timer at frame rate. The counters are updated once per block or once per
+ * game, so sampling is cheap and never blocks the loading threads.
+ *
+ * cancel() may also be called from any thread. The parser stops at the next
+ * block boundary and the producer doesn't read another block, after which the
+ * database finishes loading as usual, with the games that were parsed so far.
+ */
+class LoadProgress {
+  public:
+    //! A consistent enough copy of the counters.
+    struct Sample {
+      uint64_t file_size;		//!< The size of the file on disk, or 0 if unknown.
+      uint64_t file_bytes_read;		//!< The number of bytes read from the file; compressed bytes for a compressed file.
+      uint64_t bytes_read;		//!< The number of (decompressed) bytes that were handed to the parser.
+      uint64_t bytes_parsed;		//!< The number of bytes that the parser finished.
+      uint32_t games;			//!< The number of games found.
+      uint32_t parse_errors;		//!< The number of games with a parse error or missing game termination.
+      double wait_time;			//!< The time in seconds that the parser waited for data.
+      double elapsed_time;		//!< The time in seconds since loading started, or until it finished.
+      bool cancelled;			//!< Set when cancel() was called.
+      bool finished;			//!< Set when loading finished, whether or not it was cancelled.
+
+      //! Return the fraction of the file that was read, or 0 if the size of the file is unknown.
+      double fraction() const { return file_size ? double(file_bytes_read) / file_size : 0.0; }
+
+      //! Return the average parse speed in MB/s.
+      double parse_speed() const { return elapsed_time > 0 ? bytes_parsed / elapsed_time / 1048576 : 0.0; }
+    };
+
+  private:
+    typedef std::chrono::steady_clock clock_type;
+
+    std::atomic<uint64_t> M_file_size;
+    std::atomic<uint64_t> M_file_bytes_read;
+    std::atomic<uint64_t> M_bytes_read;
+    std::atomic<uint64_t> M_bytes_parsed;
+    std::atomic<uint32_t> M_games;
+    std::atomic<uint32_t> M_parse_errors;
+    std::atomic<uint64_t> M_wait_time;		//!< In nanoseconds.
+    std::atomic<int64_t> M_elapsed_time;	//!< In nanoseconds; only valid once finished.
+    std::atomic<bool> M_cancelled;
+    std::atomic<bool> M_finished;
+    clock_type::time_point M_start_time;	//!< Written once, before the loading threads are started.
+
+  public:
+    //! Construct the progress of a load that starts now.
+    LoadProgress() : M_file_size(0), M_file_bytes_read(0), M_bytes_read(0), M_bytes_parsed(0), M_games(0), M_parse_errors(0),
+        M_wait_time(0), M_elapsed_time(0), M_cancelled(false), M_finished(false), M_start_time(clock_type::now()) { }
+
+    LoadProgress(LoadProgress const&) = delete;
+    LoadProgress& operator=(LoadProgress const&) = delete;
+
+    //! Request that loading stops as soon as possible. Thread-safe.
+    void cancel() { M_cancelled.store(true, std::memory_order_relaxed); }
+
+    //! Return TRUE if cancel() was called.
+    bool cancelled() const { return M_cancelled.load(std::memory_order_relaxed); }
+
+    //! Return TRUE if loading finished.
+    bool finished() const { return M_finished.load(std::memory_order_acquire); }
+
+    //! Return a copy of all counters.
+    Sample sample() const
+    {
+      Sample sample;
+      sample.finished = M_finished.load(std::memory_order_acquire);
+      sample.file_size = M_file_size.load(std::memory_order_relaxed);
+      sample.file_bytes_read = M_file_bytes_read.load(std::memory_order_relaxed);
+      sample.bytes_read = M_bytes_read.load(std::memory_order_relaxed);
+      sample.bytes_parsed = M_bytes_parsed.load(std::memory_order_relaxed);
+      sample.games = M_games.load(std::memory_order_relaxed);
+      sample.parse_errors = M_parse_errors.load(std::memory_order_relaxed);
+      sample.wait_time = M_wait_time.load(std::memory_order_relaxed) * 1e-9;
+      sample.cancelled = M_cancelled.load(std::memory_order_relaxed);
+      int64_t elapsed_time = sample.finished ? M_elapsed_time.load(std::memory_order_relaxed) :
+          std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - M_start_time).count();
+      sample.elapsed_time = elapsed_time * 1e-9;
+      return sample;
+    }
+
+  /** @name Updates by the loading threads */
+  //@{
+
+    //! Set the size of the file. Called once, before loading starts.
+    void set_file_size(uint64_t file_size) { M_file_size.store(file_size, std::memory_order_relaxed); }
+
+    //! Called by the producer after appending a block.
+    void read(uint64_t file_bytes_read, uint64_t bytes_read)
+    {
+      M_file_bytes_read.store(file_bytes_read, std::memory_order_relaxed);
+      M_bytes_read.store(bytes_read, std::memory_order_relaxed);
+    }
+
+    //! Called by the parser at the start of every game. \a wait_time is the total time in nanoseconds that it waited for data.
+    void parsed(uint64_t bytes_parsed, uint32_t games, uint64_t wait_time)
+    {
+      M_bytes_parsed.store(bytes_parsed, std::memory_order_relaxed);
+      M_games.store(games, std::memory_order_relaxed);
+      M_wait_time.store(wait_time, std::memory_order_relaxed);
+    }
+
+    //! Called by the parser when it skips the rest of a game because of a parse error.
+    void parse_error() { M_parse_errors.fetch_add(1, std::memory_order_relaxed); }
+
+    //! Called once, when loading finished.
+    void finish(uint64_t bytes_parsed, uint32_t games, uint64_t wait_time)
+    {
+      parsed(bytes_parsed, games, wait_time);
+      M_elapsed_time.store(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - M_start_time).count(), std::memory_order_relaxed);
+      M_finished.store(true, std::memory_order_release);
+    }
+
+    //! Return the flag that is set by cancel(), for the loading threads to poll.
+    std::atomic<bool> const& cancel_flag() const { return M_cancelled; }
+
+  //@}
+};
+
+} // namespace pgn
+} // namespace cwchess
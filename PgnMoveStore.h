@@ -0,0 +1,160 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnMoveStore.h This file contains the declaration of class pgn::MoveStore.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ChessPosition.h"
+#include "Move.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief The main line moves of all games in a database.
+ *
+ * The game ids are the same as those of the TagStore of the same database.
+ * Each move is stored in 16 bits (see encode), the moves of all games
+ * one after another in a single array.
+ *
+ * Games that do not start from the initial position (that have a FEN tag)
+ * have their FEN stored too, see start_position.
+ */
+class MoveStore {
+  public:
+    typedef uint16_t encoded_move_type;			//!< The type of an encoded move.
+    static encoded_move_type const no_move = 0;		//!< An encoded move that is not a move (from and to are both a1).
+
+  private:
+    std::vector<encoded_move_type> M_moves;		//!< The moves of all games.
+    std::vector<uint64_t> M_end;			//!< M_end[game_id + 1] is the index into M_moves one past the last move of game_id. M_end[0] is zero.
+    std::unordered_map<uint32_t, std::string> M_FEN;	//!< The FEN of games that don't start from the initial position.
+
+  public:
+    //! Construct an empty store.
+    MoveStore() : M_end(1, 0) { }
+
+    MoveStore(MoveStore const&) = delete;
+    MoveStore& operator=(MoveStore const&) = delete;
+
+  /** @name Building */
+  //@{
+
+    //! Add a new game without moves. Returns its game id.
+    uint32_t begin_game() { M_end.push_back(M_moves.size()); return M_end.size() - 2; }
+
+    //! Add \a move to the game that was last added with begin_game.
+    void add(Move const& move) { M_moves.push_back(encode(move)); ++M_end.back(); }
+
+    //! Record that the game that was last added with begin_game starts from position \a FEN.
+    void set_FEN(std::string const& FEN) { M_FEN[M_end.size() - 2] = FEN; }
+
+    //! Remove all games.
+    void clear() { M_moves.clear(); M_end.resize(1); M_FEN.clear(); }
+
+    //! Reserve memory for \a number_of_games games with a total of \a number_of_moves moves.
+    void reserve(size_t number_of_games, size_t number_of_moves) { M_end.reserve(number_of_games + 1); M_moves.reserve(number_of_moves); }
+
+    //! Append all games of \a move_store.
+    void append(MoveStore const& move_store)
+    {
+      uint32_t first_game_id = size();
+      uint64_t first_move = M_moves.size();
+      M_moves.insert(M_moves.end(), move_store.M_moves.begin(), move_store.M_moves.end());
+      for (auto iter = move_store.M_end.begin() + 1; iter != move_store.M_end.end(); ++iter)
+        M_end.push_back(first_move + *iter);
+      for (auto const& FEN : move_store.M_FEN)
+        M_FEN[first_game_id + FEN.first] = FEN.second;
+    }
+
+  //@}
+
+  /** @name Accessors */
+  //@{
+
+    //! Return the number of games.
+    size_t size() const { return M_end.size() - 1; }
+
+    //! Return the total number of moves of all games.
+    size_t total_number_of_moves() const { return M_moves.size(); }
+
+    //! Return the number of moves (plies) of game \a game_id.
+    size_t number_of_moves(uint32_t game_id) const { return M_end[game_id + 1] - M_end[game_id]; }
+
+    //! Return a pointer to the first encoded move of game \a game_id.
+    encoded_move_type const* moves(uint32_t game_id) const { return M_moves.data() + M_end[game_id]; }
+
+    //! Return the FEN that game \a game_id starts from, or NULL if it starts from the initial position.
+    std::string const* FEN(uint32_t game_id) const
+    {
+      if (__builtin_expect(M_FEN.empty(), true))
+        return NULL;
+      auto iter = M_FEN.find(game_id);
+      return iter == M_FEN.end() ? NULL : &iter->second;
+    }
+
+    /** @brief Set up the position that game \a game_id starts from.
+     *
+     * @returns FALSE if the game has a FEN that could not be loaded.
+     */
+    bool start_position(uint32_t game_id, ChessPosition& chess_position) const
+    {
+      if (__builtin_expect(M_FEN.empty(), true))
+      {
+        chess_position.initial_position();
+	return true;
+      }
+      auto iter = M_FEN.find(game_id);
+      if (iter == M_FEN.end())
+      {
+        chess_position.initial_position();
+	return true;
+      }
+      return chess_position.load_FEN(iter->second);
+    }
+
+  //@}
+
+  /** @name Move encoding */
+  //@{
+
+    //! Encode \a move as from + 64 * to + 4096 * promotion type.
+    static encoded_move_type encode(Move const& move)
+        { return move.from()() | (move.to()() << 6) | (move.promotion_type()() << 12); }
+
+    //! Decode a move that was encoded with encode.
+    static Move decode(encoded_move_type encoded_move)
+    {
+      IndexData from = { static_cast<uint8_t>(encoded_move & 63) };
+      IndexData to = { static_cast<uint8_t>((encoded_move >> 6) & 63) };
+      TypeData promotion_type = { static_cast<uint8_t>(encoded_move >> 12) };
+      return Move(from, to, promotion_type);
+    }
+
+  //@}
+};
+
+} // namespace pgn
+} // namespace cwchess
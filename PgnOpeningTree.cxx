@@ -0,0 +1,340 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnOpeningTree.cxx This file contains the implementation of class pgn::OpeningTree.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnOpeningTree.h"
+#include "debug.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <unordered_map>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib.h>
+
+namespace cwchess {
+namespace pgn {
+
+namespace {
+
+char const magic[6] = { 'C', 'W', 'O', 'T', 'R', 'E' };
+uint16_t const version = 1;
+
+// The header of a tree file, followed directly by the entries.
+struct FileHeader {
+  char magic[6];
+  uint16_t version;
+  uint32_t number_of_plies;
+  uint32_t reserved;
+  uint64_t number_of_positions;
+};
+
+// An entry of the tree file.
+struct Entry {
+  position_key_t key;
+  OpeningTree::Statistics statistics;
+};
+
+// The number of games that a thread claims at a time.
+uint32_t const games_per_batch = 1024;
+
+// The stdio buffer size used for writing the tree file.
+size_t const file_buffer_size = 256 * 1024;
+
+typedef std::unordered_map<position_key_t, OpeningTree::Statistics> shard_type;
+
+// The state shared by the threads that build the tree.
+class Builder {
+  private:
+    TagStore const& M_tag_store;
+    MoveStore const& M_move_store;
+    OpeningTree::BuildOptions const& M_options;
+    unsigned int M_shard_bits;				// The number of most significant key bits that select the shard.
+    std::vector<std::vector<shard_type>> M_tables;	// M_tables[thread][shard].
+    std::vector<std::vector<Entry>> M_shards;		// The merged and sorted entries of each shard.
+    std::atomic<uint32_t> M_next_game;
+    std::atomic<unsigned int> M_next_shard;
+
+  public:
+    Builder(TagStore const& tag_store, MoveStore const& move_store, OpeningTree::BuildOptions const& options, unsigned int number_of_threads);
+
+    void replay_games(unsigned int thread);
+    void merge_shards();
+    bool write(std::string const& filename) const;
+
+  private:
+    size_t shard(position_key_t key) const { return M_shard_bits ? key >> (64 - M_shard_bits) : 0; }
+};
+
+Builder::Builder(TagStore const& tag_store, MoveStore const& move_store, OpeningTree::BuildOptions const& options, unsigned int number_of_threads) :
+    M_tag_store(tag_store), M_move_store(move_store), M_options(options), M_shard_bits(0), M_next_game(0), M_next_shard(0)
+{
+  // Use a few shards per thread, so that uneven shards still keep all threads busy while merging.
+  while ((1U << M_shard_bits) < 4 * number_of_threads)
+    ++M_shard_bits;
+  M_tables.resize(number_of_threads, std::vector<shard_type>(size_t(1) << M_shard_bits));
+  M_shards.resize(size_t(1) << M_shard_bits);
+}
+
+// The main function of each thread during the first phase.
+void Builder::replay_games(unsigned int thread)
+{
+  std::vector<shard_type>& tables(M_tables[thread]);
+  std::vector<position_key_t> seen;
+  ChessPosition chess_position;
+  uint32_t const number_of_games = std::min(M_move_store.size(), M_tag_store.size());
+  for (;;)
+  {
+    uint32_t begin = M_next_game.fetch_add(games_per_batch);
+    if (begin >= number_of_games)
+      break;
+    uint32_t end = std::min(begin + games_per_batch, number_of_games);
+    for (uint32_t game_id = begin; game_id < end; ++game_id)
+    {
+      if (G_UNLIKELY(!M_move_store.start_position(game_id, chess_position)))
+	continue;
+      // The contribution of this game to each of its positions.
+      OpeningTree::Statistics game = { 1, 0, 0, 0, 0, M_tag_store.date(game_id), 0 };
+      switch (M_tag_store.result(game_id))
+      {
+	case TagStore::white_wins:
+	  game.white_wins = 1;
+	  break;
+	case TagStore::black_wins:
+	  game.black_wins = 1;
+	  break;
+	case TagStore::draw:
+	  game.draws = 1;
+	  break;
+	case TagStore::result_unknown:
+	  break;
+      }
+      for (uint16_t elo : { M_tag_store.white_elo(game_id), M_tag_store.black_elo(game_id) })
+	if (elo)
+	{
+	  ++game.ratings;
+	  game.elo_sum += elo;
+	}
+      MoveStore::encoded_move_type const* moves = M_move_store.moves(game_id);
+      size_t number_of_plies = std::min(M_move_store.number_of_moves(game_id), size_t(M_options.number_of_plies));
+      seen.clear();
+      for (size_t ply = 0;; ++ply)
+      {
+	position_key_t key = position_key(chess_position);
+	// A position that is repeated within the same game is only counted once.
+	if (G_LIKELY(std::find(seen.begin(), seen.end(), key) == seen.end()))
+	{
+	  seen.push_back(key);
+	  tables[shard(key)][key].add(game);
+	}
+	if (ply == number_of_plies)
+	  break;
+	chess_position.execute(MoveStore::decode(moves[ply]));
+      }
+    }
+  }
+}
+
+// The main function of each thread during the second phase.
+// Each shard is merged by a single thread; shards cover disjoint key ranges.
+void Builder::merge_shards()
+{
+  size_t const number_of_shards = M_shards.size();
+  for (;;)
+  {
+    size_t s = M_next_shard.fetch_add(1);
+    if (s >= number_of_shards)
+      break;
+    shard_type& merged(M_tables[0][s]);
+    for (size_t thread = 1; thread < M_tables.size(); ++thread)
+    {
+      for (auto const& position : M_tables[thread][s])
+	merged[position.first].add(position.second);
+      shard_type().swap(M_tables[thread][s]);
+    }
+    std::vector<Entry>& entries(M_shards[s]);
+    entries.reserve(merged.size());
+    for (auto const& position : merged)
+      if (position.second.games >= M_options.min_games)
+	entries.push_back({ position.first, position.second });
+    shard_type().swap(merged);
+    std::sort(entries.begin(), entries.end(), [](Entry const& e1, Entry const& e2){ return e1.key < e2.key; });
+  }
+}
+
+// Write all shards, in order of their key range, to the tree file.
+bool Builder::write(std::string const& filename) const
+{
+  std::FILE* file = std::fopen(filename.c_str(), "wb");
+  if (!file)
+    return false;
+  std::vector<char> file_buffer(file_buffer_size);
+  std::setvbuf(file, file_buffer.data(), _IOFBF, file_buffer.size());
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.number_of_plies = M_options.number_of_plies;
+  for (std::vector<Entry> const& entries : M_shards)
+    header.number_of_positions += entries.size();
+  bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+  for (std::vector<Entry> const& entries : M_shards)
+    success = success && std::fwrite(entries.data(), sizeof(Entry), entries.size(), file) == entries.size();
+  if (std::fclose(file) != 0)
+    success = false;
+  return success;
+}
+
+} // namespace
+
+void OpeningTree::Statistics::add(Statistics const& statistics)
+{
+  games += statistics.games;
+  white_wins += statistics.white_wins;
+  draws += statistics.draws;
+  black_wins += statistics.black_wins;
+  ratings += statistics.ratings;
+  last_played = std::max(last_played, statistics.last_played);
+  elo_sum += statistics.elo_sum;
+}
+
+bool OpeningTree::build(TagStore const& tag_store, MoveStore const& move_store, std::string const& filename, BuildOptions const& options)
+{
+  DoutEntering(dc::notice, "OpeningTree::build(tag_store, move_store, \"" << filename << "\", options)");
+
+  unsigned int number_of_threads = options.number_of_threads;
+  if (number_of_threads == 0)
+    number_of_threads = std::max(std::thread::hardware_concurrency(), 1U);
+
+  Builder builder(tag_store, move_store, options, number_of_threads);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < number_of_threads; ++i)
+    threads.emplace_back(&Builder::replay_games, &builder, i);
+  for (std::thread& thread : threads)
+    thread.join();
+  threads.clear();
+  for (unsigned int i = 0; i < number_of_threads; ++i)
+    threads.emplace_back(&Builder::merge_shards, &builder);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  bool success = builder.write(filename);
+  if (!success)
+    std::remove(filename.c_str());
+  return success;
+}
+
+bool OpeningTree::open(std::string const& filename)
+{
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+  struct stat sb;
+  if (fstat(fd, &sb) == -1 || size_t(sb.st_size) < sizeof(FileHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+  {
+    ::close(fd);
+    return false;
+  }
+  FileHeader const* header = static_cast<FileHeader const*>(map);
+  // Bound number_of_positions first, so that the multiplication can't wrap around.
+  size_t const file_size = sb.st_size;
+  if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version ||
+      header->number_of_positions > (file_size - sizeof(FileHeader)) / sizeof(Entry) ||
+      sizeof(FileHeader) + header->number_of_positions * sizeof(Entry) != file_size)
+  {
+    munmap(map, sb.st_size);
+    ::close(fd);
+    return false;
+  }
+  // Lookups jump around in the file; don't read ahead.
+  madvise(map, sb.st_size, MADV_RANDOM);
+  M_fd = fd;
+  M_map = static_cast<char const*>(map);
+  M_map_size = sb.st_size;
+  M_number_of_positions = header->number_of_positions;
+  M_number_of_plies = header->number_of_plies;
+  M_entries = M_map + sizeof(FileHeader);
+  return true;
+}
+
+void OpeningTree::close()
+{
+  if (M_map)
+  {
+    munmap(const_cast<char*>(M_map), M_map_size);
+    ::close(M_fd);
+  }
+  M_fd = -1;
+  M_map = NULL;
+  M_map_size = 0;
+  M_number_of_positions = 0;
+  M_number_of_plies = 0;
+  M_entries = NULL;
+}
+
+bool OpeningTree::find(position_key_t key, Statistics& statistics) const
+{
+  Entry const* entries_begin = static_cast<Entry const*>(M_entries);
+  Entry const* entries_end = entries_begin + M_number_of_positions;
+  Entry const* entry =
+      std::lower_bound(entries_begin, entries_end, key, [](Entry const& entry, position_key_t key) { return entry.key < key; });
+  if (entry == entries_end || entry->key != key)
+    return false;
+  statistics = entry->statistics;
+  return true;
+}
+
+size_t OpeningTree::children(ChessPosition const& chess_position, std::vector<Child>& children) const
+{
+  size_t count = 0;
+  ChessPosition next_position;
+  for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+  {
+    for (MoveIterator move_iter = chess_position.move_begin(piece_iter.index()); move_iter != chess_position.move_end(); ++move_iter)
+    {
+      next_position = chess_position;
+      next_position.execute(*move_iter);
+      Statistics statistics;
+      if (find(next_position, statistics))
+      {
+	children.push_back({ *move_iter, statistics });
+	++count;
+      }
+    }
+  }
+  return count;
+}
+
+} // namespace pgn
+} // namespace cwchess
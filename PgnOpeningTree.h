@@ -0,0 +1,162 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnOpeningTree.h This file contains the declaration of class pgn::OpeningTree.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnMoveStore.h"
+#include "PgnTagStore.h"
+#include "PositionKey.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief Statistics of the positions in the opening phase of all games of a database.
+ *
+ * The tree is a file that is built once from the TagStore and MoveStore of a database
+ * (see build) and then memory mapped for lookups (see open and find).
+ * The file contains one entry per distinct position that occurred in the first
+ * BuildOptions::number_of_plies half moves of any game, sorted by position key,
+ * so that a lookup is a binary search.
+ *
+ * Usage example:
+ * \code
+ * pgn::OpeningTree::build(database->tag_store(), database->move_store(), "games.tree");
+ * pgn::OpeningTree tree;
+ * std::vector<pgn::OpeningTree::Child> children;
+ * if (tree.open("games.tree"))
+ *   tree.children(chess_position, children);
+ * \endcode
+ */
+class OpeningTree {
+  public:
+    //! The aggregated statistics of one position.
+    struct Statistics {
+      uint32_t games;			//!< The number of games in which the position occurred.
+      uint32_t white_wins;		//!< The number of those games that White won.
+      uint32_t draws;			//!< The number of those games that were drawn.
+      uint32_t black_wins;		//!< The number of those games that Black won.
+      uint32_t ratings;			//!< The number of known Elo ratings of the players of those games.
+      uint32_t last_played;		//!< The latest date of those games, packed with TagStore::pack_date.
+      uint64_t elo_sum;			//!< The sum of the known Elo ratings.
+
+      //! Return the average Elo rating of the players, or 0 if none is known.
+      unsigned int average_elo() const { return ratings ? (elo_sum + ratings / 2) / ratings : 0; }
+
+      //! Return the score of White in the decided and drawn games, in the range [0, 1].
+      double white_score() const
+      {
+	uint32_t results = white_wins + draws + black_wins;
+	return results ? (white_wins + 0.5 * draws) / results : 0.5;
+      }
+
+      //! Add the statistics of \a statistics.
+      void add(Statistics const& statistics);
+    };
+
+    //! The statistics of a position after one move, see children.
+    struct Child {
+      Move move;			//!< The move.
+      Statistics statistics;		//!< The statistics of the position after the move.
+    };
+
+    //! Building parameters.
+    struct BuildOptions {
+      unsigned int number_of_plies;	//!< The number of half moves of each game that are visited.
+      unsigned int number_of_threads;	//!< The number of threads to replay games with; 0 means one per core.
+      uint32_t min_games;		//!< Positions that occurred in fewer games are not stored.
+
+      BuildOptions() : number_of_plies(30), number_of_threads(0), min_games(1) { }
+    };
+
+  private:
+    int M_fd;					//!< The file descriptor of the open tree, or -1.
+    char const* M_map;				//!< The mapped file.
+    size_t M_map_size;				//!< The size of the mapping.
+    size_t M_number_of_positions;		//!< The number of positions in the tree.
+    unsigned int M_number_of_plies;		//!< The number of plies the tree was built with.
+    void const* M_entries;			//!< Pointer to the first entry in the mapped file.
+
+  public:
+    //! Construct a closed tree.
+    OpeningTree() : M_fd(-1), M_map(NULL), M_map_size(0), M_number_of_positions(0), M_number_of_plies(0), M_entries(NULL) { }
+    ~OpeningTree() { close(); }
+
+    OpeningTree(OpeningTree const&) = delete;
+    OpeningTree& operator=(OpeningTree const&) = delete;
+
+    /** @brief Build a tree file for all games of \a tag_store and \a move_store.
+     *
+     * The games are divided over \a options.number_of_threads threads, each of which
+     * replays the first \a options.number_of_plies plies of its games and aggregates
+     * the statistics per position in one hash table per shard. A shard is a range
+     * of position keys. Afterwards the threads merge the tables of one shard at a time
+     * and sort the result; the sorted shards are then written one after another.
+     *
+     * @returns TRUE on success.
+     */
+    static bool build(TagStore const& tag_store, MoveStore const& move_store, std::string const& filename,
+        BuildOptions const& options = BuildOptions());
+
+    /** @brief Memory map the tree file \a filename.
+     *
+     * @returns FALSE if the file could not be opened or is not a tree file.
+     */
+    bool open(std::string const& filename);
+
+    //! Unmap the tree, if any.
+    void close();
+
+    //! Return TRUE if a tree is open.
+    bool is_open() const { return M_map != NULL; }
+
+    //! Return the number of distinct positions in the tree.
+    size_t number_of_positions() const { return M_number_of_positions; }
+
+    //! Return the number of plies that the tree was built with.
+    unsigned int number_of_plies() const { return M_number_of_plies; }
+
+    /** @brief Look up the statistics of position \a key.
+     *
+     * @returns FALSE if the position is not in the tree.
+     */
+    bool find(position_key_t key, Statistics& statistics) const;
+
+    //! Look up the statistics of \a chess_position.
+    bool find(ChessPosition const& chess_position, Statistics& statistics) const { return find(position_key(chess_position), statistics); }
+
+    /** @brief Look up the statistics of the positions after each legal move in \a chess_position.
+     *
+     * Moves that lead to positions that are not in the tree are skipped.
+     * The children are appended to \a children, in move generation order.
+     *
+     * @returns The number of children found.
+     */
+    size_t children(ChessPosition const& chess_position, std::vector<Child>& children) const;
+};
+
+} // namespace pgn
+} // namespace cwchess
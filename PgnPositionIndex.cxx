@@ -0,0 +1,429 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnPositionIndex.cxx This file contains the implementation of class pgn::PositionIndex.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnPositionIndex.h"
+#include "PgnVarint.h"
+#include "debug.h"
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <glib.h>
+
+namespace cwchess {
+namespace pgn {
+
+namespace {
+
+char const magic[6] = { 'C', 'W', 'P', 'I', 'D', 'X' };
+uint16_t const version = 1;
+
+// The header of an index file.
+// The postings lists follow directly after the header, the key table
+// follows after the postings, aligned to a multiple of eight bytes.
+struct FileHeader {
+  char magic[6];
+  uint16_t version;
+  uint64_t number_of_keys;
+  uint64_t postings_size;
+};
+
+// An entry of the key table.
+// The postings list of key runs till the postings list of the next entry.
+struct KeyEntry {
+  position_key_t key;
+  uint64_t postings;		// Offset of the postings list, relative to the start of the first postings list.
+};
+
+size_t key_table_offset(uint64_t postings_size)
+{
+  return sizeof(FileHeader) + ((postings_size + 7) & ~uint64_t(7));
+}
+
+// A single occurrence of a position, as collected while building.
+struct Entry {
+  position_key_t key;
+  uint32_t game_id;
+  uint16_t ply;
+  MoveStore::encoded_move_type continuation;
+
+  bool operator<(Entry const& entry) const
+  {
+    if (key != entry.key)
+      return key < entry.key;
+    if (game_id != entry.game_id)
+      return game_id < entry.game_id;
+    return ply < entry.ply;
+  }
+};
+
+// The number of games that a thread claims at a time.
+uint32_t const games_per_batch = 1024;
+
+// The stdio buffer size used for temporary files.
+size_t const file_buffer_size = 256 * 1024;
+
+std::string run_filename(std::string const& filename, unsigned int run)
+{
+  return filename + ".run" + std::to_string(run);
+}
+
+// The state shared by the threads that replay the games.
+class Builder {
+  private:
+    MoveStore const& M_move_store;
+    std::string const& M_filename;
+    size_t M_entries_per_buffer;
+    std::atomic<uint32_t> M_next_game;
+    std::atomic<bool> M_error;
+    std::mutex M_runs_mutex;
+    unsigned int M_number_of_runs;	// Protected by M_runs_mutex.
+
+  public:
+    Builder(MoveStore const& move_store, std::string const& filename, size_t entries_per_buffer) :
+        M_move_store(move_store), M_filename(filename), M_entries_per_buffer(entries_per_buffer),
+	M_next_game(0), M_error(false), M_number_of_runs(0) { }
+
+    void replay_games();
+    bool merge_runs();
+    void remove_runs();
+
+  private:
+    void write_run(std::vector<Entry>& buffer);
+};
+
+// Sort the entries in buffer and write them to a new run file.
+void Builder::write_run(std::vector<Entry>& buffer)
+{
+  std::sort(buffer.begin(), buffer.end());
+  unsigned int run;
+  {
+    std::lock_guard<std::mutex> lock(M_runs_mutex);
+    run = M_number_of_runs++;
+  }
+  std::FILE* file = std::fopen(run_filename(M_filename, run).c_str(), "wb");
+  bool success = file && std::fwrite(buffer.data(), sizeof(Entry), buffer.size(), file) == buffer.size();
+  if (file && std::fclose(file) != 0)
+    success = false;
+  if (!success)
+    M_error = true;
+  buffer.clear();
+}
+
+// The main function of each thread.
+void Builder::replay_games()
+{
+  std::vector<Entry> buffer;
+  buffer.reserve(M_entries_per_buffer);
+  ChessPosition chess_position;
+  uint32_t const number_of_games = M_move_store.size();
+  for (;;)
+  {
+    uint32_t begin = M_next_game.fetch_add(games_per_batch);
+    if (begin >= number_of_games || M_error)
+      break;
+    uint32_t end = std::min(begin + games_per_batch, number_of_games);
+    for (uint32_t game_id = begin; game_id < end; ++game_id)
+    {
+      if (G_UNLIKELY(!M_move_store.start_position(game_id, chess_position)))
+	continue;
+      MoveStore::encoded_move_type const* moves = M_move_store.moves(game_id);
+      size_t number_of_moves = std::min(M_move_store.number_of_moves(game_id), size_t(0xffff));
+      for (size_t ply = 0;; ++ply)
+      {
+	MoveStore::encoded_move_type continuation = (ply < number_of_moves) ? moves[ply] : MoveStore::no_move;
+	buffer.push_back({ position_key(chess_position), game_id, static_cast<uint16_t>(ply), continuation });
+	if (G_UNLIKELY(buffer.size() == M_entries_per_buffer))
+	  write_run(buffer);
+	if (continuation == MoveStore::no_move)
+	  break;
+	chess_position.execute(MoveStore::decode(continuation));
+      }
+    }
+  }
+  if (!buffer.empty())
+    write_run(buffer);
+}
+
+// Sequential reader of the entries in a run file.
+class RunReader {
+  private:
+    std::FILE* M_file;
+    std::vector<Entry> M_buffer;
+    size_t M_next;
+
+  public:
+    RunReader() : M_file(NULL), M_next(0) { }
+    ~RunReader() { if (M_file) std::fclose(M_file); }
+
+    bool open(std::string const& filename)
+    {
+      M_file = std::fopen(filename.c_str(), "rb");
+      M_buffer.reserve(file_buffer_size / sizeof(Entry));
+      return M_file;
+    }
+
+    // Read the next entry. Returns false at the end of the run.
+    bool next(Entry& entry)
+    {
+      if (M_next == M_buffer.size())
+      {
+	M_buffer.resize(M_buffer.capacity());
+	M_buffer.resize(std::fread(M_buffer.data(), sizeof(Entry), M_buffer.size(), M_file));
+	M_next = 0;
+	if (M_buffer.empty())
+	  return false;
+      }
+      entry = M_buffer[M_next++];
+      return true;
+    }
+};
+
+// Merge all run files into the index file.
+bool Builder::merge_runs()
+{
+  if (M_error)
+    return false;
+  std::vector<RunReader> runs(M_number_of_runs);
+  for (unsigned int run = 0; run < M_number_of_runs; ++run)
+    if (!runs[run].open(run_filename(M_filename, run)))
+      return false;
+
+  std::FILE* file = std::fopen(M_filename.c_str(), "wb");
+  if (!file)
+    return false;
+  std::string keys_filename(M_filename + ".keys");
+  std::FILE* keys = std::fopen(keys_filename.c_str(), "w+b");
+  if (!keys)
+  {
+    std::fclose(file);
+    return false;
+  }
+  std::vector<char> file_buffer(file_buffer_size);
+  std::setvbuf(file, file_buffer.data(), _IOFBF, file_buffer.size());
+
+  // Leave room for the header.
+  FileHeader header;
+  std::memset(&header, 0, sizeof(header));
+  bool success = std::fwrite(&header, sizeof(header), 1, file) == 1;
+
+  // A min-heap with the next entry of each run.
+  typedef std::pair<Entry, unsigned int> heap_element_type;
+  auto greater = [](heap_element_type const& e1, heap_element_type const& e2) { return e2.first < e1.first; };
+  std::priority_queue<heap_element_type, std::vector<heap_element_type>, decltype(greater)> heap(greater);
+  for (unsigned int run = 0; run < M_number_of_runs; ++run)
+  {
+    Entry entry;
+    if (runs[run].next(entry))
+      heap.push(heap_element_type(entry, run));
+  }
+
+  uint64_t postings_size = 0;
+  uint64_t number_of_keys = 0;
+  position_key_t previous_key = 0;
+  uint32_t previous_game_id = 0;
+  while (!heap.empty() && success)
+  {
+    Entry entry(heap.top().first);
+    unsigned int run = heap.top().second;
+    heap.pop();
+    Entry next_entry;
+    if (runs[run].next(next_entry))
+      heap.push(heap_element_type(next_entry, run));
+    if (number_of_keys == 0 || entry.key != previous_key)
+    {
+      // The first occurrence of a new position.
+      KeyEntry key_entry = { entry.key, postings_size };
+      success = std::fwrite(&key_entry, sizeof(key_entry), 1, keys) == 1;
+      previous_key = entry.key;
+      ++number_of_keys;
+      previous_game_id = 0;
+    }
+    unsigned char posting[32];
+    unsigned char* p = put_varint(posting, entry.game_id - previous_game_id);
+    p = put_varint(p, entry.ply);
+    p = put_varint(p, entry.continuation);
+    success = success && std::fwrite(posting, 1, p - posting, file) == size_t(p - posting);
+    postings_size += p - posting;
+    previous_game_id = entry.game_id;
+  }
+
+  // Append the key table, aligned at eight bytes.
+  static char const padding[8] = { 0, };
+  size_t padding_size = key_table_offset(postings_size) - sizeof(FileHeader) - postings_size;
+  success = success && std::fwrite(padding, 1, padding_size, file) == padding_size;
+  std::rewind(keys);
+  std::vector<char> copy_buffer(file_buffer_size);
+  size_t len;
+  while (success && (len = std::fread(copy_buffer.data(), 1, copy_buffer.size(), keys)) > 0)
+    success = std::fwrite(copy_buffer.data(), 1, len, file) == len;
+  std::fclose(keys);
+  std::remove(keys_filename.c_str());
+
+  // Write the real header.
+  std::memcpy(header.magic, magic, sizeof(magic));
+  header.version = version;
+  header.number_of_keys = number_of_keys;
+  header.postings_size = postings_size;
+  success = success && std::fseek(file, 0, SEEK_SET) == 0 && std::fwrite(&header, sizeof(header), 1, file) == 1;
+  if (std::fclose(file) != 0)
+    success = false;
+  return success;
+}
+
+void Builder::remove_runs()
+{
+  for (unsigned int run = 0; run < M_number_of_runs; ++run)
+    std::remove(run_filename(M_filename, run).c_str());
+}
+
+} // namespace
+
+bool PositionIndex::build(MoveStore const& move_store, std::string const& filename, BuildOptions const& options)
+{
+  DoutEntering(dc::notice, "PositionIndex::build(move_store, \"" << filename << "\", options)");
+
+  unsigned int number_of_threads = options.number_of_threads;
+  if (number_of_threads == 0)
+    number_of_threads = std::max(std::thread::hardware_concurrency(), 1U);
+  size_t entries_per_buffer = std::max(options.memory_budget / number_of_threads / sizeof(Entry), size_t(1024));
+
+  Builder builder(move_store, filename, entries_per_buffer);
+  std::vector<std::thread> threads;
+  for (unsigned int i = 0; i < number_of_threads; ++i)
+    threads.emplace_back(&Builder::replay_games, &builder);
+  for (std::thread& thread : threads)
+    thread.join();
+
+  bool success = builder.merge_runs();
+  builder.remove_runs();
+  if (!success)
+    std::remove(filename.c_str());
+  return success;
+}
+
+bool PositionIndex::open(std::string const& filename)
+{
+  close();
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd == -1)
+    return false;
+  struct stat sb;
+  if (fstat(fd, &sb) == -1 || size_t(sb.st_size) < sizeof(FileHeader))
+  {
+    ::close(fd);
+    return false;
+  }
+  void* map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED)
+  {
+    ::close(fd);
+    return false;
+  }
+  FileHeader const* header = static_cast<FileHeader const*>(map);
+  // Bound postings_size and number_of_keys first, so that neither the offset nor the multiplication can wrap around.
+  size_t const file_size = sb.st_size;
+  if (std::memcmp(header->magic, magic, sizeof(magic)) != 0 || header->version != version ||
+      header->postings_size > file_size - sizeof(FileHeader) || key_table_offset(header->postings_size) > file_size ||
+      header->number_of_keys > (file_size - key_table_offset(header->postings_size)) / sizeof(KeyEntry) ||
+      key_table_offset(header->postings_size) + header->number_of_keys * sizeof(KeyEntry) != file_size)
+  {
+    munmap(map, sb.st_size);
+    ::close(fd);
+    return false;
+  }
+  // find() reads the postings list of a key up till the postings list of the next key.
+  KeyEntry const* keys = reinterpret_cast<KeyEntry const*>(static_cast<char const*>(map) + key_table_offset(header->postings_size));
+  uint64_t previous_postings = 0;
+  for (uint64_t i = 0; i < header->number_of_keys; ++i)
+  {
+    if (keys[i].postings < previous_postings || keys[i].postings > header->postings_size)
+    {
+      munmap(map, sb.st_size);
+      ::close(fd);
+      return false;
+    }
+    previous_postings = keys[i].postings;
+  }
+  // Lookups jump around in the file; don't read ahead.
+  madvise(map, sb.st_size, MADV_RANDOM);
+  M_fd = fd;
+  M_map = static_cast<char const*>(map);
+  M_map_size = sb.st_size;
+  M_number_of_keys = header->number_of_keys;
+  M_postings = reinterpret_cast<unsigned char const*>(M_map + sizeof(FileHeader));
+  M_postings_size = header->postings_size;
+  M_keys = M_map + key_table_offset(M_postings_size);
+  return true;
+}
+
+void PositionIndex::close()
+{
+  if (M_map)
+  {
+    munmap(const_cast<char*>(M_map), M_map_size);
+    ::close(M_fd);
+  }
+  M_fd = -1;
+  M_map = NULL;
+  M_map_size = 0;
+  M_number_of_keys = 0;
+  M_keys = NULL;
+  M_postings = NULL;
+  M_postings_size = 0;
+}
+
+size_t PositionIndex::find(position_key_t key, std::vector<Hit>& hits) const
+{
+  KeyEntry const* keys_begin = static_cast<KeyEntry const*>(M_keys);
+  KeyEntry const* keys_end = keys_begin + M_number_of_keys;
+  KeyEntry const* key_entry =
+      std::lower_bound(keys_begin, keys_end, key, [](KeyEntry const& entry, position_key_t key) { return entry.key < key; });
+  if (key_entry == keys_end || key_entry->key != key)
+    return 0;
+  unsigned char const* p = M_postings + key_entry->postings;
+  unsigned char const* end = M_postings + ((key_entry + 1 == keys_end) ? M_postings_size : key_entry[1].postings);
+  size_t count = 0;
+  uint64_t game_id = 0;
+  while (p < end)
+  {
+    uint64_t delta, ply, continuation;
+    if (!get_varint(p, end, delta) || !get_varint(p, end, ply) || !get_varint(p, end, continuation))
+      break;
+    game_id += delta;
+    hits.push_back({ static_cast<uint32_t>(game_id), static_cast<uint16_t>(ply), static_cast<MoveStore::encoded_move_type>(continuation) });
+    ++count;
+  }
+  return count;
+}
+
+} // namespace pgn
+} // namespace cwchess
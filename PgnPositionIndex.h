@@ -0,0 +1,139 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnPositionIndex.h This file contains the declaration of class pgn::PositionIndex.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnMoveStore.h"
+#include "PositionKey.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief An inverted index from positions to the games that reached them.
+ *
+ * The index is a file that is built once from the MoveStore of a database (see build)
+ * and then memory mapped for queries (see open and find).
+ *
+ * The file consists of a header, followed by the postings lists
+ * and a table of all distinct position keys, sorted by key.
+ * Each key table entry points to a postings list that contains
+ * one entry per occurrence of the position: the game id, the ply
+ * at which the position occurred and the move that was played next.
+ * Postings are sorted by game id and stored as variable length
+ * integers, the game id as the difference with the previous one.
+ *
+ * Usage example:
+ * \code
+ * pgn::PositionIndex::build(database->move_store(), "games.idx");
+ * pgn::PositionIndex index;
+ * if (index.open("games.idx"))
+ * {
+ *   std::vector<pgn::PositionIndex::Hit> hits;
+ *   index.find(chess_position, hits);
+ * }
+ * \endcode
+ */
+class PositionIndex {
+  public:
+    //! A single occurrence of a position.
+    struct Hit {
+      uint32_t game_id;				//!< The game in which the position occurred.
+      uint16_t ply;				//!< The number of half moves played in the game before the position was reached.
+      MoveStore::encoded_move_type continuation;	//!< The move that was played next, or MoveStore::no_move if the game ended.
+
+      //! Return TRUE if a move was played from this position.
+      bool has_continuation() const { return continuation != MoveStore::no_move; }
+      //! Return the move that was played next. May only be called if has_continuation() returns TRUE.
+      Move move() const { return MoveStore::decode(continuation); }
+    };
+
+    //! Building parameters.
+    struct BuildOptions {
+      unsigned int number_of_threads;		//!< The number of threads to replay games with; 0 means one per core.
+      size_t memory_budget;			//!< The maximum number of bytes used for sort buffers. Larger indexes are sorted on disk.
+
+      BuildOptions() : number_of_threads(0), memory_budget(size_t(1) << 30) { }
+    };
+
+  private:
+    int M_fd;					//!< The file descriptor of the open index, or -1.
+    char const* M_map;				//!< The mapped index file.
+    size_t M_map_size;				//!< The size of the mapping.
+    size_t M_number_of_keys;			//!< The number of distinct positions.
+    void const* M_keys;				//!< Pointer to the key table in the mapped file.
+    unsigned char const* M_postings;		//!< Pointer to the first postings list in the mapped file.
+    size_t M_postings_size;			//!< The total size of all postings lists.
+
+  public:
+    //! Construct a closed index.
+    PositionIndex() : M_fd(-1), M_map(NULL), M_map_size(0), M_number_of_keys(0), M_keys(NULL), M_postings(NULL), M_postings_size(0) { }
+    ~PositionIndex() { close(); }
+
+    PositionIndex(PositionIndex const&) = delete;
+    PositionIndex& operator=(PositionIndex const&) = delete;
+
+    /** @brief Build an index file for all games in \a move_store.
+     *
+     * The games are divided over \a options.number_of_threads threads,
+     * each of which replays games with ChessPosition::execute and collects
+     * one entry per position. When the sort buffers are full they are sorted
+     * and written to temporary run files next to \a filename, which are
+     * merged into the final index afterwards.
+     *
+     * @returns TRUE on success.
+     */
+    static bool build(MoveStore const& move_store, std::string const& filename, BuildOptions const& options = BuildOptions());
+
+    /** @brief Memory map the index file \a filename.
+     *
+     * @returns FALSE if the file could not be opened or is not an index file.
+     */
+    bool open(std::string const& filename);
+
+    //! Unmap the index, if any.
+    void close();
+
+    //! Return TRUE if an index is open.
+    bool is_open() const { return M_map != NULL; }
+
+    //! Return the number of distinct positions in the index.
+    size_t number_of_keys() const { return M_number_of_keys; }
+
+    /** @brief Find all games that reached position \a key.
+     *
+     * The hits are appended to \a hits, sorted by game id and ply.
+     *
+     * @returns The number of hits.
+     */
+    size_t find(position_key_t key, std::vector<Hit>& hits) const;
+
+    //! Find all games that reached \a chess_position.
+    size_t find(ChessPosition const& chess_position, std::vector<Hit>& hits) const { return find(position_key(chess_position), hits); }
+};
+
+} // namespace pgn
+} // namespace cwchess
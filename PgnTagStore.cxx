@@ -0,0 +1,547 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnTagStore.cxx This file contains the implementation of class pgn::TagStore.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnTagStore.h"
+#include "debug.h"
+#include <fstream>
+#include <cstring>
+
+namespace cwchess {
+namespace pgn {
+
+uint32_t StringPool::intern(std::string_view str)
+{
+  auto iter = M_ids.find(str);
+  if (iter != M_ids.end())
+    return iter->second;
+  uint32_t id = M_strings.size();
+  M_strings.emplace_back(str);
+  // The key must be a view into the string that we own.
+  M_ids.emplace(M_strings.back(), id);
+  return id;
+}
+
+void StringPool::clear()
+{
+  M_ids.clear();
+  M_strings.resize(1);
+  M_ids.emplace(M_strings.back(), 0);
+}
+
+uint32_t TagStore::begin_game(uint64_t offset)
+{
+  uint32_t game_id = M_offset.size();
+  M_offset.push_back(offset);
+  M_white.push_back(0);
+  M_black.push_back(0);
+  M_event.push_back(0);
+  M_site.push_back(0);
+  M_date.push_back(0);
+  M_eco.push_back(0);
+  M_white_elo.push_back(0);
+  M_black_elo.push_back(0);
+  M_result.push_back(result_unknown);
+  return game_id;
+}
+
+void TagStore::add_tag(std::string_view name, std::string_view value)
+{
+  ASSERT(!M_offset.empty());
+  // Dispatch on the first character first; this is called for every tag pair in the database.
+  switch (name[0])
+  {
+    case 'W':
+      if (name == "White")
+	M_white.back() = M_players.intern(value);
+      else if (name == "WhiteElo")
+	M_white_elo.back() = parse_elo(value);
+      break;
+    case 'B':
+      if (name == "Black")
+	M_black.back() = M_players.intern(value);
+      else if (name == "BlackElo")
+	M_black_elo.back() = parse_elo(value);
+      break;
+    case 'E':
+      if (name == "Event")
+	M_event.back() = M_events.intern(value);
+      else if (name == "ECO")
+	M_eco.back() = parse_eco(value);
+      break;
+    case 'S':
+      if (name == "Site")
+	M_site.back() = M_sites.intern(value);
+      break;
+    case 'D':
+      if (name == "Date")
+	M_date.back() = parse_date(value);
+      break;
+    case 'R':
+      if (name == "Result")
+	M_result.back() = parse_result(value);
+      break;
+  }
+}
+
+void TagStore::clear()
+{
+  M_players.clear();
+  M_events.clear();
+  M_sites.clear();
+  M_offset.clear();
+  M_white.clear();
+  M_black.clear();
+  M_event.clear();
+  M_site.clear();
+  M_date.clear();
+  M_eco.clear();
+  M_white_elo.clear();
+  M_black_elo.clear();
+  M_result.clear();
+}
+
+namespace {
+
+// Parse at most max_digits digits starting at pos; '?' or anything else makes the whole field unknown (0).
+unsigned int parse_number(std::string_view value, size_t pos, size_t max_digits)
+{
+  unsigned int number = 0;
+  size_t end = std::min(value.size(), pos + max_digits);
+  if (pos >= end)
+    return 0;
+  for (size_t i = pos; i < end; ++i)
+  {
+    char c = value[i];
+    if (c < '0' || c > '9')
+      return 0;
+    number = 10 * number + (c - '0');
+  }
+  return number;
+}
+
+} // namespace
+
+uint32_t TagStore::parse_date(std::string_view value)
+{
+  // Format: "YYYY.MM.DD", where any digit might be replaced with a question mark.
+  unsigned int year = parse_number(value, 0, 4);
+  unsigned int month = (value.size() >= 7 && value[4] == '.') ? parse_number(value, 5, 2) : 0;
+  unsigned int day = (value.size() >= 10 && value[7] == '.') ? parse_number(value, 8, 2) : 0;
+  if (month > 12)
+    month = 0;
+  if (day > 31)
+    day = 0;
+  return pack_date(year, month, day);
+}
+
+TagStore::result_type TagStore::parse_result(std::string_view value)
+{
+  if (value == "1-0")
+    return white_wins;
+  if (value == "0-1")
+    return black_wins;
+  if (value == "1/2-1/2")
+    return draw;
+  return result_unknown;
+}
+
+uint16_t TagStore::parse_eco(std::string_view value)
+{
+  if (value.size() != 3 || value[0] < 'A' || value[0] > 'E' ||
+      value[1] < '0' || value[1] > '9' || value[2] < '0' || value[2] > '9')
+    return 0;
+  return 1 + 100 * (value[0] - 'A') + 10 * (value[1] - '0') + (value[2] - '0');
+}
+
+uint16_t TagStore::parse_elo(std::string_view value)
+{
+  unsigned int elo = parse_number(value, 0, std::min(value.size(), size_t(5)));
+  return elo > 0xffff ? 0 : elo;
+}
+
+//
+// Queries.
+//
+// The columns are scanned in chunks. For each chunk a byte array with one
+// byte per game is and-ed with the result of each condition. The inner loops
+// have no branches and no dependencies between iterations so that they are
+// turned into SIMD instructions by the compiler.
+//
+
+namespace {
+
+size_t const chunk_size = 4096;
+
+template<typename T, TagQuery::operator_type op>
+void apply(T const* column, size_t n, T value, uint8_t* match)
+{
+  for (size_t i = 0; i < n; ++i)
+  {
+    bool result;
+    switch (op)		// op is a template parameter; only one case is compiled in.
+    {
+      case TagQuery::equal:
+	result = column[i] == value;
+	break;
+      case TagQuery::not_equal:
+	result = column[i] != value;
+	break;
+      case TagQuery::less:
+	result = column[i] < value;
+	break;
+      case TagQuery::less_equal:
+	result = column[i] <= value;
+	break;
+      case TagQuery::greater:
+	result = column[i] > value;
+	break;
+      case TagQuery::greater_equal:
+	result = column[i] >= value;
+	break;
+    }
+    match[i] &= result;
+  }
+}
+
+// Same as apply, but matches if the condition is true for either of the two columns.
+template<typename T, TagQuery::operator_type op>
+void apply_either(T const* column1, T const* column2, size_t n, T value, uint8_t* match)
+{
+  uint8_t either[chunk_size];
+  std::memset(either, 1, n);
+  apply<T, op>(column1, n, value, either);
+  uint8_t second[chunk_size];
+  std::memset(second, 1, n);
+  apply<T, op>(column2, n, value, second);
+  for (size_t i = 0; i < n; ++i)
+    match[i] &= either[i] | second[i];
+}
+
+template<typename T>
+void apply(T const* column, T const* column2, TagQuery::operator_type op, size_t n, uint32_t value32, uint8_t* match)
+{
+  // A value that doesn't fit in the column type can't be equal to anything in it;
+  // clamp it so that the ordering comparisons still work.
+  T value = value32 > T(~T(0)) ? T(~T(0)) : value32;
+  if (value32 > T(~T(0)))
+  {
+    if (op == TagQuery::equal || op == TagQuery::greater_equal || op == TagQuery::greater)
+    {
+      std::memset(match, 0, n);
+      return;
+    }
+    if (op == TagQuery::not_equal || op == TagQuery::less || op == TagQuery::less_equal)
+      return;
+  }
+  if (column2)
+  {
+    switch (op)
+    {
+      case TagQuery::equal:
+	apply_either<T, TagQuery::equal>(column, column2, n, value, match);
+	break;
+      case TagQuery::not_equal:
+	apply_either<T, TagQuery::not_equal>(column, column2, n, value, match);
+	break;
+      case TagQuery::less:
+	apply_either<T, TagQuery::less>(column, column2, n, value, match);
+	break;
+      case TagQuery::less_equal:
+	apply_either<T, TagQuery::less_equal>(column, column2, n, value, match);
+	break;
+      case TagQuery::greater:
+	apply_either<T, TagQuery::greater>(column, column2, n, value, match);
+	break;
+      case TagQuery::greater_equal:
+	apply_either<T, TagQuery::greater_equal>(column, column2, n, value, match);
+	break;
+    }
+    return;
+  }
+  switch (op)
+  {
+    case TagQuery::equal:
+      apply<T, TagQuery::equal>(column, n, value, match);
+      break;
+    case TagQuery::not_equal:
+      apply<T, TagQuery::not_equal>(column, n, value, match);
+      break;
+    case TagQuery::less:
+      apply<T, TagQuery::less>(column, n, value, match);
+      break;
+    case TagQuery::less_equal:
+      apply<T, TagQuery::less_equal>(column, n, value, match);
+      break;
+    case TagQuery::greater:
+      apply<T, TagQuery::greater>(column, n, value, match);
+      break;
+    case TagQuery::greater_equal:
+      apply<T, TagQuery::greater_equal>(column, n, value, match);
+      break;
+  }
+}
+
+bool any(uint8_t const* match, size_t n)
+{
+  uint8_t result = 0;
+  for (size_t i = 0; i < n; ++i)
+    result |= match[i];
+  return result;
+}
+
+} // namespace
+
+bool TagQuery::evaluate(TagStore const& tag_store, size_t begin, size_t n, uint8_t* match) const
+{
+  ASSERT(n <= chunk_size);
+  std::memset(match, 1, n);
+  for (Condition const& condition : M_conditions)
+  {
+    switch (condition.column)
+    {
+      case white:
+	apply<uint32_t>(&tag_store.M_white[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case black:
+	apply<uint32_t>(&tag_store.M_black[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case player:
+	apply<uint32_t>(&tag_store.M_white[begin], &tag_store.M_black[begin], condition.op, n, condition.value, match);
+	break;
+      case event:
+	apply<uint32_t>(&tag_store.M_event[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case site:
+	apply<uint32_t>(&tag_store.M_site[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case date:
+	apply<uint32_t>(&tag_store.M_date[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case result:
+	apply<uint8_t>(&tag_store.M_result[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case eco:
+	apply<uint16_t>(&tag_store.M_eco[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case white_elo:
+	apply<uint16_t>(&tag_store.M_white_elo[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+      case black_elo:
+	apply<uint16_t>(&tag_store.M_black_elo[begin], nullptr, condition.op, n, condition.value, match);
+	break;
+    }
+    // Don't bother with the remaining conditions if nothing matches anymore.
+    if (!any(match, n))
+      return false;
+  }
+  return true;
+}
+
+template<class Visitor>
+void TagStore::scan(TagQuery const& query, Visitor& visitor) const
+{
+  uint8_t match[chunk_size];
+  size_t const size = M_offset.size();
+  for (size_t begin = 0; begin < size; begin += chunk_size)
+  {
+    size_t n = std::min(chunk_size, size - begin);
+    if (query.evaluate(*this, begin, n, match))
+      visitor(begin, n, match);
+  }
+}
+
+std::vector<uint32_t> TagStore::select(TagQuery const& query) const
+{
+  std::vector<uint32_t> result;
+  auto visitor = [&result](size_t begin, size_t n, uint8_t const* match) {
+    for (size_t i = 0; i < n; ++i)
+      if (match[i])
+	result.push_back(begin + i);
+  };
+  scan(query, visitor);
+  return result;
+}
+
+size_t TagStore::count(TagQuery const& query) const
+{
+  size_t result = 0;
+  auto visitor = [&result](size_t, size_t n, uint8_t const* match) {
+    for (size_t i = 0; i < n; ++i)
+      result += match[i];
+  };
+  scan(query, visitor);
+  return result;
+}
+
+//
+// Persistence.
+//
+// The file format is:
+//
+// "CWTAGS" + uint16 version
+// uint64 number of games
+// three string pools: uint32 number of strings, followed by, for each string except the first (empty) one, uint32 length + characters.
+// the columns, in the order they are declared, as raw arrays.
+//
+// All integers are stored in native byte order; the file is a cache, not an exchange format.
+//
+
+namespace {
+
+char const magic[6] = { 'C', 'W', 'T', 'A', 'G', 'S' };
+uint16_t const version = 1;
+
+template<typename T>
+void write_pod(std::ostream& os, T const& value)
+{
+  os.write(reinterpret_cast<char const*>(&value), sizeof(T));
+}
+
+template<typename T>
+bool read_pod(std::istream& is, T& value)
+{
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template<typename T>
+void write_column(std::ostream& os, std::vector<T> const& column)
+{
+  os.write(reinterpret_cast<char const*>(column.data()), column.size() * sizeof(T));
+}
+
+// Return the number of bytes from the read position of is to the end of a file of file_size bytes.
+uint64_t remaining(std::istream& is, uint64_t file_size)
+{
+  std::streamoff const pos = is.tellg();
+  return pos < 0 || uint64_t(pos) > file_size ? 0 : file_size - pos;
+}
+
+template<typename T>
+bool read_column(std::istream& is, uint64_t file_size, std::vector<T>& column, uint64_t size)
+{
+  // Don't trust the size before knowing that the file is large enough.
+  if (size > remaining(is, file_size) / sizeof(T))
+    return false;
+  column.resize(size);
+  return static_cast<bool>(is.read(reinterpret_cast<char*>(column.data()), size * sizeof(T)));
+}
+
+void write_pool(std::ostream& os, StringPool const& pool)
+{
+  write_pod<uint32_t>(os, pool.size());
+  for (uint32_t id = 1; id < pool.size(); ++id)
+  {
+    std::string const& str(pool[id]);
+    write_pod<uint32_t>(os, str.size());
+    os.write(str.data(), str.size());
+  }
+}
+
+bool read_pool(std::istream& is, uint64_t file_size, StringPool& pool)
+{
+  uint32_t size;
+  if (!read_pod(is, size) || size == 0 || size - 1 > remaining(is, file_size) / sizeof(uint32_t))
+    return false;
+  std::string str;
+  for (uint32_t id = 1; id < size; ++id)
+  {
+    uint32_t length;
+    if (!read_pod(is, length) || length > remaining(is, file_size))
+      return false;
+    str.resize(length);
+    if (!is.read(str.data(), length) || pool.intern(str) != id)
+      return false;
+  }
+  return true;
+}
+
+} // namespace
+
+bool TagStore::save(std::string const& filename) const
+{
+  std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+  if (!file)
+    return false;
+  file.write(magic, sizeof(magic));
+  write_pod(file, version);
+  write_pod<uint64_t>(file, M_offset.size());
+  write_pool(file, M_players);
+  write_pool(file, M_events);
+  write_pool(file, M_sites);
+  write_column(file, M_offset);
+  write_column(file, M_white);
+  write_column(file, M_black);
+  write_column(file, M_event);
+  write_column(file, M_site);
+  write_column(file, M_date);
+  write_column(file, M_eco);
+  write_column(file, M_white_elo);
+  write_column(file, M_black_elo);
+  write_column(file, M_result);
+  return static_cast<bool>(file.flush());
+}
+
+bool TagStore::load(std::string const& filename)
+{
+  clear();
+  std::ifstream file(filename, std::ios::binary | std::ios::ate);
+  std::streamoff const file_size = file.tellg();
+  file.seekg(0);
+  char file_magic[sizeof(magic)];
+  uint16_t file_version;
+  uint64_t size;
+  bool success =
+      file_size >= 0 &&
+      file.read(file_magic, sizeof(file_magic)) && std::memcmp(file_magic, magic, sizeof(magic)) == 0 &&
+      read_pod(file, file_version) && file_version == version &&
+      read_pod(file, size) &&
+      read_pool(file, file_size, M_players) && read_pool(file, file_size, M_events) && read_pool(file, file_size, M_sites) &&
+      read_column(file, file_size, M_offset, size) &&
+      read_column(file, file_size, M_white, size) &&
+      read_column(file, file_size, M_black, size) &&
+      read_column(file, file_size, M_event, size) &&
+      read_column(file, file_size, M_site, size) &&
+      read_column(file, file_size, M_date, size) &&
+      read_column(file, file_size, M_eco, size) &&
+      read_column(file, file_size, M_white_elo, size) &&
+      read_column(file, file_size, M_black_elo, size) &&
+      read_column(file, file_size, M_result, size) &&
+      valid();
+  if (!success)
+    clear();
+  return success;
+}
+
+bool TagStore::valid() const
+{
+  for (size_t game_id = 0; game_id < M_offset.size(); ++game_id)
+    if (M_white[game_id] >= M_players.size() || M_black[game_id] >= M_players.size() ||
+        M_event[game_id] >= M_events.size() || M_site[game_id] >= M_sites.size() ||
+	M_result[game_id] > draw || M_eco[game_id] > 500)
+      return false;
+  return true;
+}
+
+} // namespace pgn
+} // namespace cwchess
@@ -0,0 +1,309 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnTagStore.h This file contains the declaration of class pgn::TagStore.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+namespace cwchess {
+namespace pgn {
+
+class TagQuery;
+
+/** @brief A set of interned strings.
+ *
+ * Each distinct string is stored once and identified by a small integer.
+ * Id 0 is reserved for the empty (unknown) string.
+ */
+class StringPool {
+  private:
+    std::deque<std::string> M_strings;				//!< The interned strings, indexed by id. Deque, so that M_ids can keep views into them.
+    std::unordered_map<std::string_view, uint32_t> M_ids;	//!< Reverse lookup from string to id.
+
+  public:
+    //! Construct a pool that only contains the empty string.
+    StringPool() { M_strings.emplace_back(); M_ids.emplace(M_strings.back(), 0); }
+
+    StringPool(StringPool const&) = delete;
+    StringPool& operator=(StringPool const&) = delete;
+
+    //! Return the id of \a str, adding it to the pool if it isn't there yet.
+    uint32_t intern(std::string_view str);
+
+    //! Return the id of \a str, or \c npos if it isn't in the pool.
+    uint32_t find(std::string_view str) const
+    {
+      auto iter = M_ids.find(str);
+      return iter == M_ids.end() ? npos : iter->second;
+    }
+
+    //! Return the string with id \a id.
+    std::string const& operator[](uint32_t id) const { return M_strings[id]; }
+
+    //! Return the number of strings in the pool, including the empty string.
+    size_t size() const { return M_strings.size(); }
+
+    //! Remove all strings, except the empty string.
+    void clear();
+
+    static uint32_t const npos = 0xffffffff;	//!< Returned by find() when the string is not in the pool.
+};
+
+/** @brief Columnar storage of the tag pairs of all games in a database.
+ *
+ * Every game in a pgn::Database gets one row, the game id being the row number.
+ * The values of the Seven Tag Roster (except Round) plus ECO and the Elo ratings
+ * are stored in one array per tag, in a form that allows fast filtering:
+ *
+ * - Player, event and site names are interned (see StringPool).
+ * - Dates are packed into a single integer that sorts chronologically (see pack_date).
+ * - The result is stored as a result_type.
+ * - The ECO code is stored as a number in the range [1, 500], 0 meaning unknown.
+ * - Elo ratings are stored as uint16_t, 0 meaning unknown.
+ *
+ * The byte offset of the start of each game is stored as well; this is the game index
+ * that allows to seek directly to a game in the PGN file.
+ *
+ * Usage example:
+ * \code
+ * TagQuery query;
+ * query.where(TagQuery::white, TagQuery::equal, tag_store.players().find("Carlsen, Magnus"))
+ *      .where(TagQuery::date, TagQuery::greater_equal, TagStore::pack_date(2020, 0, 0))
+ *      .where(TagQuery::result, TagQuery::equal, TagStore::white_wins);
+ * std::vector<uint32_t> game_ids = tag_store.select(query);
+ * \endcode
+ */
+class TagStore {
+  public:
+    //! The possible values of the Result tag.
+    enum result_type {
+      result_unknown,		//!< "*" or missing.
+      white_wins,		//!< "1-0"
+      black_wins,		//!< "0-1"
+      draw			//!< "1/2-1/2"
+    };
+
+  private:
+    StringPool M_players;			//!< Interned values of the White and Black tags.
+    StringPool M_events;			//!< Interned values of the Event tag.
+    StringPool M_sites;				//!< Interned values of the Site tag.
+
+    std::vector<uint64_t> M_offset;		//!< Column: the offset of the first character of the game in the file.
+    std::vector<uint32_t> M_white;		//!< Column: the id of the White player in M_players.
+    std::vector<uint32_t> M_black;		//!< Column: the id of the Black player in M_players.
+    std::vector<uint32_t> M_event;		//!< Column: the id of the Event in M_events.
+    std::vector<uint32_t> M_site;		//!< Column: the id of the Site in M_sites.
+    std::vector<uint32_t> M_date;		//!< Column: the packed Date.
+    std::vector<uint16_t> M_eco;		//!< Column: the ECO code.
+    std::vector<uint16_t> M_white_elo;		//!< Column: WhiteElo.
+    std::vector<uint16_t> M_black_elo;		//!< Column: BlackElo.
+    std::vector<uint8_t> M_result;		//!< Column: the Result, a result_type.
+
+    friend class TagQuery;
+
+  public:
+    TagStore() { }
+
+    TagStore(TagStore const&) = delete;
+    TagStore& operator=(TagStore const&) = delete;
+
+  /** @name Building */
+  //@{
+
+    /** @brief Add a new game, starting at byte \a offset in the file.
+     *
+     * All columns of the new row are initialized as unknown.
+     *
+     * @returns The game id of the new game.
+     */
+    uint32_t begin_game(uint64_t offset);
+
+    /** @brief Store a tag pair for the game that was last added with begin_game.
+     *
+     * Tags that have no column are ignored.
+     */
+    void add_tag(std::string_view name, std::string_view value);
+
+    //! Remove all games.
+    void clear();
+
+  //@}
+
+  /** @name Accessors */
+  //@{
+
+    //! Return the number of games.
+    size_t size() const { return M_offset.size(); }
+
+    //! Return the pool of player names.
+    StringPool const& players() const { return M_players; }
+    //! Return the pool of event names.
+    StringPool const& events() const { return M_events; }
+    //! Return the pool of site names.
+    StringPool const& sites() const { return M_sites; }
+
+    uint64_t offset(uint32_t game_id) const { return M_offset[game_id]; }
+    uint32_t white_id(uint32_t game_id) const { return M_white[game_id]; }
+    uint32_t black_id(uint32_t game_id) const { return M_black[game_id]; }
+    uint32_t event_id(uint32_t game_id) const { return M_event[game_id]; }
+    uint32_t site_id(uint32_t game_id) const { return M_site[game_id]; }
+    std::string const& white(uint32_t game_id) const { return M_players[M_white[game_id]]; }
+    std::string const& black(uint32_t game_id) const { return M_players[M_black[game_id]]; }
+    std::string const& event(uint32_t game_id) const { return M_events[M_event[game_id]]; }
+    std::string const& site(uint32_t game_id) const { return M_sites[M_site[game_id]]; }
+    uint32_t date(uint32_t game_id) const { return M_date[game_id]; }
+    result_type result(uint32_t game_id) const { return static_cast<result_type>(M_result[game_id]); }
+    uint16_t eco(uint32_t game_id) const { return M_eco[game_id]; }
+    uint16_t white_elo(uint32_t game_id) const { return M_white_elo[game_id]; }
+    uint16_t black_elo(uint32_t game_id) const { return M_black_elo[game_id]; }
+
+  //@}
+
+  /** @name Queries */
+  //@{
+
+    //! Return the ids of all games that match \a query, in increasing order.
+    std::vector<uint32_t> select(TagQuery const& query) const;
+
+    //! Return the number of games that match \a query.
+    size_t count(TagQuery const& query) const;
+
+  //@}
+
+  /** @name Persistence */
+  //@{
+
+    /** @brief Write the store to \a filename.
+     *
+     * @returns TRUE on success.
+     */
+    bool save(std::string const& filename) const;
+
+    /** @brief Read a store that was written with save().
+     *
+     * If the file is not readable, truncated or corrupt, the function returns FALSE
+     * and the store is empty.
+     *
+     * @returns TRUE on success.
+     */
+    bool load(std::string const& filename);
+
+  //@}
+
+  /** @name Encoding of values */
+  //@{
+
+    /** @brief Pack a date into an integer.
+     *
+     * Unknown parts should be passed as 0.
+     * The result compares in chronological order, with unknown parts sorting first.
+     */
+    static uint32_t pack_date(unsigned int year, unsigned int month, unsigned int day) { return (year << 9) | (month << 5) | day; }
+
+    //! Parse a PGN date ("YYYY.MM.DD", with '?' for unknown digits) and return it packed.
+    static uint32_t parse_date(std::string_view value);
+
+    //! Parse a PGN result string.
+    static result_type parse_result(std::string_view value);
+
+    //! Parse an ECO code ("A00" till "E99"). Returns 0 if the code is not valid.
+    static uint16_t parse_eco(std::string_view value);
+
+    //! Parse an Elo rating. Returns 0 if the value is not a number.
+    static uint16_t parse_elo(std::string_view value);
+
+  //@}
+
+  private:
+    template<class Visitor>
+    void scan(TagQuery const& query, Visitor& visitor) const;
+
+    // Return TRUE if every id refers to an interned string and every result and ECO code is in range.
+    bool valid() const;
+};
+
+/** @brief A conjunction of conditions on the columns of a TagStore.
+ *
+ * The conditions are evaluated column by column over chunks of games
+ * (see TagStore::select), in simple loops that the compiler vectorizes.
+ */
+class TagQuery {
+  public:
+    //! The columns that can be filtered on.
+    enum column_type {
+      white,		//!< The id of the White player.
+      black,		//!< The id of the Black player.
+      player,		//!< Matches if either the White or the Black player matches.
+      event,		//!< The id of the Event.
+      site,		//!< The id of the Site.
+      date,		//!< The packed date.
+      result,		//!< A TagStore::result_type.
+      eco,		//!< The ECO code number.
+      white_elo,	//!< WhiteElo.
+      black_elo		//!< BlackElo.
+    };
+
+    //! The comparison operators.
+    enum operator_type {
+      equal,
+      not_equal,
+      less,
+      less_equal,
+      greater,
+      greater_equal
+    };
+
+    //! A single condition.
+    struct Condition {
+      column_type column;
+      operator_type op;
+      uint32_t value;
+    };
+
+  private:
+    std::vector<Condition> M_conditions;
+
+  public:
+    //! Add a condition. Returns a reference to this object, so calls can be chained.
+    TagQuery& where(column_type column, operator_type op, uint32_t value) { M_conditions.push_back({ column, op, value }); return *this; }
+
+    //! Return the list of conditions.
+    std::vector<Condition> const& conditions() const { return M_conditions; }
+
+    /** @brief Evaluate all conditions for the games [\a begin, \a begin + \a n) of \a tag_store.
+     *
+     * Upon return, \a match[i] is non-zero if game \a begin + i matches all conditions.
+     *
+     * @returns FALSE if no game in the range matched.
+     */
+    bool evaluate(TagStore const& tag_store, size_t begin, size_t n, uint8_t* match) const;
+};
+
+} // namespace pgn
+} // namespace cwchess
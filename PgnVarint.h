@@ -0,0 +1,76 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnVarint.h This file contains the varint encoder and decoder used by the binary pgn files.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+namespace cwchess {
+namespace pgn {
+
+//! The number of bytes needed for the largest varint.
+int const max_varint_size = 10;
+
+//! Append \a value to \a buf, seven bits per byte, least significant bits first.
+inline void put_varint(std::string& buf, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    buf += static_cast<char>(value | 0x80);
+    value >>= 7;
+  }
+  buf += static_cast<char>(value);
+}
+
+//! Write \a value to \a p, which must have room for max_varint_size bytes, and return the end of what was written.
+inline unsigned char* put_varint(unsigned char* p, uint64_t value)
+{
+  while (value >= 0x80)
+  {
+    *p++ = value | 0x80;
+    value >>= 7;
+  }
+  *p++ = value;
+  return p;
+}
+
+/** @brief Decode a varint from \a p and advance \a p past it.
+ *
+ * Returns FALSE if the varint does not end before \a end or is longer than max_varint_size bytes.
+ */
+inline bool get_varint(unsigned char const*& p, unsigned char const* end, uint64_t& value)
+{
+  value = 0;
+  for (int shift = 0; p < end && shift < 7 * max_varint_size; shift += 7)
+  {
+    unsigned char c = *p++;
+    value |= uint64_t(c & 0x7f) << shift;
+    if (!(c & 0x80))
+      return true;
+  }
+  return false;
+}
+
+} // namespace pgn
+} // namespace cwchess
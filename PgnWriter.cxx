@@ -0,0 +1,418 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnWriter.cxx This file contains the implementation of class pgn::Writer.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnWriter.h"
+#include "debug.h"
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <unistd.h>
+#include <glib.h>
+
+namespace cwchess {
+namespace pgn {
+
+namespace {
+
+// The SAN letter of each Type, indexed by its underlaying integral value.
+char const piece_letter[8] = { ' ', ' ', 'N', 'K', ' ', 'B', 'R', 'Q' };
+
+// Write value in decimal to p. Returns one past the last digit.
+char* put_number(char* p, unsigned int value)
+{
+  char digits[10];
+  int n = 0;
+  do
+  {
+    digits[n++] = '0' + value % 10;
+    value /= 10;
+  }
+  while (value);
+  while (n)
+    *p++ = digits[--n];
+  return p;
+}
+
+// Write value as exactly width decimal digits, or width question marks if value is zero.
+char* put_date_part(char* p, unsigned int value, int width)
+{
+  bool unknown = value == 0;
+  for (int i = width - 1; i >= 0; --i)
+  {
+    p[i] = unknown ? '?' : '0' + value % 10;
+    value /= 10;
+  }
+  return p + width;
+}
+
+// Return TRUE if the side to move has at least one legal move.
+bool has_legal_move(ChessPosition const& chess_position)
+{
+  for (PieceIterator piece_iter = chess_position.piece_begin(chess_position.to_move()); piece_iter != chess_position.piece_end(); ++piece_iter)
+    if (chess_position.moves(piece_iter.index()).test())
+      return true;
+  return false;
+}
+
+char const* const result_string[4] = { "*", "1-0", "0-1", "1/2-1/2" };
+
+} // namespace
+
+Writer::Writer(int fd, size_t buffer_size) :
+    M_fd(fd), M_buffer(new char[std::max(buffer_size, size_t(256))]), M_buffer_end(M_buffer + std::max(buffer_size, size_t(256))),
+    M_put(M_buffer), M_line_length(0), M_has_tags(false), M_in_movetext(false), M_need_move_number(true),
+    M_after_open_paren(false), M_crlf(false), M_error(false), M_bytes_written(0)
+{
+}
+
+Writer::~Writer()
+{
+  flush();
+  delete [] M_buffer;
+}
+
+bool Writer::write_all(iovec* iov, int iovcnt)
+{
+  while (iovcnt > 0)
+  {
+    ssize_t len = writev(M_fd, iov, std::min(iovcnt, IOV_MAX));
+    if (len == -1)
+    {
+      if (errno == EINTR)
+	continue;
+      Dout(dc::warning, "writev: " << std::strerror(errno));
+      M_error = true;
+      return false;
+    }
+    M_bytes_written += len;
+    // Skip everything that was written.
+    while (iovcnt > 0 && size_t(len) >= iov->iov_len)
+    {
+      len -= iov->iov_len;
+      ++iov;
+      --iovcnt;
+    }
+    if (iovcnt > 0)
+    {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + len;
+      iov->iov_len -= len;
+    }
+  }
+  return true;
+}
+
+bool Writer::flush()
+{
+  if (M_put != M_buffer)
+  {
+    iovec iov = { M_buffer, size_t(M_put - M_buffer) };
+    write_all(&iov, 1);
+    M_put = M_buffer;
+  }
+  return !M_error;
+}
+
+void Writer::overflow(char const* data, size_t length)
+{
+  size_t buffer_size = M_buffer_end - M_buffer;
+  if (length < buffer_size / 2)
+  {
+    // Fill the buffer, write it and buffer the rest.
+    size_t len = M_buffer_end - M_put;
+    std::memcpy(M_put, data, len);
+    M_put = M_buffer_end;
+    flush();
+    std::memcpy(M_put, data + len, length - len);
+    M_put += length - len;
+  }
+  else
+  {
+    // Write the buffer and data in one go, without copying data.
+    iovec iov[2] = { { M_buffer, size_t(M_put - M_buffer) }, { const_cast<char*>(data), length } };
+    write_all(iov, 2);
+    M_put = M_buffer;
+  }
+}
+
+void Writer::token(char const* data, size_t length)
+{
+  if (G_LIKELY(M_line_length > 0))
+  {
+    if (M_line_length + 1 + length > max_line_length)
+    {
+      newline();
+      M_line_length = 0;
+    }
+    else if (G_LIKELY(!M_after_open_paren))
+    {
+      put(' ');
+      ++M_line_length;
+    }
+  }
+  M_after_open_paren = false;
+  put(data, length);
+  M_line_length += length;
+}
+
+void Writer::tag(std::string_view name, std::string_view value)
+{
+  put('[');
+  put(name.data(), name.size());
+  put(" \"", 2);
+  // Escape quotes and backslashes.
+  char const* begin = value.data();
+  char const* const end = begin + value.size();
+  for (char const* p = begin; p != end; ++p)
+  {
+    if (G_UNLIKELY(*p == '"' || *p == '\\'))
+    {
+      put(begin, p - begin);
+      put('\\');
+      begin = p;
+    }
+  }
+  put(begin, end - begin);
+  put("\"]", 2);
+  newline();
+  M_has_tags = true;
+}
+
+void Writer::move(ChessPosition& chess_position, Move const& move)
+{
+  begin_movetext();
+  char buf[16];		// The longest move number is "65535..." and the longest move "Qa1xb2+".
+  char* p = buf;
+  Color const to_move(chess_position.to_move());
+  if (to_move == white || G_UNLIKELY(M_need_move_number))
+  {
+    p = put_number(p, chess_position.full_move_number());
+    *p++ = '.';
+    if (to_move == black)
+    {
+      *p++ = '.';
+      *p++ = '.';
+    }
+    token(buf, p - buf);
+    p = buf;
+    M_need_move_number = false;
+  }
+
+  Index const from(move.from());
+  Index const to(move.to());
+  Type const type(chess_position.piece_at(from).type());
+  int col_diff = to.col() - from.col();
+  if (G_UNLIKELY(type == king && (col_diff == 2 || col_diff == -2)))
+  {
+    std::memcpy(p, "O-O-O", 5);
+    p += (col_diff == 2) ? 3 : 5;
+  }
+  else
+  {
+    bool capture = chess_position.piece_at(to) != nothing || (type == pawn && col_diff != 0);
+    if (type == pawn)
+    {
+      if (capture)
+	*p++ = 'a' + from.col();
+    }
+    else
+    {
+      *p++ = piece_letter[type()];
+      // Find other pieces of the same type that can move to the same square.
+      bool ambiguous = false;
+      bool same_col = false;
+      bool same_row = false;
+      if (type != king)
+      {
+	for (PieceIterator piece_iter = chess_position.piece_begin(Code(to_move, type)); piece_iter != chess_position.piece_end(); ++piece_iter)
+	{
+	  Index index(piece_iter.index());
+	  if (index == from || !chess_position.candidates(index).test(to) || !chess_position.moves(index).test(to))
+	    continue;
+	  ambiguous = true;
+	  same_col |= index.col() == from.col();
+	  same_row |= index.row() == from.row();
+	}
+      }
+      if (G_UNLIKELY(ambiguous))
+      {
+	if (!same_col)
+	  *p++ = 'a' + from.col();
+	else if (!same_row)
+	  *p++ = '1' + from.row();
+	else
+	{
+	  *p++ = 'a' + from.col();
+	  *p++ = '1' + from.row();
+	}
+      }
+    }
+    if (capture)
+      *p++ = 'x';
+    *p++ = 'a' + to.col();
+    *p++ = '1' + to.row();
+    if (G_UNLIKELY(move.is_promotion()))
+    {
+      *p++ = '=';
+      *p++ = piece_letter[move.promotion_type()()];
+    }
+  }
+
+  chess_position.execute(move);
+  if (chess_position.check())
+    *p++ = has_legal_move(chess_position) ? '+' : '#';
+  token(buf, p - buf);
+}
+
+void Writer::comment(std::string_view text)
+{
+  begin_movetext();
+  // Write the comment word by word, so that it can be wrapped.
+  char const* p = text.data();
+  char const* const end = p + text.size();
+  bool first = true;
+  for (;;)
+  {
+    while (p != end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r'))
+      ++p;
+    char word[max_line_length];
+    size_t len = 0;
+    if (first)
+      word[len++] = '{';
+    while (p != end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r' && len < sizeof(word) - 1)
+    {
+      if (G_LIKELY(*p != '}'))
+	word[len++] = *p;
+      ++p;
+    }
+    if (p == end)
+      word[len++] = '}';
+    if (len > 0)
+      token(word, len);
+    if (p == end)
+      break;
+    first = false;
+  }
+  M_need_move_number = true;
+}
+
+void Writer::nag(unsigned int nag)
+{
+  begin_movetext();
+  char buf[12];
+  buf[0] = '$';
+  token(buf, put_number(buf + 1, nag) - buf);
+}
+
+void Writer::begin_variation()
+{
+  begin_movetext();
+  token("(", 1);
+  M_after_open_paren = true;
+  M_need_move_number = true;
+}
+
+void Writer::end_variation()
+{
+  // The closing parenthesis follows the last move of the variation without a space.
+  if (M_line_length + 1 > max_line_length)
+  {
+    newline();
+    M_line_length = 0;
+  }
+  put(')');
+  ++M_line_length;
+  M_after_open_paren = false;
+  M_need_move_number = true;
+}
+
+void Writer::result(TagStore::result_type result)
+{
+  begin_movetext();
+  char const* str = result_string[result];
+  token(str, std::strlen(str));
+  newline();
+  newline();
+  M_line_length = 0;
+  M_has_tags = false;
+  M_in_movetext = false;
+}
+
+void Writer::game(TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id)
+{
+  static std::string_view const unknown("?");
+  std::string const& event(tag_store.event(game_id));
+  std::string const& site(tag_store.site(game_id));
+  std::string const& white_player(tag_store.white(game_id));
+  std::string const& black_player(tag_store.black(game_id));
+  tag("Event", event.empty() ? unknown : std::string_view(event));
+  tag("Site", site.empty() ? unknown : std::string_view(site));
+  char buf[16];
+  uint32_t date = tag_store.date(game_id);
+  char* p = put_date_part(buf, date >> 9, 4);
+  *p++ = '.';
+  p = put_date_part(p, (date >> 5) & 15, 2);
+  *p++ = '.';
+  p = put_date_part(p, date & 31, 2);
+  tag("Date", std::string_view(buf, p - buf));
+  tag("Round", unknown);
+  tag("White", white_player.empty() ? unknown : std::string_view(white_player));
+  tag("Black", black_player.empty() ? unknown : std::string_view(black_player));
+  TagStore::result_type game_result = tag_store.result(game_id);
+  tag("Result", result_string[game_result]);
+  if (uint16_t eco = tag_store.eco(game_id))
+  {
+    buf[0] = 'A' + (eco - 1) / 100;
+    buf[1] = '0' + (eco - 1) % 100 / 10;
+    buf[2] = '0' + (eco - 1) % 10;
+    tag("ECO", std::string_view(buf, 3));
+  }
+  if (uint16_t elo = tag_store.white_elo(game_id))
+    tag("WhiteElo", std::string_view(buf, put_number(buf, elo) - buf));
+  if (uint16_t elo = tag_store.black_elo(game_id))
+    tag("BlackElo", std::string_view(buf, put_number(buf, elo) - buf));
+  if (std::string const* FEN = move_store.FEN(game_id))
+  {
+    tag("SetUp", "1");
+    tag("FEN", *FEN);
+  }
+  if (move_store.start_position(game_id, M_chess_position))
+  {
+    MoveStore::encoded_move_type const* moves = move_store.moves(game_id);
+    size_t number_of_moves = move_store.number_of_moves(game_id);
+    for (size_t ply = 0; ply < number_of_moves; ++ply)
+      move(M_chess_position, MoveStore::decode(moves[ply]));
+  }
+  result(game_result);
+}
+
+void Writer::raw(char const* data, size_t length)
+{
+  put(data, length);
+  M_line_length = 0;
+  M_has_tags = false;
+  M_in_movetext = false;
+}
+
+} // namespace pgn
+} // namespace cwchess
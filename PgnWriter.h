@@ -0,0 +1,208 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnWriter.h This file contains the declaration of class pgn::Writer.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ChessPosition.h"
+#include "PgnTagStore.h"
+#include "PgnMoveStore.h"
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <sys/uio.h>
+
+namespace cwchess {
+namespace pgn {
+
+/** @brief A streaming PGN writer.
+ *
+ * The writer formats tag pairs, move numbers, moves in Standard Algebraic Notation
+ * and comments directly into an output buffer that is allocated once,
+ * wrapping the movetext so that no line is longer than max_line_length characters.
+ * Whenever the buffer is full it is written to the file descriptor;
+ * data larger than the buffer is passed to writev together with the
+ * buffered data, without copying it.
+ *
+ * Usage example:
+ * \code
+ * pgn::Writer writer(fd);
+ * writer.tag("White", "Carlsen, Magnus");
+ * ...
+ * writer.move(chess_position, move);	// Also executes the move.
+ * writer.comment("The only move.");
+ * writer.result(pgn::TagStore::white_wins);
+ * writer.flush();
+ * \endcode
+ */
+class Writer {
+  public:
+    static size_t const default_buffer_size = 1024 * 1024;	//!< The default size of the output buffer.
+    static size_t const max_line_length = 79;			//!< The maximum length of a movetext line, excluding the new-line.
+
+  private:
+    int M_fd;					//!< The file descriptor that is written to.
+    char* M_buffer;				//!< The output buffer.
+    char* M_buffer_end;				//!< One past the end of the output buffer.
+    char* M_put;				//!< The position in M_buffer where the next character is written.
+    size_t M_line_length;			//!< The number of characters on the current movetext line.
+    bool M_has_tags;				//!< Set when a tag pair of the current game was written.
+    bool M_in_movetext;				//!< Set when the movetext of the current game was started.
+    bool M_need_move_number;			//!< Set when the next move needs a move number, even if it is Black's move.
+    bool M_after_open_paren;			//!< Set when the last token was the start of a variation.
+    bool M_crlf;				//!< Set when lines end in CR LF instead of LF.
+    bool M_error;				//!< Set when a write failed.
+    uint64_t M_bytes_written;			//!< The number of bytes passed to the file descriptor.
+    ChessPosition M_chess_position;		//!< Used by game() to replay the moves.
+
+  public:
+    /** @brief Construct a writer that writes to \a fd.
+     *
+     * The file descriptor is not closed by the writer.
+     */
+    Writer(int fd, size_t buffer_size = default_buffer_size);
+
+    //! Destructor. Flushes the buffer.
+    ~Writer();
+
+    Writer(Writer const&) = delete;
+    Writer& operator=(Writer const&) = delete;
+
+  /** @name Writing */
+  //@{
+
+    //! Write the tag pair [\a name "\a value"]. Quotes and backslashes in \a value are escaped.
+    void tag(std::string_view name, std::string_view value);
+
+    /** @brief Write \a move in SAN, preceded by a move number if needed, and execute it.
+     *
+     * \a chess_position must be the position before the move; upon return, \a move
+     * has been executed on it. \a move must be legal.
+     */
+    void move(ChessPosition& chess_position, Move const& move);
+
+    //! Write a comment. Closing braces in \a text are removed, since they can't be escaped.
+    void comment(std::string_view text);
+
+    //! Write the Numeric Annotation Glyph $\a nag.
+    void nag(unsigned int nag);
+
+    /** @brief Start a variation (RAV) on the last move.
+     *
+     * The moves of the variation are written with move() on a copy of the position before the last move.
+     * Variations may be nested.
+     */
+    void begin_variation();
+
+    //! End the variation that was started with begin_variation().
+    void end_variation();
+
+    //! Write the game termination marker and end the current game.
+    void result(TagStore::result_type result);
+
+    /** @brief Write the complete game \a game_id of a database.
+     *
+     * Writes the Seven Tag Roster (Round is not stored and written as "?"), the ECO code
+     * and the Elo ratings if known, the FEN and SetUp tags if the game doesn't start
+     * from the initial position, the main line and the result.
+     */
+    void game(TagStore const& tag_store, MoveStore const& move_store, uint32_t game_id);
+
+    //! Copy \a length bytes of \a data to the output verbatim, for example a game from another PGN file.
+    void raw(char const* data, size_t length);
+
+    //! End lines with CR LF instead of LF from now on.
+    void set_crlf(bool crlf) { M_crlf = crlf; }
+
+    /** @brief Write all buffered data to the file descriptor.
+     *
+     * @returns FALSE if any write failed so far.
+     */
+    bool flush();
+
+  //@}
+
+  /** @name Accessors */
+  //@{
+
+    //! Return TRUE if a write failed.
+    bool error() const { return M_error; }
+
+    //! Return the total number of bytes written, including the buffered bytes.
+    uint64_t bytes_written() const { return M_bytes_written + (M_put - M_buffer); }
+
+  //@}
+
+  private:
+    // Append length bytes to the buffer.
+    void put(char const* data, size_t length)
+    {
+      if (__builtin_expect(length <= size_t(M_buffer_end - M_put), true))
+      {
+	std::memcpy(M_put, data, length);
+	M_put += length;
+      }
+      else
+	overflow(data, length);
+    }
+
+    void put(char c)
+    {
+      if (__builtin_expect(M_put == M_buffer_end, false))
+	flush();
+      *M_put++ = c;
+    }
+
+    // Append the end of a line.
+    void newline()
+    {
+      if (__builtin_expect(M_crlf, false))
+	put('\r');
+      put('\n');
+    }
+
+    // Append a movetext token, preceded by a space or a new-line.
+    void token(char const* data, size_t length);
+
+    // Write the buffer and data.
+    void overflow(char const* data, size_t length);
+
+    // Write the iovec array iov to M_fd.
+    bool write_all(iovec* iov, int iovcnt);
+
+    // Start the movetext, if not already started.
+    void begin_movetext()
+    {
+      if (__builtin_expect(!M_in_movetext, false))
+      {
+	// The tag pair section is followed by an empty line.
+	if (M_has_tags)
+	  newline();
+	M_in_movetext = true;
+	M_need_move_number = true;
+      }
+    }
+};
+
+} // namespace pgn
+} // namespace cwchess
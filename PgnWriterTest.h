@@ -0,0 +1,285 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PgnWriterTest.h Testsuite header for class pgn::Writer.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnWriter.h"
+#include "TempFile.h"
+#include <cppunit/extensions/HelperMacros.h>
+#include <memory>
+#include <string>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class PgnWriterTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(PgnWriterTest);
+
+  CPPUNIT_TEST(testSAN);
+  CPPUNIT_TEST(testTagsAndComments);
+  CPPUNIT_TEST(testVariations);
+  CPPUNIT_TEST(testRoundTrip);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    std::unique_ptr<TempFile> M_file;		// An anonymous file to write to.
+
+  public:
+    PgnWriterTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testSAN();
+    void testTagsAndComments();
+    void testVariations();
+    void testRoundTrip();
+
+  private:
+    std::string contents();
+    std::string write_moves(char const* FEN, char const* moves);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "RandomGame.h"
+#include <random>
+#include <sstream>
+#include <cstdio>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PgnWriterTest);
+
+void PgnWriterTest::setUp()
+{
+  M_file.reset(new TempFile("PgnWriterTest"));
+  M_file->remove();
+}
+
+void PgnWriterTest::tearDown()
+{
+  M_file.reset();
+}
+
+// Return everything that was written to the file and truncate it.
+std::string PgnWriterTest::contents()
+{
+  std::string result;
+  char buf[4096];
+  ssize_t len;
+  lseek(M_file->fd(), 0, SEEK_SET);
+  while ((len = read(M_file->fd(), buf, sizeof(buf))) > 0)
+    result.append(buf, len);
+  CPPUNIT_ASSERT(ftruncate(M_file->fd(), 0) == 0);
+  lseek(M_file->fd(), 0, SEEK_SET);
+  return result;
+}
+
+// Write the moves (long algebraic, separated by spaces) from position FEN and return the output.
+std::string PgnWriterTest::write_moves(char const* FEN, char const* moves)
+{
+  ChessPosition chess_position;
+  if (FEN)
+    CPPUNIT_ASSERT(chess_position.load_FEN(FEN));
+  else
+    chess_position.initial_position();
+  {
+    pgn::Writer writer(M_file->fd(), 256);
+    std::istringstream is(moves);
+    std::string from_to;
+    while (is >> from_to)
+    {
+      Type promotion = nothing;
+      if (from_to.size() == 5)
+	promotion = from_to[4] == 'q' ? queen : from_to[4] == 'r' ? rook : from_to[4] == 'b' ? bishop : knight;
+      Move move(Index(from_to[0] - 'a', from_to[1] - '1'), Index(from_to[2] - 'a', from_to[3] - '1'), promotion);
+      CPPUNIT_ASSERT(chess_position.legal(move));
+      writer.move(chess_position, move);
+    }
+    writer.result(pgn::TagStore::result_unknown);
+  }
+  return contents();
+}
+
+void PgnWriterTest::testSAN()
+{
+  CPPUNIT_ASSERT(write_moves(NULL, "e2e4 e7e5 g1f3 b8c6 f1b5") == "1. e4 e5 2. Nf3 Nc6 3. Bb5 *\n\n");
+  CPPUNIT_ASSERT(write_moves(NULL, "e2e4 e7e5 f1c4 b8c6 d1h5 g8f6 h5f7") == "1. e4 e5 2. Bc4 Nc6 3. Qh5 Nf6 4. Qxf7# *\n\n");
+  CPPUNIT_ASSERT(write_moves("r3k2r/8/8/8/8/8/4K3/R6R w kq - 0 1", "a1d1") == "1. Rad1 *\n\n");
+  CPPUNIT_ASSERT(write_moves("4k3/R7/8/8/8/8/8/R3K3 w - - 0 1", "a1a4") == "1. R1a4 *\n\n");
+  CPPUNIT_ASSERT(write_moves("4k3/8/8/8/1Q3Q2/8/1Q6/4K3 w - - 0 1", "b4d2") == "1. Qb4d2 *\n\n");
+  CPPUNIT_ASSERT(write_moves("r3k2r/8/8/8/8/8/4K3/R6R b kq - 0 1", "e8g8 e2e3 a8d8") == "1... O-O 2. Ke3 Rad8 *\n\n");
+  CPPUNIT_ASSERT(write_moves("r3k3/8/8/8/8/8/8/4K3 b q - 0 40", "e8c8") == "40... O-O-O *\n\n");
+  CPPUNIT_ASSERT(write_moves("4k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7b8q") == "1. b8=Q+ *\n\n");
+  CPPUNIT_ASSERT(write_moves("2r1k3/1P6/8/8/8/8/8/4K3 w - - 0 1", "b7c8n") == "1. bxc8=N *\n\n");
+  CPPUNIT_ASSERT(write_moves("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1", "e5d6") == "1. exd6 *\n\n");
+  // A pinned piece doesn't need to be disambiguated.
+  CPPUNIT_ASSERT(write_moves("4k3/8/8/b7/8/2N3N1/8/4K3 w - - 0 1", "g3e2") == "1. Ne2 *\n\n");
+  // Long games are wrapped.
+  std::string text = write_moves(NULL,
+      "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8 "
+      "g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8 g1f3 g8f6 f3g1 f6g8");
+  CPPUNIT_ASSERT(text ==
+      "1. Nf3 Nf6 2. Ng1 Ng8 3. Nf3 Nf6 4. Ng1 Ng8 5. Nf3 Nf6 6. Ng1 Ng8 7. Nf3 Nf6 8.\n"
+      "Ng1 Ng8 9. Nf3 Nf6 10. Ng1 Ng8 11. Nf3 Nf6 12. Ng1 Ng8 13. Nf3 Nf6 14. Ng1 Ng8\n"
+      "15. Nf3 Nf6 16. Ng1 Ng8 *\n\n");
+}
+
+void PgnWriterTest::testTagsAndComments()
+{
+  ChessPosition chess_position;
+  chess_position.initial_position();
+  {
+    pgn::Writer writer(M_file->fd(), 256);
+    writer.tag("Event", "The \"big\" one\\");
+    writer.comment("A comment } before the first move.");
+    writer.move(chess_position, Move(Index(4, 1), Index(4, 3), nothing));
+    writer.comment("");
+    writer.move(chess_position, Move(Index(4, 6), Index(4, 4), nothing));
+    writer.result(pgn::TagStore::draw);
+    // More than half the buffer is written without copying it.
+    std::string raw(1000, 'x');
+    writer.raw(raw.data(), raw.size());
+    CPPUNIT_ASSERT(writer.flush() && writer.bytes_written() == 1090);
+  }
+  CPPUNIT_ASSERT(contents() ==
+      "[Event \"The \\\"big\\\" one\\\\\"]\n\n"
+      "{A comment before the first move.} 1. e4 {} 1... e5 1/2-1/2\n\n" + std::string(1000, 'x'));
+}
+
+void PgnWriterTest::testVariations()
+{
+  ChessPosition chess_position;
+  chess_position.initial_position();
+  {
+    pgn::Writer writer(M_file->fd(), 256);
+    writer.set_crlf(true);
+    writer.tag("Event", "?");
+    ChessPosition before(chess_position);
+    writer.move(chess_position, Move(Index(4, 1), Index(4, 3), nothing));
+    writer.nag(1);
+    writer.begin_variation();
+    writer.move(before, Move(Index(3, 1), Index(3, 3), nothing));
+    writer.comment("Also good.");
+    writer.end_variation();
+    writer.move(chess_position, Move(Index(4, 6), Index(4, 4), nothing));
+    writer.result(pgn::TagStore::result_unknown);
+  }
+  CPPUNIT_ASSERT(contents() == "[Event \"?\"]\r\n\r\n1. e4 $1 (1. d4 {Also good.}) 1... e5 *\r\n\r\n");
+}
+
+void PgnWriterTest::testRoundTrip()
+{
+  // Write random games, then parse the output back with ChessPosition::parse_SAN.
+  static char const* const players[] = { "Carlsen, Magnus", "Caruana, Fabiano", "Ding, Liren", "" };
+  std::mt19937 random_number_generator(1220638382);
+  pgn::TagStore tag_store;
+  pgn::MoveStore move_store;
+  ChessPosition chess_position;
+  for (int game = 0; game < 300; ++game)
+  {
+    tag_store.begin_game(0);
+    tag_store.add_tag("White", players[random_number_generator() % 4]);
+    tag_store.add_tag("Black", players[random_number_generator() % 4]);
+    tag_store.add_tag("Date", "2026.0" + std::to_string(1 + game % 9) + ".0" + std::to_string(1 + game % 7));
+    tag_store.add_tag("Result", game % 2 ? "1-0" : "1/2-1/2");
+    tag_store.add_tag("ECO", game % 3 ? "B33" : "");
+    move_store.begin_game();
+    if (game % 10 == 5)
+    {
+      tag_store.add_tag("FEN", "4k3/1P4P1/8/8/8/8/1p4p1/4K3 b - - 0 1");
+      move_store.set_FEN("4k3/1P4P1/8/8/8/8/1p4p1/4K3 b - - 0 1");
+      chess_position.load_FEN("4k3/1P4P1/8/8/8/8/1p4p1/4K3 b - - 0 1");
+    }
+    else
+      chess_position.initial_position();
+    random_game(random_number_generator, chess_position, move_store, random_number_generator() % 200);
+  }
+  {
+    pgn::Writer writer(M_file->fd(), 4096);
+    for (uint32_t game_id = 0; game_id < move_store.size(); ++game_id)
+      writer.game(tag_store, move_store, game_id);
+  }
+
+  std::istringstream is(contents());
+  pgn::TagStore read_tag_store;
+  std::vector<Move> moves;
+  std::string line;
+  uint32_t game_id = 0;
+  while (std::getline(is, line))
+  {
+    CPPUNIT_ASSERT(line.size() <= pgn::Writer::max_line_length);
+    if (line.empty())
+      continue;
+    if (line[0] == '[')
+    {
+      if (line.compare(0, 7, "[Event ") == 0)
+	read_tag_store.begin_game(0);
+      size_t space = line.find(' ');
+      read_tag_store.add_tag(line.substr(1, space - 1), line.substr(space + 2, line.size() - space - 4));
+      if (line.compare(0, 5, "[FEN ") == 0)
+	chess_position.load_FEN(line.substr(space + 2, line.size() - space - 4));
+      else if (line.compare(0, 7, "[Event ") == 0)
+	chess_position.initial_position();
+      continue;
+    }
+    // Movetext.
+    std::istringstream tokens(line);
+    std::string token;
+    while (tokens >> token)
+    {
+      if (token.back() == '.')
+	continue;
+      if (token == "1-0" || token == "1/2-1/2")
+      {
+	CPPUNIT_ASSERT(pgn::TagStore::parse_result(token) == tag_store.result(game_id));
+	++game_id;
+	moves.clear();
+	continue;
+      }
+      Move move;
+      CPPUNIT_ASSERT(chess_position.parse_SAN(token, move));
+      moves.push_back(move);
+      CPPUNIT_ASSERT(moves.size() <= move_store.number_of_moves(game_id));
+      CPPUNIT_ASSERT(pgn::MoveStore::encode(move) == move_store.moves(game_id)[moves.size() - 1]);
+      chess_position.execute(move);
+    }
+  }
+  CPPUNIT_ASSERT(game_id == move_store.size() && read_tag_store.size() == tag_store.size());
+  for (game_id = 0; game_id < tag_store.size(); ++game_id)
+  {
+    CPPUNIT_ASSERT(read_tag_store.white(game_id) == (tag_store.white(game_id).empty() ? "?" : tag_store.white(game_id)));
+    CPPUNIT_ASSERT(read_tag_store.date(game_id) == tag_store.date(game_id));
+    CPPUNIT_ASSERT(read_tag_store.eco(game_id) == tag_store.eco(game_id));
+  }
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,267 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PositionIndexTest.h Testsuite header for class pgn::PositionIndex.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnPositionIndex.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class PositionIndexTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(PositionIndexTest);
+
+  CPPUNIT_TEST(testPositionKey);
+  CPPUNIT_TEST(testMoveStore);
+  CPPUNIT_TEST(testBuildAndFind);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    pgn::MoveStore M_move_store;
+
+  public:
+    PositionIndexTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testPositionKey();
+    void testMoveStore();
+    void testBuildAndFind();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include "RandomGame.h"
+#include <map>
+#include <tuple>
+#include <random>
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(PositionIndexTest);
+
+void PositionIndexTest::setUp()
+{
+  // Three hundred random games with a fixed seed.
+  std::mt19937 random_number_generator(1220638382);
+  ChessPosition chess_position;
+  for (int game = 0; game < 300; ++game)
+  {
+    M_move_store.begin_game();
+    chess_position.initial_position();
+    random_game(random_number_generator, chess_position, M_move_store, random_number_generator() % 60);
+  }
+}
+
+void PositionIndexTest::tearDown()
+{
+  M_move_store.clear();
+}
+
+void PositionIndexTest::testPositionKey()
+{
+  ChessPosition chess_position1;
+  ChessPosition chess_position2;
+  chess_position1.initial_position();
+  chess_position2.load_FEN("rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+  CPPUNIT_ASSERT(position_key(chess_position1) == position_key(chess_position2));
+  // Transpositions lead to the same key; move counters don't matter.
+  chess_position1.execute(Move(Index(6, 0), Index(5, 2), nothing));	// Nf3
+  chess_position1.execute(Move(Index(6, 7), Index(5, 5), nothing));	// Nf6
+  chess_position1.execute(Move(Index(1, 0), Index(2, 2), nothing));	// Nc3
+  chess_position2.execute(Move(Index(1, 0), Index(2, 2), nothing));	// Nc3
+  chess_position2.execute(Move(Index(6, 7), Index(5, 5), nothing));	// Nf6
+  chess_position2.execute(Move(Index(6, 0), Index(5, 2), nothing));	// Nf3
+  CPPUNIT_ASSERT(position_key(chess_position1) == position_key(chess_position2));
+  // Whose turn it is, castling rights and en passant are part of the key.
+  ChessPosition chess_position3;
+  chess_position3.load_FEN("r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1");
+  position_key_t key = position_key(chess_position3);
+  chess_position3.load_FEN("r3k2r/8/8/8/8/8/8/R3K2R b KQkq - 0 1");
+  CPPUNIT_ASSERT(position_key(chess_position3) != key);
+  chess_position3.load_FEN("r3k2r/8/8/8/8/8/8/R3K2R w Kkq - 0 1");
+  CPPUNIT_ASSERT(position_key(chess_position3) != key);
+  chess_position3.load_FEN("4k3/8/8/3pP3/8/8/8/4K3 w - d6 0 1");
+  key = position_key(chess_position3);
+  chess_position3.load_FEN("4k3/8/8/3pP3/8/8/8/4K3 w - - 0 1");
+  CPPUNIT_ASSERT(position_key(chess_position3) != key);
+  // A double pawn push only changes the key when the pawn can actually be taken en passant.
+  chess_position1.initial_position();
+  chess_position1.execute(Move(Index(3, 1), Index(3, 3), nothing));	// d4
+  chess_position1.execute(Move(Index(6, 7), Index(5, 5), nothing));	// Nf6
+  chess_position1.execute(Move(Index(2, 1), Index(2, 3), nothing));	// c4
+  chess_position2.initial_position();
+  chess_position2.execute(Move(Index(2, 1), Index(2, 3), nothing));	// c4
+  chess_position2.execute(Move(Index(6, 7), Index(5, 5), nothing));	// Nf6
+  chess_position2.execute(Move(Index(3, 1), Index(3, 3), nothing));	// d4
+  CPPUNIT_ASSERT(position_key(chess_position1) == position_key(chess_position2));
+  chess_position3.load_FEN("rnbqkb1r/pppppppp/5n2/8/2PP4/8/PP2PPPP/RNBQKBNR b KQkq - 0 2");
+  CPPUNIT_ASSERT(position_key(chess_position1) == position_key(chess_position3));
+  // Nor when taking en passant would leave the king in check.
+  chess_position3.load_FEN("8/8/8/K2pP2r/8/8/8/4k3 w - d6 0 1");
+  key = position_key(chess_position3);
+  chess_position3.load_FEN("8/8/8/K2pP2r/8/8/8/4k3 w - - 0 1");
+  CPPUNIT_ASSERT(position_key(chess_position3) == key);
+}
+
+void PositionIndexTest::testMoveStore()
+{
+  CPPUNIT_ASSERT(M_move_store.size() == 300);
+  Move move(Index(0, 6), Index(1, 7), knight);
+  CPPUNIT_ASSERT(pgn::MoveStore::decode(pgn::MoveStore::encode(move)) == move);
+  CPPUNIT_ASSERT(pgn::MoveStore::encode(Move(Index(0, 0), Index(0, 0), nothing)) == pgn::MoveStore::no_move);
+  size_t total = 0;
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+    total += M_move_store.number_of_moves(game_id);
+  CPPUNIT_ASSERT(total == M_move_store.total_number_of_moves());
+}
+
+void PositionIndexTest::testBuildAndFind()
+{
+  typedef std::tuple<uint32_t, uint16_t, pgn::MoveStore::encoded_move_type> occurrence_type;
+
+  // Calculate the expected result the slow way.
+  std::map<position_key_t, std::vector<occurrence_type>> expected;
+  ChessPosition chess_position;
+  for (uint32_t game_id = 0; game_id < M_move_store.size(); ++game_id)
+  {
+    M_move_store.start_position(game_id, chess_position);
+    size_t number_of_moves = M_move_store.number_of_moves(game_id);
+    for (size_t ply = 0; ply <= number_of_moves; ++ply)
+    {
+      pgn::MoveStore::encoded_move_type continuation = (ply < number_of_moves) ? M_move_store.moves(game_id)[ply] : pgn::MoveStore::no_move;
+      expected[position_key(chess_position)].push_back(occurrence_type(game_id, ply, continuation));
+      if (ply < number_of_moves)
+	chess_position.execute(pgn::MoveStore::decode(continuation));
+    }
+  }
+
+  TempFile file("PositionIndexTest");
+  pgn::PositionIndex::BuildOptions options;
+  options.number_of_threads = 3;
+  options.memory_budget = 0;	// Force the use of many run files.
+  CPPUNIT_ASSERT(pgn::PositionIndex::build(M_move_store, file.filename(), options));
+
+  pgn::PositionIndex index;
+  CPPUNIT_ASSERT(!index.open("/nonexistent/index"));
+  CPPUNIT_ASSERT(index.open(file.filename()));
+
+  // Files with a corrupt key table must be rejected.
+  std::string data;
+  {
+    std::ifstream ifs(file.filename(), std::ios::binary);
+    data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+  file.remove();
+  uint64_t number_of_keys, postings_size;
+  std::memcpy(&number_of_keys, &data[8], sizeof(number_of_keys));
+  std::memcpy(&postings_size, &data[16], sizeof(postings_size));
+  CPPUNIT_ASSERT(number_of_keys == expected.size() && number_of_keys >= 2);
+  size_t const first_postings_offset = data.size() - 16 * number_of_keys + 8;
+  size_t const last_postings_offset = data.size() - 8;
+  {
+    // A postings list that runs past the end of the postings.
+    std::string corrupt(data);
+    uint64_t postings = postings_size + 1;
+    std::memcpy(&corrupt[last_postings_offset], &postings, sizeof(postings));
+    TempFile corrupt_file("PositionIndexTest", corrupt);
+    pgn::PositionIndex corrupt_index;
+    CPPUNIT_ASSERT(!corrupt_index.open(corrupt_file.filename()));
+  }
+  {
+    // Postings offsets that are not monotone.
+    std::string corrupt(data);
+    std::memcpy(&corrupt[first_postings_offset], &postings_size, sizeof(postings_size));
+    TempFile corrupt_file("PositionIndexTest", corrupt);
+    pgn::PositionIndex corrupt_index;
+    CPPUNIT_ASSERT(!corrupt_index.open(corrupt_file.filename()));
+  }
+  {
+    // A number of keys that only matches the file size modulo 2^64.
+    std::string corrupt(data);
+    uint64_t wrapping_number_of_keys = number_of_keys + (uint64_t(1) << 60);	// Times the 16 bytes of a key entry is a multiple of 2^64.
+    std::memcpy(&corrupt[8], &wrapping_number_of_keys, sizeof(wrapping_number_of_keys));
+    TempFile corrupt_file("PositionIndexTest", corrupt);
+    pgn::PositionIndex corrupt_index;
+    CPPUNIT_ASSERT(!corrupt_index.open(corrupt_file.filename()));
+  }
+  {
+    // A postings size so large that the offset of the key table wraps around.
+    std::string corrupt(data);
+    uint64_t wrapping_postings_size = ~uint64_t(0);
+    std::memcpy(&corrupt[16], &wrapping_postings_size, sizeof(wrapping_postings_size));
+    TempFile corrupt_file("PositionIndexTest", corrupt);
+    pgn::PositionIndex corrupt_index;
+    CPPUNIT_ASSERT(!corrupt_index.open(corrupt_file.filename()));
+  }
+  {
+    // A last varint that doesn't end inside the postings list drops the last hit, without reading past the list.
+    std::string corrupt(data);
+    corrupt[24 + postings_size - 1] |= 0x80;
+    TempFile corrupt_file("PositionIndexTest", corrupt);
+    pgn::PositionIndex corrupt_index;
+    CPPUNIT_ASSERT(corrupt_index.open(corrupt_file.filename()));
+    std::vector<pgn::PositionIndex::Hit> hits;
+    CPPUNIT_ASSERT(corrupt_index.find(expected.rbegin()->first, hits) == expected.rbegin()->second.size() - 1);
+  }
+
+  CPPUNIT_ASSERT(index.number_of_keys() == expected.size());
+  std::vector<pgn::PositionIndex::Hit> hits;
+  for (auto const& key_occurrences : expected)
+  {
+    hits.clear();
+    CPPUNIT_ASSERT(index.find(key_occurrences.first, hits) == key_occurrences.second.size());
+    for (size_t i = 0; i < hits.size(); ++i)
+      CPPUNIT_ASSERT(occurrence_type(hits[i].game_id, hits[i].ply, hits[i].continuation) == key_occurrences.second[i]);
+  }
+
+  // Every game starts from the initial position.
+  chess_position.initial_position();
+  hits.clear();
+  CPPUNIT_ASSERT(index.find(chess_position, hits) == M_move_store.size());
+  for (size_t i = 0; i < hits.size(); ++i)
+  {
+    CPPUNIT_ASSERT(hits[i].game_id == i && hits[i].ply == 0);
+    CPPUNIT_ASSERT(hits[i].has_continuation() == (M_move_store.number_of_moves(i) > 0));
+    CPPUNIT_ASSERT(!hits[i].has_continuation() || chess_position.legal(hits[i].move()));
+  }
+  chess_position.load_FEN("8/8/8/8/8/8/8/K6k w - - 0 1");
+  hits.clear();
+  CPPUNIT_ASSERT(index.find(chess_position, hits) == 0 && hits.empty());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,110 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PositionKey.cxx This file contains the implementation of function position_key.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PositionKey.h"
+#include "ChessPosition.h"
+
+namespace cwchess {
+
+namespace {
+
+// The random numbers used to calculate position keys.
+struct ZobristTable {
+  position_key_t M_piece[16][64];	// Indexed by Code and Index.
+  position_key_t M_castle[4];		// White short, white long, black short, black long.
+  position_key_t M_en_passant[8];	// Indexed by the column of the en passant square.
+  position_key_t M_white_to_move;
+
+  ZobristTable()
+  {
+    // splitmix64, with a fixed seed.
+    uint64_t state = 0x6377636865737321;
+    auto next = [&state]() {
+      uint64_t z = (state += 0x9e3779b97f4a7c15);
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+      return z ^ (z >> 31);
+    };
+    for (int code = 0; code < 16; ++code)
+      for (int index = 0; index < 64; ++index)
+	M_piece[code][index] = next();
+    for (int i = 0; i < 4; ++i)
+      M_castle[i] = next();
+    for (int col = 0; col < 8; ++col)
+      M_en_passant[col] = next();
+    M_white_to_move = next();
+  }
+};
+
+ZobristTable const zobrist_table;
+
+// Return TRUE if a pawn of the side to move can legally take en passant.
+// EnPassant::exists() is also true when no pawn stands next to the pawn that advanced two squares.
+bool can_take_en_passant(ChessPosition const& chess_position)
+{
+  EnPassant const& en_passant(chess_position.en_passant());
+  if (!en_passant.exists())
+    return false;
+  Index const pawn_index(en_passant.pawn_index());
+  Code const pawn_code(chess_position.to_move(), pawn);
+  for (int col = pawn_index.col() - 1; col <= pawn_index.col() + 1; col += 2)
+  {
+    if (col < 0 || col > 7)
+      continue;
+    Index const index(col, pawn_index.row());
+    if (chess_position.piece_at(index).code() == pawn_code && chess_position.moves(index).test(en_passant.index()))
+      return true;
+  }
+  return false;
+}
+
+} // namespace
+
+position_key_t position_key(ChessPosition const& chess_position)
+{
+  position_key_t key = 0;
+  mask_t pieces = chess_position.all(white)() | chess_position.all(black)();
+  while (pieces)
+  {
+    IndexData index = { static_cast<uint8_t>(__builtin_ctzll(pieces)) };
+    pieces &= pieces - 1;
+    key ^= zobrist_table.M_piece[chess_position.piece_at(index).code()()][index.M_bits];
+  }
+  CastleFlags const& castle_flags(chess_position.castle_flags());
+  if (castle_flags.can_castle_short(white))
+    key ^= zobrist_table.M_castle[0];
+  if (castle_flags.can_castle_long(white))
+    key ^= zobrist_table.M_castle[1];
+  if (castle_flags.can_castle_short(black))
+    key ^= zobrist_table.M_castle[2];
+  if (castle_flags.can_castle_long(black))
+    key ^= zobrist_table.M_castle[3];
+  if (can_take_en_passant(chess_position))
+    key ^= zobrist_table.M_en_passant[chess_position.en_passant().index().col()];
+  if (chess_position.to_move() == white)
+    key ^= zobrist_table.M_white_to_move;
+  return key;
+}
+
+} // namespace cwchess
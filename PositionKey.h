@@ -0,0 +1,48 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file PositionKey.h This file contains the declaration of function position_key.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <cstdint>
+
+namespace cwchess {
+
+class ChessPosition;
+
+//! The type of a position key.
+typedef uint64_t position_key_t;
+
+/** @brief Return a 64-bit Zobrist key of \a chess_position.
+ *
+ * The key depends on the placement of the pieces, whose turn it is,
+ * the castling rights and the en passant square (only if a pawn can
+ * actually take en passant), but not on the move counters.
+ * Two positions that are the same in the sense of the threefold
+ * repetition rule therefore have the same key.
+ *
+ * The random numbers are generated from a fixed seed, so keys are
+ * the same for every run and can be stored on disk.
+ */
+position_key_t position_key(ChessPosition const& chess_position);
+
+} // namespace cwchess
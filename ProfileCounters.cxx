@@ -0,0 +1,139 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file ProfileCounters.cxx This file contains the implementation of the hot path profile counters.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sys.h"
+#include "ProfileCounters.h"
+
+#ifdef CWCHESS_PROFILE_COUNTERS
+
+#include <iostream>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <pthread.h>
+
+namespace cwchess {
+namespace profile {
+
+thread_local ThreadCounters* tl_thread_counters;
+
+namespace {
+
+std::mutex registry_mutex;
+std::vector<ThreadCounters*> registry;		// The counters of all threads; they are never freed, so that
+						// the counters of threads that already exited are printed too.
+
+void dump_at_exit()
+{
+  dump(std::cerr);
+}
+
+// Return the minimum number of cycles between two reads of the time stamp counter.
+uint64_t overhead()
+{
+  uint64_t result = ~uint64_t(0);
+  for (int i = 0; i < 1000; ++i)
+  {
+    uint64_t start = __rdtsc();
+    uint64_t cycles = __rdtsc() - start;
+    if (cycles < result)
+      result = cycles;
+  }
+  return result;
+}
+
+// Return the upper bound of the bucket that contains fraction of the calls.
+uint64_t percentile(Counter const& counter, uint64_t calls, double fraction)
+{
+  uint64_t count = 0;
+  for (int bucket = 0; bucket < number_of_buckets; ++bucket)
+  {
+    count += counter.histogram[bucket].load(std::memory_order_relaxed);
+    if (count >= fraction * calls)
+      return uint64_t(2) << bucket;
+  }
+  return uint64_t(2) << (number_of_buckets - 1);
+}
+
+} // namespace
+
+char const* name(counter_type counter)
+{
+  static char const* const names[number_of_counters] = {
+    "ChessPosition::place",
+    "ChessPosition::update_pinning",
+    "ChessPosition::update_blocked_defendables",
+    "ChessPosition::update_removed",
+    "ChessPosition::update_placed",
+    "CountBoard::add",
+    "CountBoard::sub"
+  };
+  return names[counter];
+}
+
+ThreadCounters* register_thread()
+{
+  ThreadCounters* thread_counters = new ThreadCounters();
+  if (pthread_getname_np(pthread_self(), thread_counters->name, sizeof(thread_counters->name)) != 0)
+    thread_counters->name[0] = 0;
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  if (registry.empty())
+    std::atexit(dump_at_exit);
+  thread_counters->number = registry.size() + 1;
+  registry.push_back(thread_counters);
+  tl_thread_counters = thread_counters;
+  return thread_counters;
+}
+
+void dump(std::ostream& os)
+{
+  std::lock_guard<std::mutex> lock(registry_mutex);
+  uint64_t const measurement_overhead = overhead();
+  for (ThreadCounters const* thread_counters : registry)
+  {
+    os << "Profile counters of thread " << thread_counters->number << " \"" << thread_counters->name <<
+        "\" (cycles are inclusive; one measurement costs about " << measurement_overhead << " cycles):\n";
+    os << "  " << std::left << std::setw(42) << "function" << std::right << std::setw(12) << "calls" << std::setw(16) << "cycles" <<
+        std::setw(12) << "cycles/call" << std::setw(8) << "p50 <" << std::setw(8) << "p90 <" << std::setw(8) << "p99 <" << '\n';
+    for (int counter = 0; counter < number_of_counters; ++counter)
+    {
+      Counter const& c(thread_counters->counters[counter]);
+      uint64_t calls = c.calls.load(std::memory_order_relaxed);
+      if (calls == 0)
+	continue;
+      uint64_t cycles = c.cycles.load(std::memory_order_relaxed);
+      os << "  " << std::left << std::setw(42) << name(counter_type(counter)) << std::right << std::setw(12) << calls << std::setw(16) << cycles <<
+          std::setw(12) << std::fixed << std::setprecision(1) << double(cycles) / calls <<
+	  std::setw(8) << percentile(c, calls, 0.5) << std::setw(8) << percentile(c, calls, 0.9) << std::setw(8) << percentile(c, calls, 0.99) << '\n';
+    }
+  }
+  os.flush();
+}
+
+} // namespace profile
+} // namespace cwchess
+
+#endif // CWCHESS_PROFILE_COUNTERS
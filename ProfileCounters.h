@@ -0,0 +1,130 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file ProfileCounters.h This file contains the declaration of the hot path profile counters.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+/*
+ * Call counters and cycle histograms of the incremental updates of ChessPosition.
+ *
+ * The counters are only compiled in when CWCHESS_PROFILE_COUNTERS is defined
+ * (configure --enable-profile-counters, or cmake -DOptionEnableProfileCounters=ON);
+ * otherwise CWCHESS_PROFILE expands to nothing. Unlike the debug channels dc::place
+ * and dc::countboard, which turn every call into text output, a measurement costs
+ * two reads of the time stamp counter and a few additions to counters of the calling
+ * thread, so that the relative cost of the updates can be measured on real workloads.
+ *
+ * Each thread has its own counters; they are printed as a table per thread
+ * to std::cerr when the program exits, or when profile::dump is called.
+ * The cycles are inclusive: the cycles of place() include those of the updates that it calls.
+ */
+
+#ifdef CWCHESS_PROFILE_COUNTERS
+
+#include <atomic>
+#include <cstdint>
+#include <iosfwd>
+#include <x86intrin.h>
+
+namespace cwchess {
+namespace profile {
+
+//! The measured functions.
+enum counter_type {
+  place,
+  update_pinning,
+  update_blocked_defendables,
+  update_removed,
+  update_placed,
+  countboard_add,
+  countboard_sub,
+  number_of_counters
+};
+
+//! The number of buckets of a cycle histogram; bucket b counts the calls that took [2^b, 2^(b+1)) cycles.
+int const number_of_buckets = 32;
+
+//! The counters of one function in one thread. Only the owning thread writes them.
+struct Counter {
+  std::atomic<uint64_t> calls;
+  std::atomic<uint64_t> cycles;
+  std::atomic<uint64_t> histogram[number_of_buckets];
+};
+
+//! The counters of one thread.
+struct ThreadCounters {
+  Counter counters[number_of_counters];
+  char name[16];		//!< The name of the thread, as set with pthread_setname_np.
+  int number;			//!< The threads are numbered in the order in which they first recorded something.
+};
+
+// The counters of the current thread, or NULL if it didn't record anything yet.
+extern thread_local ThreadCounters* tl_thread_counters;
+
+// Allocate and register the counters of the current thread.
+ThreadCounters* register_thread();
+
+//! Add one call of \a counter that took \a cycles cycles.
+inline void record(counter_type counter, uint64_t cycles)
+{
+  ThreadCounters* thread_counters = tl_thread_counters;
+  if (__builtin_expect(!thread_counters, false))
+    thread_counters = register_thread();
+  Counter& c(thread_counters->counters[counter]);
+  int bucket = 63 - __builtin_clzll(cycles | 1);
+  if (bucket >= number_of_buckets)
+    bucket = number_of_buckets - 1;
+  // Only this thread writes, so there is no need for a read-modify-write.
+  c.calls.store(c.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+  c.cycles.store(c.cycles.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+  c.histogram[bucket].store(c.histogram[bucket].load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+//! Measures the cycles from construction till destruction.
+class Scope {
+  private:
+    counter_type M_counter;
+    uint64_t M_start;
+
+  public:
+    Scope(counter_type counter) : M_counter(counter), M_start(__rdtsc()) { }
+    ~Scope() { record(M_counter, __rdtsc() - M_start); }
+};
+
+//! Print the counters of all threads to \a os.
+void dump(std::ostream& os);
+
+//! Return the name of \a counter.
+char const* name(counter_type counter);
+
+} // namespace profile
+} // namespace cwchess
+
+//! Measure the rest of the current scope as one call of profile::\a counter.
+#define CWCHESS_PROFILE(counter) ::cwchess::profile::Scope cwchess_profile_scope(::cwchess::profile::counter)
+
+#else // CWCHESS_PROFILE_COUNTERS
+
+#define CWCHESS_PROFILE(counter) do { } while(0)
+
+#endif // CWCHESS_PROFILE_COUNTERS
@@ -0,0 +1,76 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file RandomGame.h Random games for the testsuite.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "ChessPosition.h"
+#include "PieceIterator.h"
+#include "MoveIterator.h"
+#include "PgnMoveStore.h"
+#include <random>
+#include <vector>
+#include <algorithm>
+#include <limits>
+
+namespace testsuite {
+
+/** @brief Play random legal moves from \a chess_position.
+ *
+ * Plays up to \a max_plies moves, or until there is no legal move left.
+ * Each move is chosen from the first \a max_choices legal moves, in the order
+ * of the move generator; a small value makes games share their openings.
+ * After executing a move, \a executed(move) is called.
+ *
+ * @returns The number of moves played.
+ */
+template<typename Executed>
+int random_game(std::mt19937& random_number_generator, cwchess::ChessPosition& chess_position, int max_plies, size_t max_choices, Executed executed)
+{
+  using namespace cwchess;
+  std::vector<Move> moves;
+  MoveIterator const move_end;
+  int ply = 0;
+  for (; ply < max_plies; ++ply)
+  {
+    moves.clear();
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+	moves.push_back(*move_iter);
+    if (moves.empty())
+      break;
+    Move move(moves[random_number_generator() % std::min(moves.size(), max_choices)]);
+    chess_position.execute(move);
+    executed(move);
+  }
+  return ply;
+}
+
+//! @brief Play random legal moves from \a chess_position and add them to the last game of \a move_store.
+inline int random_game(std::mt19937& random_number_generator, cwchess::ChessPosition& chess_position, cwchess::pgn::MoveStore& move_store,
+    int max_plies, size_t max_choices = std::numeric_limits<size_t>::max())
+{
+  return random_game(random_number_generator, chess_position, max_plies, max_choices,
+      [&move_store](cwchess::Move const& move) { move_store.add(move); });
+}
+
+} // namespace testsuite
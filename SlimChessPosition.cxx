@@ -0,0 +1,190 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file SlimChessPosition.cxx This file contains the implementation of class SlimChessPosition.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "SlimChessPosition.h"
+#include <cstring>
+
+namespace cwchess {
+
+namespace {
+
+ChessPosition initial_chess_position()
+{
+  ChessPosition chess_position;
+  chess_position.initial_position();
+  return chess_position;
+}
+
+int const knight_offsets[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+int const king_offsets[8][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, -1 }, { -1, 0 }, { -1, 1 } };
+
+} // namespace
+
+SlimChessPosition::SlimChessPosition() : SlimChessPosition(initial_chess_position())
+{
+}
+
+void SlimChessPosition::assign(ChessPosition const& chess_position)
+{
+  std::memset(M_codes, 0, sizeof(M_codes));
+  for (Index index = index_begin; index != index_end; ++index)
+    M_codes[index() >> 1] |= chess_position.piece_at(index).code()() << ((index() & 1) << 2);
+  M_full_move_number = chess_position.full_move_number();
+  M_half_move_clock = chess_position.half_move_clock();
+  M_to_move = chess_position.to_move();
+  M_en_passant = chess_position.en_passant();
+}
+
+void SlimChessPosition::expand(ChessPosition& chess_position) const
+{
+  // This does the same as ChessPosition::load_FEN.
+  chess_position.clear();
+  for (Index index = index_begin; index != index_end; ++index)
+  {
+    Code code(code_at(index));
+    if (!code.is_nothing())
+      chess_position.place(code, index);
+  }
+  chess_position.M_to_move = M_to_move;
+  bool in_check = chess_position.check();
+  chess_position.M_double_check = in_check ? chess_position.double_check(M_to_move) : false;
+  chess_position.M_castle_flags = M_castle_flags;
+  chess_position.M_castle_flags.set_check(M_to_move, in_check);
+  if (M_en_passant.exists())
+    chess_position.set_en_passant(M_en_passant.index());
+  chess_position.M_half_move_clock = M_half_move_clock;
+  chess_position.M_full_move_number = M_full_move_number;
+}
+
+Piece SlimChessPosition::piece_at(Index const& index) const
+{
+  Code code(code_at(index));
+  Flags flags(fl_none);
+  if (code.is_a(pawn))
+  {
+    // See ChessPosition::place for how these flags are maintained.
+    int col = index.col();
+    int row = index.row();
+    Color color(code.color());
+    int forward = (color == white) ? 1 : -1;
+    int next_row = row + forward;
+    if (code_at(Index(col, next_row)).is_nothing())
+    {
+      flags.set(fl_pawn_is_not_blocked);
+      if (row == ((color == white) ? 1 : 6) && code_at(Index(col, next_row + forward)).is_nothing())
+	flags.set(fl_pawn_can_move_two_squares);
+    }
+    for (int side = -1; side <= 1; side += 2)
+    {
+      if (col + side < 0 || col + side > 7)
+        continue;
+      Index target(col + side, next_row);
+      Code target_code(code_at(target));
+      if ((!target_code.is_nothing() && target_code.color() != color) ||
+	  (color == M_to_move && M_en_passant.exists() && M_en_passant.index() == target))
+	flags.set(side < 0 ? fl_pawn_can_take_queen_side : fl_pawn_can_take_king_side);
+    }
+  }
+  return Piece(code, flags);
+}
+
+BitBoard SlimChessPosition::all(Code const& code) const
+{
+  BitBoard result;
+  result.reset();
+  for (Index index = index_begin; index != index_end; ++index)
+    if (code_at(index) == code)
+      result.set(index);
+  return result;
+}
+
+BitBoard SlimChessPosition::all(Color const& color) const
+{
+  BitBoard result;
+  result.reset();
+  for (Index index = index_begin; index != index_end; ++index)
+  {
+    Code code(code_at(index));
+    if (!code.is_nothing() && code.color() == color)
+      result.set(index);
+  }
+  return result;
+}
+
+Index SlimChessPosition::index_of_king(Color const& color) const
+{
+  Code king_code(color, king);
+  for (Index index = index_begin; index != index_end; ++index)
+    if (code_at(index) == king_code)
+      return index;
+  return index_end;
+}
+
+bool SlimChessPosition::check(Color const& color) const
+{
+  Index king_index(index_of_king(color));
+  return king_index != index_end && attacked(king_index, color.opposite());
+}
+
+bool SlimChessPosition::attacked(Index const& index, Color const& color) const
+{
+  int col = index.col();
+  int row = index.row();
+  // Pawns.
+  int pawn_row = row - ((color == white) ? 1 : -1);
+  if (pawn_row >= 0 && pawn_row <= 7)
+    for (int side = -1; side <= 1; side += 2)
+      if (col + side >= 0 && col + side <= 7 && code_at(Index(col + side, pawn_row)) == Code(color, pawn))
+        return true;
+  // Knights and king.
+  for (int i = 0; i < 8; ++i)
+  {
+    int c = col + knight_offsets[i][0];
+    int r = row + knight_offsets[i][1];
+    if (c >= 0 && c <= 7 && r >= 0 && r <= 7 && code_at(Index(c, r)) == Code(color, knight))
+      return true;
+    c = col + king_offsets[i][0];
+    r = row + king_offsets[i][1];
+    if (c >= 0 && c <= 7 && r >= 0 && r <= 7 && code_at(Index(c, r)) == Code(color, king))
+      return true;
+  }
+  // Sliders; the even directions are those of a rook.
+  for (int i = 0; i < 8; ++i)
+  {
+    Code slider(color, (i & 1) ? bishop : rook);
+    for (int c = col + king_offsets[i][0], r = row + king_offsets[i][1]; c >= 0 && c <= 7 && r >= 0 && r <= 7;
+        c += king_offsets[i][0], r += king_offsets[i][1])
+    {
+      Code code(code_at(Index(c, r)));
+      if (code.is_nothing())
+        continue;
+      if (code == slider || code == Code(color, queen))
+        return true;
+      break;
+    }
+  }
+  return false;
+}
+
+} // namespace cwchess
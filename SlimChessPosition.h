@@ -0,0 +1,159 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file SlimChessPosition.h This file contains the declaration of class SlimChessPosition.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "ChessPosition.h"
+#include <string>
+#include <string_view>
+
+namespace cwchess {
+
+/** @brief A compact chess position.
+ *
+ * A ChessPosition keeps bitboards for every piece, the pieces with their flags
+ * and the attack data up to date with every move, which makes it almost 400 bytes.
+ * This class only stores the placement of the pieces (four bits per square), the
+ * castling and en passant state and the move counters; 38 bytes in total. That makes
+ * it suitable for holding many positions at once, like search stacks, game caches or
+ * the history of a widget.
+ *
+ * The read-only queries of ChessPosition are available with the same names.
+ * The accessors are calculated directly from the stored placement, as is check().
+ * Everything that needs the attack data (moves, legal, parse_SAN, ...) sets up a
+ * full ChessPosition first; call position() once when doing more than one such query.
+ *
+ * @sa ChessPosition
+ */
+class SlimChessPosition {
+  private:
+    uint8_t M_codes[32];				//!< The Code of the piece on each square; the lower four bits for an even Index.
+    uint16_t M_full_move_number;			//!< The number of the full move.
+    uint8_t M_half_move_clock;				//!< Number of half moves since the last pawn advance or capture.
+    CastleFlags M_castle_flags;				//!< Whether black and white may castle long or short.
+    Color M_to_move;					//!< The active color.
+    EnPassant M_en_passant;				//!< A pawn that can be taken en passant, or zeroed if none such pawn exists.
+
+  public:
+
+  /** @name Constructors */
+  //@{
+
+    //! @brief Construct the initial position.
+    SlimChessPosition();
+
+    //! @brief Construct a compact copy of \a chess_position.
+    explicit SlimChessPosition(ChessPosition const& chess_position) : M_castle_flags(chess_position.castle_flags()) { assign(chess_position); }
+
+    //! @brief Assign a compact copy of \a chess_position.
+    SlimChessPosition& operator=(ChessPosition const& chess_position) { M_castle_flags = chess_position.castle_flags(); assign(chess_position); return *this; }
+
+  //@}
+
+  /** @name Conversion */
+  //@{
+
+    /** @brief Set up \a chess_position as the position that this object represents.
+     *
+     * This places every piece on an empty board, about as expensive as ChessPosition::load_FEN.
+     */
+    void expand(ChessPosition& chess_position) const;
+
+    //! @brief Return the full ChessPosition.
+    ChessPosition position() const { ChessPosition chess_position; expand(chess_position); return chess_position; }
+
+  //@}
+
+  /** @name Accessors */
+  //@{
+
+    //! @brief Return the Code of the piece on the square \a index.
+    Code code_at(Index const& index) const { CodeData data = { static_cast<uint8_t>((M_codes[index() >> 1] >> ((index() & 1) << 2)) & 15) }; return data; }
+
+    //! @brief Return the Piece on the square \a index, with the same flags as ChessPosition::piece_at.
+    Piece piece_at(Index const& index) const;
+
+    //! @brief Return the Piece on the square \a col, \a row.
+    Piece piece_at(int col, int row) const { return piece_at(Index(col, row)); }
+
+    //! @brief Return whose turn it is.
+    Color to_move() const { return M_to_move; }
+
+    //! @brief Return the number of half moves since the last pawn advance or capture.
+    unsigned int half_move_clock() const { return M_half_move_clock; }
+
+    //! @brief Return the number of the full move.
+    unsigned int full_move_number() const { return M_full_move_number; }
+
+    //! @brief Return the castle flags object.
+    CastleFlags const& castle_flags() const { return M_castle_flags; }
+
+    //! @brief Return the en passant object.
+    EnPassant const& en_passant() const { return M_en_passant; }
+
+    //! @brief Return a BitBoard with bits set for each square that is occupied by a piece with Code \a code.
+    BitBoard all(Code const& code) const;
+
+    //! @brief Return a BitBoard with bits set for each square that is occupied by a piece of color \a color.
+    BitBoard all(Color const& color) const;
+
+    //! @brief Return the index of the king with color \a color, or index_end if there is none.
+    Index index_of_king(Color const& color) const;
+
+  //@}
+
+  /** @name Visitors */
+  //@{
+
+    //! @brief Return the FEN code for this position.
+    std::string FEN() const { return position().FEN(); }
+
+    //! @brief Return true if the king of the color to move is in check.
+    bool check() const { return check(M_to_move); }
+
+    //! @brief Return true if the king of color \a color is in check.
+    bool check(Color const& color) const;
+
+    //! @brief Return true if the king of color \a color is in double check.
+    bool double_check(Color const& color) const { return position().double_check(color); }
+
+    //! @brief Return a BitBoard with bits set for each square the piece at \a index can legally go to.
+    BitBoard moves(Index const& index) const { return position().moves(index); }
+
+    //! @brief Return TRUE if \a move is a legal move.
+    bool legal(Move const& move) const { return position().legal(move); }
+
+    //! @brief Parse the move in Standard Algebraic Notation \a SAN; see ChessPosition::parse_SAN.
+    bool parse_SAN(std::string_view SAN, Move& move) const { return position().parse_SAN(SAN, move); }
+
+  //@}
+
+  private:
+    void assign(ChessPosition const& chess_position);
+
+    // Return TRUE if the square at \a index is attacked by a piece of color \a color.
+    bool attacked(Index const& index, Color const& color) const;
+};
+
+} // namespace cwchess
@@ -0,0 +1,141 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file SlimChessPositionTest.h Testsuite for cwchess::SlimChessPosition.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include "SlimChessPosition.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class SlimChessPositionTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(SlimChessPositionTest);
+
+  CPPUNIT_TEST(testSize);
+  CPPUNIT_TEST(testRoundTrip);
+  CPPUNIT_TEST(testQueries);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    SlimChessPositionTest() { }
+
+    void testSize();
+    void testRoundTrip();
+    void testQueries();
+
+  private:
+    void compare(ChessPosition const& chess_position);
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "RandomGame.h"
+#include <random>
+#include <vector>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SlimChessPositionTest);
+
+void SlimChessPositionTest::compare(ChessPosition const& chess_position)
+{
+  SlimChessPosition slim_chess_position(chess_position);
+  CPPUNIT_ASSERT(slim_chess_position.FEN() == chess_position.FEN());
+  CPPUNIT_ASSERT(slim_chess_position.to_move() == chess_position.to_move());
+  CPPUNIT_ASSERT(slim_chess_position.check() == chess_position.check());
+  for (Index index = index_begin; index != index_end; ++index)
+  {
+    Piece piece(slim_chess_position.piece_at(index));
+    CPPUNIT_ASSERT(piece.code() == chess_position.piece_at(index).code());
+    CPPUNIT_ASSERT(piece.flags()() == chess_position.piece_at(index).flags()());
+  }
+  for (Color color : { Color(white), Color(black) })
+  {
+    CPPUNIT_ASSERT(slim_chess_position.all(color) == chess_position.all(color));
+    CPPUNIT_ASSERT(slim_chess_position.index_of_king(color) == chess_position.index_of_king(color));
+    for (Type type : { Type(pawn), Type(knight), Type(bishop), Type(rook), Type(queen), Type(king) })
+      CPPUNIT_ASSERT(slim_chess_position.all(Code(color, type)) == chess_position.all(Code(color, type)));
+  }
+  // The expanded position has the same incremental state as the original.
+  ChessPosition expanded(slim_chess_position.position());
+  std::string difference;
+  CPPUNIT_ASSERT(expanded.verify_incremental_state(difference));
+  CPPUNIT_ASSERT(expanded.FEN() == chess_position.FEN() && expanded.en_passant().pinned() == chess_position.en_passant().pinned());
+}
+
+void SlimChessPositionTest::testSize()
+{
+  CPPUNIT_ASSERT(sizeof(SlimChessPosition) <= 40);
+  SlimChessPosition slim_chess_position;
+  CPPUNIT_ASSERT(slim_chess_position.FEN() == "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1");
+}
+
+void SlimChessPositionTest::testRoundTrip()
+{
+  ChessPosition chess_position;
+  for (char const* FEN : { "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+                           "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+                           "8/8/8/K7/1R2PpPk/8/8/8 b - e3 0 2",
+                           "4k3/8/8/8/8/8/8/4K3 b - - 12 60" })
+  {
+    CPPUNIT_ASSERT(chess_position.load_FEN(FEN));
+    compare(chess_position);
+  }
+  std::mt19937 random_number_generator(1220638382);
+  for (int game = 0; game < 10; ++game)
+  {
+    chess_position.initial_position();
+    compare(chess_position);
+    random_game(random_number_generator, chess_position, 150, std::numeric_limits<size_t>::max(),
+	[&](Move const&) { compare(chess_position); });
+  }
+}
+
+void SlimChessPositionTest::testQueries()
+{
+  ChessPosition chess_position;
+  chess_position.load_FEN("r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1");
+  SlimChessPosition slim_chess_position(chess_position);
+  for (PieceIterator piece_iter(chess_position.piece_begin(white)); piece_iter != chess_position.piece_end(); ++piece_iter)
+    CPPUNIT_ASSERT(slim_chess_position.moves(piece_iter.index()) == chess_position.moves(piece_iter.index()));
+  Move move;
+  // White is in check by the bishop on b6.
+  CPPUNIT_ASSERT(slim_chess_position.check() && chess_position.check());
+  CPPUNIT_ASSERT(slim_chess_position.parse_SAN("Bc5", move) && slim_chess_position.legal(move));
+  CPPUNIT_ASSERT(!slim_chess_position.parse_SAN("Nxf7", move));
+  CPPUNIT_ASSERT(slim_chess_position.double_check(white) == chess_position.double_check(white));
+  // Assignment replaces everything.
+  chess_position.initial_position();
+  slim_chess_position = chess_position;
+  CPPUNIT_ASSERT(slim_chess_position.FEN() == chess_position.FEN());
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,242 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file TagStoreTest.h Testsuite header for class pgn::TagStore.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "PgnTagStore.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+using namespace cwchess;
+
+class TagStoreTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TagStoreTest);
+
+  CPPUNIT_TEST(testStringPool);
+  CPPUNIT_TEST(testParsing);
+  CPPUNIT_TEST(testAddTag);
+  CPPUNIT_TEST(testQuery);
+  CPPUNIT_TEST(testSaveLoad);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  private:
+    pgn::TagStore M_tag_store;
+
+  public:
+    TagStoreTest() { }
+
+    void setUp();
+    void tearDown();
+
+    void testStringPool();
+    void testParsing();
+    void testAddTag();
+    void testQuery();
+    void testSaveLoad();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+#include "TempFile.h"
+#include <fstream>
+#include <iterator>
+#include <cstdio>
+#include <cstring>
+#include <unistd.h>
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TagStoreTest);
+
+void TagStoreTest::setUp()
+{
+  using pgn::TagStore;
+  // Ten thousand games, so that the queries need more than one chunk.
+  for (int i = 0; i < 10000; ++i)
+  {
+    M_tag_store.begin_game(100 * i);
+    M_tag_store.add_tag("Event", (i % 2) ? "Odd Open" : "Even Open");
+    M_tag_store.add_tag("White", (i % 3 == 0) ? "Carlsen, Magnus" : "Anand, Viswanathan");
+    M_tag_store.add_tag("Black", (i % 3 == 1) ? "Carlsen, Magnus" : "Kramnik, Vladimir");
+    M_tag_store.add_tag("Date", (i < 5000) ? "2019.12.31" : "2020.??.??");
+    M_tag_store.add_tag("Result", (i % 4 == 0) ? "1-0" : (i % 4 == 1) ? "0-1" : (i % 4 == 2) ? "1/2-1/2" : "*");
+    M_tag_store.add_tag("WhiteElo", std::to_string(2000 + i % 1000));
+    M_tag_store.add_tag("Annotator", "ignored");
+  }
+}
+
+void TagStoreTest::tearDown()
+{
+  M_tag_store.clear();
+}
+
+void TagStoreTest::testStringPool()
+{
+  pgn::StringPool pool;
+  CPPUNIT_ASSERT(pool.size() == 1);
+  CPPUNIT_ASSERT(pool.find("") == 0);
+  CPPUNIT_ASSERT(pool.find("a") == pgn::StringPool::npos);
+  uint32_t a = pool.intern("a");
+  uint32_t b = pool.intern("b");
+  CPPUNIT_ASSERT(a == 1 && b == 2);
+  CPPUNIT_ASSERT(pool.intern("a") == a);
+  CPPUNIT_ASSERT(pool.find("b") == b);
+  CPPUNIT_ASSERT(pool[b] == "b");
+  pool.clear();
+  CPPUNIT_ASSERT(pool.size() == 1);
+  CPPUNIT_ASSERT(pool.find("a") == pgn::StringPool::npos);
+}
+
+void TagStoreTest::testParsing()
+{
+  using pgn::TagStore;
+  CPPUNIT_ASSERT(TagStore::parse_date("2008.09.06") == TagStore::pack_date(2008, 9, 6));
+  CPPUNIT_ASSERT(TagStore::parse_date("2008.??.??") == TagStore::pack_date(2008, 0, 0));
+  CPPUNIT_ASSERT(TagStore::parse_date("????.??.??") == 0);
+  CPPUNIT_ASSERT(TagStore::parse_date("2008") == TagStore::pack_date(2008, 0, 0));
+  CPPUNIT_ASSERT(TagStore::pack_date(2008, 12, 31) < TagStore::pack_date(2009, 0, 0));
+  CPPUNIT_ASSERT(TagStore::pack_date(2009, 1, 31) < TagStore::pack_date(2009, 2, 1));
+  CPPUNIT_ASSERT(TagStore::parse_result("1-0") == TagStore::white_wins);
+  CPPUNIT_ASSERT(TagStore::parse_result("0-1") == TagStore::black_wins);
+  CPPUNIT_ASSERT(TagStore::parse_result("1/2-1/2") == TagStore::draw);
+  CPPUNIT_ASSERT(TagStore::parse_result("*") == TagStore::result_unknown);
+  CPPUNIT_ASSERT(TagStore::parse_eco("A00") == 1);
+  CPPUNIT_ASSERT(TagStore::parse_eco("E99") == 500);
+  CPPUNIT_ASSERT(TagStore::parse_eco("F00") == 0);
+  CPPUNIT_ASSERT(TagStore::parse_eco("B1") == 0);
+  CPPUNIT_ASSERT(TagStore::parse_elo("2850") == 2850);
+  CPPUNIT_ASSERT(TagStore::parse_elo("-") == 0);
+  CPPUNIT_ASSERT(TagStore::parse_elo("99999") == 0);
+}
+
+void TagStoreTest::testAddTag()
+{
+  using pgn::TagStore;
+  CPPUNIT_ASSERT(M_tag_store.size() == 10000);
+  CPPUNIT_ASSERT(M_tag_store.offset(42) == 4200);
+  CPPUNIT_ASSERT(M_tag_store.white(3) == "Carlsen, Magnus");
+  CPPUNIT_ASSERT(M_tag_store.black(3) == "Kramnik, Vladimir");
+  CPPUNIT_ASSERT(M_tag_store.event(3) == "Odd Open");
+  CPPUNIT_ASSERT(M_tag_store.site(3).empty());
+  CPPUNIT_ASSERT(M_tag_store.result(3) == TagStore::result_unknown);
+  CPPUNIT_ASSERT(M_tag_store.result(4) == TagStore::white_wins);
+  CPPUNIT_ASSERT(M_tag_store.white_elo(1234) == 2234);
+  CPPUNIT_ASSERT(M_tag_store.black_elo(1234) == 0);
+  CPPUNIT_ASSERT(M_tag_store.players().size() == 4);	// Including the empty string.
+}
+
+void TagStoreTest::testQuery()
+{
+  using pgn::TagStore;
+  using pgn::TagQuery;
+  uint32_t carlsen = M_tag_store.players().find("Carlsen, Magnus");
+
+  TagQuery all;
+  CPPUNIT_ASSERT(M_tag_store.count(all) == 10000);
+
+  TagQuery query;
+  query.where(TagQuery::white, TagQuery::equal, carlsen)
+       .where(TagQuery::date, TagQuery::greater_equal, TagStore::pack_date(2020, 0, 0))
+       .where(TagQuery::result, TagQuery::equal, TagStore::white_wins);
+  std::vector<uint32_t> games = M_tag_store.select(query);
+  size_t expected = 0;
+  for (uint32_t i = 5000; i < 10000; ++i)
+    if (i % 3 == 0 && i % 4 == 0)
+      ++expected;
+  CPPUNIT_ASSERT(games.size() == expected);
+  CPPUNIT_ASSERT(M_tag_store.count(query) == expected);
+  for (uint32_t game_id : games)
+    CPPUNIT_ASSERT(game_id >= 5000 && game_id % 12 == 0);
+
+  TagQuery either;
+  either.where(TagQuery::player, TagQuery::equal, carlsen);
+  expected = 0;
+  for (uint32_t i = 0; i < 10000; ++i)
+    if (i % 3 != 2)
+      ++expected;
+  CPPUNIT_ASSERT(M_tag_store.count(either) == expected);
+
+  TagQuery elo;
+  elo.where(TagQuery::white_elo, TagQuery::greater, 2990).where(TagQuery::white_elo, TagQuery::less_equal, 100000);
+  CPPUNIT_ASSERT(M_tag_store.count(elo) == 90);
+
+  TagQuery unknown_player;
+  unknown_player.where(TagQuery::black, TagQuery::equal, M_tag_store.players().find("Fischer, Robert James"));
+  CPPUNIT_ASSERT(M_tag_store.count(unknown_player) == 0);
+}
+
+void TagStoreTest::testSaveLoad()
+{
+  TempFile file("TagStoreTest");
+  CPPUNIT_ASSERT(M_tag_store.save(file.filename()));
+  pgn::TagStore loaded;
+  CPPUNIT_ASSERT(loaded.load(file.filename()));
+  CPPUNIT_ASSERT(loaded.size() == M_tag_store.size());
+  for (uint32_t game_id = 0; game_id < loaded.size(); game_id += 97)
+  {
+    CPPUNIT_ASSERT(loaded.offset(game_id) == M_tag_store.offset(game_id));
+    CPPUNIT_ASSERT(loaded.white(game_id) == M_tag_store.white(game_id));
+    CPPUNIT_ASSERT(loaded.black(game_id) == M_tag_store.black(game_id));
+    CPPUNIT_ASSERT(loaded.event(game_id) == M_tag_store.event(game_id));
+    CPPUNIT_ASSERT(loaded.date(game_id) == M_tag_store.date(game_id));
+    CPPUNIT_ASSERT(loaded.result(game_id) == M_tag_store.result(game_id));
+    CPPUNIT_ASSERT(loaded.white_elo(game_id) == M_tag_store.white_elo(game_id));
+  }
+  CPPUNIT_ASSERT(!loaded.load("/nonexistent/tags"));
+  CPPUNIT_ASSERT(loaded.size() == 0);
+
+  // Corrupt files are rejected, without trying to allocate what they claim to contain.
+  std::ifstream saved(file.filename(), std::ios::binary);
+  std::string const data((std::istreambuf_iterator<char>(saved)), std::istreambuf_iterator<char>());
+  uint64_t const games = M_tag_store.size();
+  size_t const white_column = data.size() - games * (4 * 5 + 2 * 3 + 1);	// White, Black, Event, Site and Date; ECO and Elos; Result.
+  auto corrupt = [&data](size_t offset, uint64_t value, size_t size)
+  {
+    std::string corrupted(data);
+    std::memcpy(&corrupted[offset], &value, size);
+    return corrupted;
+  };
+  std::string const corrupted_files[] = {
+    data.substr(0, data.size() / 2),
+    data.substr(0, data.size() - 1),
+    corrupt(8, uint64_t(1) << 40, sizeof(uint64_t)),		// The number of games.
+    corrupt(16, 0xffffffff, sizeof(uint32_t)),			// The number of players.
+    corrupt(20, 0x7fffffff, sizeof(uint32_t)),			// The length of the first player.
+    corrupt(white_column, M_tag_store.players().size(), sizeof(uint32_t)),
+    corrupt(data.size() - 1, pgn::TagStore::draw + 1, 1)	// The result of the last game.
+  };
+  for (std::string const& corrupted : corrupted_files)
+  {
+    TempFile corrupt_file("TagStoreTest", corrupted);
+    CPPUNIT_ASSERT(!loaded.load(corrupt_file.filename()));
+    CPPUNIT_ASSERT(loaded.size() == 0);
+  }
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
@@ -0,0 +1,95 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file TempFile.h Temporary files for the testsuite.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#pragma once
+
+#include <cppunit/extensions/HelperMacros.h>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace testsuite {
+
+/** @brief A temporary file that is removed again when the object is destroyed.
+ *
+ * The file is created as /tmp/<prefix>XXXXXX and stays open for reading and
+ * writing until close() is called. Tests that only need the file descriptor
+ * can remove() the file right away.
+ */
+class TempFile {
+  private:
+    std::string M_filename;
+    int M_fd;
+
+  public:
+    //! Create a new file and write \a content to it.
+    explicit TempFile(char const* prefix, std::string const& content = std::string())
+    {
+      std::string path = std::string("/tmp/") + prefix + "XXXXXX";
+      M_fd = mkstemp(path.data());
+      CPPUNIT_ASSERT(M_fd != -1);
+      M_filename = path;
+      bool const written = content.empty() || write(M_fd, content.data(), content.size()) == ssize_t(content.size());
+      if (!written)
+      {
+	close();
+	remove();
+      }
+      CPPUNIT_ASSERT(written);
+    }
+
+    ~TempFile()
+    {
+      close();
+      remove();
+    }
+
+    TempFile(TempFile const&) = delete;
+    TempFile& operator=(TempFile const&) = delete;
+
+    //! The name of the file; empty after remove().
+    std::string const& filename() const { return M_filename; }
+
+    //! The file descriptor, or -1 after close().
+    int fd() const { return M_fd; }
+
+    //! Close the file descriptor. The file itself stays until destruction.
+    void close()
+    {
+      if (M_fd != -1)
+	::close(M_fd);
+      M_fd = -1;
+    }
+
+    //! Remove the file now; the file descriptor stays valid.
+    void remove()
+    {
+      if (!M_filename.empty())
+	std::remove(M_filename.c_str());
+      M_filename.clear();
+    }
+};
+
+} // namespace testsuite
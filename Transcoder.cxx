@@ -0,0 +1,190 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file Transcoder.cxx This file contains the implementation of class Transcoder.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "Transcoder.h"
+#include "debug.h"
+#include <cstdint>
+#include <cstring>
+#include <glib.h>
+
+namespace util {
+
+namespace {
+
+// The Unicode code points of the bytes 0x80 till 0x9F in Windows-1252.
+// The five bytes that are undefined are mapped like in Latin-1.
+uint16_t const windows_1252_table[32] = {
+  0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021, 0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+  0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014, 0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+} // namespace
+
+bool Transcoder::is_ascii(char const* data, size_t len)
+{
+  // Eight bytes at a time.
+  uint64_t high_bits = 0;
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8)
+  {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    high_bits |= word;
+  }
+  for (; i < len; ++i)
+    high_bits |= static_cast<unsigned char>(data[i]);
+  return (high_bits & 0x8080808080808080ULL) == 0;
+}
+
+size_t Transcoder::valid_utf8(char const* data, size_t len, size_t& incomplete)
+{
+  unsigned char const* s = reinterpret_cast<unsigned char const*>(data);
+  size_t i = 0;
+  incomplete = 0;
+  while (i < len)
+  {
+    unsigned char c = s[i];
+    if (c < 0x80)
+    {
+      ++i;
+      continue;
+    }
+    // The number of continuation bytes and the allowed range of the first one (no overlong encodings, surrogates or code points above 0x10FFFF).
+    size_t n;
+    unsigned char low = 0x80, high = 0xBF;
+    if (c >= 0xC2 && c <= 0xDF)
+      n = 1;
+    else if (c >= 0xE0 && c <= 0xEF)
+    {
+      n = 2;
+      if (c == 0xE0)
+	low = 0xA0;
+      else if (c == 0xED)
+	high = 0x9F;
+    }
+    else if (c >= 0xF0 && c <= 0xF4)
+    {
+      n = 3;
+      if (c == 0xF0)
+	low = 0x90;
+      else if (c == 0xF4)
+	high = 0x8F;
+    }
+    else
+      return i;
+    size_t j = 1;
+    for (; j <= n && i + j < len; ++j)
+    {
+      unsigned char cc = s[i + j];
+      if (cc < low || cc > high)
+	return i;
+      low = 0x80;
+      high = 0xBF;
+    }
+    if (j <= n)
+    {
+      // Ran out of data in the middle of a character.
+      incomplete = len - i;
+      return i;
+    }
+    i += n + 1;
+  }
+  return i;
+}
+
+void Transcoder::detect(char const* data, size_t len)
+{
+  if (G_LIKELY(M_encoding.load(std::memory_order_relaxed) != undecided) || is_ascii(data, len))
+    return;
+  size_t incomplete;
+  encoding_type encoding;
+  if (valid_utf8(data, len, incomplete) + incomplete == len)
+    encoding = utf8;
+  else
+  {
+    encoding = iso_8859_1;
+    for (size_t i = 0; i < len; ++i)
+      if (static_cast<unsigned char>(data[i]) >= 0x80 && static_cast<unsigned char>(data[i]) <= 0x9F)
+      {
+	encoding = windows_1252;
+	break;
+      }
+  }
+  Dout(dc::notice, "Detected encoding: " << name(encoding));
+  M_encoding.store(encoding, std::memory_order_relaxed);
+}
+
+std::string_view Transcoder::to_utf8(std::string_view str, std::string& buffer, bool truncated) const
+{
+  if (G_LIKELY(is_ascii(str.data(), str.size())))
+    return str;
+  size_t incomplete;
+  size_t valid = valid_utf8(str.data(), str.size(), incomplete);
+  if (valid == str.size() || (truncated && valid + incomplete == str.size()))
+    return str.substr(0, valid);
+  // Convert from the 8-bit encoding.
+  bool const windows = M_encoding.load(std::memory_order_relaxed) != iso_8859_1;
+  buffer.clear();
+  for (char ch : str)
+  {
+    unsigned int c = static_cast<unsigned char>(ch);
+    if (c < 0x80)
+    {
+      buffer += ch;
+      continue;
+    }
+    if (windows && c < 0xA0)
+      c = windows_1252_table[c - 0x80];
+    if (c < 0x800)
+    {
+      buffer += static_cast<char>(0xC0 | (c >> 6));
+      buffer += static_cast<char>(0x80 | (c & 0x3F));
+    }
+    else
+    {
+      buffer += static_cast<char>(0xE0 | (c >> 12));
+      buffer += static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+      buffer += static_cast<char>(0x80 | (c & 0x3F));
+    }
+  }
+  return buffer;
+}
+
+char const* Transcoder::name(encoding_type encoding)
+{
+  switch (encoding)
+  {
+    case undecided:
+      return "ASCII";
+    case utf8:
+      return "UTF-8";
+    case iso_8859_1:
+      return "ISO-8859-1";
+    case windows_1252:
+      return "Windows-1252";
+  }
+  return "unknown";
+}
+
+} // namespace util
@@ -0,0 +1,97 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file Transcoder.h This file contains the declaration of class Transcoder.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace util {
+
+/** @brief Detection of the character set of a PGN file and conversion of its text to UTF-8.
+ *
+ * PGN files are written in UTF-8, ISO 8859-1 (Latin-1) or Windows-1252.
+ * The producer passes every block that it reads to detect() before it
+ * hands the block to the parser. The encoding is decided on the first
+ * block that contains a non-ASCII character. If that block is valid UTF-8,
+ * the encoding is UTF-8. Otherwise it is Windows-1252 when bytes in the range
+ * 0x80-0x9F occur (those are control characters in Latin-1), else ISO 8859-1.
+ *
+ * The parser then passes the text that it stores, the tag values, through
+ * to_utf8(). Pure ASCII and valid UTF-8 are returned as is, without copying.
+ * Anything else is converted from the detected 8-bit encoding. A database
+ * that mixes UTF-8 games with Latin-1 games therefore still ends up with
+ * UTF-8 everywhere. The file itself is not rewritten, so byte offsets into
+ * the file (the game index) remain valid.
+ */
+class Transcoder {
+  public:
+    enum encoding_type {
+      undecided,		//!< Only ASCII was seen so far.
+      utf8,			//!< UTF-8.
+      iso_8859_1,		//!< Latin-1.
+      windows_1252		//!< Windows-1252, a superset of the printable characters of Latin-1.
+    };
+
+  private:
+    std::atomic<encoding_type> M_encoding;	//!< Written by the producer, read by the parser.
+
+  public:
+    //! Construct a transcoder that detects the encoding, or uses \a encoding when that isn't undecided.
+    Transcoder(encoding_type encoding = undecided) : M_encoding(encoding) { }
+
+    /** @brief Inspect the next \a len bytes of the input at \a data.
+     *
+     * Decides the encoding on the first block with non-ASCII characters.
+     * A multi-byte UTF-8 character may be split over two blocks.
+     */
+    void detect(char const* data, size_t len);
+
+    //! Return the detected encoding.
+    encoding_type encoding() const { return M_encoding.load(std::memory_order_relaxed); }
+
+    /** @brief Return \a str in UTF-8.
+     *
+     * Returns \a str itself if it is ASCII or valid UTF-8; otherwise the result
+     * of converting it from the detected 8-bit encoding, which is stored in \a buffer.
+     * If \a truncated is TRUE, an incomplete UTF-8 character at the end, left by
+     * truncating the value, is dropped; otherwise such a tail is 8-bit text.
+     */
+    std::string_view to_utf8(std::string_view str, std::string& buffer, bool truncated = false) const;
+
+    //! Return the name of \a encoding.
+    static char const* name(encoding_type encoding);
+
+    //! Return TRUE if the \a len bytes at \a data are all ASCII.
+    static bool is_ascii(char const* data, size_t len);
+
+    /** @brief Return the length of the longest prefix of the \a len bytes at \a data that is valid UTF-8.
+     *
+     * If the rest is the start of a valid multi-byte character, \a incomplete is set to its length; otherwise to 0.
+     */
+    static size_t valid_utf8(char const* data, size_t len, size_t& incomplete);
+};
+
+} // namespace util
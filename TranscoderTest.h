@@ -0,0 +1,133 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file TranscoderTest.h Testsuite for util::Transcoder.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#pragma once
+
+#include "Transcoder.h"
+#include <cppunit/extensions/HelperMacros.h>
+
+namespace testsuite {
+
+class TranscoderTest : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(TranscoderTest);
+
+  CPPUNIT_TEST(testValidUtf8);
+  CPPUNIT_TEST(testDetect);
+  CPPUNIT_TEST(testToUtf8);
+
+  CPPUNIT_TEST_SUITE_END();
+
+  public:
+    TranscoderTest() { }
+
+    void setUp() { }
+    void tearDown() { }
+
+    void testValidUtf8();
+    void testDetect();
+    void testToUtf8();
+};
+
+} // namespace testsuite
+
+#ifdef TESTSUITE_IMPLEMENTATION
+
+namespace testsuite {
+
+CPPUNIT_TEST_SUITE_REGISTRATION(TranscoderTest);
+
+void TranscoderTest::testValidUtf8()
+{
+  size_t incomplete;
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("abc", 3, incomplete) == 3 && incomplete == 0);
+  // "Réti €" and a four byte character.
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("R\xc3\xa9ti \xe2\x82\xac \xf0\x9f\x98\x80", 14, incomplete) == 14 && incomplete == 0);
+  // Latin-1 "Réti".
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("R\xe9ti", 4, incomplete) == 1 && incomplete == 0);
+  // A character that is cut off.
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("ab\xe2\x82", 4, incomplete) == 2 && incomplete == 2);
+  // Overlong encoding, surrogate, beyond U+10FFFF and a stray continuation byte.
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("\xc0\xaf", 2, incomplete) == 0 && incomplete == 0);
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("\xed\xa0\x80", 3, incomplete) == 0 && incomplete == 0);
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("\xf4\x90\x80\x80", 4, incomplete) == 0 && incomplete == 0);
+  CPPUNIT_ASSERT(util::Transcoder::valid_utf8("a\x80", 2, incomplete) == 1 && incomplete == 0);
+
+  CPPUNIT_ASSERT(util::Transcoder::is_ascii("[Event \"Wijk aan Zee\"]\n", 24));
+  CPPUNIT_ASSERT(!util::Transcoder::is_ascii("[Event \"Wijk aan Zee\"]\n\xe9", 25));
+  CPPUNIT_ASSERT(!util::Transcoder::is_ascii("\xe9[Event \"Wijk aan Zee\"]\n", 25));
+}
+
+void TranscoderTest::testDetect()
+{
+  util::Transcoder transcoder;
+  transcoder.detect("[White \"Reti\"]\n", 15);
+  CPPUNIT_ASSERT(transcoder.encoding() == util::Transcoder::undecided);
+  // A UTF-8 character split over two blocks.
+  transcoder.detect("[White \"R\xc3", 10);
+  CPPUNIT_ASSERT(transcoder.encoding() == util::Transcoder::utf8);
+  // Once decided, the encoding doesn't change.
+  transcoder.detect("\xe9", 1);
+  CPPUNIT_ASSERT(transcoder.encoding() == util::Transcoder::utf8);
+
+  util::Transcoder latin1;
+  latin1.detect("[White \"R\xe9ti\"]\n", 15);
+  CPPUNIT_ASSERT(latin1.encoding() == util::Transcoder::iso_8859_1);
+
+  util::Transcoder windows;
+  windows.detect("{\x93quoted\x94 R\xe9ti}", 15);
+  CPPUNIT_ASSERT(windows.encoding() == util::Transcoder::windows_1252);
+
+  util::Transcoder forced(util::Transcoder::iso_8859_1);
+  forced.detect("R\xc3\xa9ti", 5);
+  CPPUNIT_ASSERT(forced.encoding() == util::Transcoder::iso_8859_1);
+}
+
+void TranscoderTest::testToUtf8()
+{
+  std::string buffer;
+  util::Transcoder latin1(util::Transcoder::iso_8859_1);
+  util::Transcoder windows(util::Transcoder::windows_1252);
+
+  // ASCII and UTF-8 are passed through without a copy.
+  std::string_view ascii("Carlsen, Magnus");
+  CPPUNIT_ASSERT(latin1.to_utf8(ascii, buffer).data() == ascii.data());
+  std::string_view utf8("R\xc3\xa9ti, Richard");
+  CPPUNIT_ASSERT(latin1.to_utf8(utf8, buffer).data() == utf8.data());
+
+  CPPUNIT_ASSERT(latin1.to_utf8("R\xe9ti, Richard", buffer) == "R\xc3\xa9ti, Richard");
+  CPPUNIT_ASSERT(latin1.to_utf8("\xdf\xff", buffer) == "\xc3\x9f\xc3\xbf");
+  CPPUNIT_ASSERT(latin1.to_utf8("\x80", buffer) == "\xc2\x80");
+  CPPUNIT_ASSERT(windows.to_utf8("\x80 \x93x\x94", buffer) == "\xe2\x82\xac \xe2\x80\x9cx\xe2\x80\x9d");
+  CPPUNIT_ASSERT(windows.to_utf8("\x8a\x81", buffer) == "\xc5\xa0\xc2\x81");
+
+  // Latin-1 that ends in a byte that starts a multi-byte UTF-8 character.
+  CPPUNIT_ASSERT(latin1.to_utf8("Jos\xe9", buffer) == "Jos\xc3\xa9");
+  CPPUNIT_ASSERT(latin1.to_utf8("L\xe9k\xf3", buffer) == "L\xc3\xa9k\xc3\xb3");
+
+  // A value that was truncated in the middle of a character.
+  CPPUNIT_ASSERT(latin1.to_utf8("R\xc3\xa9ti \xe2\x82", buffer, true) == "R\xc3\xa9ti ");
+}
+
+} // namespace testsuite
+
+#endif // TESTSUITE_IMPLEMENTATION
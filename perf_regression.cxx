@@ -0,0 +1,426 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file perf_regression.cxx Compare the speed of the core operations against a stored baseline.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Runs a fixed set of benchmarks (move generation, execute, FEN parsing and
+// scanning a PGN database) with a fixed number of iterations and compares the
+// median of each with the baseline in perf_baseline.json. The program fails
+// when a benchmark became slower than the tolerance of that benchmark allows.
+//
+// Absolute timings differ from machine to machine, therefore every median is
+// also stored relative to a calibration loop that only does integer arithmetic,
+// and it is the relative value that is compared. After an intended change in
+// speed, or to start on a new kind of machine, rewrite the baseline with -u;
+// that keeps the tolerance of every benchmark that is already in the baseline.
+//
+// Every benchmark also counts its heap allocations, by all threads, once it is
+// warmed up (see AllocationCounter.h). Move generation and execute may not
+// allocate at all. Scanning a PGN database allocates when it opens the database
+// and when the stores grow, but that is spread over all games of the corpus;
+// more than one allocation per two games means that something allocates per
+// game or per move. Too many allocations fail the program too.
+//
+// Usage: perf_regression [-n <samples>] [-t <tolerance>] [-u] [baseline.json]
+
+#include "sys.h"
+#include "ChessPosition.h"
+#include "PieceIterator.h"
+#include "MoveIterator.h"
+#include "PgnCorpusGenerator.h"
+#include "PgnWriter.h"
+#include "PgnDatabase.h"
+#include "Benchmark.h"
+#include "AllocationCounter.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <unistd.h>
+
+using namespace cwchess;
+using util::benchmark::do_not_optimize;
+
+//-----------------------------------------------------------------------------
+// The workloads.
+
+char const* const FENs[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PB2BPPP/2RQ1RK1 w - - 0 11",
+  "r3kb1r/1bqn1ppp/p2ppn2/1p6/3NPP2/2N1BB2/PPP3PP/R2Q1RK1 w kq - 2 11",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
+};
+
+std::vector<ChessPosition> positions;
+std::vector<std::vector<Move>> legal_moves;
+std::string corpus_filename;
+
+size_t calibration()
+{
+  // A fixed amount of integer arithmetic that doesn't touch memory.
+  uint64_t x = 88172645463325252ULL;
+  for (int i = 0; i < 4096; ++i)
+  {
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+  }
+  do_not_optimize(x);
+  return 4096;
+}
+
+size_t move_generation()
+{
+  size_t count = 0;
+  MoveIterator const move_end;
+  for (ChessPosition const& chess_position : positions)
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+      {
+        do_not_optimize(*move_iter);
+        ++count;
+      }
+  return count;
+}
+
+size_t execute()
+{
+  size_t count = 0;
+  for (size_t i = 0; i < positions.size(); ++i)
+    for (Move const& move : legal_moves[i])
+    {
+      ChessPosition chess_position(positions[i]);
+      do_not_optimize(chess_position.execute(move));
+      do_not_optimize(chess_position);
+      ++count;
+    }
+  return count;
+}
+
+size_t load_FEN()
+{
+  ChessPosition chess_position;
+  for (char const* FEN : FENs)
+    do_not_optimize(chess_position.load_FEN(FEN));
+  return sizeof(FENs) / sizeof(FENs[0]);
+}
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+
+void open_finished(size_t)
+{
+  main_loop->quit();
+}
+
+size_t pgn_scan()
+{
+  // Read and parse the whole corpus, in a main loop like the GUI does.
+  // The parser prints a report when it is done; that is discarded.
+  std::ostringstream report;
+  std::streambuf* cout_buf = std::cout.rdbuf(report.rdbuf());
+  main_loop = Glib::MainLoop::create(false);
+  Glib::RefPtr<pgn::Database> database = pgn::DatabaseSeekable::open(corpus_filename, sigc::ptr_fun(&open_finished));
+  main_loop->run();
+  size_t games = database->number_of_games();
+  database.reset();
+  main_loop.reset();
+  std::cout.rdbuf(cout_buf);
+  return games;
+}
+
+struct Benchmark {
+  char const* name;
+  char const* unit;
+  size_t (*function)();
+  size_t iterations;			// The number of calls per sample.
+  double max_allocations;		// The allowed number of allocations per operation, or negative if there is no limit.
+};
+
+Benchmark const benchmarks[] = {
+  { "calibration", "ns/step", calibration, 2000, -1 },
+  { "move_generation", "ns/move", move_generation, 5000, 0 },
+  { "execute", "ns/move", execute, 1000, 0 },
+  { "load_FEN", "ns/position", load_FEN, 5000, -1 },	// The benchmark itself converts the FEN to a std::string.
+  { "pgn_scan", "ns/game", pgn_scan, 1, 0.5 }
+};
+
+//-----------------------------------------------------------------------------
+// The baseline.
+
+//! One entry of the baseline file.
+struct Entry {
+  std::string name;
+  std::string unit;
+  double median;			// In unit.
+  double relative;			// The median divided by the median of the calibration.
+  double tolerance;			// The allowed relative slowdown.
+  double allocations;			// The number of allocations per operation; not stored in the baseline.
+  double bytes_allocated;		// The number of bytes allocated per operation; not stored in the baseline.
+  double max_allocations;		// The allowed number of allocations per operation; not stored in the baseline.
+};
+
+double const default_tolerance = 0.25;
+
+// Return the value of the field \a key in the JSON object text, or \a def when it is missing.
+double number_field(std::string const& object, char const* key, double def)
+{
+  std::string::size_type pos = object.find(std::string("\"") + key + "\":");
+  if (pos == std::string::npos)
+    return def;
+  return std::strtod(object.c_str() + pos + std::strlen(key) + 3, NULL);
+}
+
+std::string string_field(std::string const& object, char const* key)
+{
+  std::string::size_type pos = object.find(std::string("\"") + key + "\":");
+  if (pos == std::string::npos || (pos = object.find('"', pos + std::strlen(key) + 3)) == std::string::npos)
+    return std::string();
+  std::string::size_type end = object.find('"', pos + 1);
+  return end == std::string::npos ? std::string() : object.substr(pos + 1, end - pos - 1);
+}
+
+// Read the baseline as written by write_baseline; this is not a general JSON parser.
+bool read_baseline(std::string const& filename, std::vector<Entry>& baseline)
+{
+  std::ifstream file(filename);
+  if (!file)
+    return false;
+  std::stringstream buffer;
+  buffer << file.rdbuf();
+  std::string text(buffer.str());
+  std::string::size_type pos = text.find("\"results\":");
+  if (pos == std::string::npos)
+    return false;
+  while ((pos = text.find('{', pos)) != std::string::npos)
+  {
+    std::string::size_type end = text.find('}', pos);
+    if (end == std::string::npos)
+      return false;
+    std::string object(text, pos, end - pos);
+    Entry entry;
+    entry.name = string_field(object, "name");
+    entry.unit = string_field(object, "unit");
+    entry.median = number_field(object, "median", 0.0);
+    entry.relative = number_field(object, "relative", 0.0);
+    entry.tolerance = number_field(object, "tolerance", default_tolerance);
+    if (entry.name.empty() || entry.relative <= 0)
+      return false;
+    baseline.push_back(entry);
+    pos = end;
+  }
+  return true;
+}
+
+void write_baseline(std::ostream& os, std::vector<Entry> const& entries)
+{
+  os << "{\n  \"program\": \"perf_regression\",\n  \"results\": [";
+  char const* separator = "\n";
+  for (Entry const& entry : entries)
+  {
+    os << separator << "    { \"name\": \"" << entry.name << "\", \"unit\": \"" << entry.unit << "\", \"median\": " << entry.median <<
+        ", \"relative\": " << entry.relative << ", \"tolerance\": " << entry.tolerance << " }";
+    separator = ",\n";
+  }
+  os << "\n  ]\n}\n";
+}
+
+//-----------------------------------------------------------------------------
+
+void usage(char const* program)
+{
+  std::cerr << "Usage: " << program << " [-n <samples>] [-t <tolerance>] [-u] [baseline.json]\n"
+               "Compares the median speed of the core operations with baseline.json (default perf_baseline.json)\n"
+	       "and exits with a non-zero status if one of them is slower than its tolerance allows.\n"
+	       "-t overrides the tolerance of every benchmark (for example 0.1 for 10%); -u rewrites the baseline instead." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Debug(NAMESPACE_DEBUG::init());
+  Gio::init();
+
+  util::benchmark::Options options;
+  options.samples = 9;
+  double tolerance = 0;
+  bool update = false;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:u")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+	options.samples = std::atoi(optarg);
+	break;
+      case 't':
+	tolerance = std::atof(optarg);
+	break;
+      case 'u':
+	update = true;
+	break;
+      default:
+	usage(argv[0]);
+	return 1;
+    }
+  }
+  if (argc - optind > 1 || options.samples < 1 || tolerance < 0)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  std::string baseline_filename(optind < argc ? argv[optind] : "perf_baseline.json");
+
+  std::vector<Entry> baseline;
+  // The baseline is also read when updating, to keep its tolerances.
+  if (!read_baseline(baseline_filename, baseline) && !update)
+  {
+    std::cerr << "Can't read the baseline " << baseline_filename << "; use -u to create it." << std::endl;
+    return 1;
+  }
+
+  // Set up the workloads.
+  for (char const* FEN : FENs)
+  {
+    ChessPosition chess_position;
+    if (!chess_position.load_FEN(FEN))
+    {
+      std::cerr << "Invalid FEN: " << FEN << std::endl;
+      return 1;
+    }
+    std::vector<Move> moves;
+    MoveIterator const move_end;
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+        moves.push_back(*move_iter);
+    positions.push_back(chess_position);
+    legal_moves.push_back(std::move(moves));
+  }
+  char path[] = "/tmp/perf_regressionXXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1)
+  {
+    std::cerr << "mkstemp: " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  corpus_filename = path;
+  {
+    pgn::CorpusGenerator::Options corpus_options;
+    corpus_options.size = 4 * 1024 * 1024;
+    corpus_options.style = pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::variations;
+    pgn::Writer writer(fd);
+    pgn::CorpusGenerator(corpus_options).generate(writer);
+  }
+  close(fd);
+
+  std::vector<Entry> entries;
+  double calibration_median = 0;
+  for (Benchmark const& benchmark : benchmarks)
+  {
+    options.iterations = benchmark.iterations;
+    util::benchmark::Result result = util::benchmark::measure(benchmark.function, options);
+    if (!calibration_median)
+      calibration_median = result.median;
+    Entry entry = { benchmark.name, benchmark.unit, result.median, result.median / calibration_median, tolerance ? tolerance : default_tolerance,
+        result.allocations, result.bytes_allocated, benchmark.max_allocations };
+    for (Entry const& old : baseline)
+      if (old.name == entry.name && !tolerance)
+        entry.tolerance = old.tolerance;
+    entries.push_back(entry);
+  }
+  std::remove(corpus_filename.c_str());
+
+  if (update)
+  {
+    std::ofstream file(baseline_filename);
+    write_baseline(file, entries);
+    if (!file)
+    {
+      std::cerr << "Can't write " << baseline_filename << '.' << std::endl;
+      return 1;
+    }
+    std::cout << "Wrote " << baseline_filename << '.' << std::endl;
+    return 0;
+  }
+
+  // Compare; the calibration itself is only printed.
+  int regressions = 0;
+  int allocating = 0;
+  std::cout << std::setfill(' ') << std::left << std::setw(16) << "benchmark" << std::right << std::setw(14) << "baseline" << std::setw(14) << "current" <<
+      std::setw(9) << "change" << std::setw(11) << "tolerance" << std::setw(12) << "allocs/op" << std::setw(12) << "bytes/op" << "  unit" << std::endl;
+  std::cout << std::fixed;
+  for (Entry const& entry : entries)
+  {
+    Entry const* old = NULL;
+    for (Entry const& e : baseline)
+      if (e.name == entry.name)
+        old = &e;
+    bool const allocates = entry.max_allocations >= 0 && entry.allocations > entry.max_allocations;
+    if (allocates)
+      ++allocating;
+    std::cout << std::left << std::setw(16) << entry.name << std::right << std::setprecision(2);
+    if (!old)
+    {
+      std::cout << std::setw(14) << "-" << std::setw(14) << entry.median << std::setw(9) << "-" << std::setw(11) << "-" <<
+          std::setw(12) << entry.allocations << std::setw(12) << entry.bytes_allocated << "  " << entry.unit << "  (not in baseline)" <<
+	  (allocates ? "  ALLOCATES" : "") << std::endl;
+      continue;
+    }
+    // Express the baseline in the time units of this machine.
+    double expected = old->relative * calibration_median;
+    double change = entry.relative / old->relative - 1;
+    bool regression = entry.name != benchmarks[0].name && change > entry.tolerance;
+    std::cout << std::setw(14) << expected << std::setw(14) << entry.median << std::setprecision(1) << std::showpos <<
+        std::setw(8) << change * 100 << '%' << std::noshowpos << std::setw(9) << entry.tolerance * 100 << " %" <<
+        std::setprecision(2) << std::setw(12) << entry.allocations << std::setw(12) << entry.bytes_allocated << "  " << entry.unit <<
+        (regression ? "  REGRESSION" : "") << (allocates ? "  ALLOCATES" : "") << std::endl;
+    if (regression)
+      ++regressions;
+  }
+  std::cout << std::setprecision(2) << "Calibration: " << calibration_median << " ns/step";
+  for (Entry const& e : baseline)
+    if (e.name == benchmarks[0].name)
+      std::cout << " (baseline " << e.median << ")";
+  std::cout << '.' << std::endl;
+  if (!util::allocation::counting())
+    std::cout << "Allocations are not counted in this build." << std::endl;
+  if (allocating)
+    std::cout << allocating << " benchmark(s) allocate more than allowed." << std::endl;
+  if (regressions)
+    std::cout << regressions << " benchmark(s) became slower than allowed by their tolerance." << std::endl;
+  if (regressions || allocating)
+    return 1;
+  std::cout << "No regressions." << std::endl;
+  return 0;
+}
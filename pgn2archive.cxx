@@ -0,0 +1,117 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file pgn2archive.cxx Convert a PGN file to a pgn::GameArchive.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDatabase.h"
+#include "PgnGameArchive.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <ctime>
+#include <sys/stat.h>
+
+using namespace cwchess;
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+Glib::RefPtr<pgn::Database> pgn_data_base;
+char const* archive_file;
+int exit_code = 1;
+
+double seconds_since(timespec const& start)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void open_finished(size_t len)
+{
+  main_loop->quit();
+
+  pgn::TagStore const& tag_store(pgn_data_base->tag_store());
+  pgn::MoveStore const& move_store(pgn_data_base->move_store());
+  std::cout << "Converting " << move_store.size() << " games (" << move_store.total_number_of_moves() << " moves)..." << std::endl;
+  timespec start;
+  clock_gettime(CLOCK_REALTIME, &start);
+  if (!pgn::GameArchive::write(tag_store, move_store, archive_file))
+  {
+    std::cerr << "Failed to write " << archive_file << std::endl;
+    return;
+  }
+  std::cout << "Write time: " << seconds_since(start) << " seconds." << std::endl;
+  struct stat sb;
+  if (stat(archive_file, &sb) == 0)
+    std::cout << "Size: " << len << " bytes PGN, " << sb.st_size << " bytes archive." << std::endl;
+
+  // Read the archive back and compare.
+  pgn::GameArchive archive;
+  if (!archive.open(archive_file))
+  {
+    std::cerr << "Failed to open " << archive_file << std::endl;
+    return;
+  }
+  std::vector<pgn::GameArchive::Header> headers;
+  pgn::MoveStore decoded_move_store;
+  clock_gettime(CLOCK_REALTIME, &start);
+  if (!archive.decode(headers, decoded_move_store))
+  {
+    std::cerr << "Failed to decode " << archive_file << std::endl;
+    return;
+  }
+  double seconds = seconds_since(start);
+  std::cout << "Decode time: " << seconds << " seconds (" <<
+      decoded_move_store.total_number_of_moves() / seconds / 1e6 << " million moves per second, " <<
+      archive.number_of_blocks() << " blocks)." << std::endl;
+  for (uint32_t game_id = 0; game_id < move_store.size(); ++game_id)
+  {
+    size_t number_of_moves = move_store.number_of_moves(game_id);
+    if (decoded_move_store.number_of_moves(game_id) != number_of_moves ||
+        !std::equal(move_store.moves(game_id), move_store.moves(game_id) + number_of_moves, decoded_move_store.moves(game_id)) ||
+	archive.players()[headers[game_id].white] != tag_store.white(game_id) ||
+	archive.players()[headers[game_id].black] != tag_store.black(game_id))
+    {
+      std::cerr << "Game " << game_id << " differs after decoding." << std::endl;
+      return;
+    }
+  }
+  exit_code = 0;
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Gio::init();
+
+  if (argc != 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <database.pgn> <archive file>" << std::endl;
+    return 1;
+  }
+  archive_file = argv[2];
+  pgn_data_base = pgn::DatabaseSeekable::open(argv[1], sigc::ptr_fun(&open_finished));
+  main_loop = Glib::MainLoop::create(false);
+  main_loop->run();
+  return exit_code;
+}
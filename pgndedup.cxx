@@ -0,0 +1,241 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file pgndedup.cxx Remove duplicate games from one or more PGN files.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDatabase.h"
+#include "PgnDeduplicator.h"
+#include "PgnWriter.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <fstream>
+#include <ctime>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace cwchess;
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+std::vector<Glib::RefPtr<pgn::Database>> databases;
+std::vector<uint32_t> game_numbers;	// The number of games read so far, per database.
+size_t running;				// The number of databases that are still being read.
+pgn::Deduplicator* deduplicator;
+pgn::Writer* writer;
+uint64_t games_written;
+
+double seconds_since(timespec const& start)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+// Called in the read thread of database number `database' for every game.
+void fingerprint_game(pgn::Database const& database_, uint32_t game_id, unsigned int database)
+{
+  deduplicator->add(database, game_numbers[database]++, database_.tag_store(), database_.move_store(), game_id);
+}
+
+// Called in the read thread of database number `database' for every game, during the second pass.
+void write_game(pgn::Database const& database_, uint32_t game_id, unsigned int database)
+{
+  if (!deduplicator->is_duplicate(database, game_numbers[database]++))
+  {
+    writer->game(database_.tag_store(), database_.move_store(), game_id);
+    ++games_written;
+  }
+}
+
+void read_finished(size_t)
+{
+  if (--running == 0)
+    main_loop->quit();
+}
+
+// Read database number `database' from `filename', calling `slot' for every game.
+bool read_database(char const* filename, unsigned int database, pgn::Database::SlotGameCompleted const& slot)
+{
+  int fd = open(filename, O_RDONLY);
+  if (fd == -1)
+  {
+    std::cerr << "Can't open " << filename << ": " << std::strerror(errno) << std::endl;
+    return false;
+  }
+  // The games are not kept, so that memory use doesn't depend on the size of the databases.
+  databases[database] = pgn::DatabaseStream::open(fd, sigc::ptr_fun(&read_finished), slot, false);
+  ++running;
+  return true;
+}
+
+void usage(char const* program)
+{
+  std::cerr << "Usage: " << program << " [-k players,result,year,event] [-p min_plies] [-m megabytes] [-t spill directory] [-j threads]\n"
+               "        [-o output.pgn] [-c clusters.txt] database.pgn...\n"
+	       "Finds the games that occur more than once in the given databases (compressed or not) and writes\n"
+	       "each game once to output.pgn, and the clusters of duplicates to clusters.txt, one cluster per line\n"
+	       "as database:game pairs, where the first game is the one that is kept." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Gio::init();
+
+  pgn::Deduplicator::Options options;
+  char const* output_file = NULL;
+  char const* clusters_file = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "k:p:m:t:j:o:c:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'k':
+      {
+	std::string keys(optarg);
+	for (size_t begin = 0; begin <= keys.size();)
+	{
+	  size_t end = std::min(keys.find(',', begin), keys.size());
+	  std::string key = keys.substr(begin, end - begin);
+	  if (key == "players")
+	    options.key_tags |= pgn::Deduplicator::key_players;
+	  else if (key == "result")
+	    options.key_tags |= pgn::Deduplicator::key_result;
+	  else if (key == "year")
+	    options.key_tags |= pgn::Deduplicator::key_year;
+	  else if (key == "event")
+	    options.key_tags |= pgn::Deduplicator::key_event;
+	  else
+	  {
+	    std::cerr << "Unknown key tag \"" << key << "\"." << std::endl;
+	    return 1;
+	  }
+	  begin = end + 1;
+	}
+	break;
+      }
+      case 'p':
+	options.min_plies = std::atoi(optarg);
+	break;
+      case 'm':
+	options.memory_budget = size_t(std::atol(optarg)) * 1024 * 1024;
+	break;
+      case 't':
+	options.spill_directory = optarg;
+	break;
+      case 'j':
+	options.number_of_threads = std::atoi(optarg);
+	break;
+      case 'o':
+	output_file = optarg;
+	break;
+      case 'c':
+	clusters_file = optarg;
+	break;
+      default:
+	usage(argv[0]);
+	return 1;
+    }
+  }
+  if (optind == argc)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+  char** filenames = argv + optind;
+  unsigned int const number_of_databases = argc - optind;
+  databases.resize(number_of_databases);
+  main_loop = Glib::MainLoop::create(false);
+
+  // Fingerprint all databases at the same time, each in its own read thread.
+  timespec start;
+  clock_gettime(CLOCK_REALTIME, &start);
+  deduplicator = new pgn::Deduplicator(options);
+  game_numbers.assign(number_of_databases, 0);
+  for (unsigned int database = 0; database < number_of_databases; ++database)
+    if (!read_database(filenames[database], database, sigc::bind(sigc::ptr_fun(&fingerprint_game), database)))
+      return 1;
+  main_loop->run();
+  std::cerr << "Fingerprinted " << deduplicator->number_of_games() << " games in " << seconds_since(start) << " seconds" <<
+      (deduplicator->spilled() ? ", spilling to disk." : ".") << std::endl;
+
+  std::ofstream clusters;
+  if (clusters_file)
+  {
+    clusters.open(clusters_file);
+    for (unsigned int database = 0; database < number_of_databases; ++database)
+      clusters << "# " << database << ": " << filenames[database] << '\n';
+  }
+  clock_gettime(CLOCK_REALTIME, &start);
+  bool success = deduplicator->finish([&clusters, clusters_file](pgn::Deduplicator::GameRef const* games, size_t size) {
+      if (!clusters_file)
+        return;
+      for (size_t i = 0; i < size; ++i)
+        clusters << (i ? " " : "") << games[i].database << ':' << games[i].game;
+      clusters << '\n';
+  });
+  if (!success)
+  {
+    std::cerr << "Failed to use the spill files in " << options.spill_directory << '.' << std::endl;
+    return 1;
+  }
+  std::cerr << "Found " << deduplicator->number_of_duplicates() << " duplicates in " << deduplicator->number_of_clusters() <<
+      " clusters in " << seconds_since(start) << " seconds." << std::endl;
+  if (clusters_file && !clusters.flush())
+  {
+    std::cerr << "Failed to write " << clusters_file << std::endl;
+    return 1;
+  }
+
+  // Write the games that are kept, one database after another, in order.
+  if (output_file)
+  {
+    int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd == -1)
+    {
+      std::cerr << "Can't create " << output_file << ": " << std::strerror(errno) << std::endl;
+      return 1;
+    }
+    writer = new pgn::Writer(fd);
+    game_numbers.assign(number_of_databases, 0);
+    for (unsigned int database = 0; database < number_of_databases; ++database)
+    {
+      if (!read_database(filenames[database], database, sigc::bind(sigc::ptr_fun(&write_game), database)))
+	return 1;
+      main_loop->run();
+    }
+    bool write_error = !writer->flush();
+    delete writer;
+    if (close(fd) == -1 || write_error)
+    {
+      std::cerr << "Failed to write " << output_file << std::endl;
+      return 1;
+    }
+    std::cerr << "Wrote " << games_written << " games to " << output_file << '.' << std::endl;
+  }
+  delete deduplicator;
+  return 0;
+}
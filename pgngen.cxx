@@ -0,0 +1,107 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file pgngen.cxx Generate a synthetic PGN database for benchmarks.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+#include "sys.h"
+#include "PgnCorpusGenerator.h"
+#include "PgnWriter.h"
+#include "debug.h"
+#include <iostream>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace cwchess;
+
+void usage(char const* program)
+{
+  std::cerr << "Usage: " << program << " [-n games] [-s megabytes] [-r seed] [-y bare,annotated,variations,crlf,junk] [-o output.pgn]\n"
+               "Writes random games to output.pgn, or to stdout. The output only depends on the options;\n"
+	       "without -n, games are written until the output is at least the given size (default 64 MB)." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  pgn::CorpusGenerator::Options options;
+  char const* output_file = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:r:y:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+	options.games = std::atol(optarg);
+	break;
+      case 's':
+	options.size = uint64_t(std::atof(optarg) * 1024 * 1024);
+	break;
+      case 'r':
+	options.seed = std::strtoull(optarg, NULL, 0);
+	break;
+      case 'y':
+	if (!pgn::CorpusGenerator::parse_style(optarg, options.style))
+	{
+	  std::cerr << "Unknown style \"" << optarg << "\"." << std::endl;
+	  return 1;
+	}
+	break;
+      case 'o':
+	output_file = optarg;
+	break;
+      default:
+	usage(argv[0]);
+	return 1;
+    }
+  }
+  if (optind != argc)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  int fd = 1;
+  if (output_file && (fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1)
+  {
+    std::cerr << "Can't create " << output_file << ": " << std::strerror(errno) << std::endl;
+    return 1;
+  }
+  uint32_t games;
+  bool success;
+  uint64_t bytes;
+  {
+    pgn::Writer writer(fd);
+    games = pgn::CorpusGenerator(options).generate(writer);
+    success = writer.flush();
+    bytes = writer.bytes_written();
+  }
+  if (!success || (output_file && close(fd) == -1))
+  {
+    std::cerr << "Write error." << std::endl;
+    return 1;
+  }
+  std::cerr << "Wrote " << games << " games, " << bytes << " bytes." << std::endl;
+}
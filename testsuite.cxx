@@ -34,12 +34,33 @@
 #include "FlagsTest.h"
 #include "BitBoardTest.h"
 #include "PieceTest.h"
+#include "MoveIteratorTest.h"
 #include "ChessPositionTest.h"
+#include "SlimChessPositionTest.h"
+#include "TagStoreTest.h"
+#include "PositionIndexTest.h"
+#include "GameArchiveTest.h"
+#include "PgnWriterTest.h"
+#include "OpeningTreeTest.h"
+#include "DecompressorTest.h"
+#include "MemoryBlockPoolTest.h"
+#include "LoadProgressTest.h"
+#include "FileFollowerTest.h"
+#include "TranscoderTest.h"
+#include "DeduplicatorTest.h"
+#include "DiagnosticsTest.h"
+#include "BlockReaderTest.h"
+#include "CorpusGeneratorTest.h"
+#include "DragLatencyTest.h"
+#include "AllocationCounterTest.h"
 #include "debug.h"
+#include <giomm/init.h>
 
 int main()
 {
   Debug(NAMESPACE_DEBUG::init());
+  // DiagnosticsTest parses a PGN file with pgn::DatabaseSeekable.
+  Gio::init();
 
   // Get the top level suite from the registry
   CppUnit::Test* suite = CppUnit::TestFactoryRegistry::getRegistry().makeTest();
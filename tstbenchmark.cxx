@@ -1,6 +1,6 @@
 // cwchessboard -- A C++ chessboard tool set for gtkmm
 //
-//! @file tstbenchmark.cxx A program to measure the move generation speed.
+//! @file tstbenchmark.cxx Microbenchmarks of the ChessPosition operations.
 //
 // Copyright (C) 2008, by
 //
@@ -21,123 +21,588 @@
 // You should have received a copy of the GNU General Public License
 // along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
+
+// Each benchmark runs one ChessPosition operation over every position of a
+// position set; the operations that modify the position work on a copy.
+// A sample runs a benchmark often enough to take at least the minimum sample
+// time, after one untimed warm-up sample. The time per operation of every sample
+// is collected and summarized as min, median, mean and standard deviation.
+//
+// The benchmarks whose name starts with "slim_" do the same on a SlimChessPosition;
+// the size of both classes and how much slower each slim_ query is are reported too.
+//
+// The results are written as JSON (to stdout by default) so that two runs
+// can be compared, and as a table on stderr. Both include the number of heap
+// allocations and bytes per operation, counted after the warm-up.
+//
+// Usage: tstbenchmark [-n <samples>] [-t <milliseconds per sample>] [-f <filter>] [-o <output.json>]
+
 #include "sys.h"
 #include "ChessPosition.h"
+#include "SlimChessPosition.h"
 #include "PieceIterator.h"
 #include "MoveIterator.h"
-#include "ChessNotation.h"
+#include "Benchmark.h"
 #include "debug.h"
 #include <iostream>
-#include <cstdlib>
-#include <ctime>
+#include <fstream>
 #include <iomanip>
 #include <sstream>
+#include <string>
 #include <vector>
-#include <sys/time.h>
+#include <algorithm>
+#include <cstdlib>
+#include <unistd.h>
 
 using namespace cwchess;
 
-void print_move(ChessPosition const& chess_position, Move const& move)
+namespace {
+
+//-----------------------------------------------------------------------------
+// Position sets.
+
+char const* const opening_FENs[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "rnbqkbnr/pppp1ppp/8/4p3/4P3/8/PPPP1PPP/RNBQKBNR w KQkq e6 0 2",
+  "r1bqkbnr/pppp1ppp/2n5/1B2p3/4P3/5N2/PPPP1PPP/RNBQK2R b KQkq - 3 3",
+  "rnbqkb1r/pp2pppp/3p1n2/8/3NP3/8/PPP2PPP/RNBQKB1R w KQkq - 1 5",
+  "rnbqkb1r/ppp1pppp/5n2/3p4/2PP4/8/PP2PPPP/RNBQKBNR w KQkq - 1 3",
+  "rnbqk2r/ppppppbp/5np1/8/2PP4/2N5/PP2PPPP/R1BQKBNR w KQkq - 2 4",
+  "rnbqkbnr/pp1ppppp/8/2p5/4P3/5N2/PPPP1PPP/RNBQKB1R b KQkq - 1 2",
+  "r1bqk1nr/pppp1ppp/2n5/2b1p3/2B1P3/5N2/PPPP1PPP/RNBQK2R w KQkq - 4 4"
+};
+
+char const* const middlegame_FENs[] = {
+  "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+  "r1bq1rk1/pp2bppp/2n1pn2/3p4/2PP4/2N1PN2/PP3PPP/R2QKB1R w KQ - 0 9",
+  "2rq1rk1/pb1nbppp/1p2pn2/2pp4/2PP4/1PN1PN2/PB2BPPP/2RQ1RK1 w - - 0 11",
+  "r2q1rk1/1b2bppp/p2ppn2/1p6/3NP3/1BN1B3/PPP2PPP/R2Q1RK1 w - - 0 11",
+  "r1b2rk1/2q1bppp/p2ppn2/1p6/3NPP2/2N1B3/PPP1B1PP/R2Q1RK1 w - - 0 11",
+  "r2qr1k1/pp1nbppp/2p2n2/3p1b2/3P1B2/2NBPN2/PPQ2PPP/R4RK1 b - - 5 11",
+  "2kr3r/ppp2ppp/2n1bn2/2bqp3/8/2NP1N2/PPP1BPPP/R1BQ1RK1 w - - 6 9",
+  "r3kb1r/1bqn1ppp/p2ppn2/1p6/3NPP2/2N1BB2/PPP3PP/R2Q1RK1 w kq - 2 11"
+};
+
+char const* const endgame_FENs[] = {
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "8/8/4k3/8/2K5/8/3P4/8 w - - 0 1",
+  "8/5k2/8/8/8/8/1R6/4K3 w - - 0 1",
+  "8/8/1p3k2/p1p5/P1P2K2/1P6/8/8 w - - 0 1",
+  "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+  "8/4kp2/6p1/7p/P4P2/6P1/5K1P/3r4 b - - 0 40",
+  "8/8/8/4k3/8/8/8/R3K2R w KQ - 0 1",
+  "2b5/4k3/8/3p4/3P4/4B3/4K3/8 w - - 0 50"
+};
+
+char const* const tactical_FENs[] = {
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+  "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+  "4k3/8/8/8/1b6/8/3P4/4K3 w - - 0 1",
+  "rnb1kbnr/pppp1ppp/8/4p3/6Pq/5P2/PPPPP2P/RNBQKBNR w KQkq - 1 3",
+  "r1bqkb1r/pppp1Qpp/2n2n2/4p3/2B1P3/8/PPPP1PPP/RNB1K1NR b KQkq - 0 4"
+};
+
+//! A position set with everything that the benchmarks need precomputed.
+struct PositionSet {
+  std::string M_name;
+  std::vector<std::string> M_FENs;
+  std::vector<ChessPosition> M_positions;
+  std::vector<SlimChessPosition> M_slim_positions;
+  std::vector<std::vector<std::pair<Code, Index>>> M_pieces;	//!< The pieces of each position, for place().
+  std::vector<std::vector<Move>> M_moves;			//!< The legal moves of each position.
+  std::vector<std::vector<Move>> M_candidates;			//!< Legal and illegal moves of each position, for legal().
+
+  template<size_t N>
+  PositionSet(char const* name, char const* const (&FENs)[N]);
+};
+
+template<size_t N>
+PositionSet::PositionSet(char const* name, char const* const (&FENs)[N]) : M_name(name)
 {
-  if (chess_position.to_move() == white)
-    std::cout << chess_position.full_move_number() << ". ";
-  std::ostringstream str;
-  str << ChessNotation(chess_position, move);
-  std::cout << std::setfill(' ') << std::setw(10) << std::left << str.str();
-  if (chess_position.to_move() == black)
-    std::cout << '\n';
+  for (char const* FEN : FENs)
+  {
+    ChessPosition chess_position;
+    if (!chess_position.load_FEN(FEN))
+    {
+      std::cerr << "Invalid FEN in position set \"" << name << "\": " << FEN << std::endl;
+      std::exit(1);
+    }
+    M_FENs.push_back(FEN);
+    M_positions.push_back(chess_position);
+    M_slim_positions.emplace_back(chess_position);
+
+    std::vector<std::pair<Code, Index>> pieces;
+    for (Index index = index_begin; index != index_end; ++index)
+      if (!chess_position.piece_at(index).code().is_nothing())
+        pieces.emplace_back(chess_position.piece_at(index).code(), index);
+    M_pieces.push_back(std::move(pieces));
+
+    std::vector<Move> moves;
+    std::vector<Move> candidates;
+    MoveIterator const move_end;
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+    {
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+        moves.push_back(*move_iter);
+      // Every square that the piece attacks or could move to, whether or not that is legal.
+      bool is_pawn = piece_iter->code().is_a(pawn);
+      mask_t targets = chess_position.reachables(piece_iter.index())() | chess_position.reachables(piece_iter.index(), true)();
+      for (Index to = index_begin; to != index_end; ++to)
+        if ((targets & index2mask(to)))
+          candidates.push_back(Move(piece_iter.index(), to, (is_pawn && (to.row() == 0 || to.row() == 7)) ? queen : nothing));
+    }
+    M_moves.push_back(std::move(moves));
+    M_candidates.push_back(std::move(candidates));
+  }
 }
 
-int main()
+//-----------------------------------------------------------------------------
+// Measuring.
+
+using util::benchmark::do_not_optimize;
+
+//! The runtime settings.
+struct Options : util::benchmark::Options {
+  std::string filter;
+};
+
+//! The result of one benchmark.
+struct Result : util::benchmark::Result {
+  std::string name;
+  std::string set;
+};
+
+Result measure(char const* name, size_t (*function)(PositionSet const&), PositionSet const& set, Options const& options)
 {
-  Debug(NAMESPACE_DEBUG::init());
-  Debug(libcw_do.off());
+  Result result;
+  static_cast<util::benchmark::Result&>(result) = util::benchmark::measure([function, &set](){ return function(set); }, options);
+  result.name = name;
+  result.set = set.M_name;
+  return result;
+}
 
-  time_t seed = 1220638382; // Use fixed seed for reproducibility. time(NULL);
-  //std::cout << "seed = " << seed << std::endl;
-  std::srand(seed);
+//-----------------------------------------------------------------------------
+// The benchmarks. Each returns the number of operations it did.
+// The templates are run for ChessPosition and, with the prefix "slim_", for SlimChessPosition.
 
-  ChessPosition chess_position;
-  std::vector<Move> game;
-  Move moves[2048];
-  Move* move_ptr;
-  static int random_numbers[5000000];
+template<typename POSITION>
+std::vector<POSITION> const& positions(PositionSet const& set);
+
+template<>
+std::vector<ChessPosition> const& positions<ChessPosition>(PositionSet const& set) { return set.M_positions; }
+
+template<>
+std::vector<SlimChessPosition> const& positions<SlimChessPosition>(PositionSet const& set) { return set.M_slim_positions; }
 
-  // Pre-calculate random numbers.
-  for (int i = 0; i < 5000000; ++i)
-    random_numbers[i] = std::rand();
+size_t bench_place(PositionSet const& set)
+{
+  // Set up every position from an empty board; this includes one clear() per position.
+  ChessPosition chess_position;
+  size_t count = 0;
+  for (auto const& pieces : set.M_pieces)
+  {
+    chess_position.clear();
+    for (auto const& piece : pieces)
+      do_not_optimize(chess_position.place(piece.first, piece.second));
+    count += pieces.size();
+  }
+  return count;
+}
 
-  int games = 0;
-  int total_moves = 0;
-  int Move_count = 0;
+size_t bench_copy(PositionSet const& set)
+{
+  // The cost of copying a position, which is included in the execute benchmark.
+  size_t count = 0;
+  for (size_t i = 0; i < set.M_positions.size(); ++i)
+    for (size_t m = 0; m < set.M_moves[i].size(); ++m)
+    {
+      ChessPosition chess_position(set.M_positions[i]);
+      do_not_optimize(chess_position);
+      ++count;
+    }
+  return count;
+}
 
-  struct timeval before, after;
-  gettimeofday(&before, NULL);
+size_t bench_execute(PositionSet const& set)
+{
+  // Every legal move, each on a fresh copy of the position.
+  size_t count = 0;
+  for (size_t i = 0; i < set.M_positions.size(); ++i)
+    for (Move const& move : set.M_moves[i])
+    {
+      ChessPosition chess_position(set.M_positions[i]);
+      do_not_optimize(chess_position.execute(move));
+      do_not_optimize(chess_position);
+      ++count;
+    }
+  return count;
+}
 
-  do
+template<typename POSITION>
+size_t bench_moves(PositionSet const& set)
+{
+  // The bitboard of legal target squares of every piece of the side to move.
+  size_t count = 0;
+  for (size_t i = 0; i < set.M_positions.size(); ++i)
   {
-    chess_position.initial_position();
-    //game.clear();
-    for(;;)
+    ChessPosition const& chess_position(set.M_positions[i]);
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
     {
-      move_ptr = moves;
-      for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move()));	// >
-	   piece_iter != chess_position.piece_end();						// >- 20 ns
-	   ++piece_iter)									// >
+      do_not_optimize(positions<POSITION>(set)[i].moves(piece_iter.index())());
+      ++count;
+    }
+  }
+  return count;
+}
+
+size_t bench_move_iterator(PositionSet const& set)
+{
+  // Generating Move objects with MoveIterator; counts generated moves.
+  size_t count = 0;
+  MoveIterator const move_end;
+  for (ChessPosition const& chess_position : set.M_positions)
+    for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+      for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
       {
-	MoveIterator const move_end;
-#if 0
-	Move* move_save = move_ptr;
-        for (int i = 0; i < 100; ++i)
-	{
-	  move_ptr = move_save;
-#endif
-	  for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index()));		// 216 ns (per executed move)
-	       move_iter != move_end;								// >- 161 ns (per executed move)
-	       ++move_iter)									// >
-	  {
-	    *move_ptr++ = *move_iter;
-	  }
-#if 0
-	}
-#endif
+        do_not_optimize(*move_iter);
+        ++count;
       }
+  return count;
+}
+
+size_t bench_reachables(PositionSet const& set)
+{
+  // Every piece of both colors.
+  size_t count = 0;
+  for (ChessPosition const& chess_position : set.M_positions)
+    for (Color color : { Color(white), Color(black) })
+      for (PieceIterator piece_iter(chess_position.piece_begin(color)); piece_iter != chess_position.piece_end(); ++piece_iter)
+      {
+        do_not_optimize(chess_position.reachables(piece_iter.index())());
+        ++count;
+      }
+  return count;
+}
+
+size_t bench_defendables(PositionSet const& set)
+{
+  // Every piece of both colors.
+  size_t count = 0;
+  for (ChessPosition const& chess_position : set.M_positions)
+    for (Color color : { Color(white), Color(black) })
+      for (PieceIterator piece_iter(chess_position.piece_begin(color)); piece_iter != chess_position.piece_end(); ++piece_iter)
+      {
+        bool battery;
+        do_not_optimize(chess_position.defendables(piece_iter->code(), piece_iter.index(), battery)());
+        do_not_optimize(battery);
+        ++count;
+      }
+  return count;
+}
+
+template<typename POSITION>
+size_t bench_legal(PositionSet const& set)
+{
+  // A mix of legal and illegal moves of the side to move.
+  size_t count = 0;
+  for (size_t i = 0; i < set.M_positions.size(); ++i)
+    for (Move const& move : set.M_candidates[i])
+    {
+      do_not_optimize(positions<POSITION>(set)[i].legal(move));
+      ++count;
+    }
+  return count;
+}
+
+size_t bench_load_FEN(PositionSet const& set)
+{
+  ChessPosition chess_position;
+  for (std::string const& FEN : set.M_FENs)
+    do_not_optimize(chess_position.load_FEN(FEN));
+  return set.M_FENs.size();
+}
+
+template<typename POSITION>
+size_t bench_FEN(PositionSet const& set)
+{
+  for (POSITION const& chess_position : positions<POSITION>(set))
+  {
+    std::string FEN(chess_position.FEN());
+    do_not_optimize(FEN.data());
+  }
+  return set.M_positions.size();
+}
+
+template<typename POSITION>
+size_t bench_piece_at(PositionSet const& set)
+{
+  // Every square.
+  for (POSITION const& chess_position : positions<POSITION>(set))
+    for (Index index = index_begin; index != index_end; ++index)
+      do_not_optimize(chess_position.piece_at(index).flags()());
+  return 64 * set.M_positions.size();
+}
+
+template<typename POSITION>
+size_t bench_check(PositionSet const& set)
+{
+  for (POSITION const& chess_position : positions<POSITION>(set))
+    do_not_optimize(chess_position.check());
+  return set.M_positions.size();
+}
+
+size_t bench_slim_pack(PositionSet const& set)
+{
+  // Converting a ChessPosition into a SlimChessPosition.
+  for (ChessPosition const& chess_position : set.M_positions)
+  {
+    SlimChessPosition slim_chess_position(chess_position);
+    do_not_optimize(slim_chess_position);
+  }
+  return set.M_positions.size();
+}
+
+size_t bench_slim_expand(PositionSet const& set)
+{
+  // Converting a SlimChessPosition back into a ChessPosition.
+  ChessPosition chess_position;
+  for (SlimChessPosition const& slim_chess_position : set.M_slim_positions)
+  {
+    slim_chess_position.expand(chess_position);
+    do_not_optimize(chess_position);
+  }
+  return set.M_positions.size();
+}
+
+size_t bench_piece_iterator(PositionSet const& set)
+{
+  // Iterating over all pieces of both colors; counts visited pieces.
+  size_t count = 0;
+  for (ChessPosition const& chess_position : set.M_positions)
+    for (Color color : { Color(white), Color(black) })
+      for (PieceIterator piece_iter(chess_position.piece_begin(color)); piece_iter != chess_position.piece_end(); ++piece_iter)
+      {
+        do_not_optimize(piece_iter.index()());
+        ++count;
+      }
+  return count;
+}
+
+// The aggregate that this program used to measure: random games from the initial position.
+// Counts executed plies; the random numbers are precalculated with a fixed seed for reproducibility.
+int const random_games_per_call = 100;
+std::vector<int> random_numbers;
+
+size_t bench_random_games(PositionSet const&)
+{
+  ChessPosition chess_position;
+  Move moves[256];
+  MoveIterator const move_end;
+  size_t total_moves = 0;
+  for (int game = 0; game < random_games_per_call; ++game)
+  {
+    chess_position.initial_position();
+    for (;;)
+    {
+      Move* move_ptr = moves;
+      for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+        for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+          *move_ptr++ = *move_iter;
       int number_of_moves = move_ptr - moves;
-      Move_count += number_of_moves;
       if (number_of_moves == 0)
-	break;
-      int mn = random_numbers[total_moves] % number_of_moves;	// 12 ns.
+        break;
+      int mn = random_numbers[total_moves % random_numbers.size()] % number_of_moves;
       ++total_moves;
-      //game.push_back(move);
-      if (chess_position.execute(moves[mn]))			// 300 ns.
-	break;
+      if (chess_position.execute(moves[mn]))
+        break;
     }
-    ++games;
   }
-  while (games < 10000);
+  return total_moves;
+}
 
-  gettimeofday(&after, NULL);
+//-----------------------------------------------------------------------------
+// Output.
 
-#if 0
-  chess_position.initial_position();
-  for (std::vector<Move>::iterator iter = game.begin(); iter != game.end(); ++iter)
+std::string json_string(std::string const& str)
+{
+  std::string result("\"");
+  for (char c : str)
   {
-    //print_move(chess_position, *iter);
-    Move const& move(*iter);
-    print_move(chess_position, move);
-    chess_position.execute(move);
+    if (c == '"' || c == '\\')
+      result += '\\';
+    result += c;
+  }
+  return result + '"';
+}
+
+//! How much slower a query on a SlimChessPosition is than the same query on a ChessPosition.
+struct Slowdown {
+  std::string name;
+  std::string set;
+  double factor;	//!< The ratio of the medians.
+};
+
+std::vector<Slowdown> slowdowns(std::vector<Result> const& results)
+{
+  std::vector<Slowdown> result;
+  for (Result const& slim : results)
+  {
+    if (slim.name.compare(0, 5, "slim_") != 0)
+      continue;
+    for (Result const& full : results)
+      if (full.name == slim.name.substr(5) && full.set == slim.set && full.median > 0)
+        result.push_back({ full.name, full.set, slim.median / full.median });
+  }
+  return result;
+}
+
+void write_json(std::ostream& os, std::vector<Result> const& results, Options const& options)
+{
+  os << std::setprecision(6);
+  os << "{\n  \"program\": \"tstbenchmark\",\n  \"unit\": \"ns/op\",\n  \"samples\": " << options.samples <<
+      ",\n  \"min_sample_time\": " << options.min_sample_time <<
+      ",\n  \"bytes_per_position\": { \"ChessPosition\": " << sizeof(ChessPosition) <<
+      ", \"SlimChessPosition\": " << sizeof(SlimChessPosition) << " },\n  \"results\": [";
+  char const* separator = "\n";
+  for (Result const& result : results)
+  {
+    os << separator << "    { \"name\": " << json_string(result.name) << ", \"set\": " << json_string(result.set) <<
+        ", \"operations\": " << result.operations << ", \"iterations\": " << result.iterations <<
+        ", \"min\": " << result.min << ", \"median\": " << result.median <<
+        ", \"mean\": " << result.mean << ", \"stddev\": " << result.stddev <<
+        ", \"allocations\": " << result.allocations << ", \"bytes_allocated\": " << result.bytes_allocated << ",\n      \"samples\": [";
+    for (size_t i = 0; i < result.samples.size(); ++i)
+      os << (i ? ", " : "") << result.samples[i];
+    os << "] }";
+    separator = ",\n";
+  }
+  os << "\n  ],\n  \"slim_slowdown\": [";
+  separator = "\n";
+  for (Slowdown const& slowdown : slowdowns(results))
+  {
+    os << separator << "    { \"name\": " << json_string(slowdown.name) << ", \"set\": " << json_string(slowdown.set) <<
+        ", \"factor\": " << slowdown.factor << " }";
+    separator = ",\n";
+  }
+  os << "\n  ]\n}\n";
+}
+
+void usage(char const* progname)
+{
+  std::cerr << "Usage: " << progname << " [-n <samples>] [-t <milliseconds per sample>] [-f <filter>] [-o <output.json>]\n"
+               "  The filter selects the benchmarks whose \"name/set\" contains it." << std::endl;
+  std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  Debug(libcw_do.off());
+
+  Options options;
+  std::string output_filename;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:f:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        options.samples = std::atoi(optarg);
+        break;
+      case 't':
+        options.min_sample_time = std::atof(optarg) / 1000;
+        break;
+      case 'f':
+        options.filter = optarg;
+        break;
+      case 'o':
+        output_filename = optarg;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc || options.samples < 1 || options.min_sample_time <= 0)
+    usage(argv[0]);
+
+  std::srand(1220638382);
+  random_numbers.resize(1000000);
+  for (int& random_number : random_numbers)
+    random_number = std::rand();
+
+  std::vector<PositionSet> const sets = {
+    PositionSet("opening", opening_FENs),
+    PositionSet("middlegame", middlegame_FENs),
+    PositionSet("endgame", endgame_FENs),
+    PositionSet("tactical", tactical_FENs)
+  };
+  char const* const initial_FEN[] = { "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1" };
+  PositionSet const initial("initial", initial_FEN);
+
+  struct Benchmark {
+    char const* name;
+    size_t (*function)(PositionSet const&);
+  };
+  Benchmark const benchmarks[] = {
+    { "place", bench_place },
+    { "copy", bench_copy },
+    { "execute", bench_execute },
+    { "moves", bench_moves<ChessPosition> },
+    { "move_iterator", bench_move_iterator },
+    { "reachables", bench_reachables },
+    { "defendables", bench_defendables },
+    { "legal", bench_legal<ChessPosition> },
+    { "load_FEN", bench_load_FEN },
+    { "FEN", bench_FEN<ChessPosition> },
+    { "piece_iterator", bench_piece_iterator },
+    { "piece_at", bench_piece_at<ChessPosition> },
+    { "check", bench_check<ChessPosition> },
+    { "slim_pack", bench_slim_pack },
+    { "slim_expand", bench_slim_expand },
+    { "slim_moves", bench_moves<SlimChessPosition> },
+    { "slim_legal", bench_legal<SlimChessPosition> },
+    { "slim_FEN", bench_FEN<SlimChessPosition> },
+    { "slim_piece_at", bench_piece_at<SlimChessPosition> },
+    { "slim_check", bench_check<SlimChessPosition> }
+  };
+
+  std::vector<Result> results;
+  auto run = [&](char const* name, size_t (*function)(PositionSet const&), PositionSet const& set)
+  {
+    if (!options.filter.empty() && (std::string(name) + '/' + set.M_name).find(options.filter) == std::string::npos)
+      return;
+    results.push_back(measure(name, function, set, options));
+    Result const& result(results.back());
+    std::cerr << std::left << std::setw(16) << result.name << std::setw(12) << result.set << std::right << std::fixed << std::setprecision(1) <<
+        " median " << std::setw(9) << result.median << " ns  min " << std::setw(9) << result.min <<
+        " ns  mean " << std::setw(9) << result.mean << " ns  stddev " << std::setw(7) << result.stddev << " ns  allocations " <<
+        std::setprecision(2) << result.allocations << " (" << result.bytes_allocated << " bytes)" << std::endl;
+  };
+  for (Benchmark const& benchmark : benchmarks)
+    for (PositionSet const& set : sets)
+      run(benchmark.name, benchmark.function, set);
+  run("random_games", bench_random_games, initial);
+
+  std::cerr << "\nBytes per position: ChessPosition " << sizeof(ChessPosition) << ", SlimChessPosition " << sizeof(SlimChessPosition) << '\n';
+  for (Slowdown const& slowdown : slowdowns(results))
+    std::cerr << "slim_" << std::left << std::setw(11) << slowdown.name << std::setw(12) << slowdown.set << std::right <<
+        std::setprecision(2) << std::setw(8) << slowdown.factor << " times slower" << '\n';
+
+  if (output_filename.empty() || output_filename == "-")
+    write_json(std::cout, results, options);
+  else
+  {
+    std::ofstream output(output_filename);
+    write_json(output, results, options);
+    if (!output)
+    {
+      std::cerr << "Failed to write " << output_filename << std::endl;
+      return 1;
+    }
   }
-  if (chess_position.to_move() == black)
-    std::cout << std::endl;
-#endif
-
-  std::cout << "Number of games played: " << games << "\nTotal number of moves played: " << total_moves << std::endl;
-
-  timersub(&after, &before, &after);
-  uint64_t t = after.tv_sec;
-  t *= 1000000;
-  t += after.tv_usec;
-  std::cout << "Generated Move objects: " << (unsigned long)(Move_count / (t / 1000000.0) + 0.5) << " Moves/second." << std::endl;
-  std::cout << "Executed ply: " << (unsigned long)(total_moves / (t / 1000000.0) + 0.5) << " ply/second." << std::endl;
-  std::cout << "Computing time: " << ((double)t / total_moves) << " microseconds per executed move (ply)." << std::endl;
 }
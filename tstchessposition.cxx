@@ -47,7 +47,6 @@ namespace test {
     ArrayColor<BitBoard> M_attackers;			//!< Bitboards for squares of enemy pieces on the same line as the king and all squares in between.
     ArrayColor<BitBoard> M_pinning;			//!< Squares between attacker and king for actually pinned pieces (including attacker).
     ArrayColor<CountBoard> M_defended;			//!< The number times a square is defended.
-    ArrayColor<uint8_t> M_king_battery_attack_count;	//!< The number of times that a king is 'attacked' by pieces behind another attacker.
     uint16_t M_full_move_number;			//!< The number of the full move. It starts at 1, and is incremented after Black's move.
     uint8_t M_half_move_clock;				//!< Number of half moves since the last pawn advance or capture.
     CastleFlags M_castle_flags;				//!< Whether black and white may castle long or short.
@@ -91,10 +90,8 @@ int main(int argc, char* argv[])
   assert(sizeof(ArrayColor<BitBoard>) == 2 * sizeof(BitBoard));
   std::cout << "sizeof(ArrayColor<CountBoard>) = " << sizeof(ArrayColor<CountBoard>) << '\n';
   assert(sizeof(ArrayColor<CountBoard>) == 2 * sizeof(CountBoard));
-  std::cout << "sizeof(ArrayColor<uint8_t>) = " << sizeof(ArrayColor<uint8_t>) << '\n';
-  assert(sizeof(ArrayColor<uint8_t>) == 2);
   size_t sum = sizeof(ArrayCode<BitBoard>) + sizeof(ArrayIndex<Piece>) +
-      sizeof(ArrayColor<BitBoard>) + sizeof(ArrayColor<BitBoard>) + sizeof(ArrayColor<CountBoard>) + sizeof(ArrayColor<uint8_t>) +
+      sizeof(ArrayColor<BitBoard>) + sizeof(ArrayColor<BitBoard>) + sizeof(ArrayColor<CountBoard>) +
       sizeof(uint16_t) + sizeof(uint8_t) + sizeof(CastleFlags) + sizeof(Color) + sizeof(EnPassant) + sizeof(bool);
   std::cout << "Sum is " << sum << '\n';
   std::cout << "sizeof(test::ChessPosition) = " << sizeof(test::ChessPosition) << '\n';
@@ -0,0 +1,662 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file tstfuzz.cxx Play random games and cross-check ChessPosition against a recalculation from scratch.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+//
+// Every thread plays random legal games, starting from random positions or
+// from FEN positions, and checks after every ply that
+//
+// - the incrementally maintained state of ChessPosition (pawn flags, attackers,
+//   pinning, defended counts, castling and en passant) equals that of the same
+//   position set up from scratch (see ChessPosition::verify_incremental_state), and
+// - the legal moves generated by MoveIterator equal those of a naive move
+//   generator in this file that only looks at the pieces on the board.
+//
+// The first failure is shrunk: to the shortest sequence of moves that still
+// reproduces it, and then by removing pieces from the position as long as it
+// keeps failing. The result is printed as a FEN and the moves from there.
+//
+// Usage: tstfuzz [-j <threads>] [-n <plies>] [-g <plies per game>] [-r <seed>] [-f <FEN file>]
+
+#include "sys.h"
+#include "ChessPosition.h"
+#include "ChessNotation.h"
+#include "PieceIterator.h"
+#include "MoveIterator.h"
+#include "debug.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace cwchess;
+
+// Positions with castling, en passant and promotions.
+char const* const builtin_FENs[] = {
+  "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+  "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+  "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+  "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+  "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1",
+  "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+  "rnbqkbnr/ppp1p1pp/8/3pPp2/8/8/PPPP1PPP/RNBQKBNR w KQkq f6 0 3",
+  "8/8/8/2k5/2pP4/8/B7/4K3 b - d3 0 3",
+  "r3k2r/8/8/8/8/8/8/R3K2R w KQkq - 0 1"
+};
+
+//-----------------------------------------------------------------------------
+// A naive move generator.
+
+// A plain copy of the board.
+struct Board {
+  Code M_squares[64];
+  Color M_to_move;
+  bool M_castle[2][2];		// Indexed by white/black and long/short.
+  int M_en_passant;		// The square that was passed by a pawn advancing two squares, or -1.
+
+  Board(ChessPosition const& chess_position);
+
+  Code at(int col, int row) const { return (col < 0 || col > 7 || row < 0 || row > 7) ? Code() : M_squares[col + 8 * row]; }
+  bool on_board(int col, int row) const { return col >= 0 && col <= 7 && row >= 0 && row <= 7; }
+  bool attacked(int col, int row, Color const& by) const { return attackers(col, row, by) > 0; }
+  int attackers(int col, int row, Color const& by) const;
+  bool king_attacked(Color const& color) const;
+  int checkers(Color const& color) const;
+  void apply(Move const& move);
+  void legal_moves(std::vector<Move>& moves) const;
+};
+
+Board::Board(ChessPosition const& chess_position) : M_to_move(chess_position.to_move())
+{
+  for (Index index = index_begin; index != index_end; ++index)
+    M_squares[index()] = chess_position.piece_at(index).code();
+  for (Color color : { Color(white), Color(black) })
+  {
+    M_castle[color == white][0] = chess_position.castle_flags().can_castle_long(color);
+    M_castle[color == white][1] = chess_position.castle_flags().can_castle_short(color);
+  }
+  M_en_passant = chess_position.en_passant().exists() ? chess_position.en_passant().index()() : -1;
+}
+
+int const knight_offsets[8][2] = { { 1, 2 }, { 2, 1 }, { 2, -1 }, { 1, -2 }, { -1, -2 }, { -2, -1 }, { -2, 1 }, { -1, 2 } };
+int const king_offsets[8][2] = { { 0, 1 }, { 1, 1 }, { 1, 0 }, { 1, -1 }, { 0, -1 }, { -1, -1 }, { -1, 0 }, { -1, 1 } };
+// The first four are the directions of a rook, the last four those of a bishop.
+int const (&slider_directions)[8][2] = king_offsets;
+
+bool is_rookmover_direction(int dc, int dr) { return dc == 0 || dr == 0; }
+
+int Board::attackers(int col, int row, Color const& by) const
+{
+  int count = 0;
+  int pawn_row = row - (by == white ? 1 : -1);
+  count += (at(col - 1, pawn_row) == Code(by, pawn)) + (at(col + 1, pawn_row) == Code(by, pawn));
+  for (auto const& offset : knight_offsets)
+    count += at(col + offset[0], row + offset[1]) == Code(by, knight);
+  for (auto const& offset : king_offsets)
+    count += at(col + offset[0], row + offset[1]) == Code(by, king);
+  for (auto const& direction : slider_directions)
+  {
+    Code slider(by, is_rookmover_direction(direction[0], direction[1]) ? rook : bishop);
+    for (int c = col + direction[0], r = row + direction[1]; on_board(c, r); c += direction[0], r += direction[1])
+    {
+      Code code(at(c, r));
+      if (code.is_nothing())
+        continue;
+      count += code == slider || code == Code(by, queen);
+      break;
+    }
+  }
+  return count;
+}
+
+bool Board::king_attacked(Color const& color) const
+{
+  return checkers(color) > 0;
+}
+
+int Board::checkers(Color const& color) const
+{
+  for (int i = 0; i < 64; ++i)
+    if (M_squares[i] == Code(color, king))
+      return attackers(i & 7, i >> 3, color.opposite());
+  return 0;
+}
+
+// Execute a pseudo legal move; only the squares are updated.
+void Board::apply(Move const& move)
+{
+  int from = move.from()(), to = move.to()();
+  Code code(M_squares[from]);
+  if (code.is_a(pawn) && to == M_en_passant)
+    M_squares[(from & ~7) | (to & 7)] = Code();
+  if (code.is_a(king) && (to - from == 2 || from - to == 2))
+  {
+    int rook_from = to > from ? from + 3 : from - 4;
+    M_squares[(from + to) / 2] = M_squares[rook_from];
+    M_squares[rook_from] = Code();
+  }
+  M_squares[from] = Code();
+  M_squares[to] = move.is_promotion() ? Code(code.color(), move.promotion_type()) : code;
+}
+
+void Board::legal_moves(std::vector<Move>& moves) const
+{
+  std::vector<Move> candidates;
+  Color const color(M_to_move);
+  auto add = [&](int from, int col, int row)
+  {
+    Code target(at(col, row));
+    if (!on_board(col, row) || (!target.is_nothing() && target.color() == color))
+      return false;
+    candidates.push_back(Move(IndexData{ static_cast<uint8_t>(from) }, Index(col, row), nothing));
+    return target.is_nothing();
+  };
+  for (int from = 0; from < 64; ++from)
+  {
+    Code code(M_squares[from]);
+    if (code.is_nothing() || code.color() != color)
+      continue;
+    int col = from & 7, row = from >> 3;
+    if (code.is_a(pawn))
+    {
+      int forward = color == white ? 1 : -1;
+      bool promotion = row + forward == (color == white ? 7 : 0);
+      std::vector<int> targets;
+      if (at(col, row + forward).is_nothing())
+      {
+        targets.push_back(col + 8 * (row + forward));
+        if (row == (color == white ? 1 : 6) && at(col, row + 2 * forward).is_nothing())
+          targets.push_back(col + 8 * (row + 2 * forward));
+      }
+      for (int dc : { -1, 1 })
+      {
+        if (!on_board(col + dc, row + forward))
+          continue;
+        int to = col + dc + 8 * (row + forward);
+        Code target(M_squares[to]);
+        if ((!target.is_nothing() && target.color() != color) || to == M_en_passant)
+          targets.push_back(to);
+      }
+      for (int to : targets)
+      {
+        IndexData from_data = { static_cast<uint8_t>(from) }, to_data = { static_cast<uint8_t>(to) };
+        if (promotion)
+          for (Type type : { Type(queen), Type(rook), Type(bishop), Type(knight) })
+            candidates.push_back(Move(from_data, to_data, type));
+        else
+          candidates.push_back(Move(from_data, to_data, nothing));
+      }
+    }
+    else if (code.is_a(knight))
+    {
+      for (auto const& offset : knight_offsets)
+        add(from, col + offset[0], row + offset[1]);
+    }
+    else if (code.is_a(king))
+    {
+      for (auto const& offset : king_offsets)
+        add(from, col + offset[0], row + offset[1]);
+      // Castling.
+      int home_row = color == white ? 0 : 7;
+      if (col == 4 && row == home_row && !attacked(4, home_row, color.opposite()))
+      {
+        if (M_castle[color == white][1] && at(7, home_row) == Code(color, rook) && at(5, home_row).is_nothing() &&
+            at(6, home_row).is_nothing() && !attacked(5, home_row, color.opposite()) && !attacked(6, home_row, color.opposite()))
+          candidates.push_back(Move(IndexData{ static_cast<uint8_t>(from) }, Index(6, home_row), nothing));
+        if (M_castle[color == white][0] && at(0, home_row) == Code(color, rook) && at(1, home_row).is_nothing() &&
+            at(2, home_row).is_nothing() && at(3, home_row).is_nothing() &&
+            !attacked(3, home_row, color.opposite()) && !attacked(2, home_row, color.opposite()))
+          candidates.push_back(Move(IndexData{ static_cast<uint8_t>(from) }, Index(2, home_row), nothing));
+      }
+    }
+    else
+    {
+      for (auto const& direction : slider_directions)
+      {
+        bool rook_direction = is_rookmover_direction(direction[0], direction[1]);
+        if (code.is_a(rook) ? !rook_direction : code.is_a(bishop) ? rook_direction : false)
+          continue;
+        for (int c = col + direction[0], r = row + direction[1]; add(from, c, r); c += direction[0], r += direction[1])
+          ;
+      }
+    }
+  }
+  for (Move const& move : candidates)
+  {
+    Board board(*this);
+    board.apply(move);
+    if (!board.king_attacked(color))
+      moves.push_back(move);
+  }
+}
+
+//-----------------------------------------------------------------------------
+// Checking.
+
+// A move in coordinate notation, for example e7e8q.
+std::string coordinates(Move const& move)
+{
+  std::string result;
+  result += 'a' + move.from().col();
+  result += '1' + move.from().row();
+  result += 'a' + move.to().col();
+  result += '1' + move.to().row();
+  if (move.is_promotion())
+    result += move.promotion_type() == queen ? 'q' : move.promotion_type() == rook ? 'r' : move.promotion_type() == bishop ? 'b' : 'n';
+  return result;
+}
+
+unsigned int key(Move const& move)
+{
+  return (move.from()() << 16) | (move.to()() << 8) | move.promotion_type()();
+}
+
+void engine_moves(ChessPosition const& chess_position, std::vector<Move>& moves)
+{
+  MoveIterator const move_end;
+  for (PieceIterator piece_iter(chess_position.piece_begin(chess_position.to_move())); piece_iter != chess_position.piece_end(); ++piece_iter)
+    for (MoveIterator move_iter(chess_position.move_begin(piece_iter.index())); move_iter != move_end; ++move_iter)
+      moves.push_back(*move_iter);
+}
+
+// Return TRUE if chess_position fails one of the checks, with a description in difference.
+// Upon success the legal moves are returned in moves.
+bool fails(ChessPosition const& chess_position, std::vector<Move>& moves, std::string& difference)
+{
+  if (!chess_position.verify_incremental_state(difference))
+    return true;
+  Board board(chess_position);
+  int checkers = board.checkers(chess_position.to_move());
+  if (chess_position.check() != (checkers > 0) || chess_position.double_check(chess_position.to_move()) != (checkers > 1))
+  {
+    difference = "the king to move is attacked by " + std::to_string(checkers) + " pieces, but check() is " +
+        std::to_string(chess_position.check()) + " and double_check() is " + std::to_string(chess_position.double_check(chess_position.to_move()));
+    return true;
+  }
+  std::vector<Move> reference;
+  board.legal_moves(reference);
+  moves.clear();
+  engine_moves(chess_position, moves);
+  auto by_key = [](Move const& m1, Move const& m2){ return key(m1) < key(m2); };
+  std::sort(reference.begin(), reference.end(), by_key);
+  std::sort(moves.begin(), moves.end(), by_key);
+  if (moves.size() == reference.size() && std::equal(moves.begin(), moves.end(), reference.begin(),
+      [](Move const& m1, Move const& m2){ return key(m1) == key(m2); }))
+    return false;
+  std::ostringstream os;
+  os << "the legal moves differ:";
+  for (Move const& move : moves)
+    if (std::find_if(reference.begin(), reference.end(), [&](Move const& m){ return key(m) == key(move); }) == reference.end())
+      os << " MoveIterator generates " << coordinates(move) << ';';
+  for (Move const& move : reference)
+    if (std::find_if(moves.begin(), moves.end(), [&](Move const& m){ return key(m) == key(move); }) == moves.end())
+      os << " MoveIterator misses " << coordinates(move) << ';';
+  difference = os.str();
+  difference.pop_back();
+  return true;
+}
+
+// A start position and moves from there.
+struct Reproduction {
+  std::string FEN;
+  std::vector<Move> moves;
+};
+
+// Return TRUE if the reproduction still fails; the moves must be legal according to the naive move generator.
+bool reproduces(Reproduction const& reproduction, std::string& difference)
+{
+  ChessPosition chess_position;
+  if (!chess_position.load_FEN(reproduction.FEN))
+    return false;
+  // A position where the side that isn't to move is in check can't be reached,
+  // and castling rights need the king and rook on their initial squares.
+  Board board(chess_position);
+  if (board.king_attacked(chess_position.to_move().opposite()))
+    return false;
+  for (Color color : { Color(white), Color(black) })
+  {
+    int row = color == white ? 0 : 7;
+    bool has_king = board.at(4, row) == Code(color, king);
+    if ((board.M_castle[color == white][0] && (!has_king || board.at(0, row) != Code(color, rook))) ||
+        (board.M_castle[color == white][1] && (!has_king || board.at(7, row) != Code(color, rook))))
+      return false;
+  }
+  std::vector<Move> moves;
+  for (Move const& move : reproduction.moves)
+  {
+    std::vector<Move> legal;
+    board.legal_moves(legal);
+    if (std::find_if(legal.begin(), legal.end(), [&](Move const& m){ return key(m) == key(move); }) == legal.end())
+      return false;
+    chess_position.execute(move);
+    board = Board(chess_position);
+  }
+  return fails(chess_position, moves, difference);
+}
+
+// Remove one field of a FEN piece placement at (col, row); return an empty string if there is no piece or it is a king.
+std::string remove_piece(std::string const& FEN, int col, int row)
+{
+  ChessPosition chess_position;
+  chess_position.load_FEN(FEN);
+  Code code(chess_position.piece_at(col, row).code());
+  if (code.is_nothing() || code.is_a(king))
+    return std::string();
+  std::string placement(FEN, 0, FEN.find(' '));
+  // Expand digits, remove the piece, and compress again.
+  std::string expanded;
+  for (char c : placement)
+    if (c >= '1' && c <= '8')
+      expanded.append(c - '0', '1');
+    else
+      expanded += c;
+  expanded[(7 - row) * 9 + col] = '1';
+  std::string result;
+  int empty = 0;
+  for (char c : expanded)
+    if (c == '1')
+      ++empty;
+    else
+    {
+      if (empty)
+        result += '0' + empty;
+      empty = 0;
+      result += c;
+    }
+  if (empty)
+    result += '0' + empty;
+  return result + FEN.substr(FEN.find(' '));
+}
+
+// Make the reproduction as small as possible.
+void shrink(Reproduction& reproduction, std::string& difference)
+{
+  // Start as late as possible.
+  while (!reproduction.moves.empty())
+  {
+    ChessPosition chess_position;
+    chess_position.load_FEN(reproduction.FEN);
+    chess_position.execute(reproduction.moves.front());
+    Reproduction shorter = { chess_position.FEN(), std::vector<Move>(reproduction.moves.begin() + 1, reproduction.moves.end()) };
+    std::string shorter_difference;
+    if (!reproduces(shorter, shorter_difference))
+      break;
+    reproduction = shorter;
+    difference = shorter_difference;
+  }
+  // Remove pieces, and castling and en passant rights, as long as it keeps failing.
+  bool progress = true;
+  while (progress)
+  {
+    progress = false;
+    std::vector<std::string> smaller;
+    for (int row = 0; row < 8; ++row)
+      for (int col = 0; col < 8; ++col)
+      {
+        std::string FEN(remove_piece(reproduction.FEN, col, row));
+        if (!FEN.empty())
+          smaller.push_back(FEN);
+      }
+    std::istringstream fields(reproduction.FEN);
+    std::string placement, to_move, castling, en_passant, rest;
+    fields >> placement >> to_move >> castling >> en_passant;
+    std::getline(fields, rest);
+    for (size_t i = 0; castling != "-" && i < castling.size(); ++i)
+    {
+      std::string fewer(castling);
+      fewer.erase(i, 1);
+      smaller.push_back(placement + ' ' + to_move + ' ' + (fewer.empty() ? "-" : fewer) + ' ' + en_passant + rest);
+    }
+    if (en_passant != "-")
+      smaller.push_back(placement + ' ' + to_move + ' ' + castling + " -" + rest);
+    for (std::string const& FEN : smaller)
+    {
+      Reproduction candidate = { FEN, reproduction.moves };
+      std::string candidate_difference;
+      if (reproduces(candidate, candidate_difference))
+      {
+        reproduction = candidate;
+        difference = candidate_difference;
+        progress = true;
+        break;
+      }
+    }
+  }
+}
+
+//-----------------------------------------------------------------------------
+// The fuzzer.
+
+// SplitMix64, like pgn::CorpusGenerator; every thread has its own.
+struct Random {
+  uint64_t M_state;
+  Random(uint64_t seed) : M_state(seed) { }
+  uint64_t operator()()
+  {
+    uint64_t z = (M_state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+  }
+  unsigned int operator()(unsigned int n) { return (*this)() % n; }
+};
+
+// Return the FEN of a random position with both kings, without castling or en passant,
+// where the side that is not to move is not in check.
+std::string random_position(Random& random)
+{
+  Type const types[] = { pawn, pawn, pawn, knight, bishop, rook, queen };
+  for (;;)
+  {
+    ChessPosition chess_position;
+    chess_position.clear();
+    chess_position.place(white_king, IndexData{ static_cast<uint8_t>(random(64)) });
+    chess_position.place(black_king, IndexData{ static_cast<uint8_t>(random(64)) });
+    if (!chess_position.all(white_king) || !chess_position.all(black_king))
+      continue;
+    unsigned int pieces = random(24);
+    for (unsigned int i = 0; i < pieces; ++i)
+    {
+      Index index(IndexData{ static_cast<uint8_t>(random(64)) });
+      if (chess_position.piece_at(index).code().is_nothing())
+        chess_position.place(Code(random(2) ? white : black, types[random(7)]), index);	// Fails for pawns on the first and last row.
+    }
+    chess_position.to_move(random(2) ? white : black);
+    std::string FEN(chess_position.FEN());
+    // The kings may not be next to each other, and the side that isn't to move may not be in check.
+    ChessPosition check;
+    if (check.load_FEN(FEN) && !Board(check).king_attacked(check.to_move().opposite()))
+      return FEN;
+  }
+}
+
+struct Options {
+  unsigned int threads;
+  uint64_t plies;
+  unsigned int plies_per_game;
+  uint64_t seed;
+  std::vector<std::string> FENs;
+};
+
+std::atomic<uint64_t> plies_done(0);
+std::atomic<uint64_t> games_done(0);
+std::atomic<bool> stop(false);
+std::mutex failure_mutex;
+bool failed = false;
+Reproduction failure;
+std::string failure_difference;
+
+void fuzz(Options const& options, unsigned int thread)
+{
+  Random random(options.seed + 0x632be59bd9b4e019ULL * thread);
+  std::vector<Move> moves;
+  std::string difference;
+  while (!stop.load(std::memory_order_relaxed))
+  {
+    Reproduction reproduction;
+    reproduction.FEN = random(2) ? random_position(random) : options.FENs[random(options.FENs.size())];
+    ChessPosition chess_position;
+    chess_position.load_FEN(reproduction.FEN);
+    unsigned int ply = 0;
+    for (;;)
+    {
+      if (fails(chess_position, moves, difference))
+      {
+        std::lock_guard<std::mutex> lock(failure_mutex);
+        if (!failed)
+        {
+          failed = true;
+          failure = reproduction;
+          failure_difference = difference;
+        }
+        stop = true;
+        return;
+      }
+      if (moves.empty() || ply == options.plies_per_game)
+        break;
+      Move const move(moves[random(moves.size())]);
+      chess_position.execute(move);
+      reproduction.moves.push_back(move);
+      ++ply;
+    }
+    games_done.fetch_add(1, std::memory_order_relaxed);
+    if (plies_done.fetch_add(ply, std::memory_order_relaxed) + ply >= options.plies)
+      stop = true;
+  }
+}
+
+void usage(char const* program)
+{
+  std::cerr << "Usage: " << program << " [-j <threads>] [-n <plies>] [-g <plies per game>] [-r <seed>] [-f <FEN file>]\n"
+               "Plays random games (default 1000000 plies in total, at most 300 per game) on all cores and checks ChessPosition\n"
+	       "after every ply. The games start from random positions or from FENs, one per line in the FEN file." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+
+  Options options;
+  options.threads = std::max(1U, std::thread::hardware_concurrency());
+  options.plies = 1000000;
+  options.plies_per_game = 300;
+  options.seed = 1220638382;
+  options.FENs.assign(std::begin(builtin_FENs), std::end(builtin_FENs));
+  int opt;
+  while ((opt = getopt(argc, argv, "j:n:g:r:f:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'j':
+	options.threads = std::max(1, std::atoi(optarg));
+	break;
+      case 'n':
+	options.plies = std::strtod(optarg, NULL);	// Allows 1e9.
+	break;
+      case 'g':
+	options.plies_per_game = std::max(1, std::atoi(optarg));
+	break;
+      case 'r':
+	options.seed = std::strtoull(optarg, NULL, 0);
+	break;
+      case 'f':
+      {
+	std::ifstream file(optarg);
+	if (!file)
+	{
+	  std::cerr << "Can't open " << optarg << '.' << std::endl;
+	  return 1;
+	}
+	std::string line;
+	while (std::getline(file, line))
+	{
+	  ChessPosition chess_position;
+	  if (line.empty() || line[0] == '#')
+	    continue;
+	  if (!chess_position.load_FEN(line))
+	  {
+	    std::cerr << "Invalid FEN: " << line << std::endl;
+	    return 1;
+	  }
+	  options.FENs.push_back(line);
+	}
+	break;
+      }
+      default:
+	usage(argv[0]);
+	return 1;
+    }
+  }
+  if (optind != argc)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::cout << "Playing " << options.plies << " plies on " << options.threads << " threads (seed " << options.seed << ")." << std::endl;
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (unsigned int thread = 0; thread < options.threads; ++thread)
+    threads.emplace_back(fuzz, std::cref(options), thread);
+  auto last_report = start;
+  while (!stop)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    auto now = std::chrono::steady_clock::now();
+    if (now - last_report >= std::chrono::seconds(10))
+    {
+      last_report = now;
+      double seconds = std::chrono::duration<double>(now - start).count();
+      std::cerr << plies_done << " plies, " << games_done << " games, " << uint64_t(plies_done / seconds) << " plies/s" << std::endl;
+    }
+  }
+  for (std::thread& thread : threads)
+    thread.join();
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  if (failed)
+  {
+    std::cout << "FAILED after " << failure.moves.size() << " plies from \"" << failure.FEN << "\": " << failure_difference << std::endl;
+    shrink(failure, failure_difference);
+    std::cout << "Shrunk to \"" << failure.FEN << "\"";
+    if (!failure.moves.empty())
+    {
+      std::cout << " with move";
+      if (failure.moves.size() > 1)
+        std::cout << 's';
+      for (Move const& move : failure.moves)
+        std::cout << ' ' << coordinates(move);
+    }
+    std::cout << ": " << failure_difference << std::endl;
+    return 1;
+  }
+  std::cout << plies_done << " plies in " << games_done << " games in " << seconds << " seconds; no differences found." << std::endl;
+  return 0;
+}
@@ -0,0 +1,142 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file tstopeningtree.cxx Build an opening tree for a PGN database and browse it.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDatabase.h"
+#include "PgnOpeningTree.h"
+#include "ChessNotation.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+
+using namespace cwchess;
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+Glib::RefPtr<pgn::Database> pgn_data_base;
+char const* tree_file;
+unsigned int number_of_plies = 30;
+char const* FEN;
+
+double seconds_since(timespec const& start)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void print_statistics(pgn::OpeningTree::Statistics const& statistics)
+{
+  uint32_t date = statistics.last_played;
+  std::cout << std::setfill(' ') << std::setw(8) << statistics.games << " games, " <<
+      std::fixed << std::setprecision(1) << std::setw(5) << 100 * statistics.white_score() << "% " <<
+      '(' << statistics.white_wins << '/' << statistics.draws << '/' << statistics.black_wins << "), Elo " <<
+      statistics.average_elo() << ", last played " << (date >> 9) << '.' << ((date >> 5) & 15) << '.' << (date & 31) << '\n';
+}
+
+void open_finished(size_t)
+{
+  main_loop->quit();
+
+  pgn::TagStore const& tag_store(pgn_data_base->tag_store());
+  pgn::MoveStore const& move_store(pgn_data_base->move_store());
+  std::cout << "Building opening tree of " << number_of_plies << " plies for " << move_store.size() << " games..." << std::endl;
+  timespec start;
+  clock_gettime(CLOCK_REALTIME, &start);
+  pgn::OpeningTree::BuildOptions options;
+  options.number_of_plies = number_of_plies;
+  if (!pgn::OpeningTree::build(tag_store, move_store, tree_file, options))
+  {
+    std::cerr << "Failed to write " << tree_file << std::endl;
+    return;
+  }
+  std::cout << "Build time: " << seconds_since(start) << " seconds." << std::endl;
+
+  pgn::OpeningTree tree;
+  if (!tree.open(tree_file))
+  {
+    std::cerr << "Failed to open " << tree_file << std::endl;
+    return;
+  }
+  std::cout << "Number of distinct positions: " << tree.number_of_positions() << std::endl;
+
+  ChessPosition chess_position;
+  if (!FEN)
+    chess_position.initial_position();
+  else if (!chess_position.load_FEN(FEN))
+  {
+    std::cerr << "Invalid FEN: " << FEN << std::endl;
+    return;
+  }
+  pgn::OpeningTree::Statistics statistics;
+  std::vector<pgn::OpeningTree::Child> children;
+  clock_gettime(CLOCK_REALTIME, &start);
+  bool found = tree.find(chess_position, statistics);
+  tree.children(chess_position, children);
+  std::cout << "Query time: " << seconds_since(start) << " seconds.\n";
+  if (!found)
+  {
+    std::cout << "The position is not in the tree." << std::endl;
+    return;
+  }
+  std::cout << "Position: ";
+  print_statistics(statistics);
+
+  // Show the most popular continuations first.
+  std::sort(children.begin(), children.end(),
+      [](pgn::OpeningTree::Child const& c1, pgn::OpeningTree::Child const& c2){ return c1.statistics.games > c2.statistics.games; });
+  for (pgn::OpeningTree::Child const& child : children)
+  {
+    std::ostringstream move;
+    move << ChessNotation(chess_position, child.move);
+    std::cout << "  " << std::setfill(' ') << std::setw(6) << std::left << move.str() << std::right;
+    print_statistics(child.statistics);
+  }
+  std::cout.flush();
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Gio::init();
+
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <database.pgn> <tree file> [<plies> [<FEN>]]" << std::endl;
+    return 1;
+  }
+  tree_file = argv[2];
+  if (argc > 3)
+    number_of_plies = std::atoi(argv[3]);
+  if (argc > 4)
+    FEN = argv[4];
+  pgn_data_base = pgn::DatabaseSeekable::open(argv[1], sigc::ptr_fun(&open_finished));
+  main_loop = Glib::MainLoop::create(false);
+  main_loop->run();
+}
@@ -36,10 +36,38 @@ char const* filename="/home/carlo/projects/cwchessboard/cwchessboard/torture.pgn
 using namespace cwchess;
 
 Glib::RefPtr<Glib::MainLoop> main_loop;
+Glib::RefPtr<pgn::Database> pgn_data_base;
+char const* tags_file;
+size_t printed_games;
+
+// Called while following a file, each time new games were parsed.
+void games_added(size_t complete_games)
+{
+  Glib::Mutex::Lock lock(pgn_data_base->store_mutex());
+  pgn::TagStore const& tag_store(pgn_data_base->tag_store());
+  for (; printed_games < complete_games; ++printed_games)
+    std::cout << printed_games + 1 << ". " << tag_store.white(printed_games) << " - " << tag_store.black(printed_games) << '\n';
+  std::cout << std::flush;
+}
+
+// Called in the read thread for every game read from standard input.
+void game_completed(pgn::Database const& database, uint32_t game_id)
+{
+  pgn::TagStore const& tag_store(database.tag_store());
+  std::cout << ++printed_games << ". " << tag_store.white(game_id) << " - " << tag_store.black(game_id) << '\n';
+}
 
 void open_finished(size_t len)
 {
   std::cout << "Total size read: " << len << '\n';
+  std::cout << "Number of games: " << pgn_data_base->progress().sample().games << '\n';
+  pgn::Diagnostics const& diagnostics(pgn_data_base->diagnostics());
+  for (pgn::Diagnostics::Entry const& entry : diagnostics)
+    std::cout << entry << '\n';
+  if (diagnostics.dropped())
+    std::cout << "... and " << diagnostics.dropped() << " more problems.\n";
+  if (tags_file && !pgn_data_base->tag_store().save(tags_file))
+    std::cerr << "Failed to write " << tags_file << std::endl;
   main_loop->quit();
 }
 
@@ -50,10 +78,29 @@ int main(int argc, char* argv[])
     Glib::thread_init();
   Gio::init();
 
+  // With -f, keep following the file and print the games that are appended to it.
+  bool follow = argc > 1 && std::string(argv[1]) == "-f";
+  if (follow)
+  {
+    --argc;
+    ++argv;
+  }
   char const* infile = filename;
   if (argc > 1)
     infile = argv[1];
-  Glib::RefPtr<pgn::Database> pgn_data_base = pgn::DatabaseSeekable::open(infile, sigc::ptr_fun(&open_finished));
+  // Optionally, write the tag store (including the game offsets) to a file.
+  if (argc > 2)
+    tags_file = argv[2];
+  if (std::string(infile) == "-")
+  {
+    // Read standard input, for example: zcat games.pgn.gz | tstpgn -
+    // The games are printed as they come in and not kept.
+    pgn_data_base = pgn::DatabaseStream::open(0, sigc::ptr_fun(&open_finished), sigc::ptr_fun(&game_completed), false);
+  }
+  else if (follow)
+    pgn_data_base = pgn::DatabaseSeekable::follow(infile, sigc::ptr_fun(&open_finished), sigc::ptr_fun(&games_added));
+  else
+    pgn_data_base = pgn::DatabaseSeekable::open(infile, sigc::ptr_fun(&open_finished));
   main_loop = Glib::MainLoop::create(false);
   main_loop->run();
 }
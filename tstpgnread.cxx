@@ -2,152 +2,139 @@
 // with as goal to get to the end fast (maximum disk speed).
 // That means that we want to read an integer number of
 // blocks (likely 4096 bytes) at a time.
+//
+// Every reader implementation is run on the same file, with a warm
+// and/or a cold page cache. If no file is given, a synthetic corpus
+// is generated with pgn::CorpusGenerator (see also pgngen), so that
+// the results are reproducible on any machine.
+//
+// The page cache of the file is dropped with posix_fadvise(POSIX_FADV_DONTNEED),
+// which doesn't need root privileges; the fraction of the file that was still
+// cached when a cold run started is printed, since not every file system honors it.
 
 #include "sys.h"
 #include "debug.h"
+#include "PgnCorpusGenerator.h"
+#include "PgnWriter.h"
+#include "PgnDatabase.h"
+#include <giomm/init.h>
+#include <gio/gio.h>
 #include <iostream>
+#include <iomanip>
 #include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cerrno>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <stdint.h>
-#include <sys/time.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <gio/gio.h>
-
-char const* filename="/opt/verylarge/chessgames/ftp.cis.uab.edu/crafty/enormous.pgn";
-char const* warmupfile="/home/carlo/chess/fics2008.pgn";
-
-//#define REFERENCE_IMPLEMENTATION
-//#define BUFFERSIZE_IMPLEMENTATION
-//#define FSTREAM_READ_IMPLEMENTATION
-//#define FSTREAM_GETLINE_IMPLEMENTATION
-//#define GFILE_IMPLEMENTATION
-//#define GFILE_ASYNC_IMPLEMENTATION
-#define CWCHESS_PGN_IMPLEMENTATION
-
-#ifdef GFILE_ASYNC_IMPLEMENTATION
-#include <gio/gio.h>
-#include "PgnDatabase.h"		// Needed for cwchess::pgn::DatabaseSeekable::S_buffer_size.
-#endif
-#ifdef CWCHESS_PGN_IMPLEMENTATION
-#include <giomm/init.h>
-#include "PgnDatabase.h"
-#endif
-#if defined(GFILE_ASYNC_IMPLEMENTATION) || defined(CWCHESS_PGN_IMPLEMENTATION)
-std::ostream* global_os;
-#endif
 
-struct timeval before, after;
+using namespace cwchess;
 
-inline void start_timer()
-{
-  gettimeofday(&before, NULL);
-}
+// The result of one run of a reader.
+struct Result {
+  uint64_t bytes;
+  uint64_t lines;			// The number of lines, or games for memoryblocklist.
+};
 
-uint64_t stop_timer()
-{
-  gettimeofday(&after, NULL);
-  timersub(&after, &before, &after);
-  uint64_t t = after.tv_sec;
-  t *= 1000000;
-  t += after.tv_usec;
-  return t;
-}
+typedef std::chrono::steady_clock clock_type;
+clock_type::time_point start_time;
+double elapsed;				// Set by the readers that finish in a callback.
 
 char buf[4096 * 50];
 
-#ifdef REFERENCE_IMPLEMENTATION
-void benchmark_reference(std::ostream& os, char const* filename)
+uint64_t count_lines(char const* data, size_t len)
 {
-  int fd = open(filename, O_RDONLY);
-  size_t len = 0;
-  start_timer();
-  while(len < 945950820)
+  uint64_t lines = 0;
+  char const* const end = data + len;
+  while ((data = static_cast<char const*>(std::memchr(data, '\n', end - data))))
   {
-    int s = read(fd, buf, sizeof(buf));
-    if (s == -1)
-    {
-      perror("read");
-      exit(0);
-    }
-    else if (s == 0)
-      break;
-    len += s;
+    ++lines;
+    ++data;
   }
-  uint64_t microseconds = stop_timer();
-  os << "Reference implementation (buffersize " << sizeof(buf) << "): " << microseconds << " microseconds." << std::endl;
-  close(fd);
+  return lines;
 }
-#endif
 
-#ifdef BUFFERSIZE_IMPLEMENTATION
-void benchmark_buffersize(std::ostream& os, char const* filename)
+Result read_syscall(char const* filename)
 {
-  size_t const bufsize = 4096;
+  Result result = { 0, 0 };
   int fd = open(filename, O_RDONLY);
-  size_t len = 0;
-  start_timer();
-  while(len < 945950820)
+  start_time = clock_type::now();
+  ssize_t len;
+  while ((len = read(fd, buf, sizeof(buf))) > 0)
   {
-    int s = read(fd, buf, bufsize);
-    if (s == -1)
-    {
-      perror("read");
-      exit(0);
-    }
-    else if (s == 0)
-      break;
-    len += s;
+    result.bytes += len;
+    result.lines += count_lines(buf, len);
   }
-  uint64_t microseconds = stop_timer();
-  os << "read(2) (buffersize " << bufsize << "): " << microseconds << " microseconds." << std::endl;
+  if (len == -1)
+    perror("read");
   close(fd);
+  return result;
 }
-#endif
 
-#ifdef FSTREAM_READ_IMPLEMENTATION
-void benchmark_fstream_read(std::ostream& os, char const* filename)
+Result fstream_read(char const* filename)
 {
-  std::ifstream inputfile;
-  inputfile.open(filename);
-  start_timer();
-  size_t len = 0;
-  while(inputfile)
+  Result result = { 0, 0 };
+  std::ifstream inputfile(filename);
+  start_time = clock_type::now();
+  while (inputfile)
   {
     inputfile.read(buf, 4096);
-    len += inputfile.gcount();
+    result.bytes += inputfile.gcount();
+    result.lines += count_lines(buf, inputfile.gcount());
   }
-  uint64_t microseconds = stop_timer();
-  os << "std::ifstream::read (buffersize 4096): " << microseconds << " microseconds. Size read: " << len << std::endl;
-  inputfile.close();
+  return result;
 }
-#endif
 
-#ifdef FSTREAM_GETLINE_IMPLEMENTATION
-void benchmark_fstream_getline(std::ostream& os, char const* filename)
+Result fstream_getline(char const* filename)
 {
-  std::ifstream inputfile;
-  inputfile.open(filename);
-  start_timer();
-  size_t len = 0;
+  Result result = { 0, 0 };
+  std::ifstream inputfile(filename);
+  start_time = clock_type::now();
   std::string line;
-  while(getline(inputfile, line))
+  while (std::getline(inputfile, line))
   {
-    len += line.length() + 1;
+    result.bytes += line.length() + 1;
+    ++result.lines;
+  }
+  return result;
+}
+
+Result mmap_read(char const* filename)
+{
+  Result result = { 0, 0 };
+  int fd = open(filename, O_RDONLY);
+  start_time = clock_type::now();
+  struct stat st;
+  fstat(fd, &st);
+  if (st.st_size > 0)
+  {
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED)
+      perror("mmap");
+    else
+    {
+      madvise(data, st.st_size, MADV_SEQUENTIAL);
+      result.bytes = st.st_size;
+      result.lines = count_lines(static_cast<char const*>(data), st.st_size);
+      munmap(data, st.st_size);
+    }
   }
-  uint64_t microseconds = stop_timer();
-  os << "std::getline(std::ifstream, ...): " << microseconds << " microseconds. Size read: " << len << std::endl;
-  inputfile.close();
+  close(fd);
+  return result;
 }
-#endif
 
-#ifdef GFILE_IMPLEMENTATION
-void benchmark_gfile(std::ostream& os, char const* filename)
+Result gfile_read(char const* filename)
 {
-  g_type_init();
+  Result result = { 0, 0 };
   GFile* file = g_file_new_for_path(filename);
   GCancellable* cancellable = g_cancellable_new();
   GError* error = NULL;
@@ -157,193 +144,331 @@ void benchmark_gfile(std::ostream& os, char const* filename)
     std::cerr << "g_file_read failed: " << error->message << std::endl;
     exit(1);
   }
-  start_timer();
-  size_t len = 0;
+  start_time = clock_type::now();
   gssize res;
-  do
+  while ((res = g_input_stream_read(G_INPUT_STREAM(stream), buf, 4096, cancellable, &error)) > 0)
   {
-    res = g_input_stream_read(G_INPUT_STREAM(stream), buf, 4096, cancellable, &error);
-    if (res == -1)
-    {
-      std::cerr << "g_input_stream_read: " << error->message << std::endl;
-      exit(1);
-    }
-    len += res;
+    result.bytes += res;
+    result.lines += count_lines(buf, res);
+  }
+  if (res == -1)
+  {
+    std::cerr << "g_input_stream_read: " << error->message << std::endl;
+    exit(1);
   }
-  while(res > 0);
-  uint64_t microseconds = stop_timer();
-  os << "g_input_stream_read (buffersize 4096): " << microseconds << " microseconds. Size read: " << len << std::endl;
   g_object_unref(stream);
   g_object_unref(cancellable);
   g_object_unref(file);
+  return result;
 }
-#endif
 
-#ifdef GFILE_ASYNC_IMPLEMENTATION
 GMainLoop* gmain_loop;
 GCancellable* cancellable;
-void async_ready_callback(GObject* source_object, GAsyncResult* async_res, gpointer user_data);
-void async_ready_callback2(GObject* source_object, GAsyncResult* async_res, gpointer user_data);
+Result async_result;
+
+void async_ready_callback2(GObject* source_object, GAsyncResult* async_res, gpointer user_data)
+{
+  GInputStream* stream = G_INPUT_STREAM(user_data);
+  GError* error = NULL;
+  gssize res = g_input_stream_read_finish(stream, async_res, &error);
+  if (res == -1)
+  {
+    std::cerr << "g_input_stream_read_finish: " << error->message << std::endl;
+    exit(1);
+  }
+  async_result.bytes += res;
+  async_result.lines += count_lines(buf, res);
+  if (res > 0)
+    g_input_stream_read_async(stream, buf, pgn::DatabaseSeekable::S_buffer_size, G_PRIORITY_DEFAULT, cancellable, async_ready_callback2, stream);
+  else
+  {
+    g_object_unref(stream);
+    g_main_loop_quit(gmain_loop);
+  }
+}
+
+void async_ready_callback(GObject* source_object, GAsyncResult* async_res, gpointer user_data)
+{
+  GFile* file = G_FILE(user_data);
+  GError* error = NULL;
+  GFileInputStream* stream = g_file_read_finish(file, async_res, &error);
+  if (stream == NULL)
+  {
+    std::cerr << "g_file_read_finish failed: " << error->message << std::endl;
+    exit(1);
+  }
+  g_input_stream_read_async(G_INPUT_STREAM(stream), buf, pgn::DatabaseSeekable::S_buffer_size,
+      G_PRIORITY_DEFAULT, cancellable, async_ready_callback2, stream);
+}
 
-void benchmark_gfile_async(std::ostream& os, char const* filename)
+Result gfile_read_async(char const* filename)
 {
-  g_type_init();
-  global_os = &os;
+  async_result.bytes = async_result.lines = 0;
   GFile* file = g_file_new_for_path(filename);
   cancellable = g_cancellable_new();
+  start_time = clock_type::now();
   g_file_read_async(file, G_PRIORITY_DEFAULT, cancellable, async_ready_callback, file);
   gmain_loop = g_main_loop_new(NULL, false);
   g_main_loop_run(gmain_loop);
+  g_main_loop_unref(gmain_loop);
   g_object_unref(cancellable);
   g_object_unref(file);
+  return async_result;
 }
-#endif
 
-#ifdef CWCHESS_PGN_IMPLEMENTATION
 Glib::RefPtr<Glib::MainLoop> main_loop;
-Glib::RefPtr<cwchess::pgn::Database> pgn_data_base;
-void open_finished(size_t len);
+Glib::RefPtr<pgn::Database> pgn_data_base;
+util::BlockReader::Options read_options(pgn::DatabaseSeekable::S_buffer_size);
 
-void benchmark_cwchess_pgn(std::ostream& os, char const* filename)
+size_t bytes_read;
+pgn::ImportTiming import_timing;	// Where the time of the last memoryblocklist run went.
+
+void open_finished(size_t len)
+{
+  bytes_read = len;
+  elapsed = std::chrono::duration<double>(clock_type::now() - start_time).count();
+  main_loop->quit();
+}
+
+// Reads the file into a MemoryBlockList and parses it.
+Result memory_block_list(char const* filename)
 {
-  using namespace cwchess;
-  Gio::init();
-  global_os = &os;
-  pgn_data_base = pgn::DatabaseSeekable::open(filename, sigc::ptr_fun(&open_finished));
   main_loop = Glib::MainLoop::create(false);
-  start_timer();
+  start_time = clock_type::now();
+  pgn_data_base = pgn::DatabaseSeekable::open(filename, sigc::ptr_fun(&open_finished), read_options);
   main_loop->run();
+  Result result = { bytes_read, pgn_data_base->number_of_games() };
+  import_timing = pgn_data_base->import_timing();
+  pgn_data_base.reset();
+  return result;
 }
-#endif
 
-void clear_disk_cache()
+struct Reader {
+  char const* name;
+  Result (*function)(char const* filename);
+  bool parses;				// Set when the reader parses the games; it sets elapsed itself and counts games instead of lines.
+};
+
+Reader const readers[] = {
+  { "read", read_syscall, false },
+  { "fstream_read", fstream_read, false },
+  { "fstream_getline", fstream_getline, false },
+  { "gio", gfile_read, false },
+  { "gio_async", gfile_read_async, false },
+  { "memoryblocklist", memory_block_list, true },
+  { "mmap", mmap_read, false }
+};
+
+// Return the fraction of the file that is in the page cache.
+double cached_fraction(char const* filename)
 {
-  // Free pagecache.
-  system("sudo sh -c \"sync; echo 1 > /proc/sys/vm/drop_caches\"");
-  // Warm up (read libraries etc).
-  start_timer();
-  stop_timer();
-  std::ofstream dump("/dev/null");
-  //std::ostream& dump(std::cout);
-#ifdef REFERENCE_IMPLEMENTATION
-  benchmark_reference(dump, warmupfile);
-#endif
-#ifdef BUFFERSIZE_IMPLEMENTATION
-  benchmark_buffersize(dump, warmupfile);
-#endif
-#ifdef FSTREAM_READ_IMPLEMENTATION
-  benchmark_fstream_read(dump, warmupfile);
-#endif
-#ifdef FSTREAM_GETLINE_IMPLEMENTATION
-  benchmark_fstream_getline(dump, warmupfile);
-#endif
-#ifdef GFILE_IMPLEMENTATION
-  benchmark_gfile(dump, warmupfile);
-#endif
-#ifdef GFILE_ASYNC_IMPLEMENTATION
-  benchmark_gfile_async(dump, warmupfile);
-#endif
-#ifdef CWCHESS_PGN_IMPLEMENTATION
-  benchmark_cwchess_pgn(dump, warmupfile);
-#endif
-  dump.close();
-  // Sleep to let other running application catch up too.
-  sleep(1);
+  int fd = open(filename, O_RDONLY);
+  struct stat st;
+  fstat(fd, &st);
+  double fraction = 0;
+  if (st.st_size > 0)
+  {
+    void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    long page_size = sysconf(_SC_PAGESIZE);
+    size_t pages = (st.st_size + page_size - 1) / page_size;
+    std::vector<unsigned char> residency(pages);
+    if (data != MAP_FAILED && mincore(data, st.st_size, residency.data()) == 0)
+      fraction = double(std::count_if(residency.begin(), residency.end(), [](unsigned char c){ return c & 1; })) / pages;
+    if (data != MAP_FAILED)
+      munmap(data, st.st_size);
+  }
+  close(fd);
+  return fraction;
 }
 
-int main()
+void drop_cache(char const* filename)
 {
-  if (!Glib::thread_supported())
-      Glib::thread_init();
-  Debug(NAMESPACE_DEBUG::init());
-
-#ifdef REFERENCE_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_reference(std::cout, filename);
-#endif
-
-#ifdef BUFFERSIZE_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_buffersize(std::cout, filename);
-#endif
-
-#ifdef FSTREAM_READ_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_fstream_read(std::cout, filename);
-#endif
-
-#ifdef FSTREAM_GETLINE_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_fstream_getline(std::cout, filename);
-#endif
-
-#ifdef GFILE_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_gfile(std::cout, filename);
-#endif
-
-#ifdef GFILE_ASYNC_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_gfile_async(std::cout, filename);
-#endif
-
-#ifdef CWCHESS_PGN_IMPLEMENTATION
-  clear_disk_cache();
-  benchmark_cwchess_pgn(std::cout, filename);
-#endif
+  int fd = open(filename, O_RDONLY);
+  fdatasync(fd);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
 }
 
-#ifdef GFILE_ASYNC_IMPLEMENTATION
-size_t len = 0;
+void warm_cache(char const* filename)
+{
+  read_syscall(filename);
+}
 
-void async_ready_callback(GObject* source_object, GAsyncResult* async_res, gpointer user_data)
+// Run reader `repeats' times with the cache in the given state and print the result.
+void benchmark(Reader const& reader, char const* filename, bool cold, int repeats, uint64_t file_size)
 {
-  GFile* file = G_FILE(user_data);
-  GError* error = NULL;
-  GFileInputStream* stream = g_file_read_finish(file, async_res, &error);
-  if (stream == NULL)
+  std::vector<double> times;
+  Result result;
+  double cached = 0;
+  for (int i = 0; i < repeats; ++i)
   {
-    std::cerr << "g_file_read_finish failed: " << error->message << std::endl;
-    exit(1);
+    if (cold)
+    {
+      drop_cache(filename);
+      cached = std::max(cached, cached_fraction(filename));
+    }
+    else
+      warm_cache(filename);
+    result = reader.function(filename);
+    if (!reader.parses)
+      elapsed = std::chrono::duration<double>(clock_type::now() - start_time).count();
+    times.push_back(elapsed);
+  }
+  std::sort(times.begin(), times.end());
+  double best = times.front();
+  double median = times[times.size() / 2];
+  std::cout << std::setfill(' ') << std::left << std::setw(16) << reader.name << std::setw(5) << (cold ? "cold" : "warm") << std::right <<
+      std::fixed << std::setprecision(1) << std::setw(9) << file_size / best / 1048576 << " MB/s  best " <<
+      std::setprecision(4) << best << " s  median " << median << " s  " << (reader.parses ? "games " : "lines ") << result.lines;
+  if (result.bytes != file_size)
+    std::cout << "  (read " << result.bytes << " of " << file_size << " bytes)";
+  if (cold && cached > 0.01)
+    std::cout << "  (" << std::setprecision(0) << cached * 100 << "% was still cached)";
+  std::cout << std::endl;
+  if (reader.parses)
+  {
+    std::cout << "Stages of the last run:\n";
+    import_timing.print_on(std::cout);
+    std::cout.flush();
   }
-  start_timer();
-  len = 0;
-  g_input_stream_read_async(G_INPUT_STREAM(stream), buf, cwchess::pgn::DatabaseSeekable::S_buffer_size,
-      G_PRIORITY_DEFAULT, cancellable, async_ready_callback2, stream);
 }
 
-void async_ready_callback2(GObject* source_object, GAsyncResult* async_res, gpointer user_data)
+void usage(char const* program)
 {
-  GInputStream* stream = G_INPUT_STREAM(user_data);
-  GError* error = NULL;
-  gssize res = g_input_stream_read_finish(stream, async_res, &error);
-  if (res == -1)
+  std::cerr << "Usage: " << program << " [-c warm|cold|both] [-r repeats] [-i reader,...] [-b block KB] [-q queue depth] [-d]\n"
+               "        [-s megabytes] [-y style] [-j file.json] [file.pgn]\n"
+	       "Reads file.pgn with every reader (read, fstream_read, fstream_getline, gio, gio_async, memoryblocklist, mmap)\n"
+	       "or those given with -i. Without file.pgn, a corpus of the given size and style is generated (see pgngen).\n"
+	       "-b, -q and -d (O_DIRECT) set the BlockReader options of memoryblocklist.\n"
+	       "-j writes the per-stage timing of the last memoryblocklist run to file.json." << std::endl;
+}
+
+int main(int argc, char* argv[])
+{
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Debug(NAMESPACE_DEBUG::init());
+  Gio::init();
+
+  bool warm = true;
+  bool cold = true;
+  int repeats = 3;
+  std::string selection;
+  char const* json_filename = NULL;
+  pgn::CorpusGenerator::Options corpus_options;
+  corpus_options.style = pgn::CorpusGenerator::annotated | pgn::CorpusGenerator::variations;
+  int opt;
+  while ((opt = getopt(argc, argv, "c:r:i:b:q:ds:y:j:")) != -1)
   {
-    std::cerr << "g_input_stream_read_finish: " << error->message << std::endl;
-    exit(1);
+    switch (opt)
+    {
+      case 'c':
+	warm = std::strcmp(optarg, "cold") != 0;
+	cold = std::strcmp(optarg, "warm") != 0;
+	break;
+      case 'r':
+	repeats = std::max(1, std::atoi(optarg));
+	break;
+      case 'i':
+	selection = std::string(",") + optarg + ',';
+	break;
+      case 'b':
+	read_options.block_size = size_t(std::atol(optarg)) * 1024;
+	break;
+      case 'q':
+	read_options.queue_depth = std::atoi(optarg);
+	break;
+      case 'd':
+	read_options.direct = true;
+	break;
+      case 's':
+	corpus_options.size = uint64_t(std::atof(optarg) * 1024 * 1024);
+	break;
+      case 'y':
+	if (!pgn::CorpusGenerator::parse_style(optarg, corpus_options.style))
+	{
+	  std::cerr << "Unknown style \"" << optarg << "\"." << std::endl;
+	  return 1;
+	}
+	break;
+      case 'j':
+	json_filename = optarg;
+	break;
+      default:
+	usage(argv[0]);
+	return 1;
+    }
+  }
+  if (argc - optind > 1)
+  {
+    usage(argv[0]);
+    return 1;
+  }
+
+  std::string filename;
+  bool generated = optind == argc;
+  if (generated)
+  {
+    char path[] = "/tmp/tstpgnreadXXXXXX";
+    int fd = mkstemp(path);
+    if (fd == -1)
+    {
+      std::cerr << "mkstemp: " << std::strerror(errno) << std::endl;
+      return 1;
+    }
+    filename = path;
+    uint32_t games;
+    {
+      pgn::Writer writer(fd);
+      games = pgn::CorpusGenerator(corpus_options).generate(writer);
+    }
+    close(fd);
+    std::cout << "Generated " << games << " games (seed " << corpus_options.seed << ") in " << filename << '.' << std::endl;
   }
-  len += res;
-  if (res > 0)
-    g_input_stream_read_async(G_INPUT_STREAM(stream), buf, cwchess::pgn::DatabaseSeekable::S_buffer_size,
-        G_PRIORITY_DEFAULT, cancellable, async_ready_callback2, stream);
   else
+    filename = argv[optind];
+
+  struct stat st;
+  if (stat(filename.c_str(), &st) == -1)
   {
-    uint64_t microseconds = stop_timer();
-    *global_os << "g_input_stream_read_async (buffersize " << cwchess::pgn::DatabaseSeekable::S_buffer_size << "): " <<
-        microseconds << " microseconds. Size read: " << len << std::endl;
-    g_object_unref(stream);
-    g_main_loop_quit(gmain_loop);
+    std::cerr << "Can't stat " << filename << ": " << std::strerror(errno) << std::endl;
+    return 1;
   }
-}
-#endif
+  std::cout << "File size: " << st.st_size << " bytes; " << repeats << " runs per reader; memoryblocklist reads blocks of " <<
+      read_options.block_size << " bytes with queue depth " << read_options.queue_depth << (read_options.direct ? " and O_DIRECT" : "") <<
+      " and also parses the games." << std::endl;
 
-#ifdef CWCHESS_PGN_IMPLEMENTATION
-void open_finished(size_t len)
-{
-  uint64_t microseconds = stop_timer();
-  *global_os << "cwchess::pgn::DatabaseSeekable (buffersize " << cwchess::pgn::DatabaseSeekable::S_buffer_size << "): " <<
-      microseconds << " microseconds. Size read: " << len << "; number of lines: " << pgn_data_base->number_of_lines() << "; number of characters: " <<
-      pgn_data_base->number_of_characters() << std::endl;
-  main_loop->quit();
+  // Warm up (read libraries etc).
+  warm_cache(filename.c_str());
+
+  for (Reader const& reader : readers)
+  {
+    if (!selection.empty() && selection.find(std::string(",") + reader.name + ',') == std::string::npos)
+      continue;
+    if (warm)
+      benchmark(reader, filename.c_str(), false, repeats, st.st_size);
+    if (cold)
+      benchmark(reader, filename.c_str(), true, repeats, st.st_size);
+  }
+
+  util::MemoryBlockPool::Statistics statistics = util::MemoryBlockPool::instance().statistics();
+  if (statistics.allocations)
+    std::cout << "Memory blocks: " << statistics.allocations << " allocations, of which " << statistics.recycled << " recycled; peak " <<
+        statistics.peak_blocks_in_use << " blocks in use; " << statistics.arenas << " arenas (" << statistics.huge_page_arenas <<
+        " from hugetlbfs)." << std::endl;
+
+  if (json_filename)
+  {
+    std::ofstream json(json_filename);
+    import_timing.write_json(json);
+    json << '\n';
+    if (!json)
+    {
+      std::cerr << "Failed to write " << json_filename << '.' << std::endl;
+      return 1;
+    }
+  }
+
+  if (generated)
+    std::remove(filename.c_str());
 }
-#endif
@@ -0,0 +1,204 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file tstpgnwrite.cxx Export (a subset of) a PGN database with pgn::Writer and read it back.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDatabase.h"
+#include "PgnWriter.h"
+#include "Decompressor.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <ctime>
+#include <cstring>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace cwchess;
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+Glib::RefPtr<pgn::Database> pgn_data_base;
+Glib::RefPtr<pgn::Database> exported_data_base;
+char const* input_file;
+char const* output_file;
+bool raw;
+char const* player;
+std::vector<uint32_t> game_ids;
+uint64_t input_size;
+int exit_code = 1;
+
+double seconds_since(timespec const& start)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void export_finished(size_t)
+{
+  main_loop->quit();
+
+  // Compare the games that were read back with the original ones.
+  pgn::MoveStore const& move_store(pgn_data_base->move_store());
+  pgn::MoveStore const& exported_move_store(exported_data_base->move_store());
+  if (exported_move_store.size() != game_ids.size())
+  {
+    std::cerr << "Read back " << exported_move_store.size() << " games instead of " << game_ids.size() << '.' << std::endl;
+    return;
+  }
+  for (uint32_t i = 0; i < game_ids.size(); ++i)
+  {
+    size_t number_of_moves = move_store.number_of_moves(game_ids[i]);
+    if (exported_move_store.number_of_moves(i) != number_of_moves ||
+        !std::equal(exported_move_store.moves(i), exported_move_store.moves(i) + number_of_moves, move_store.moves(game_ids[i])) ||
+	exported_data_base->tag_store().white(i) != pgn_data_base->tag_store().white(game_ids[i]))
+    {
+      std::cerr << "Game " << game_ids[i] << " differs after reading it back." << std::endl;
+      return;
+    }
+  }
+  std::cout << "All games read back correctly." << std::endl;
+  exit_code = 0;
+}
+
+void open_finished(size_t bytes_read)
+{
+  input_size = bytes_read;
+  pgn::TagStore const& tag_store(pgn_data_base->tag_store());
+  pgn::MoveStore const& move_store(pgn_data_base->move_store());
+  if (player)
+  {
+    pgn::TagQuery query;
+    query.where(pgn::TagQuery::player, pgn::TagQuery::equal, tag_store.players().find(player));
+    game_ids = tag_store.select(query);
+  }
+  else
+    for (uint32_t game_id = 0; game_id < tag_store.size(); ++game_id)
+      game_ids.push_back(game_id);
+
+  int fd = open(output_file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd == -1)
+  {
+    std::cerr << "Failed to open " << output_file << std::endl;
+    main_loop->quit();
+    return;
+  }
+  timespec start;
+  clock_gettime(CLOCK_REALTIME, &start);
+  uint64_t bytes_written;
+  bool success;
+  if (raw)
+  {
+    // Copy the text of the selected games from the input file, which might be compressed.
+    util::Decompressor decompressor;
+    if (!decompressor.open(input_file))
+    {
+      std::cerr << "Failed to open " << input_file << std::endl;
+      main_loop->quit();
+      return;
+    }
+    pgn::Writer writer(fd);
+    std::vector<char> text;
+    success = true;
+    for (uint32_t game_id : game_ids)
+    {
+      uint64_t begin = tag_store.offset(game_id);
+      uint64_t end = (game_id + 1 < tag_store.size()) ? tag_store.offset(game_id + 1) : input_size;
+      // Jump to the game if possible (uncompressed or seekable zstd files), otherwise read up till it.
+      if (decompressor.position() != begin && !decompressor.seek(begin))
+      {
+	while (success && decompressor.position() < begin)
+	{
+	  text.resize(std::min(begin - decompressor.position(), uint64_t(1024 * 1024)));
+	  success = decompressor.read(text.data(), text.size()) > 0;
+	}
+      }
+      text.resize(end - begin);
+      for (size_t len = 0; success && len < text.size();)
+      {
+	ssize_t n = decompressor.read(text.data() + len, text.size() - len);
+	success = n > 0;
+	len += n;
+      }
+      if (!success || decompressor.position() != end)
+      {
+	std::cerr << "Failed to read game " << game_id << " from " << input_file << std::endl;
+	success = false;
+	break;
+      }
+      writer.raw(text.data(), text.size());
+    }
+    success = writer.flush() && success;
+    bytes_written = writer.bytes_written();
+  }
+  else
+  {
+    pgn::Writer writer(fd);
+    for (uint32_t game_id : game_ids)
+      writer.game(tag_store, move_store, game_id);
+    success = writer.flush();
+    bytes_written = writer.bytes_written();
+  }
+  double seconds = seconds_since(start);
+  close(fd);
+  if (!success)
+  {
+    std::cerr << "Failed to write " << output_file << std::endl;
+    main_loop->quit();
+    return;
+  }
+  std::cout << "Exported " << game_ids.size() << " games, " << bytes_written << " bytes in " << seconds << " seconds (" <<
+      bytes_written / seconds / 1e6 << " MB/s)." << std::endl;
+
+  // Read the exported games back.
+  exported_data_base = pgn::DatabaseSeekable::open(output_file, sigc::ptr_fun(&export_finished));
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Gio::init();
+
+  // With --raw, the text of the selected games is copied instead of formatted from the move store.
+  if (argc > 1 && std::strcmp(argv[1], "--raw") == 0)
+  {
+    raw = true;
+    --argc;
+    ++argv;
+  }
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " [--raw] <database.pgn> <output.pgn> [<player>]" << std::endl;
+    return 1;
+  }
+  input_file = argv[1];
+  output_file = argv[2];
+  if (argc > 3)
+    player = argv[3];
+  pgn_data_base = pgn::DatabaseSeekable::open(input_file, sigc::ptr_fun(&open_finished));
+  main_loop = Glib::MainLoop::create(false);
+  main_loop->run();
+  return exit_code;
+}
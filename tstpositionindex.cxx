@@ -0,0 +1,122 @@
+// cwchessboard -- A C++ chessboard tool set
+//
+//! @file tstpositionindex.cxx Build a position index for a PGN database and query it.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "sys.h"
+#include "PgnDatabase.h"
+#include "PgnPositionIndex.h"
+#include "ChessNotation.h"
+#include "debug.h"
+#include <giomm/init.h>
+#include <iostream>
+#include <map>
+#include <ctime>
+
+using namespace cwchess;
+
+Glib::RefPtr<Glib::MainLoop> main_loop;
+Glib::RefPtr<pgn::Database> pgn_data_base;
+char const* index_file;
+char const* FEN;
+
+double seconds_since(timespec const& start)
+{
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) * 1e-9;
+}
+
+void open_finished(size_t)
+{
+  main_loop->quit();
+
+  pgn::MoveStore const& move_store(pgn_data_base->move_store());
+  std::cout << "Building index for " << move_store.size() << " games (" << move_store.total_number_of_moves() << " moves)..." << std::endl;
+  timespec start;
+  clock_gettime(CLOCK_REALTIME, &start);
+  if (!pgn::PositionIndex::build(move_store, index_file))
+  {
+    std::cerr << "Failed to write " << index_file << std::endl;
+    return;
+  }
+  std::cout << "Build time: " << seconds_since(start) << " seconds." << std::endl;
+
+  pgn::PositionIndex index;
+  if (!index.open(index_file))
+  {
+    std::cerr << "Failed to open " << index_file << std::endl;
+    return;
+  }
+  std::cout << "Number of distinct positions: " << index.number_of_keys() << std::endl;
+
+  ChessPosition chess_position;
+  if (!FEN)
+    chess_position.initial_position();
+  else if (!chess_position.load_FEN(FEN))
+  {
+    std::cerr << "Invalid FEN: " << FEN << std::endl;
+    return;
+  }
+  std::vector<pgn::PositionIndex::Hit> hits;
+  clock_gettime(CLOCK_REALTIME, &start);
+  index.find(chess_position, hits);
+  std::cout << "Query time: " << seconds_since(start) << " seconds.\n";
+  std::cout << "Number of games: " << hits.size() << '\n';
+
+  // Aggregate the continuations.
+  std::map<pgn::MoveStore::encoded_move_type, size_t> continuations;
+  for (pgn::PositionIndex::Hit const& hit : hits)
+    ++continuations[hit.continuation];
+  for (auto const& continuation : continuations)
+  {
+    if (continuation.first == pgn::MoveStore::no_move)
+      std::cout << "  (game ended)";
+    else
+      std::cout << "  " << ChessNotation(chess_position, pgn::MoveStore::decode(continuation.first));
+    std::cout << ": " << continuation.second << '\n';
+  }
+  pgn::TagStore const& tag_store(pgn_data_base->tag_store());
+  for (size_t i = 0; i < hits.size() && i < 10; ++i)
+    std::cout << "  #" << hits[i].game_id << " ply " << hits[i].ply << ": " <<
+        tag_store.white(hits[i].game_id) << " - " << tag_store.black(hits[i].game_id) << '\n';
+  std::cout.flush();
+}
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  if (!Glib::thread_supported())
+    Glib::thread_init();
+  Gio::init();
+
+  if (argc < 3)
+  {
+    std::cerr << "Usage: " << argv[0] << " <database.pgn> <index file> [<FEN>]" << std::endl;
+    return 1;
+  }
+  index_file = argv[2];
+  if (argc > 3)
+    FEN = argv[3];
+  pgn_data_base = pgn::DatabaseSeekable::open(argv[1], sigc::ptr_fun(&open_finished));
+  main_loop = Glib::MainLoop::create(false);
+  main_loop->run();
+}
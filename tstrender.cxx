@@ -0,0 +1,344 @@
+// cwchessboard -- A C++ chessboard tool set for gtkmm
+//
+//! @file tstrender.cxx Benchmarks of the ChessboardWidget drawing code.
+//
+// Copyright (C) 2026, by
+//
+// Carlo Wood, Run on IRC <carlo@alinoe.com>
+// RSA-1024 0x624ACAD5 1997-01-26                    Sign & Encrypt
+// Fingerprint16 = 32 EC A7 B6 AC DB 65 A6  F6 F6 55 DD 1C DC FF 61
+//
+// This program is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+
+// The drawing code of ChessboardWidget normally only runs from a GTK expose
+// event. This program puts the widget in a Gtk::OffscreenWindow, so that it
+// is realized without being mapped on a screen, and then calls on_draw itself
+// with a cairo context on an image surface. Nothing is drawn by GTK; all
+// rendering, including the piece and HUD caches, is done on image surfaces.
+// A display connection is still needed to initialize GTK; in CI run this
+// program with xvfb-run or with GDK_BACKEND=broadway.
+//
+// Each frame is one of:
+//
+//   full_redraw   Draw the whole widget: all 64 squares and the border.
+//   square        Put a piece on a square or remove it again, and draw only that square.
+//   resize_<N>    Resize the widget and draw it; every frame changes the side of the
+//                 squares between N and N+1 pixels, so that the pieces are rasterised again.
+//   hud           Redraw the whole HUD layer 0 (hatching of the dark squares) and the widget.
+//   arrows        Remove an arrow and add it again, and draw the widget with four arrows.
+//
+// The results are written as JSON (to stdout by default) and as a table of
+// frames per second on stderr.
+//
+// Usage: tstrender [-n <samples>] [-t <milliseconds per sample>] [-s <square side>] [-f <filter>] [-o <output.json>]
+
+#include "sys.h"
+#include "ChessboardWidget.h"
+#include "CwChessboardCodes.h"
+#include "Benchmark.h"
+#include "debug.h"
+#include <gtkmm/offscreenwindow.h>
+#include <gtkmm/main.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <unistd.h>
+
+namespace {
+
+//! A ChessboardWidget that can be resized and drawn by hand.
+class RenderWidget : public cwmm::ChessboardWidget {
+  public:
+    //! Give the widget a square allocation such that the squares have side \a sside.
+    void allocate(gint sside)
+    {
+      gint size = cwmm::squares * sside + 2 * default_calc_board_border_width(sside);
+      Gtk::Allocation allocation(0, 0, size, size);
+      on_size_allocate(allocation);
+    }
+
+    //! Draw the part of the widget inside the given rectangle on \a cr.
+    void draw(Cairo::RefPtr<Cairo::Context> const& cr, int x, int y, int width, int height)
+    {
+      cr->save();
+      cr->rectangle(x, y, width, height);
+      cr->clip();
+      on_draw(cr);
+      cr->restore();
+    }
+
+    //! Draw the whole widget on \a cr.
+    void draw(Cairo::RefPtr<Cairo::Context> const& cr)
+    {
+      Gtk::Allocation allocation = get_allocation();
+      draw(cr, 0, 0, allocation.get_width(), allocation.get_height());
+    }
+};
+
+//! The widget being benchmarked and the image surface that it is drawn on.
+struct Canvas {
+  RenderWidget& M_widget;
+  Cairo::RefPtr<Cairo::ImageSurface> M_surface;
+  Cairo::RefPtr<Cairo::Context> M_cr;
+
+  //! Resize the widget to squares of side \a sside, and draw it once so that all caches are up to date.
+  Canvas(RenderWidget& widget, gint sside) : M_widget(widget)
+  {
+    // Large enough for sside + 1 too, for the resize benchmarks.
+    gint size = cwmm::squares * (sside + 1) + 2 * cwmm::ChessboardWidget::default_calc_board_border_width(sside + 1);
+    M_surface = Cairo::ImageSurface::create(Cairo::FORMAT_ARGB32, size, size);
+    M_cr = Cairo::Context::create(M_surface);
+    M_widget.allocate(sside);
+    M_widget.draw(M_cr);
+  }
+};
+
+void initial_position(RenderWidget& widget)
+{
+  static CwChessboardCode const white_back_rank[8] = { white_rook, white_knight, white_bishop, white_queen, white_king, white_bishop, white_knight, white_rook };
+  static CwChessboardCode const black_back_rank[8] = { black_rook, black_knight, black_bishop, black_queen, black_king, black_bishop, black_knight, black_rook };
+  for (gint col = 0; col < 8; ++col)
+  {
+    widget.set_square(col, 0, white_back_rank[col]);
+    widget.set_square(col, 1, white_pawn);
+    for (gint row = 2; row < 6; ++row)
+      widget.set_square(col, row, empty_square);
+    widget.set_square(col, 6, black_pawn);
+    widget.set_square(col, 7, black_back_rank[col]);
+  }
+}
+
+//! The arrows of the arrows benchmark, as begin column, begin row, end column and end row.
+gint const arrow_coordinates[4][4] = { { 4, 1, 4, 3 }, { 6, 0, 5, 2 }, { 3, 6, 3, 4 }, { 2, 0, 7, 5 } };
+
+gpointer add_arrow(RenderWidget& widget, int arrow)
+{
+  GdkColor color;
+  color.red = 0x2000;
+  color.green = 0x8000;
+  color.blue = 0xe000;
+  gint const* c = arrow_coordinates[arrow];
+  return widget.add_arrow(c[0], c[1], c[2], c[3], color);
+}
+
+//-----------------------------------------------------------------------------
+// Measuring.
+
+//! The runtime settings.
+struct Options : util::benchmark::Options {
+  gint sside = 64;		//!< The side of the squares in pixels, except for the resize benchmarks.
+  std::string filter;
+};
+
+//! The result of one benchmark.
+struct Result : util::benchmark::Result {
+  std::string name;
+  gint sside;
+
+  double frames_per_second() const { return median > 0 ? 1e9 / median : 0.0; }
+};
+
+Result measure(std::string const& name, gint sside, util::benchmark::function_type const& frame, Options const& options)
+{
+  Result result;
+  static_cast<util::benchmark::Result&>(result) = util::benchmark::measure(frame, options);
+  result.name = name;
+  result.sside = sside;
+  return result;
+}
+
+//-----------------------------------------------------------------------------
+// Output.
+
+void write_json(std::ostream& os, std::vector<Result> const& results, Options const& options)
+{
+  os << std::setprecision(6);
+  os << "{\n  \"program\": \"tstrender\",\n  \"unit\": \"ns/frame\",\n  \"samples\": " << options.samples <<
+      ",\n  \"min_sample_time\": " << options.min_sample_time << ",\n  \"results\": [";
+  char const* separator = "\n";
+  for (Result const& result : results)
+  {
+    os << separator << "    { \"name\": \"" << result.name << "\", \"sside\": " << result.sside <<
+        ", \"iterations\": " << result.iterations << ", \"frames_per_second\": " << result.frames_per_second() <<
+        ", \"min\": " << result.min << ", \"median\": " << result.median <<
+        ", \"mean\": " << result.mean << ", \"stddev\": " << result.stddev <<
+        ", \"allocations\": " << result.allocations << ", \"bytes_allocated\": " << result.bytes_allocated << ",\n      \"samples\": [";
+    for (size_t i = 0; i < result.samples.size(); ++i)
+      os << (i ? ", " : "") << result.samples[i];
+    os << "] }";
+    separator = ",\n";
+  }
+  os << "\n  ]\n}\n";
+}
+
+void usage(char const* progname)
+{
+  std::cerr << "Usage: " << progname << " [-n <samples>] [-t <milliseconds per sample>] [-s <square side>] [-f <filter>] [-o <output.json>]\n"
+               "  The filter selects the benchmarks whose name contains it." << std::endl;
+  std::exit(1);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+  Debug(NAMESPACE_DEBUG::init());
+  Debug(libcw_do.off());
+
+  if (!gtk_init_check(&argc, &argv))
+  {
+    std::cerr << argv[0] << ": cannot open a display; run with xvfb-run or GDK_BACKEND=broadway." << std::endl;
+    return 1;
+  }
+  Gtk::Main::init_gtkmm_internals();
+
+  Options options;
+  std::string output_filename;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:t:s:f:o:")) != -1)
+  {
+    switch (opt)
+    {
+      case 'n':
+        options.samples = std::atoi(optarg);
+        break;
+      case 't':
+        options.min_sample_time = std::atof(optarg) / 1000;
+        break;
+      case 's':
+        options.sside = std::atoi(optarg);
+        break;
+      case 'f':
+        options.filter = optarg;
+        break;
+      case 'o':
+        output_filename = optarg;
+        break;
+      default:
+        usage(argv[0]);
+    }
+  }
+  if (optind != argc || options.samples < 1 || options.min_sample_time <= 0 || options.sside < 8)
+    usage(argv[0]);
+
+  // Realize the widget without showing it.
+  Gtk::OffscreenWindow window;
+  RenderWidget widget;
+  window.add(widget);
+  window.show_all();
+  while (gtk_events_pending())
+    gtk_main_iteration();
+  if (!widget.get_realized())
+  {
+    std::cerr << argv[0] << ": failed to realize the widget." << std::endl;
+    return 1;
+  }
+  initial_position(widget);
+  // Never return to the main loop from here on: every draw below is ours.
+
+  std::vector<Result> results;
+  auto run = [&](std::string const& name, gint sside, util::benchmark::function_type const& frame)
+  {
+    if (!options.filter.empty() && name.find(options.filter) == std::string::npos)
+      return;
+    results.push_back(measure(name, sside, frame, options));
+    Result const& result(results.back());
+    std::cerr << std::left << std::setw(12) << result.name << std::right << std::setw(4) << result.sside << " px" << std::fixed <<
+        std::setprecision(1) << std::setw(10) << result.frames_per_second() << " frames/s  median " <<
+        std::setw(10) << result.median / 1000 << " us  min " << std::setw(10) << result.min / 1000 <<
+        " us  stddev " << std::setw(8) << result.stddev / 1000 << " us  allocations " << result.allocations <<
+        " (" << std::setprecision(0) << result.bytes_allocated << " bytes)" << std::endl;
+  };
+
+  {
+    Canvas canvas(widget, options.sside);
+    run("full_redraw", options.sside, [&canvas]()
+    {
+      canvas.M_widget.draw(canvas.M_cr);
+      return 1;
+    });
+
+    // Toggle a white knight on e4.
+    gint x, y;
+    widget.colrow2xy(4, 3, x, y);
+    bool occupied = false;
+    run("square", options.sside, [&canvas, &occupied, x, y]()
+    {
+      occupied = !occupied;
+      canvas.M_widget.set_square(4, 3, occupied ? white_knight : empty_square);
+      canvas.M_widget.draw(canvas.M_cr, x, y, canvas.M_widget.sside(), canvas.M_widget.sside());
+      return 1;
+    });
+    widget.set_square(4, 3, empty_square);
+  }
+
+  for (gint sside : { 32, 64, 128, 256 })
+  {
+    Canvas canvas(widget, sside);
+    gint next_sside = sside;
+    run("resize_" + std::to_string(sside), sside, [&canvas, &next_sside, sside]()
+    {
+      next_sside = (next_sside == sside) ? sside + 1 : sside;
+      canvas.M_widget.allocate(next_sside);
+      canvas.M_widget.draw(canvas.M_cr);
+      return 1;
+    });
+  }
+
+  {
+    Canvas canvas(widget, options.sside);
+    widget.enable_hud_layer(0);
+    run("hud", options.sside, [&canvas]()
+    {
+      canvas.M_widget.enable_hud_layer(0);	// Marks every square of the layer for redraw.
+      canvas.M_widget.draw(canvas.M_cr);
+      return 1;
+    });
+    widget.disable_hud_layer(0);
+
+    std::vector<gpointer> arrows;
+    for (int arrow = 0; arrow < 4; ++arrow)
+      arrows.push_back(add_arrow(widget, arrow));
+    int next_arrow = 0;
+    run("arrows", options.sside, [&canvas, &arrows, &next_arrow]()
+    {
+      // Every frame removes and adds a different one of the arrows.
+      canvas.M_widget.remove_arrow(arrows[next_arrow]);
+      arrows[next_arrow] = add_arrow(canvas.M_widget, next_arrow);
+      next_arrow = (next_arrow + 1) % 4;
+      canvas.M_widget.draw(canvas.M_cr);
+      return 1;
+    });
+    for (gpointer arrow : arrows)
+      widget.remove_arrow(arrow);
+  }
+
+  if (output_filename.empty() || output_filename == "-")
+    write_json(std::cout, results, options);
+  else
+  {
+    std::ofstream output(output_filename);
+    write_json(output, results, options);
+    if (!output)
+    {
+      std::cerr << "Failed to write " << output_filename << std::endl;
+      return 1;
+    }
+  }
+}